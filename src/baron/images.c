@@ -0,0 +1,199 @@
+/**
+ *  @file   images.c
+ *
+ *  Implementation of disk image writing
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if !defined(__STDC_NO_THREADS__)
+#include <threads.h>
+#endif
+#include "images.h"
+
+
+#define MAX_DISK_IMAGE_THREADS 8
+
+
+bool is_double_sided_filename(const char *filename) {
+    size_t length = strlen(filename);
+    return length >= 4 && filename[length - 4] == '.' &&
+           (filename[length - 3] | 0x20) == 'd' &&
+           (filename[length - 2] | 0x20) == 's' &&
+           (filename[length - 1] | 0x20) == 'd';
+}
+
+
+typedef struct disk_image_queue_t disk_image_queue_t;
+
+struct disk_image_queue_t {
+    disk_image_job_t *jobs;
+    size_t num_jobs;
+    size_t next_job;
+#if !defined(__STDC_NO_THREADS__)
+    mtx_t mutex;
+#endif
+};
+
+
+bool init_disk_image_job(disk_image_job_t *job, const char *filename, const char *title, int opt,
+                         const baron_disk_file_t *saved_files, size_t num_saved_files, const manifest_image_t *image) {
+
+    size_t num_files = image ? image->num_files : num_saved_files;
+    *job = (disk_image_job_t){
+        .filename = filename,
+        .desc = {
+            .title = title,
+            .boot_option = opt,
+            .double_sided = is_double_sided_filename(filename),
+            .num_files = num_files
+        },
+        .files = malloc((num_files ? num_files : 1) * sizeof(baron_disk_file_t))
+    };
+
+    if (!job->files) {
+        fprintf(stderr, "Out of memory\n");
+        return false;
+    }
+    job->desc.files = job->files;
+
+    if (!image) {
+        memcpy(job->files, saved_files, num_files * sizeof(baron_disk_file_t));
+        return true;
+    }
+
+    // Files reference the saved overlays' object code, so selecting them copies no data
+    for (size_t i = 0; i < num_files; i++) {
+        size_t j = 0;
+        while (j < num_saved_files && strcmp(saved_files[j].name, image->files[i].name) != 0) {
+            j++;
+        }
+        if (j == num_saved_files) {
+            fprintf(stderr, "Disk image %s: %s is not a saved overlay\n", filename, image->files[i].name);
+            return false;
+        }
+        job->files[i] = saved_files[j];
+        job->files[i].side = image->files[i].side;
+    }
+    return true;
+}
+
+
+bool report_disk_image_status(const disk_image_job_t *job) {
+    switch (job->status) {
+        case baron_disk_image_ok:
+            return true;
+        case baron_disk_image_invalid_desc:
+            fprintf(stderr, "Invalid description for disk image %s\n", job->filename);
+            return false;
+        case baron_disk_image_invalid_filename:
+            fprintf(stderr, "Invalid DFS filename when writing disk image %s\n", job->filename);
+            return false;
+        case baron_disk_image_too_many_files:
+            fprintf(stderr, "Too many files for disk image %s\n", job->filename);
+            return false;
+        case baron_disk_image_disk_full:
+            fprintf(stderr, "Disk image %s is full\n", job->filename);
+            return false;
+        default:
+            fprintf(stderr, "Failed to write disk image %s\n", job->filename);
+            return false;
+    }
+}
+
+
+static disk_image_job_t *take_disk_image_job(disk_image_queue_t *queue) {
+#if !defined(__STDC_NO_THREADS__)
+    mtx_lock(&queue->mutex);
+#endif
+    disk_image_job_t *job = (queue->next_job < queue->num_jobs) ? &queue->jobs[queue->next_job++] : 0;
+#if !defined(__STDC_NO_THREADS__)
+    mtx_unlock(&queue->mutex);
+#endif
+    return job;
+}
+
+
+static int disk_image_worker(void *context) {
+    disk_image_queue_t *queue = context;
+    disk_image_job_t *job;
+    while ((job = take_disk_image_job(queue))) {
+        job->status = baron_disk_image_save(&job->desc, job->filename);
+    }
+    return 0;
+}
+
+
+void write_disk_images(disk_image_job_t *jobs, size_t num_jobs) {
+    disk_image_queue_t queue = {
+        .jobs = jobs,
+        .num_jobs = num_jobs
+    };
+
+#if !defined(__STDC_NO_THREADS__)
+    // The assembly is only read while writing images, so they can all be written concurrently.
+    // The main thread works through the queue too, so this still succeeds if no threads can be started.
+    thrd_t threads[MAX_DISK_IMAGE_THREADS];
+    size_t num_threads = 0;
+    if (num_jobs > 1 && mtx_init(&queue.mutex, mtx_plain) == thrd_success) {
+        while (num_threads < num_jobs - 1 && num_threads < MAX_DISK_IMAGE_THREADS &&
+               thrd_create(&threads[num_threads], disk_image_worker, &queue) == thrd_success) {
+            num_threads++;
+        }
+        disk_image_worker(&queue);
+        for (size_t i = 0; i < num_threads; i++) {
+            thrd_join(threads[i], 0);
+        }
+        mtx_destroy(&queue.mutex);
+        return;
+    }
+    for (size_t i = 0; i < num_jobs; i++) {
+        jobs[i].status = baron_disk_image_save(&jobs[i].desc, jobs[i].filename);
+    }
+#else
+    disk_image_worker(&queue);
+#endif
+}
+
+
+bool save_disk_images(const baron_assembly_t *assembly, const char *output_ssd, const char *title, int opt, const char *manifest_filename) {
+    manifest_t manifest = {0};
+    if (manifest_filename && !manifest_load(&manifest, manifest_filename)) {
+        return false;
+    }
+
+    size_t num_saved_files = baron_assembly_disk_files(assembly, 0, 0);
+    baron_disk_file_t *saved_files = malloc((num_saved_files ? num_saved_files : 1) * sizeof(baron_disk_file_t));
+    size_t num_jobs = manifest.num_images + (output_ssd ? 1 : 0);
+    disk_image_job_t *jobs = calloc(num_jobs ? num_jobs : 1, sizeof(disk_image_job_t));
+    bool success = saved_files && jobs;
+    if (!success) {
+        fprintf(stderr, "Out of memory\n");
+    }
+    else {
+        baron_assembly_disk_files(assembly, saved_files, num_saved_files);
+        for (size_t i = 0; success && i < manifest.num_images; i++) {
+            const manifest_image_t *image = &manifest.images[i];
+            success = init_disk_image_job(&jobs[i], image->filename, image->title, image->opt, saved_files, num_saved_files, image);
+        }
+        if (success && output_ssd) {
+            success = init_disk_image_job(&jobs[num_jobs - 1], output_ssd, title, opt, saved_files, num_saved_files, 0);
+        }
+    }
+
+    if (success) {
+        write_disk_images(jobs, num_jobs);
+        for (size_t i = 0; i < num_jobs; i++) {
+            success = report_disk_image_status(&jobs[i]) && success;
+        }
+    }
+
+    for (size_t i = 0; jobs && i < num_jobs; i++) {
+        free(jobs[i].files);
+    }
+    free(jobs);
+    free(saved_files);
+    manifest_free(&manifest);
+    return success;
+}
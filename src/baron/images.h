@@ -0,0 +1,81 @@
+/**
+ *  @file   images.h
+ *
+ *  Writing of the disk images requested on the command line or by a manifest.
+ *
+ *  Each disk image is described by a job, and the jobs are worked through concurrently by a small pool of threads,
+ *  since a finished assembly may be read from several threads at once.
+ */
+
+#ifndef BARON_IMAGES_H_
+#define BARON_IMAGES_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "baron/baron.h"
+#include "manifest.h"
+
+typedef struct disk_image_job_t disk_image_job_t;
+
+
+struct disk_image_job_t {
+    const char *filename;
+    baron_disk_image_desc_t desc;
+    baron_disk_file_t *files;
+    baron_disk_image_status_t status;
+};
+
+
+/**
+ *  Determine whether a filename has a .dsd extension, naming a double-sided disk image
+ */
+bool is_double_sided_filename(const char *filename);
+
+
+/**
+ *  Initialize the job writing one disk image.
+ *  Any errors are reported to stderr.
+ *
+ *  @param  job             Pointer to the job to initialize; its files must be freed, even on failure
+ *  @param  filename        Filename of the disk image
+ *  @param  title           Disk title, or null
+ *  @param  opt             Boot option, 0-3
+ *  @param  saved_files     The files saved by the assembly
+ *  @param  num_saved_files Number of saved files
+ *  @param  image           Manifest entry selecting the files for the image, or null to write every saved file
+ *
+ *  @return Success true/false
+ */
+bool init_disk_image_job(disk_image_job_t *job, const char *filename, const char *title, int opt,
+                         const baron_disk_file_t *saved_files, size_t num_saved_files, const manifest_image_t *image);
+
+
+/**
+ *  Report the status of a finished job to stderr, if it failed
+ *
+ *  @return Whether the job succeeded
+ */
+bool report_disk_image_status(const disk_image_job_t *job);
+
+
+/**
+ *  Write the disk images described by a number of jobs, setting the status of each
+ */
+void write_disk_images(disk_image_job_t *jobs, size_t num_jobs);
+
+
+/**
+ *  Write the disk images requested on the command line and by a manifest
+ *
+ *  @param  assembly        The finished assembly whose saved files are written
+ *  @param  output_ssd      Filename of the disk image holding every saved file, or null
+ *  @param  title           Title of that disk image, or null
+ *  @param  opt             Boot option of that disk image
+ *  @param  manifest_filename   Filename of the manifest describing further disk images, or null
+ *
+ *  @return Success true/false
+ */
+bool save_disk_images(const baron_assembly_t *assembly, const char *output_ssd, const char *title, int opt, const char *manifest_filename);
+
+
+#endif // ifndef BARON_IMAGES_H_
@@ -4,15 +4,20 @@
  *  Implementation of the command line tool wrapping baronlib
  */
 
+#include <errno.h>
 #include <string.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include "baron/baron.h"
+#include "images.h"
 
 
 #define BARON_VERSION "0.1"
 
+// Far more source lines than anyone could read through, so larger counts are simply clamped to it
+#define MAX_PROFILE_LINES 100000
+
 
 void display_version(void) {
     puts("baron " BARON_VERSION);
@@ -28,26 +33,102 @@ void display_help(void) {
     puts("  -D <defines>     Define the variables in the comma-separated list which follows");
     puts("                   Example: -D SecondProc=TRUE,thickness=2,version=\"1.0\"");
     puts("  -log<N> <file>   Output messages to stream N (1-7) to the given file");
+    puts("  -manifest <file> Generate the disk images described in the given manifest, one per line:");
+    puts("                   <image> [-t <title>] [-opt <0-3>] [-side <0-1>] [<file>]...");
     puts("  -O <path>        Specify path for outputting object files");
     puts("  -opt <val>       When generating a disk image, set this boot option");
+    puts("  -profile <n>     Output the n source lines which took the most assembly time to stderr");
     puts("  -ssd <file>      Generate a disk image with the given filename");
+    puts("                   A .dsd extension generates a double-sided disk image");
+    puts("  -sym <file>      Write the symbol table to the given file, in a binary form which can be mapped and queried");
     puts("  -t <title>       When generating a disk image, set this disk title");
     puts("  -v, --verbose    Output listing for assembled source code");
+    puts("  --stats          Output timings and counters of the assembly to stdout, as JSON");
     puts("");
     puts("  --version to display version and author information");
     puts("  --help to display this help again");
 }
 
 
+bool write_to_file(const void *data, size_t size, void *context) {
+    return fwrite(data, 1, size, context) == size;
+}
+
+
+bool open_log_files(FILE *log_files[], const char *const log_filenames[], baron_desc_t *desc) {
+    for (int i = 0; i < BARON_NUM_LOG_CHANNELS; i++) {
+        if (!log_filenames[i]) {
+            continue;
+        }
+        log_files[i] = fopen(log_filenames[i], "wb");
+        if (!log_files[i]) {
+            fprintf(stderr, "Unable to open log file %s\n", log_filenames[i]);
+            return false;
+        }
+        // Text arrives from baronlib in large chunks already, so it's passed straight through rather than copied again
+        setvbuf(log_files[i], 0, _IONBF, 0);
+        desc->log_sinks[i] = (baron_log_sink_t){write_to_file, log_files[i]};
+    }
+    return true;
+}
+
+
+bool close_log_files(FILE *log_files[], const char *const log_filenames[]) {
+    bool success = true;
+    for (int i = 0; i < BARON_NUM_LOG_CHANNELS; i++) {
+        if (log_files[i] && fclose(log_files[i]) != 0) {
+            fprintf(stderr, "Failed to write log file %s\n", log_filenames[i]);
+            success = false;
+        }
+        log_files[i] = 0;
+    }
+    return success;
+}
+
+
+void write_stats(FILE *file, const baron_assembly_t *assembly) {
+    static const char *const memory_use_names[baron_memory_use_count] = {
+        "object_code", "symbols", "logs", "files", "other"
+    };
+
+    baron_stats_t stats;
+    baron_assembly_stats(assembly, &stats);
+    fprintf(file, "{\n  \"num_passes\": %u,\n  \"pass_seconds\": [", stats.num_passes);
+    uint32_t num_timed_passes = stats.num_passes < BARON_STATS_MAX_PASSES ? stats.num_passes : BARON_STATS_MAX_PASSES;
+    for (uint32_t i = 0; i < num_timed_passes; i++) {
+        fprintf(file, "%s%.6f", i ? ", " : "", stats.pass_seconds[i]);
+    }
+    fprintf(file, "],\n");
+    fprintf(file, "  \"finish_seconds\": %.6f,\n", stats.finish_seconds);
+    fprintf(file, "  \"tokens_lexed\": %llu,\n", (unsigned long long)stats.tokens_lexed);
+    fprintf(file, "  \"expressions_evaluated\": %llu,\n", (unsigned long long)stats.expressions_evaluated);
+    fprintf(file, "  \"macro_expansions\": %llu,\n", (unsigned long long)stats.macro_expansions);
+    fprintf(file, "  \"symbol_lookups\": %llu,\n", (unsigned long long)stats.symbol_lookups);
+    fprintf(file, "  \"symbol_probes\": %llu,\n", (unsigned long long)stats.symbol_probes);
+    fprintf(file, "  \"max_symbol_probe_length\": %u,\n", stats.max_symbol_probe_length);
+    fprintf(file, "  \"memory\": {\n");
+    for (int i = 0; i < baron_memory_use_count; i++) {
+        fprintf(file, "    \"%s\": {\"allocations\": %llu, \"bytes_requested\": %llu}%s\n", memory_use_names[i],
+                (unsigned long long)stats.memory[i].num_allocations, (unsigned long long)stats.memory[i].bytes_requested,
+                (i + 1 < baron_memory_use_count) ? "," : "");
+    }
+    fprintf(file, "  }\n}\n");
+}
+
+
 int main(int argc, char *argv[]) {
 
     const char *input_filename = 0;
-    const char *log_filenames[8] = {0};
+    const char *log_filenames[BARON_NUM_LOG_CHANNELS] = {0};
     const char *output_path = 0;
     const char *output_ssd = 0;
+    const char *manifest_filename = 0;
+    const char *symbols_filename = 0;
     const char *defines = 0;
     bool cmos = false;
     bool verbose = false;
+    bool stats = false;
+    int profile_lines = 0;
     int opt = 0;
     const char *title = 0;
 
@@ -64,6 +145,9 @@ int main(int argc, char *argv[]) {
         else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0) {
             verbose = true;
         }
+        else if (strcmp(argv[i], "--stats") == 0) {
+            stats = true;
+        }
         else if (strcmp(argv[i], "-D") == 0) {
             if (++i < argc) {
                 defines = argv[i];
@@ -91,6 +175,24 @@ int main(int argc, char *argv[]) {
                 return EXIT_FAILURE;
             }
         }
+        else if (strcmp(argv[i], "-manifest") == 0) {
+            if (++i < argc) {
+                manifest_filename = argv[i];
+            }
+            else {
+                fprintf(stderr, "Missing manifest filename (-manifest <filename>)\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "-sym") == 0) {
+            if (++i < argc) {
+                symbols_filename = argv[i];
+            }
+            else {
+                fprintf(stderr, "Missing symbol file filename (-sym <filename>)\n");
+                return EXIT_FAILURE;
+            }
+        }
         else if (strcmp(argv[i], "-opt") == 0) {
             if (++i < argc) {
                 if (argv[i][0] >= '0' && argv[i][0] <= '3' && argv[i][1] == 0) {
@@ -106,6 +208,21 @@ int main(int argc, char *argv[]) {
                 return EXIT_FAILURE;
             }
         }
+        else if (strcmp(argv[i], "-profile") == 0) {
+            char *end = 0;
+            long lines = 0;
+            if (++i < argc) {
+                errno = 0;
+                lines = strtol(argv[i], &end, 10);
+            }
+            if (end && end != argv[i] && *end == 0 && lines > 0) {
+                profile_lines = (errno == ERANGE || lines > MAX_PROFILE_LINES) ? MAX_PROFILE_LINES : (int)lines;
+            }
+            else {
+                fprintf(stderr, "Missing or invalid number of lines (-profile <n>)\n");
+                return EXIT_FAILURE;
+            }
+        }
         else if (strcmp(argv[i], "-t") == 0) {
             if (++i < argc) {
                 title = argv[i];
@@ -131,15 +248,56 @@ int main(int argc, char *argv[]) {
             }
 
         }
+        else if (argv[i][0] != '-') {
+            input_filename = argv[i];
+        }
     }
 
     baron_desc_t desc = {
-        .allocator = 0
+        .allocator = 0,
+        .cmos = cmos,
+        .profile = profile_lines > 0
     };
 
-    (void)(input_filename);
-    (void)(desc);
+    if (!input_filename) {
+        return EXIT_SUCCESS;
+    }
+
+    // Logs are streamed to their files as the final pass proceeds, rather than being held until the end
+    FILE *log_files[BARON_NUM_LOG_CHANNELS] = {0};
+    if (!open_log_files(log_files, log_filenames, &desc)) {
+        close_log_files(log_files, log_filenames);
+        return EXIT_FAILURE;
+    }
 
+    baron_assembly_t *assembly = baron_assemble_from_file(&desc, input_filename);
+    bool logs_written = close_log_files(log_files, log_filenames);
+    if (!assembly) {
+        fprintf(stderr, "Unable to assemble %s\n", input_filename);
+        return EXIT_FAILURE;
+    }
+
+    fputs(baron_assembly_errors(assembly), stderr);
+    if (stats) {
+        write_stats(stdout, assembly);
+    }
+    int result = (baron_assembly_status(assembly) == 0 && logs_written) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (profile_lines > 0 && !baron_assembly_profile_write(assembly, (size_t)profile_lines, write_to_file, stderr)) {
+        fprintf(stderr, "Failed to write profile\n");
+        result = EXIT_FAILURE;
+    }
+
+    if (result == EXIT_SUCCESS && symbols_filename && !baron_assembly_symbols_save(assembly, symbols_filename)) {
+        fprintf(stderr, "Failed to write symbol file %s\n", symbols_filename);
+        result = EXIT_FAILURE;
+    }
+
+    if (result == EXIT_SUCCESS && (output_ssd || manifest_filename) &&
+        !save_disk_images(assembly, output_ssd, title, opt, manifest_filename)) {
+        result = EXIT_FAILURE;
+    }
 
-    return EXIT_SUCCESS;
+    baron_assembly_destroy(assembly);
+    return result;
 }
@@ -0,0 +1,187 @@
+/**
+ *  @file   manifest.c
+ * 
+ *  Implementation of disk image manifest loading
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "manifest.h"
+
+
+static char *load_text(const char *filename, size_t *length) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        return 0;
+    }
+
+    char *text = 0;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        long size = ftell(file);
+        if (size >= 0 && fseek(file, 0, SEEK_SET) == 0) {
+            text = malloc((size_t)size + 1);
+            if (text && fread(text, 1, (size_t)size, file) == (size_t)size) {
+                text[size] = 0;
+                *length = (size_t)size;
+            }
+            else {
+                free(text);
+                text = 0;
+            }
+        }
+    }
+
+    fclose(file);
+    return text;
+}
+
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+
+// Returns the next token on the line, zero-terminating it in place, or null at the end of the line
+static char *next_token(char **cursor) {
+    char *p = *cursor;
+    while (is_space(*p)) {
+        p++;
+    }
+    if (*p == 0 || *p == ';' || *p == '#') {
+        *cursor = p + strlen(p);
+        return 0;
+    }
+
+    char *token;
+    if (*p == '"') {
+        token = ++p;
+        while (*p && *p != '"') {
+            p++;
+        }
+    }
+    else {
+        token = p;
+        while (*p && !is_space(*p)) {
+            p++;
+        }
+    }
+
+    if (*p) {
+        *p++ = 0;
+    }
+    *cursor = p;
+    return token;
+}
+
+
+static bool parse_digit(const char *token, char max, int *value) {
+    if (token && token[0] >= '0' && token[0] <= max && token[1] == 0) {
+        *value = token[0] - '0';
+        return true;
+    }
+    return false;
+}
+
+
+static bool parse_line(manifest_t *manifest, char *line, const char *filename, int line_number) {
+    char *cursor = line;
+    char *token = next_token(&cursor);
+    if (!token) {
+        return true;
+    }
+
+    manifest_image_t *image = &manifest->images[manifest->num_images++];
+    *image = (manifest_image_t){
+        .filename = token,
+        .files = manifest->files + manifest->num_files
+    };
+
+    int side = 0;
+    while ((token = next_token(&cursor))) {
+        if (strcmp(token, "-t") == 0) {
+            if (!(image->title = next_token(&cursor))) {
+                fprintf(stderr, "%s:%d: Missing disk title (-t <title>)\n", filename, line_number);
+                return false;
+            }
+        }
+        else if (strcmp(token, "-opt") == 0) {
+            if (!parse_digit(next_token(&cursor), '3', &image->opt)) {
+                fprintf(stderr, "%s:%d: Invalid disk option (-opt <0-3>)\n", filename, line_number);
+                return false;
+            }
+        }
+        else if (strcmp(token, "-side") == 0) {
+            if (!parse_digit(next_token(&cursor), '1', &side)) {
+                fprintf(stderr, "%s:%d: Invalid disk side (-side <0-1>)\n", filename, line_number);
+                return false;
+            }
+        }
+        else if (token[0] == '-') {
+            fprintf(stderr, "%s:%d: Unknown option: %s\n", filename, line_number, token);
+            return false;
+        }
+        else {
+            manifest->files[manifest->num_files++] = (manifest_file_t){token, side};
+            image->num_files++;
+        }
+    }
+
+    return true;
+}
+
+
+bool manifest_load(manifest_t *manifest, const char *filename) {
+    *manifest = (manifest_t){0};
+
+    size_t length = 0;
+    char *text = load_text(filename, &length);
+    if (!text) {
+        fprintf(stderr, "Unable to read manifest %s\n", filename);
+        return false;
+    }
+    return manifest_parse(manifest, text, length, filename);
+}
+
+
+bool manifest_parse(manifest_t *manifest, char *text, size_t length, const char *filename) {
+    *manifest = (manifest_t){.text = text};
+
+    // Every token is followed by a separator, so there can be no more than this many of them
+    size_t max_tokens = length / 2 + 1;
+    size_t max_lines = 1;
+    for (size_t i = 0; i < length; i++) {
+        max_lines += (text[i] == '\n');
+    }
+
+    manifest->images = malloc(max_lines * sizeof(manifest_image_t));
+    manifest->files = malloc(max_tokens * sizeof(manifest_file_t));
+    if (!manifest->images || !manifest->files) {
+        fprintf(stderr, "Out of memory\n");
+        manifest_free(manifest);
+        return false;
+    }
+
+    char *line = text;
+    for (int line_number = 1; line; line_number++) {
+        char *next_line = strchr(line, '\n');
+        if (next_line) {
+            *next_line++ = 0;
+        }
+        if (!parse_line(manifest, line, filename, line_number)) {
+            manifest_free(manifest);
+            return false;
+        }
+        line = next_line;
+    }
+
+    return true;
+}
+
+
+void manifest_free(manifest_t *manifest) {
+    free(manifest->text);
+    free(manifest->images);
+    free(manifest->files);
+    *manifest = (manifest_t){0};
+}
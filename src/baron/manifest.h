@@ -0,0 +1,85 @@
+/**
+ *  @file   manifest.h
+ * 
+ *  Loading of disk image manifests, which describe a number of disk images to be built from a single assembly.
+ * 
+ *  Each non-empty line of a manifest describes one disk image, using the same options as the command line:
+ * 
+ *    <image filename> [-t <title>] [-opt <0-3>] [-side <0-1>] [<file>]...
+ * 
+ *  Files are named by the overlays they were saved from. -side applies to the files which follow it, and
+ *  is only valid for double-sided (.dsd) images. Titles containing spaces may be quoted with "".
+ *  Text following ; or # at the start of a token is a comment.
+ */
+
+#ifndef BARON_MANIFEST_H_
+#define BARON_MANIFEST_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct manifest_t manifest_t;
+typedef struct manifest_image_t manifest_image_t;
+typedef struct manifest_file_t manifest_file_t;
+
+
+struct manifest_file_t {
+    const char *name;
+    int side;
+};
+
+
+struct manifest_image_t {
+    const char *filename;
+    const char *title;
+    int opt;
+    const manifest_file_t *files;
+    size_t num_files;
+};
+
+
+struct manifest_t {
+    char *text;
+    manifest_image_t *images;
+    size_t num_images;
+    manifest_file_t *files;
+    size_t num_files;
+};
+
+
+/**
+ *  Load and parse a manifest file.
+ *  Any errors are reported to stderr.
+ * 
+ *  @param  manifest        Pointer to the manifest to fill in
+ *  @param  filename        Zero-terminated filename of the manifest
+ * 
+ *  @return Success true/false
+ */
+bool manifest_load(manifest_t *manifest, const char *filename);
+
+
+/**
+ *  Parse the text of a manifest.
+ *  Any errors are reported to stderr.
+ *
+ *  @param  manifest        Pointer to the manifest to fill in
+ *  @param  text            Zero-terminated text allocated with malloc, which the manifest takes ownership of, even on
+ *                          failure; it is modified in place, and the manifest's strings point into it
+ *  @param  length          Length of the text
+ *  @param  filename        Filename of the manifest, used in error messages
+ *
+ *  @return Success true/false
+ */
+bool manifest_parse(manifest_t *manifest, char *text, size_t length, const char *filename);
+
+
+/**
+ *  Free all allocations made by a manifest
+ * 
+ *  @param  manifest        Pointer to the manifest to free
+ */
+void manifest_free(manifest_t *manifest);
+
+
+#endif // ifndef BARON_MANIFEST_H_
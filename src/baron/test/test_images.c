@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "base/test.h"
+#include "images.h"
+
+#define NUM_JOBS 12
+
+
+static const uint8_t code[256] = {0xA9, 0x00, 0x60};
+
+static const baron_disk_file_t saved_files[] = {
+    {.name = "LOADER", .load_address = 0x1900, .exec_address = 0x1900, .object_code = {code, 3}},
+    {.name = "CODE", .load_address = 0x2000, .exec_address = 0x2000, .object_code = {code, 256}},
+    {.name = "D.LEVEL", .load_address = 0x3000, .exec_address = 0x3000, .object_code = {code, 100}}
+};
+
+#define NUM_SAVED_FILES (sizeof saved_files / sizeof saved_files[0])
+
+
+DEF_TEST(images, double_sided_filename) {
+    REQUIRE_TRUE(is_double_sided_filename("game.dsd"));
+    REQUIRE_TRUE(is_double_sided_filename("GAME.DSD"));
+    REQUIRE_TRUE(is_double_sided_filename(".dsd"));
+    REQUIRE_FALSE(is_double_sided_filename("game.ssd"));
+    REQUIRE_FALSE(is_double_sided_filename("dsd"));
+    REQUIRE_FALSE(is_double_sided_filename("game.dsdx"));
+}
+
+DEF_TEST(images, init_job) {
+    // Without a manifest entry, every saved file is written
+    disk_image_job_t job;
+    REQUIRE_TRUE(init_disk_image_job(&job, "all.ssd", "ALL", 2, saved_files, NUM_SAVED_FILES, 0));
+    REQUIRE(job.desc.num_files,==,NUM_SAVED_FILES);
+    REQUIRE(job.desc.boot_option,==,2);
+    REQUIRE_FALSE(job.desc.double_sided);
+    REQUIRE(make_strview(job.desc.files[2].name),==,STRVIEW("D.LEVEL"));
+    free(job.files);
+
+    // A manifest entry selects saved files by name, in its own order, and gives each its side
+    const manifest_file_t files[] = {{"D.LEVEL", 1}, {"LOADER", 0}};
+    const manifest_image_t image = {.filename = "game.dsd", .title = "GAME", .opt = 3, .files = files, .num_files = 2};
+    REQUIRE_TRUE(init_disk_image_job(&job, image.filename, image.title, image.opt, saved_files, NUM_SAVED_FILES, &image));
+    REQUIRE_TRUE(job.desc.double_sided);
+    REQUIRE(job.desc.num_files,==,2);
+    REQUIRE(make_strview(job.desc.files[0].name),==,STRVIEW("D.LEVEL"));
+    REQUIRE(job.desc.files[0].side,==,1);
+    REQUIRE(job.desc.files[0].object_code.size,==,100);
+    REQUIRE(make_strview(job.desc.files[1].name),==,STRVIEW("LOADER"));
+    REQUIRE(job.desc.files[1].side,==,0);
+    free(job.files);
+
+    const manifest_file_t missing[] = {{"CODE", 0}, {"MUSIC", 0}};
+    const manifest_image_t bad_image = {.filename = "bad.ssd", .files = missing, .num_files = 2};
+    REQUIRE_FALSE(init_disk_image_job(&job, bad_image.filename, 0, 0, saved_files, NUM_SAVED_FILES, &bad_image));
+    free(job.files);
+}
+
+DEF_TEST(images, write_concurrently) {
+    // More jobs than threads, every other one failing, so that the queue is shared and statuses kept apart
+    char filenames[NUM_JOBS][32];
+    disk_image_job_t jobs[NUM_JOBS];
+    const manifest_file_t files[] = {{"CODE", 0}, {"LOADER", 1}};
+    const manifest_image_t image = {.files = files, .num_files = 2};
+    for (int i = 0; i < NUM_JOBS; i++) {
+        snprintf(filenames[i], sizeof filenames[i], "test_image_%d.%s", i, (i & 1) ? "ssd" : "dsd");
+        REQUIRE_TRUE(init_disk_image_job(&jobs[i], filenames[i], "TEST", 0, saved_files, NUM_SAVED_FILES, &image));
+    }
+
+    write_disk_images(jobs, NUM_JOBS);
+
+    bool success = true;
+    for (int i = 0; i < NUM_JOBS; i++) {
+        // Side 1 is only valid on a double-sided image
+        baron_disk_image_status_t expected = (i & 1) ? baron_disk_image_invalid_desc : baron_disk_image_ok;
+        success = success && jobs[i].status == expected;
+
+        FILE *file = fopen(filenames[i], "rb");
+        long size = 0;
+        if (file) {
+            fseek(file, 0, SEEK_END);
+            size = ftell(file);
+            fclose(file);
+        }
+        success = success && ((i & 1) || size > 0);
+
+        free(jobs[i].files);
+        remove(filenames[i]);
+    }
+    REQUIRE_TRUE(success);
+}
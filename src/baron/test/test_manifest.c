@@ -0,0 +1,106 @@
+#include <stdlib.h>
+#include <string.h>
+#include "base/test.h"
+#include "base/str.h"
+#include "manifest.h"
+
+
+// Parses a manifest from a copy of the given text
+static bool parse(manifest_t *manifest, const char *text) {
+    size_t length = strlen(text);
+    char *copy = malloc(length + 1);
+    if (!copy) {
+        return false;
+    }
+    memcpy(copy, text, length + 1);
+    return manifest_parse(manifest, copy, length, "test.manifest");
+}
+
+
+DEF_TEST(manifest, images) {
+    manifest_t manifest;
+    REQUIRE_TRUE(parse(&manifest,
+        "; Disks for the release\n"
+        "game.ssd -t \"Spin Cube\" -opt 3 LOADER CODE  # boots the loader\n"
+        "\n"
+        "   \t\r\n"
+        "data.dsd -side 1 LEVELS -side 0 MUSIC -t DATA\n"
+        "empty.ssd\n"));
+
+    REQUIRE(manifest.num_images,==,3);
+    REQUIRE(manifest.num_files,==,4);
+
+    const manifest_image_t *game = &manifest.images[0];
+    REQUIRE(make_strview(game->filename),==,STRVIEW("game.ssd"));
+    REQUIRE(make_strview(game->title),==,STRVIEW("Spin Cube"));
+    REQUIRE(game->opt,==,3);
+    REQUIRE(game->num_files,==,2);
+    REQUIRE(make_strview(game->files[0].name),==,STRVIEW("LOADER"));
+    REQUIRE(make_strview(game->files[1].name),==,STRVIEW("CODE"));
+    REQUIRE(game->files[1].side,==,0);
+
+    // -side applies to the files which follow it
+    const manifest_image_t *data = &manifest.images[1];
+    REQUIRE(make_strview(data->title),==,STRVIEW("DATA"));
+    REQUIRE(data->opt,==,0);
+    REQUIRE(data->num_files,==,2);
+    REQUIRE(make_strview(data->files[0].name),==,STRVIEW("LEVELS"));
+    REQUIRE(data->files[0].side,==,1);
+    REQUIRE(make_strview(data->files[1].name),==,STRVIEW("MUSIC"));
+    REQUIRE(data->files[1].side,==,0);
+
+    const manifest_image_t *empty = &manifest.images[2];
+    REQUIRE(make_strview(empty->filename),==,STRVIEW("empty.ssd"));
+    REQUIRE_TRUE(empty->title == 0);
+    REQUIRE(empty->num_files,==,0);
+
+    manifest_free(&manifest);
+    REQUIRE_TRUE(manifest.images == 0);
+}
+
+DEF_TEST(manifest, empty) {
+    manifest_t manifest;
+    REQUIRE_TRUE(parse(&manifest, ""));
+    REQUIRE(manifest.num_images,==,0);
+    manifest_free(&manifest);
+
+    REQUIRE_TRUE(parse(&manifest, "# nothing but comments\n; and blank lines\n\n"));
+    REQUIRE(manifest.num_images,==,0);
+    manifest_free(&manifest);
+}
+
+DEF_TEST(manifest, quoting) {
+    manifest_t manifest;
+
+    // A quoted token may be empty, and an unterminated quote runs to the end of the line
+    REQUIRE_TRUE(parse(&manifest, "a.ssd -t \"\" CODE\nb.ssd -t \"No end CODE\nc.ssd \"A B\"\n"));
+    REQUIRE(manifest.num_images,==,3);
+    REQUIRE(make_strview(manifest.images[0].title),==,STRVIEW(""));
+    REQUIRE(manifest.images[0].num_files,==,1);
+    REQUIRE(make_strview(manifest.images[1].title),==,STRVIEW("No end CODE"));
+    REQUIRE(manifest.images[1].num_files,==,0);
+    REQUIRE(make_strview(manifest.images[2].files[0].name),==,STRVIEW("A B"));
+    manifest_free(&manifest);
+}
+
+DEF_TEST(manifest, errors) {
+    static const char *const bad[] = {
+        "a.ssd -opt\n",
+        "a.ssd -opt 4\n",
+        "a.ssd -opt 12\n",
+        "a.ssd -side 2 CODE\n",
+        "a.ssd -side x CODE\n",
+        "a.ssd -t\n",
+        "good.ssd CODE\nbad.ssd -boot 1\n"
+    };
+
+    for (size_t i = 0; i < sizeof bad / sizeof bad[0]; i++) {
+        manifest_t manifest;
+        REQUIRE_FALSE(parse(&manifest, bad[i]));
+        REQUIRE_TRUE(manifest.text == 0 && manifest.images == 0 && manifest.files == 0);
+    }
+
+    manifest_t manifest;
+    REQUIRE_FALSE(manifest_load(&manifest, "no such manifest"));
+    REQUIRE_TRUE(manifest.text == 0);
+}
@@ -0,0 +1,149 @@
+/**
+ *  @file   generate.c
+ *
+ *  Generators of synthetic sources for the benchmarks
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include "base/allocator.h"
+#include "base/defines.h"
+#include "generate.h"
+
+
+#define NUM_MACROS 200
+#define MACRO_CALLS_PER_SCALE 10000
+#define TABLES_PER_SCALE 16
+#define LABELS_PER_SCALE 5000
+#define OVERLAYS_PER_SCALE 64
+#define BINARY_FILES_PER_SCALE 8
+#define BINARY_FILE_SIZE 0x8000
+#define BINARY_FILE_NAME_SIZE 16
+
+
+static bool source_printf(bench_source_t *source, const char *format, ...) {
+    va_list args, args_copy;
+    va_start(args, format);
+    va_copy(args_copy, args);
+    int length = vsnprintf(0, 0, format, args_copy);
+    va_end(args_copy);
+
+    // Room is reserved for vsnprintf's zero terminator, which is not counted in the size
+    bool success = length >= 0 && array_reserve(&source->text, source->text.size + (uint32_t)length + 1);
+    if (success) {
+        vsnprintf(source->text.data + source->text.size, (size_t)length + 1, format, args);
+        source->text.size += (uint32_t)length;
+    }
+    va_end(args);
+    return success;
+}
+
+
+bench_source_t make_bench_source(const allocator_t *allocator) {
+    return (bench_source_t){
+        .text = make_array(char, allocator, 0x10000),
+        .names = make_array(char, allocator, 256),
+        .data = make_array(uint8_t, allocator, 256),
+        .files = make_array(baron_memory_file_t, allocator, 16)
+    };
+}
+
+
+void bench_source_deinit(bench_source_t *source) {
+    ASSERT(source);
+    array_deinit(&source->text);
+    array_deinit(&source->names);
+    array_deinit(&source->data);
+    array_deinit(&source->files);
+}
+
+
+bool generate_macros(bench_source_t *source, uint32_t scale) {
+    bool success = true;
+    for (uint32_t i = 0; success && i < NUM_MACROS; i++) {
+        success = source_printf(source,
+            "MACRO fill%u addr, value\n"
+            "    LDA #value : STA addr\n"
+            "    LDA #(value + %u) AND &FF : STA addr + 1\n"
+            "    EQUW addr, (addr + value) AND &FFFF\n"
+            "ENDMACRO\n", i, i);
+    }
+    for (uint32_t i = 0; success && i < MACRO_CALLS_PER_SCALE * scale; i++) {
+        success = source_printf(source, "fill%u &%04X, %u\n", (i * 7) % NUM_MACROS, 0x70 + (i & 0x7FFF), i & 0xFF);
+    }
+    return success;
+}
+
+
+bool generate_for_tables(bench_source_t *source, uint32_t scale) {
+    bool success = true;
+    for (uint32_t i = 0; success && i < TABLES_PER_SCALE * scale; i++) {
+        success = source_printf(source,
+            "FOR i, 0, 1023 : EQUB (i * %u + %u) AND &FF : EQUW &8000 + i * 2 : NEXT\n"
+            "FOR y, 0, 31 : FOR x, 0, 39 : EQUB (x + y * 40) AND &FF : NEXT : NEXT\n"
+            "FOR i, 0, 4095 : EQUB &%02X : NEXT\n", i * 2 + 1, i, i & 0xFF);
+    }
+    return success;
+}
+
+
+bool generate_labels(bench_source_t *source, uint32_t scale) {
+    bool success = true;
+    for (uint32_t i = 0; success && i < LABELS_PER_SCALE * scale; i++) {
+        success = source_printf(source,
+            "sprite_frame_%u = &%04X\n"
+            ".draw_sprite_%u\n"
+            "    LDA #%u : STA &70 : JSR draw\n", i, 0x3000 + (i & 0x3FFF), i, i & 0xFF);
+    }
+    return success;
+}
+
+
+bool generate_overlays(bench_source_t *source, uint32_t scale) {
+    bool success = true;
+    for (uint32_t i = 0; success && i < OVERLAYS_PER_SCALE * scale; i++) {
+        // Overlays are 256 bytes long but only 128 bytes apart, so each overlaps the next
+        success = source_printf(source,
+            "OVERLAY \"ov%u\"\n"
+            "ORG &%04X\n"
+            "FOR i, 0, 255 : EQUB (i + %u) AND &FF : NEXT\n"
+            "SAVE\n", i, 0x1900 + (i * 0x80) % 0x6000, i);
+    }
+    return success;
+}
+
+
+bool generate_incbins(bench_source_t *source, uint32_t scale) {
+    uint32_t num_files = BINARY_FILES_PER_SCALE * scale;
+    uint32_t first_file = source->files.size;
+    uint32_t first_name = source->names.size;
+    uint32_t first_data = source->data.size;
+    if (!array_resize(&source->names, first_name + num_files * BINARY_FILE_NAME_SIZE) ||
+        !array_resize(&source->data, first_data + num_files * BINARY_FILE_SIZE)) {
+        return false;
+    }
+
+    // A xorshift generator fills the files with data which doesn't compress or repeat
+    uint32_t state = 0x12345678;
+    for (uint32_t i = first_data; i < source->data.size; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        source->data.data[i] = (uint8_t)state;
+    }
+
+    // Names and data are complete, so the memory files can refer to them directly
+    bool success = true;
+    for (uint32_t i = 0; success && i < num_files; i++) {
+        char *name = source->names.data + first_name + i * BINARY_FILE_NAME_SIZE;
+        snprintf(name, BINARY_FILE_NAME_SIZE, "data%u.bin", first_file + i);
+        baron_memory_file_t file = {name, source->data.data + first_data + i * BINARY_FILE_SIZE, BINARY_FILE_SIZE};
+        success = array_add(&source->files, file);
+    }
+
+    // Every file is included twice, the second time from the cache
+    for (uint32_t i = 0; success && i < num_files * 2; i++) {
+        success = source_printf(source, "INCBIN \"data%u.bin\"\n", first_file + i % num_files);
+    }
+    return success;
+}
@@ -0,0 +1,83 @@
+/**
+ *  @file   generate.h
+ *
+ *  Generators of large synthetic sources for the benchmarks, each stressing one part of the assembler.
+ *  Sources are deterministic for a given scale, so timings can be compared between builds.
+ */
+
+#ifndef BARON_BENCH_GENERATE_H_
+#define BARON_BENCH_GENERATE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "base/array.h"
+#include "baron/baron.h"
+
+typedef struct bench_source_t bench_source_t;
+typedef struct allocator_t allocator_t;
+
+def_slice(baron_memory_file_t);
+
+
+struct bench_source_t {
+    array_char text;
+    array_char names;                   // Zero-terminated names of the binary files, back to back
+    array_uint8_t data;                 // Contents of the binary files, back to back
+    array_baron_memory_file_t files;    // Binary files named by INCBIN, referencing names and data
+};
+
+
+/**
+ *  Function which appends a generated source, and any binary files it includes, to a bench_source_t
+ *
+ *  @param  source          Pointer to the source to append to
+ *  @param  scale           Multiplier of the amount of source generated; 1 takes a few milliseconds to process
+ *
+ *  @return Success true/false
+ */
+typedef bool (*generate_fn_t)(bench_source_t *source, uint32_t scale);
+
+
+/**
+ *  Make an empty source
+ */
+bench_source_t make_bench_source(const allocator_t *allocator);
+
+
+/**
+ *  Deinitialize a source, freeing its allocations
+ */
+void bench_source_deinit(bench_source_t *source);
+
+
+/**
+ *  Many macros with several parameters, each invoked many times
+ */
+bool generate_macros(bench_source_t *source, uint32_t scale);
+
+
+/**
+ *  Huge FOR..NEXT tables, including nested loops and loops with invariant bodies
+ */
+bool generate_for_tables(bench_source_t *source, uint32_t scale);
+
+
+/**
+ *  Thousands of labels and constants
+ */
+bool generate_labels(bench_source_t *source, uint32_t scale);
+
+
+/**
+ *  Many small overlays, each saved at its own address, some of them overlapping
+ */
+bool generate_overlays(bench_source_t *source, uint32_t scale);
+
+
+/**
+ *  Large binary files included with INCBIN, some of them more than once
+ */
+bool generate_incbins(bench_source_t *source, uint32_t scale);
+
+
+#endif // ifndef BARON_BENCH_GENERATE_H_
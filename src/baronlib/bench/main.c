@@ -0,0 +1,596 @@
+/**
+ *  @file   main.c
+ *
+ *  Benchmarks of baronlib over large synthetic sources.
+ *
+ *  Each scenario generates a source stressing one part of the assembler, and times the phases of assembling it:
+ *  lexing, the pass over the tokens, emission (completing the assembly: the memory map and overlap checks), and
+ *  output (disk image, symbol export and logs). The number of allocations and bytes requested in each phase are
+ *  counted too, by a tracker under the assembly's allocator. The best time of several runs is reported, so that
+ *  results are stable enough to compare between releases. With -track, the tracker's report for the last run is
+ *  printed too: a histogram of allocation sizes, and the allocations made in each phase and whether any are leaked.
+ *
+ *  The pass is driven here, statement by statement, through the same modules the assembler uses: the loop compiler,
+ *  the macro table, the symbol table, overlays and the file system. Instructions outside loops and macro expansions
+ *  are not yet assembled by baronlib, so they are only counted.
+ *
+ *  The find benchmark times strview_find_first and strview_find_last over a long haystack, against the bytewise
+ *  searches they replaced.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "base/allocator.h"
+#include "base/defines.h"
+#include "base/tracker.h"
+#include "assembly.h"
+#include "generate.h"
+#include "lexer.h"
+#include "loop.h"
+#include "macro.h"
+#include "stats.h"
+
+
+#define DEFAULT_NUM_RUNS 5
+#define FIND_HAYSTACK_SIZE 0x100000
+#define FIND_ITERATIONS 50
+#define MAX_MACRO_PARAMS 8
+
+
+typedef enum phase_t {
+    phase_lex,
+    phase_pass,
+    phase_emission,
+    phase_output,
+    num_phases
+} phase_t;
+
+static const char *const phase_names[num_phases] = {"lex", "pass", "emission", "output"};
+
+
+typedef struct scenario_t scenario_t;
+typedef struct measurement_t measurement_t;
+typedef struct bench_t bench_t;
+
+struct scenario_t {
+    const char *name;
+    generate_fn_t generate;
+};
+
+static const scenario_t scenarios[] = {
+    {"macros", generate_macros},
+    {"for_tables", generate_for_tables},
+    {"labels", generate_labels},
+    {"overlays", generate_overlays},
+    {"incbins", generate_incbins}
+};
+
+#define NUM_SCENARIOS (sizeof scenarios / sizeof scenarios[0])
+
+
+struct measurement_t {
+    double seconds;
+    uint64_t num_allocations;
+    uint64_t bytes_requested;
+};
+
+
+struct bench_t {
+    baron_assembly_t *assembly;
+    array_token_t tokens;
+    macro_table_t macros;
+    array_token_t expansion;        // Tokens of the macro invocation being expanded
+    uint32_t overlay_index;
+    uint32_t org;                   // Address of the start of the current overlay
+    uint32_t pc;
+    uint64_t num_statements;
+    const char *error;
+    uint32_t error_line;
+};
+
+
+static bool fail(bench_t *bench, const char *error, uint32_t line) {
+    bench->error = error;
+    bench->error_line = line;
+    return false;
+}
+
+
+// Returns the index of the token which ends the statement starting at index
+static uint32_t statement_end(const bench_t *bench, uint32_t index) {
+    const token_t *tokens = bench->tokens.data;
+    while (tokens[index].type != token_end_of_statement && tokens[index].type != token_end_of_file) {
+        index++;
+    }
+    return index;
+}
+
+
+// Loop bodies in the generated sources only refer to their loop variables
+static uint32_t resolve_none(strview_t name, void *context) {
+    UNUSED(name);
+    UNUSED(context);
+    return invalid_index;
+}
+
+
+static bool run_for(bench_t *bench, uint32_t *index) {
+    baron_assembly_t *assembly = bench->assembly;
+    slice_const_token_t tokens = {bench->tokens.data + *index, bench->tokens.size - *index};
+    loop_t loop;
+    loop_result_t result = loop_compile(&loop, assembly_allocator(assembly, baron_memory_other), tokens, assembly->opcodes, resolve_none, 0, 0);
+    if (!result.error) {
+        double values[LOOP_MAX_DEPTH];
+        array_uint8_t *object_code = &assembly->overlays.data[bench->overlay_index].object_code;
+        result = loop_run(&loop, values, object_code, &bench->pc, &assembly->budget, assembly_profile(assembly));
+        assembly->stats.expressions_evaluated += result.num_evaluations;
+        *index += loop.length;
+    }
+    loop_deinit(&loop);
+    return !result.error || fail(bench, result.error, result.line);
+}
+
+
+static bool define_macro(bench_t *bench, uint32_t *index) {
+    token_t *tokens = bench->tokens.data;
+    uint32_t line = tokens[*index].line;
+    uint32_t i = *index + 1;
+    if (tokens[i].type != token_identifier) {
+        return fail(bench, "Expected macro name", line);
+    }
+    strview_t name = tokens[i++].text;
+
+    strview_t params[MAX_MACRO_PARAMS];
+    uint32_t num_params = 0;
+    while (tokens[i].type == token_identifier && num_params < MAX_MACRO_PARAMS) {
+        params[num_params++] = tokens[i++].text;
+        if (token_is_symbol(&tokens[i], STRVIEW(","))) {
+            i++;
+        }
+    }
+
+    uint32_t body_start = i;
+    while (tokens[i].type != token_end_of_file && !token_is_keyword(&tokens[i], STRVIEW("ENDMACRO"))) {
+        i++;
+    }
+    if (tokens[i].type == token_end_of_file) {
+        return fail(bench, "MACRO without ENDMACRO", line);
+    }
+
+    // The body is given its own terminator in place of ENDMACRO
+    token_t endmacro = tokens[i];
+    tokens[i].type = token_end_of_file;
+    macro_t macro;
+    bool success = macro_init(&macro, assembly_allocator(bench->assembly, baron_memory_other), name, (slice_const_strview_t){params, num_params},
+                              (slice_const_token_t){tokens + body_start, i - body_start + 1}) &&
+                   macro_table_add(&bench->macros, &macro, MACRO_ANY_MODE);
+    tokens[i] = endmacro;
+    *index = i + 1;
+    return success || fail(bench, "Failed to define macro", line);
+}
+
+
+static bool expand_macro(bench_t *bench, const macro_t *macro, uint32_t *index) {
+    uint32_t end = statement_end(bench, *index);
+    slice_const_token_t call_args = {bench->tokens.data + *index + 1, end - *index - 1};
+    slice_const_token_t args[MAX_MACRO_PARAMS];
+    uint32_t line = bench->tokens.data[*index].line;
+    *index = end;
+    if (macro->num_params > MAX_MACRO_PARAMS || !macro_bind(macro, call_args, args)) {
+        return fail(bench, "Wrong number of macro arguments", line);
+    }
+
+    // Substitute the arguments into each statement of the body, as expansion will
+    array_reset(&bench->expansion);
+    const token_t terminator = {.type = token_end_of_statement, .line = line};
+    profile_t *profile = assembly_profile(bench->assembly);
+    for (uint32_t i = 0; i < macro->statements.size; i++) {
+        slice_const_token_t statement = macro_statement(macro, i);
+        if (profile && statement.size > 0) {
+            profile_count(profile, statement.data[0].line, 1, 0);
+        }
+        for (uint32_t j = 0; j < statement.size; j++) {
+            const token_t *token = &statement.data[j];
+            bool success = (token->type == token_param) ? array_append(&bench->expansion, args[token->slot])
+                                                        : array_add(&bench->expansion, *token);
+            if (!success) {
+                return fail(bench, "Out of memory", line);
+            }
+        }
+        if (!array_add(&bench->expansion, terminator)) {
+            return fail(bench, "Out of memory", line);
+        }
+    }
+    bench->num_statements += macro->statements.size;
+    bench->assembly->stats.macro_expansions++;
+    return true;
+}
+
+
+static bool run_statement(bench_t *bench, uint32_t *index) {
+    baron_assembly_t *assembly = bench->assembly;
+    const token_t *token = &bench->tokens.data[*index];
+    bench->num_statements++;
+
+    if (token_is_keyword(token, STRVIEW("FOR"))) {
+        return run_for(bench, index);
+    }
+
+    // Loops profile their own lines
+    profile_t *profile = assembly_profile(assembly);
+    if (profile) {
+        profile_count(profile, token->line, 1, 0);
+    }
+    if (token_is_keyword(token, STRVIEW("MACRO"))) {
+        return define_macro(bench, index);
+    }
+
+    bool success = true;
+    if (token_is_keyword(token, STRVIEW("OVERLAY")) && token[1].type == token_string) {
+        bench->overlay_index = assembly_find_overlay(assembly, token[1].text);
+        if (bench->overlay_index == invalid_index) {
+            bench->overlay_index = assembly_add_overlay(assembly, token[1].text);
+        }
+        success = bench->overlay_index != invalid_index;
+    }
+    else if (token_is_keyword(token, STRVIEW("ORG")) && token[1].type == token_number) {
+        bench->org = bench->pc = (uint32_t)token[1].number;
+    }
+    else if (token_is_keyword(token, STRVIEW("SAVE"))) {
+        assembly_save_overlay(assembly, bench->overlay_index, bench->org, bench->org);
+    }
+    else if (token_is_keyword(token, STRVIEW("INCBIN")) && token[1].type == token_string) {
+        strview_t contents = vfs_load(&assembly->files, token[1].text);
+        if (!strview_is_valid(contents)) {
+            return fail(bench, "Couldn't load INCBIN file", token->line);
+        }
+        array_uint8_t *object_code = &assembly->overlays.data[bench->overlay_index].object_code;
+        success = array_append(object_code, ((slice_const_uint8_t){contents.data, contents.length}));
+        bench->pc += contents.length;
+    }
+    else if (token->type == token_identifier && token_is_symbol(&token[1], STRVIEW("=")) && token[2].type == token_number) {
+        success = symtab_set(&assembly->symbols, token->text, make_number_value(token[2].number));
+    }
+    else if (token_is_symbol(token, STRVIEW(".")) && token[1].type == token_identifier) {
+        success = symtab_set(&assembly->symbols, token[1].text, make_number_value(bench->pc));
+    }
+    else if (token->type == token_identifier) {
+        const macro_table_entry_t *entry = macro_table_find(&bench->macros, token->text);
+        if (entry) {
+            return expand_macro(bench, macro_table_resolve(&bench->macros, entry, addr_mode_absolute), index);
+        }
+    }
+
+    *index = statement_end(bench, *index);
+    return success || fail(bench, "Out of memory", token->line);
+}
+
+
+static bool run_pass(bench_t *bench) {
+    uint32_t index = 0;
+    while (bench->tokens.data[index].type != token_end_of_file) {
+        if (bench->tokens.data[index].type == token_end_of_statement) {
+            index++;
+        }
+        else if (!run_statement(bench, &index)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+static bool count_bytes(const void *data, size_t size, void *context) {
+    UNUSED(data);
+    *(uint64_t *)context += size;
+    return true;
+}
+
+
+static bool write_output(baron_assembly_t *assembly) {
+    // Only the first saved overlays are written, as many as fit on one side of a disk
+    baron_disk_file_t files[31];
+    size_t num_files = baron_assembly_disk_files(assembly, files, 31);
+    num_files = (num_files < 31) ? num_files : 31;
+    baron_disk_image_desc_t desc = {.title = "BENCH", .files = files, .num_files = num_files};
+    uint64_t size = 0;
+    bool success = (num_files == 0 || baron_disk_image_write(&desc, count_bytes, &size) == baron_disk_image_ok) &&
+                   baron_assembly_symbols_write(assembly, count_bytes, &size);
+    for (int i = 0; success && i < BARON_NUM_LOG_CHANNELS; i++) {
+        success = baron_assembly_log(assembly, i) != 0;
+    }
+    return success && baron_assembly_memory_map(assembly) != 0;
+}
+
+
+static uint64_t num_allocations(const tracker_t *tracker) {
+    return tracker->totals.num_allocs + tracker->totals.num_reallocs;
+}
+
+
+static void begin_phase(tracker_t *tracker, measurement_t measurements[num_phases], phase_t phase) {
+    tracker_set_tag(tracker, phase_names[phase]);
+    measurements[phase] = (measurement_t){stats_now(), num_allocations(tracker), tracker->totals.bytes_requested};
+}
+
+
+static void end_phase(const tracker_t *tracker, measurement_t *measurement) {
+    measurement->seconds = stats_now() - measurement->seconds;
+    measurement->num_allocations = num_allocations(tracker) - measurement->num_allocations;
+    measurement->bytes_requested = tracker->totals.bytes_requested - measurement->bytes_requested;
+}
+
+
+static bool write_to_stdout(const void *data, size_t size, void *context) {
+    UNUSED(context);
+    return fwrite(data, 1, size, stdout) == size;
+}
+
+
+/**
+ *  Generate and assemble a scenario's source, timing each phase.
+ *  If profile_lines is nonzero, the assembly is profiled and a report of that many of its hottest lines is printed.
+ *  Every allocation made for the assembly is tracked by tracker, tagged with its phase.
+ */
+static bool run_scenario(const scenario_t *scenario, uint32_t scale, size_t profile_lines, tracker_t *tracker,
+                         measurement_t measurements[num_phases], uint64_t *num_statements) {
+    bench_source_t source = make_bench_source(allocator_default());
+    if (!scenario->generate(&source, scale)) {
+        bench_source_deinit(&source);
+        fprintf(stderr, "%s: failed to generate source\n", scenario->name);
+        return false;
+    }
+
+    tracker_set_tag(tracker, "setup");
+    allocator_t tracking_allocator = tracker_allocator(tracker);
+    const baron_allocator_t allocator = make_baron_allocator(&tracking_allocator);
+    baron_desc_t desc = {
+        .allocator = &allocator,
+        .file_system = {.files = source.files.data, .num_files = source.files.size},
+        .profile = profile_lines > 0
+    };
+
+    bench_t bench = {.assembly = assembly_create(&desc)};
+    bool success = bench.assembly != 0;
+    if (success) {
+        const allocator_t *other = assembly_allocator(bench.assembly, baron_memory_other);
+        bench.tokens = make_array(token_t, other, 0x1000);
+        bench.expansion = make_array(token_t, other, 64);
+        success = array_is_valid(&bench.tokens) && array_is_valid(&bench.expansion) &&
+                  macro_table_init(&bench.macros, other) &&
+                  (profile_lines == 0 || profile_enter_file(&bench.assembly->profile, make_strview(scenario->name)));
+    }
+
+    if (success) {
+        begin_phase(tracker, measurements, phase_lex);
+        lex_result_t result = assembly_lex(bench.assembly, (strview_t){(const uint8_t *)source.text.data, source.text.size}, &bench.tokens);
+        end_phase(tracker, &measurements[phase_lex]);
+        success = !result.error || fail(&bench, result.error, result.line);
+    }
+    if (success) {
+        begin_phase(tracker, measurements, phase_pass);
+        assembly_begin_pass(bench.assembly, true);
+        success = run_pass(&bench);
+        assembly_end_pass(bench.assembly);
+        end_phase(tracker, &measurements[phase_pass]);
+    }
+    if (success) {
+        begin_phase(tracker, measurements, phase_emission);
+        success = assembly_finish(bench.assembly) || fail(&bench, "Failed to finish assembly", 0);
+        end_phase(tracker, &measurements[phase_emission]);
+    }
+    if (success) {
+        begin_phase(tracker, measurements, phase_output);
+        success = write_output(bench.assembly) || fail(&bench, "Failed to write output", 0);
+        end_phase(tracker, &measurements[phase_output]);
+    }
+    tracker_set_tag(tracker, "teardown");
+    if (success && profile_lines > 0) {
+        success = baron_assembly_profile_write(bench.assembly, profile_lines, write_to_stdout, 0) && puts("") >= 0;
+    }
+
+    if (bench.error) {
+        fprintf(stderr, "%s: line %u: %s\n", scenario->name, bench.error_line, bench.error);
+    }
+    else if (!success) {
+        fprintf(stderr, "%s: out of memory\n", scenario->name);
+    }
+    // Statements executed by loops are counted by the budget
+    *num_statements = bench.num_statements + (bench.assembly ? bench.assembly->budget.steps : 0);
+
+    if (bench.assembly) {
+        macro_table_deinit(&bench.macros);
+        array_deinit(&bench.expansion);
+        array_deinit(&bench.tokens);
+        assembly_destroy(bench.assembly);
+    }
+    bench_source_deinit(&source);
+    return success;
+}
+
+
+static uint32_t naive_find_first(strview_t a, strview_t b) {
+    for (uint32_t i = 0; i + b.length <= a.length; i++) {
+        if (memcmp(a.data + i, b.data, b.length) == 0) {
+            return i;
+        }
+    }
+    return invalid_index;
+}
+
+
+static uint32_t naive_find_last(strview_t a, strview_t b) {
+    for (uint32_t i = (a.length >= b.length) ? a.length - b.length + 1 : 0; i-- > 0; ) {
+        if (memcmp(a.data + i, b.data, b.length) == 0) {
+            return i;
+        }
+    }
+    return invalid_index;
+}
+
+
+/**
+ *  Time searches which must scan the whole of a path-like haystack, with the strview functions and the bytewise
+ *  searches they replaced, printing the best time of each
+ */
+static bool run_find_benchmark(uint32_t scale, uint32_t num_runs) {
+    typedef uint32_t (*find_fn_t)(strview_t, strview_t);
+    static const struct {
+        const char *name;
+        find_fn_t find;
+    } searches[] = {
+        {"first", strview_find_first},
+        {"last", strview_find_last},
+        {"naive_first", naive_find_first},
+        {"naive_last", naive_find_last}
+    };
+
+    uint32_t size = FIND_HAYSTACK_SIZE * math_min_uint32(scale, 1024);
+    uint8_t *buffer = allocator_alloc(allocator_default(), size);
+    if (!buffer) {
+        fprintf(stderr, "find: out of memory\n");
+        return false;
+    }
+    uint32_t seed = 12345;
+    for (uint32_t i = 0; i < size; i++) {
+        seed = seed * 1103515245U + 12345U;
+        buffer[i] = (uint8_t)("abcdefghijklmnop"[(seed >> 16) & 15]);
+    }
+    strview_t haystack = {buffer, size};
+    strview_t missing = STRVIEW("/include");
+
+    bool success = true;
+    for (size_t i = 0; i < sizeof searches / sizeof searches[0]; i++) {
+        double best = 0;
+        for (uint32_t run = 0; run < num_runs; run++) {
+            double start = stats_now();
+            for (int j = 0; j < FIND_ITERATIONS; j++) {
+                success = success && searches[i].find(haystack, missing) == invalid_index;
+            }
+            double seconds = stats_now() - start;
+            best = (run == 0 || seconds < best) ? seconds : best;
+        }
+        printf("%-12s %-10s %12.3f\n", "find", searches[i].name, best * 1E3);
+    }
+    puts("");
+
+    allocator_free(allocator_default(), buffer);
+    if (!success) {
+        fprintf(stderr, "find: search found a missing needle\n");
+    }
+    return success;
+}
+
+
+static void display_help(void) {
+    puts("Usage: baron_bench [OPTION]... [SCENARIO]...");
+    puts("Time baronlib over large synthetic sources, reporting the best of several runs.");
+    puts("");
+    puts("  -profile <n>     Print the n source lines which took the most time in the last run of each scenario");
+    puts("  -runs <n>        Number of runs of each scenario (default 5)");
+    puts("  -scale <n>       Multiply the size of the generated sources by n (default 1)");
+    puts("  -track           Print a histogram of the allocations made in the last run of each scenario, by phase");
+    puts("");
+    printf("Scenarios:");
+    for (size_t i = 0; i < NUM_SCENARIOS; i++) {
+        printf(" %s", scenarios[i].name);
+    }
+    puts(" find");
+}
+
+
+int main(int argc, char *argv[]) {
+    uint32_t num_runs = DEFAULT_NUM_RUNS;
+    uint32_t scale = 1;
+    uint32_t profile_lines = 0;
+    bool is_tracked = false;
+    bool is_selected[NUM_SCENARIOS] = {0};
+    bool is_find_selected = false;
+    bool is_any_selected = false;
+
+    for (int i = 1; i < argc; i++) {
+        uint32_t *option = (strcmp(argv[i], "-runs") == 0) ? &num_runs :
+                           (strcmp(argv[i], "-scale") == 0) ? &scale :
+                           (strcmp(argv[i], "-profile") == 0) ? &profile_lines : 0;
+        if (option) {
+            int value = (i + 1 < argc) ? atoi(argv[i + 1]) : 0;
+            if (value <= 0) {
+                fprintf(stderr, "%s must be followed by a positive number\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+            *option = (uint32_t)value;
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], "-track") == 0) {
+            is_tracked = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--help") == 0) {
+            display_help();
+            return EXIT_SUCCESS;
+        }
+        if (strcmp(argv[i], "find") == 0) {
+            is_find_selected = is_any_selected = true;
+            continue;
+        }
+        size_t j = 0;
+        while (j < NUM_SCENARIOS && strcmp(argv[i], scenarios[j].name) != 0) {
+            j++;
+        }
+        if (j == NUM_SCENARIOS) {
+            fprintf(stderr, "Unknown option or scenario %s\n", argv[i]);
+            display_help();
+            return EXIT_FAILURE;
+        }
+        is_selected[j] = is_any_selected = true;
+    }
+
+    printf("scale %u, best of %u runs\n\n", scale, num_runs);
+    printf("%-12s %-10s %12s %12s %14s\n", "scenario", "phase", "time (ms)", "allocations", "bytes");
+
+    for (size_t i = 0; i < NUM_SCENARIOS; i++) {
+        if (is_any_selected && !is_selected[i]) {
+            continue;
+        }
+
+        // Allocation counts are the same on every run; only the times vary
+        measurement_t best[num_phases];
+        uint64_t num_statements = 0;
+        tracker_t tracker;
+        for (uint32_t run = 0; run < num_runs; run++) {
+            measurement_t measurements[num_phases];
+            // Profiling costs time, so only the last run is profiled; the tracker left is the last run's
+            size_t run_profile_lines = (run + 1 == num_runs) ? profile_lines : 0;
+            tracker_init(&tracker, allocator_default());
+            if (!run_scenario(&scenarios[i], scale, run_profile_lines, &tracker, measurements, &num_statements)) {
+                return EXIT_FAILURE;
+            }
+            for (int phase = 0; phase < num_phases; phase++) {
+                if (run == 0 || measurements[phase].seconds < best[phase].seconds) {
+                    best[phase] = measurements[phase];
+                }
+            }
+        }
+
+        double total = 0;
+        for (int phase = 0; phase < num_phases; phase++) {
+            printf("%-12s %-10s %12.3f %12llu %14llu\n", scenarios[i].name, phase_names[phase], best[phase].seconds * 1E3,
+                   (unsigned long long)best[phase].num_allocations, (unsigned long long)best[phase].bytes_requested);
+            total += best[phase].seconds;
+        }
+        printf("%-12s %-10s %12.3f %12s %14s  (%llu statements)\n\n", scenarios[i].name, "total", total * 1E3, "", "",
+               (unsigned long long)num_statements);
+        if (is_tracked) {
+            printf("%s allocations: ", scenarios[i].name);
+            tracker_print(&tracker, stdout);
+            puts("");
+        }
+    }
+
+    if ((!is_any_selected || is_find_selected) && !run_find_benchmark(scale, num_runs)) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
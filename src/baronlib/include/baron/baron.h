@@ -2,19 +2,53 @@
  *  @file   baron.h
  *
  *  Define public entry points for baronlib
+ *
+ *  Thread safety: baronlib has no mutable global or static state. Everything an assembly uses is reached through the
+ *  baron_assembly_t or baron_context_t it belongs to, or through the baron_desc_t and allocator it was created with,
+ *  and the only shared data (such as the opcode tables) is const. Different threads may therefore assemble at the same
+ *  time, each with its own assembly or context. A finished assembly may be read from any number of threads at once:
+ *  the only work done by the functions taking a const baron_assembly_t is formatting a log channel's text when it's
+ *  first asked for, which happens once, however many threads ask for it together. A single assembly or context must
+ *  not otherwise be used from two threads at once, and a shared allocator or write function must itself be thread
+ *  safe.
  */
 
 #ifndef BARONLIB_BARON_H_
 #define BARONLIB_BARON_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 
 typedef struct baron_allocator_fns_t baron_allocator_fns_t;
 typedef struct baron_allocator_t baron_allocator_t;
+typedef struct baron_log_sink_t baron_log_sink_t;
+typedef struct baron_file_contents_t baron_file_contents_t;
+typedef struct baron_memory_file_t baron_memory_file_t;
+typedef struct baron_file_system_t baron_file_system_t;
+typedef struct baron_limits_t baron_limits_t;
 typedef struct baron_desc_t baron_desc_t;
 typedef struct baron_assembly_t baron_assembly_t;
+typedef struct baron_context_t baron_context_t;
 typedef struct baron_object_code_t baron_object_code_t;
+typedef struct baron_disk_file_t baron_disk_file_t;
+typedef struct baron_disk_image_desc_t baron_disk_image_desc_t;
+typedef struct baron_symbol_t baron_symbol_t;
+typedef struct baron_symbol_filter_t baron_symbol_filter_t;
+typedef struct baron_symbol_file_header_t baron_symbol_file_header_t;
+typedef struct baron_symbol_record_t baron_symbol_record_t;
+typedef struct baron_memory_stats_t baron_memory_stats_t;
+typedef struct baron_stats_t baron_stats_t;
+typedef struct baron_hot_line_t baron_hot_line_t;
+
+typedef bool (*baron_write_fn_t)(const void *data, size_t size, void *context);
+
+
+// Number of log channels: channel 0 is the error log, and channels 1-7 are written by the source
+#define BARON_NUM_LOG_CHANNELS 8
+
+// Number of passes timed individually by baron_stats_t
+#define BARON_STATS_MAX_PASSES 8
 
 
 /**
@@ -40,6 +74,83 @@ struct baron_allocator_t {
 };
 
 
+/**
+ *  @struct baron_log_sink_t
+ *
+ *  A destination to which a log channel's text is streamed as the final pass of the assembly proceeds.
+ *  Text is passed to write_fn in buffers of up to 64KB, rather than line by line, and a channel with a sink keeps none
+ *  of its text in memory, so baron_assembly_log returns an empty string for it. If write_fn returns false, nothing
+ *  more is written to that sink, and the assembly fails.
+ */
+struct baron_log_sink_t {
+    baron_write_fn_t write_fn;  // If null, the channel's text is kept and can be obtained with baron_assembly_log
+    void *context;
+};
+
+
+/**
+ *  @struct baron_file_contents_t
+ *
+ *  The contents of a source or binary file, as supplied by a file system hook
+ */
+struct baron_file_contents_t {
+    const void *data;
+    size_t size;
+};
+
+
+/**
+ *  @struct baron_memory_file_t
+ *
+ *  A file held in memory, which is referenced rather than copied, so must remain valid for the lifetime of the
+ *  assembly
+ */
+struct baron_memory_file_t {
+    const char *name;
+    const void *data;
+    size_t size;
+};
+
+
+/**
+ *  @struct baron_file_system_t
+ *
+ *  Describes where the files named by baron_assemble_from_file, INCLUDE and INCBIN are read from.
+ *  A name is first looked for in the table of memory files, then passed to load_fn. If neither files nor load_fn is
+ *  given, files are read from disk; otherwise the disk is never accessed, so an assembly can be made entirely in
+ *  memory. Each file is loaded at most once per assembly, however many times it's included, and released when the
+ *  assembly is destroyed or reset.
+ */
+struct baron_file_system_t {
+    const baron_memory_file_t *files;
+    size_t num_files;
+    // Optional: fill in the contents of the named file, returning false if it can't be found.
+    // The contents must remain valid until release_fn is called for them. Files over 4GB are released at once, and
+    // treated as not found.
+    bool (*load_fn)(const char *filename, baron_file_contents_t *contents, void *context);
+    // Optional: called once the assembly no longer needs the contents returned by load_fn
+    void (*release_fn)(const char *filename, baron_file_contents_t contents, void *context);
+    void *context;
+};
+
+
+/**
+ *  @struct baron_limits_t
+ *
+ *  Bounds on the work an assembly may do, so that runaway source (e.g. a FOR loop with billions of iterations, or a
+ *  macro which invokes itself) can't hang the caller. Exceeding any of them stops the assembly with the matching
+ *  baron_status_t. A zero limit means no limit.
+ */
+struct baron_limits_t {
+    // Optional: polled every few thousand steps; returning true cancels the assembly, e.g. when a request times out
+    bool (*cancel_fn)(void *context);
+    void *cancel_context;
+    uint64_t max_steps;         // Statements executed, counting each iteration of a loop body
+    uint32_t max_macro_depth;   // Depth of nested macro invocations
+    uint64_t max_memory;        // Bytes live in the allocator at any one time, including any kept by a context
+};
+
+
 /**
  *  @struct baron_desc_t
  *
@@ -47,6 +158,11 @@ struct baron_allocator_t {
  */
 struct baron_desc_t {
     const baron_allocator_t *allocator;
+    bool cmos;                  // Accept 65C02 instructions
+    baron_log_sink_t log_sinks[BARON_NUM_LOG_CHANNELS];
+    baron_file_system_t file_system;
+    baron_limits_t limits;
+    bool profile;               // Attribute assembly work to source lines, for baron_assembly_hot_lines
 };
 
 
@@ -61,6 +177,81 @@ struct baron_object_code_t {
 };
 
 
+/**
+ *  @struct baron_disk_file_t
+ * 
+ *  Describes a file to be written to a DFS disk image.
+ *  The object code is referenced rather than copied, so must remain valid until the image has been written.
+ */
+struct baron_disk_file_t {
+    char name[10];              // "NAME" or "D.NAME", where D is the directory, and NAME is up to 7 chars
+    uint32_t load_address;
+    uint32_t exec_address;
+    baron_object_code_t object_code;
+    int side;                   // 0 or 1; side 1 is only valid for double-sided images
+    bool locked;
+};
+
+
+/**
+ *  @struct baron_disk_image_desc_t
+ * 
+ *  Describes a DFS disk image.
+ *  Files are laid out on each side in the order given, and each side holds at most 31 files.
+ */
+struct baron_disk_image_desc_t {
+    const char *title;          // Up to 12 chars; may be null
+    int boot_option;            // 0-3
+    int num_tracks;             // 40 or 80; 0 means 80
+    bool double_sided;          // If true, the image is track-interleaved (.dsd), otherwise single-sided (.ssd)
+    const baron_disk_file_t *files;
+    size_t num_files;
+};
+
+
+/**
+ *  @enum   baron_disk_image_status_t
+ */
+typedef enum baron_disk_image_status_t {
+    baron_disk_image_ok,
+    baron_disk_image_invalid_desc,
+    baron_disk_image_invalid_filename,
+    baron_disk_image_too_many_files,
+    baron_disk_image_disk_full,
+    baron_disk_image_write_failed
+} baron_disk_image_status_t;
+
+
+/**
+ *  @enum   baron_status_t
+ *
+ *  The status of an assembly, returned by baron_assembly_status
+ */
+typedef enum baron_status_t {
+    baron_status_ok,
+    baron_status_error,                 // The source has errors, which are described in the error log
+    baron_status_cancelled,             // The cancel function asked for the assembly to stop
+    baron_status_step_limit,            // More than limits.max_steps statements were executed
+    baron_status_macro_depth_limit,     // Macro invocations were nested more than limits.max_macro_depth deep
+    baron_status_memory_limit           // More than limits.max_memory bytes were needed at once
+} baron_status_t;
+
+
+/**
+ *  @enum   baron_memory_use_t
+ *
+ *  The uses of an assembly's memory, for which allocations are counted separately by baron_stats_t
+ */
+typedef enum baron_memory_use_t {
+    baron_memory_object_code,           // Overlays' object code
+    baron_memory_symbols,               // The symbol table and symbol values
+    baron_memory_logs,                  // Log records and text
+    baron_memory_files,                 // Source and binary files read from disk, and the file cache
+    baron_memory_other,                 // Everything else, e.g. the overlay table, memory map, macros and loops
+    baron_memory_use_count
+} baron_memory_use_t;
+
+
 /**
  *  @enum   
  */
@@ -72,13 +263,136 @@ typedef enum baron_value_type_t {
 } baron_value_type_t;
 
 
+/**
+ *  @struct baron_symbol_t
+ *
+ *  A view of a symbol in an assembly's symbol table.
+ *  The name and string refer directly to the table's own storage, so they have the same lifetime as the
+ *  baron_assembly_t object.
+ */
+struct baron_symbol_t {
+    const char *name;           // Zero-terminated, scope qualified name, separated by periods
+    size_t name_length;
+    baron_value_type_t type;    // baron_value_none if the symbol doesn't exist
+    double number;              // Value of a numeric symbol
+    const char *string;         // Value of a string symbol; this is not zero-terminated
+    size_t string_length;
+};
+
+
+/**
+ *  @struct baron_symbol_filter_t
+ *
+ *  Selects the symbols visited by baron_assembly_visit_symbols
+ */
+struct baron_symbol_filter_t {
+    const char *scope;          // Only symbols within this scope, e.g. "a.b" selects "a.b.c" but not "a.bc"; null for all
+    uint32_t types;             // Bit mask of (1 << baron_value_type_t) for the types to select; 0 for all
+};
+
+
+// "BSYM" when read as bytes
+#define BARON_SYMBOL_FILE_MAGIC 0x4D595342U
+#define BARON_SYMBOL_FILE_VERSION 1
+
+
+/**
+ *  @struct baron_symbol_file_header_t
+ *
+ *  Header at the start of a binary symbol file, which is laid out so that it can be mapped into memory and queried
+ *  in place, without being parsed. All fields are in the byte order of the machine which wrote the file, and all
+ *  offsets are from the start of the file. The file holds:
+ *
+ *    - the records, numeric symbols first in ascending order of value, then string symbols in ascending order of name;
+ *    - a hash index of num_hash_slots uint32_t record indices, with 0xFFFFFFFF marking an empty slot. A name is looked
+ *      up by linear probing from slot (hash & (num_hash_slots - 1)), where hash is the 32-bit FNV-1a hash of its bytes;
+ *    - the string pool, holding the symbol names and string values, each followed by a zero byte.
+ */
+struct baron_symbol_file_header_t {
+    uint32_t magic;             // BARON_SYMBOL_FILE_MAGIC
+    uint32_t version;           // BARON_SYMBOL_FILE_VERSION
+    uint32_t num_symbols;
+    uint32_t num_numeric_symbols;
+    uint32_t num_hash_slots;    // A power of two, at least twice num_symbols
+    uint32_t records_offset;    // Aligned to 8 bytes
+    uint32_t hash_offset;
+    uint32_t strings_offset;
+    uint32_t strings_size;
+    uint32_t reserved;
+};
+
+
+/**
+ *  @struct baron_symbol_record_t
+ *
+ *  A symbol in a binary symbol file
+ */
+struct baron_symbol_record_t {
+    double number;              // Value of a numeric symbol
+    uint32_t name_offset;       // Offset of the name within the string pool
+    uint32_t name_length;
+    uint32_t string_offset;     // Offset of a string symbol's value within the string pool
+    uint32_t string_length;
+    uint32_t type;              // baron_value_numeric or baron_value_string
+    uint32_t hash;              // FNV-1a hash of the name
+};
+
+
+/**
+ *  @struct baron_memory_stats_t
+ *
+ *  Allocations made for one use of an assembly's memory
+ */
+struct baron_memory_stats_t {
+    uint64_t num_allocations;   // Calls to alloc and realloc
+    uint64_t bytes_requested;   // Total bytes requested, including growth of existing blocks
+};
+
+
+/**
+ *  @struct baron_stats_t
+ *
+ *  Counters and timings gathered as an assembly runs, so that a slow build can be narrowed down to the phase
+ *  responsible without a profiler. They are always collected; they cost a few increments per operation counted.
+ */
+struct baron_stats_t {
+    uint32_t num_passes;
+    double pass_seconds[BARON_STATS_MAX_PASSES];    // Time spent in each pass; any passes beyond the last are added to it
+    double finish_seconds;                          // Time spent completing the assembly after the last pass
+    uint64_t tokens_lexed;
+    uint64_t expressions_evaluated;
+    uint64_t macro_expansions;
+    uint64_t symbol_lookups;                        // Lookups of symbols by name, including those which define them
+    uint64_t symbol_probes;                         // Hash table slots examined by those lookups
+    uint32_t max_symbol_probe_length;
+    baron_memory_stats_t memory[baron_memory_use_count];
+};
+
+
+/**
+ *  @struct baron_hot_line_t
+ *
+ *  The work attributed to one source line by the profiler enabled with baron_desc_t.profile.
+ *  Work done by a macro body is attributed to the lines of the body.
+ */
+struct baron_hot_line_t {
+    const char *filename;       // Same lifetime as the assembly
+    uint32_t line;
+    uint64_t steps;             // Statements executed, counting every iteration of a loop
+    uint64_t evaluations;       // Expressions evaluated
+    double seconds;             // Time spent, estimated by sampling the clock every few dozen steps
+};
+
+
 /**
  *  Assemble the given text
  * 
  *  @param  desc        Description of the environment to be used to assemble the text
  *  @param  text        Zero-terminated string to be assembled
  * 
- *  @result A baron_assembly_t from which the object code, symbol table and logs can be obtained
+ *  @result A baron_assembly_t from which the object code, symbol table and logs can be obtained, even if assembly
+ *          failed: baron_assembly_status tells whether it succeeded, or which limit stopped it, and the error log
+ *          why. Null only if there wasn't enough memory to create the assembly.
  */
 baron_assembly_t *baron_assemble(const baron_desc_t *desc, const char *text);
 
@@ -89,11 +403,55 @@ baron_assembly_t *baron_assemble(const baron_desc_t *desc, const char *text);
  *  @param  desc        Description of the environment to be used to assemble the text
  *  @param  filename    Zero-terminated filename of the source file to assemble
  * 
- *  @result A baron_assembly_t from which the object code, symbol table and logs can be obtained
+ *  @result A baron_assembly_t, as for baron_assemble
  */
 baron_assembly_t *baron_assemble_from_file(const baron_desc_t *desc, const char *filename);
 
 
+/**
+ *  Create a context which can be used for many assemblies in turn, amortising the cost of setting one up.
+ *  The context holds a single assembly which is reset before each use, keeping its allocations, so repeatedly
+ *  assembling small pieces of source makes few allocations after the first.
+ *
+ *  @param  desc        Description of the environment to be used for every assembly made with the context
+ *
+ *  @result The context, or null if allocation failed
+ */
+baron_context_t *baron_context_create(const baron_desc_t *desc);
+
+
+/**
+ *  Destroy a context, including the assembly it holds
+ *
+ *  @param  context     The context to destroy. If null, this does nothing.
+ */
+void baron_context_destroy(baron_context_t *context);
+
+
+/**
+ *  Assemble the given text, reusing a context
+ *
+ *  @param  context     The context to use
+ *  @param  text        Zero-terminated string to be assembled
+ *
+ *  @result The assembly, whose status tells whether it succeeded, as for baron_assemble. It is owned by the context:
+ *          it remains valid until the context is next used or destroyed, and must not be passed to
+ *          baron_assembly_destroy.
+ */
+const baron_assembly_t *baron_context_assemble(baron_context_t *context, const char *text);
+
+
+/**
+ *  Assemble from the given file, reusing a context
+ *
+ *  @param  context     The context to use
+ *  @param  filename    Zero-terminated filename of the source file to assemble
+ *
+ *  @result The assembly, which is owned by the context, as for baron_context_assemble
+ */
+const baron_assembly_t *baron_context_assemble_from_file(baron_context_t *context, const char *filename);
+
+
 /**
  *  Destroy a baron_assembly_t object
  * 
@@ -104,14 +462,48 @@ void baron_assembly_destroy(baron_assembly_t *baron_assembly);
 
 /**
  *  Determine the status of the baron_assembly_t object.
- *  A status of 0 indicates a valid, successful assembly.
- *  Any other value indicates an error state.
+ *  A status of 0 (baron_status_ok) indicates a valid, successful assembly.
+ *  Any other value is a baron_status_t indicating an error state, or which limit stopped the assembly.
  * 
  *  @param  baron_assembly  The baron_assembly_t object to inspect
  */
 int baron_assembly_status(const baron_assembly_t *baron_assembly);
 
 
+/**
+ *  Get the statistics gathered by an assembly
+ *
+ *  @param  baron_assembly  Pointer to the object holding the result of the assembly
+ *  @param  stats           Pointer to the baron_stats_t to fill in
+ */
+void baron_assembly_stats(const baron_assembly_t *baron_assembly, baron_stats_t *stats);
+
+
+/**
+ *  Get the source lines which cost the most assembly time, if the assembly was profiled
+ *
+ *  @param  baron_assembly  Pointer to the object holding the result of the assembly
+ *  @param  hot_lines       Array receiving up to max_lines lines, most time first, ties going to the most steps
+ *  @param  max_lines       Size of the hot_lines array
+ *
+ *  @return Number of lines written to hot_lines, which is 0 if the assembly wasn't profiled
+ */
+size_t baron_assembly_hot_lines(const baron_assembly_t *baron_assembly, baron_hot_line_t *hot_lines, size_t max_lines);
+
+
+/**
+ *  Write a report of the source lines which cost the most assembly time, as text with one line per source line
+ *
+ *  @param  baron_assembly  Pointer to the object holding the result of the assembly
+ *  @param  max_lines       Number of source lines to report, at least 1
+ *  @param  write_fn        Function called with successive blocks of the report; it returns false on failure
+ *  @param  context         Context passed to write_fn
+ *
+ *  @return Success true/false
+ */
+bool baron_assembly_profile_write(const baron_assembly_t *baron_assembly, size_t max_lines, baron_write_fn_t write_fn, void *context);
+
+
 
 /**
  *  Get the object code from the baron_assembly corresponding to the given overlay
@@ -134,13 +526,33 @@ const char *baron_assembly_errors(const baron_assembly_t *baron_assembly);
 
 
 /**
- *  Get the text corresponding to the nth log channel
+ *  Get the text corresponding to the nth log channel.
+ *  Log messages are stored in a compact binary form during assembly, and only formatted as text when a channel is first
+ *  asked for, so messages from passes which are discarded, and channels which are never read, cost little. This may
+ *  be called from several threads at once. The text has the same lifetime as the baron_assembly_t object.
  *  
  *  @param  baron_assembly  Pointer to the object holding the result of the assembly
+ *  @param  log_number      Log channel 1-7. Channel 0 is the error log, which also holds warnings,
+ *                          such as saved overlays which will overwrite each other when loaded.
  */
 const char *baron_assembly_log(const baron_assembly_t *baron_assembly, int log_number);
 
 
+/**
+ *  Get a machine-readable memory map of the saved overlays.
+ *  Each line is a record of space-separated fields, with addresses in hex and end addresses exclusive:
+ *
+ *    region <start> <end> <overlay name>
+ *    overlap <start> <end> <first overlay name> <second overlay name>
+ *
+ *  Regions are listed in address order, followed by every address range where two saved overlays overlap.
+ *  The default overlay has an empty name.
+ *  
+ *  @param  baron_assembly  Pointer to the object holding the result of the assembly
+ */
+const char *baron_assembly_memory_map(const baron_assembly_t *baron_assembly);
+
+
 /**
  *  Get the type of the named symbol
  *  
@@ -168,5 +580,141 @@ const double *baron_assembly_symbol_numeric(const baron_assembly_t *baron_assemb
 const char *baron_assembly_symbol_string(const baron_assembly_t *baron_assembly, const char *symbol_name);
 
 
+/**
+ *  Visit each symbol of an assembly in the order it was defined, without copying any names or values
+ *
+ *  @param  baron_assembly  Pointer to the object holding the result of the assembly
+ *  @param  filter          Symbols to visit, or null to visit them all
+ *  @param  visit_fn        Function called with each symbol; it returns false to stop visiting
+ *  @param  context         Context passed to visit_fn
+ *
+ *  @return The number of symbols visited
+ */
+size_t baron_assembly_visit_symbols(const baron_assembly_t *baron_assembly, const baron_symbol_filter_t *filter,
+                                    bool (*visit_fn)(const baron_symbol_t *symbol, void *context), void *context);
+
+
+/**
+ *  Look up a batch of symbols by name in a single call
+ *
+ *  @param  baron_assembly  Pointer to the object holding the result of the assembly
+ *  @param  names           Zero-terminated names of the symbols to find
+ *  @param  num_names       Number of names
+ *  @param  symbols         Array of num_names symbols to fill in; any not found has type baron_value_none
+ *
+ *  @return The number of symbols found
+ */
+size_t baron_assembly_find_symbols(const baron_assembly_t *baron_assembly, const char *const *names, size_t num_names,
+                                   baron_symbol_t *symbols);
+
+
+/**
+ *  Write the symbol table in the binary format described by baron_symbol_file_header_t.
+ *  Only numeric and string symbols are written.
+ *
+ *  @param  baron_assembly  Pointer to the object holding the result of the assembly
+ *  @param  write_fn        Function called with successive blocks of the file; it returns false on failure
+ *  @param  context         Context passed to write_fn
+ *
+ *  @return Success true/false
+ */
+bool baron_assembly_symbols_write(const baron_assembly_t *baron_assembly, baron_write_fn_t write_fn, void *context);
+
+
+/**
+ *  Write the symbol table to the named file, in the binary format described by baron_symbol_file_header_t
+ *
+ *  @param  baron_assembly  Pointer to the object holding the result of the assembly
+ *  @param  filename        Zero-terminated filename of the symbol file to write
+ *
+ *  @return Success true/false
+ */
+bool baron_assembly_symbols_save(const baron_assembly_t *baron_assembly, const char *filename);
+
+
+/**
+ *  Check that a block of memory, typically a mapped file, holds a binary symbol file which can be queried.
+ *  Only the header is inspected, so this is O(1); queries check the bounds of anything they read.
+ *
+ *  @param  data            Pointer to the start of the file, aligned to 8 bytes
+ *  @param  size            Size of the file in bytes
+ *
+ *  @return Pointer to the header, or null if the file is not valid
+ */
+const baron_symbol_file_header_t *baron_symbol_file_open(const void *data, size_t size);
+
+
+/**
+ *  Find a symbol in a binary symbol file by name, using its hash index
+ *
+ *  @param  file            Header returned by baron_symbol_file_open
+ *  @param  name            Zero-terminated name of the symbol
+ *
+ *  @return Pointer to the record, or null if there is no symbol with that name
+ */
+const baron_symbol_record_t *baron_symbol_file_find(const baron_symbol_file_header_t *file, const char *name);
+
+
+/**
+ *  Find the numeric symbol in a binary symbol file with the greatest value not above an address, by binary search.
+ *  Where several symbols share that value, the first defined is returned.
+ *
+ *  @param  file            Header returned by baron_symbol_file_open
+ *  @param  address         Address to look up
+ *
+ *  @return Pointer to the record, or null if every numeric symbol is above the address
+ */
+const baron_symbol_record_t *baron_symbol_file_find_address(const baron_symbol_file_header_t *file, double address);
+
+
+/**
+ *  Get a string from the string pool of a binary symbol file, such as a symbol's name or string value
+ *
+ *  @param  file            Header returned by baron_symbol_file_open
+ *  @param  offset          Offset of the string within the pool
+ *
+ *  @return The zero-terminated string, or null if the offset is out of range
+ */
+const char *baron_symbol_file_string(const baron_symbol_file_header_t *file, uint32_t offset);
+
+
+/**
+ *  Fill in a description of each saved overlay, ready to be written to a disk image.
+ *  Each file references the overlay's object code directly, so it has the same lifetime as the baron_assembly_t object.
+ * 
+ *  @param  baron_assembly  Pointer to the object holding the result of the assembly
+ *  @param  files           Array to receive the file descriptions, or null just to count them
+ *  @param  max_files       Capacity of the files array
+ * 
+ *  @return The number of saved overlays, which may be greater than max_files
+ */
+size_t baron_assembly_disk_files(const baron_assembly_t *baron_assembly, baron_disk_file_t *files, size_t max_files);
+
+
+/**
+ *  Write a DFS disk image.
+ *  The image is produced in a single pass, with each file's object code passed straight to the write function
+ *  from the buffer it references, so no copy of the image or its files is made.
+ * 
+ *  @param  desc            Description of the disk image
+ *  @param  write_fn        Function called with successive blocks of the image; it returns false on failure
+ *  @param  context         Context passed to write_fn
+ * 
+ *  @return baron_disk_image_ok on success, otherwise the reason for failure
+ */
+baron_disk_image_status_t baron_disk_image_write(const baron_disk_image_desc_t *desc, baron_write_fn_t write_fn, void *context);
+
+
+/**
+ *  Write a DFS disk image to the named file.
+ *  The file isn't touched if the description is invalid, and is removed if the image can't be completely written.
+ * 
+ *  @param  desc            Description of the disk image
+ *  @param  filename        Zero-terminated filename of the image to write
+ * 
+ *  @return baron_disk_image_ok on success, otherwise the reason for failure
+ */
+baron_disk_image_status_t baron_disk_image_save(const baron_disk_image_desc_t *desc, const char *filename);
+
 
 #endif // ifndef BARONLIB_BARON_H_
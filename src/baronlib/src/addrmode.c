@@ -0,0 +1,106 @@
+#include "base/defines.h"
+#include "addrmode.h"
+
+
+static bool is_register(const token_t *token, char name) {
+    return token->type == token_identifier &&
+           token->text.length == 1 &&
+           (token->text.data[0] | 0x20) == (name | 0x20);
+}
+
+
+// Returns whether the operand ends with ",X" or ",Y" (per name)
+static bool has_index_suffix(slice_const_token_t tokens, char name) {
+    return tokens.size >= 3 &&
+           token_is_symbol(&tokens.data[tokens.size - 2], STRVIEW(",")) &&
+           is_register(&tokens.data[tokens.size - 1], name);
+}
+
+
+// Returns the index of the bracket which closes the one at index 0, or invalid_index
+static uint32_t find_closing_bracket(slice_const_token_t tokens) {
+    int depth = 0;
+    for (uint32_t i = 0; i < tokens.size; i++) {
+        if (token_is_symbol(&tokens.data[i], STRVIEW("("))) {
+            depth++;
+        }
+        else if (token_is_symbol(&tokens.data[i], STRVIEW(")")) && --depth == 0) {
+            return i;
+        }
+    }
+    return invalid_index;
+}
+
+
+static slice_const_token_t slice_tokens(slice_const_token_t tokens, uint32_t start, uint32_t end) {
+    return (slice_const_token_t){tokens.data + start, end - start};
+}
+
+
+bool operand_parse(slice_const_token_t tokens, operand_t *operand) {
+    ASSERT(operand);
+    *operand = (operand_t){.expression = slice_tokens(tokens, 0, 0)};
+
+    if (tokens.size == 0) {
+        operand->mode = addr_mode_implied;
+        return true;
+    }
+
+    if (tokens.size == 1 && is_register(&tokens.data[0], 'A')) {
+        operand->mode = addr_mode_accumulator;
+        return true;
+    }
+
+    if (token_is_symbol(&tokens.data[0], STRVIEW("#"))) {
+        operand->mode = addr_mode_immediate;
+        operand->expression = slice_tokens(tokens, 1, tokens.size);
+        return tokens.size > 1;
+    }
+
+    // An operand in brackets is indirect, unless the brackets only enclose part of an expression, e.g. (a+b)*2
+    if (token_is_symbol(&tokens.data[0], STRVIEW("("))) {
+        uint32_t close = find_closing_bracket(tokens);
+        if (close == tokens.size - 1) {
+            slice_const_token_t inner = slice_tokens(tokens, 1, close);
+            if (has_index_suffix(inner, 'X')) {
+                operand->mode = addr_mode_indirect_x;
+                operand->expression = slice_tokens(inner, 0, inner.size - 2);
+            }
+            else {
+                operand->mode = addr_mode_indirect;
+                operand->expression = inner;
+            }
+            return operand->expression.size > 0;
+        }
+        if (close != invalid_index && close == tokens.size - 3 && has_index_suffix(tokens, 'Y')) {
+            operand->mode = addr_mode_indirect_y;
+            operand->expression = slice_tokens(tokens, 1, close);
+            return operand->expression.size > 0;
+        }
+    }
+
+    if (has_index_suffix(tokens, 'X')) {
+        operand->mode = addr_mode_absolute_x;
+        operand->expression = slice_tokens(tokens, 0, tokens.size - 2);
+    }
+    else if (has_index_suffix(tokens, 'Y')) {
+        operand->mode = addr_mode_absolute_y;
+        operand->expression = slice_tokens(tokens, 0, tokens.size - 2);
+    }
+    else {
+        operand->mode = addr_mode_absolute;
+        operand->expression = tokens;
+    }
+    return true;
+}
+
+
+addr_mode_t addr_mode_zero_page_form(addr_mode_t mode) {
+    switch (mode) {
+        case addr_mode_absolute:    return addr_mode_zero_page;
+        case addr_mode_absolute_x:  return addr_mode_zero_page_x;
+        case addr_mode_absolute_y:  return addr_mode_zero_page_y;
+        case addr_mode_indirect:    return addr_mode_indirect_zero_page;
+        default:                    return mode;
+    }
+}
@@ -0,0 +1,64 @@
+/**
+ *  @file   addrmode.h
+ *
+ *  6502 and 65C02 addressing modes, and classification of operands into them
+ */
+
+#ifndef BARONLIB_ADDRMODE_H_
+#define BARONLIB_ADDRMODE_H_
+
+#include <stdbool.h>
+#include "lexer.h"
+
+typedef struct operand_t operand_t;
+
+
+typedef enum addr_mode_t {
+    addr_mode_implied,
+    addr_mode_accumulator,              // A
+    addr_mode_immediate,                // #n
+    addr_mode_zero_page,                // zp
+    addr_mode_zero_page_x,              // zp,X
+    addr_mode_zero_page_y,              // zp,Y
+    addr_mode_absolute,                 // abs
+    addr_mode_absolute_x,               // abs,X
+    addr_mode_absolute_y,               // abs,Y
+    addr_mode_indirect,                 // (abs)
+    addr_mode_indirect_x,               // (zp,X)
+    addr_mode_indirect_y,               // (zp),Y
+    addr_mode_indirect_zero_page,       // (zp), 65C02 only
+    addr_mode_indirect_absolute_x,      // (abs,X), 65C02 only
+    addr_mode_relative,                 // Branch target
+    addr_mode_count
+} addr_mode_t;
+
+
+/**
+ *  An operand, split into its addressing mode and the tokens of the expression it contains.
+ *  Whether an address is zero page depends on its value, so operands are classified with the absolute form of
+ *  the addressing mode, and narrowed by addr_mode_zero_page_form once the expression has been evaluated.
+ */
+struct operand_t {
+    addr_mode_t mode;
+    slice_const_token_t expression;
+};
+
+
+/**
+ *  Classify the tokens of an operand by their syntactic form
+ *
+ *  @param  tokens          Tokens of the operand, excluding the statement terminator
+ *  @param  operand         Receives the addressing mode and the expression tokens
+ *
+ *  @return false if the operand is not a valid form for any addressing mode
+ */
+bool operand_parse(slice_const_token_t tokens, operand_t *operand);
+
+
+/**
+ *  Get the zero page form of an absolute addressing mode, or the same mode if it has none
+ */
+addr_mode_t addr_mode_zero_page_form(addr_mode_t mode);
+
+
+#endif // ifndef BARONLIB_ADDRMODE_H_
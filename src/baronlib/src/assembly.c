@@ -0,0 +1,310 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "base/defines.h"
+#include "assembly.h"
+
+
+static void *baron_allocator_alloc(uint32_t size, void *context) {
+    const baron_allocator_t *baron_allocator = context;
+    return baron_allocator->allocator_fns->alloc(size, baron_allocator->context);
+}
+
+
+static void *baron_allocator_realloc(void *ptr, uint32_t size, void *context) {
+    const baron_allocator_t *baron_allocator = context;
+    return baron_allocator->allocator_fns->realloc(ptr, size, baron_allocator->context);
+}
+
+
+static void baron_allocator_free(void *ptr, void *context) {
+    const baron_allocator_t *baron_allocator = context;
+    baron_allocator->allocator_fns->free(ptr, baron_allocator->context);
+}
+
+
+static allocator_t make_allocator_from_desc(const baron_desc_t *desc) {
+
+    static const allocator_vtable_t baron_allocator_vtable = {
+        baron_allocator_alloc,
+        baron_allocator_realloc,
+        baron_allocator_free
+    };
+
+    if (desc && desc->allocator) {
+        return (allocator_t){
+            (void *)desc->allocator,
+            &baron_allocator_vtable
+        };
+    }
+
+    return *allocator_default();
+}
+
+
+static void *wrapped_allocator_alloc(size_t size, void *context) {
+    return (size <= UINT32_MAX) ? allocator_alloc(context, (uint32_t)size) : 0;
+}
+
+
+static void *wrapped_allocator_realloc(void *ptr, size_t size, void *context) {
+    return (size <= UINT32_MAX) ? allocator_realloc(context, ptr, (uint32_t)size) : 0;
+}
+
+
+static void wrapped_allocator_free(void *ptr, void *context) {
+    allocator_free(context, ptr);
+}
+
+
+baron_allocator_t make_baron_allocator(const allocator_t *allocator) {
+    ASSERT(allocator);
+
+    static const baron_allocator_fns_t wrapped_allocator_fns = {
+        wrapped_allocator_alloc,
+        wrapped_allocator_realloc,
+        wrapped_allocator_free
+    };
+
+    return (baron_allocator_t){
+        &wrapped_allocator_fns,
+        (void *)allocator
+    };
+}
+
+
+baron_assembly_t *assembly_create(const baron_desc_t *desc) {
+    allocator_t allocator = make_allocator_from_desc(desc);
+    baron_assembly_t *assembly = allocator_alloc(&allocator, sizeof(baron_assembly_t));
+    if (!assembly) {
+        return 0;
+    }
+
+    *assembly = (baron_assembly_t){
+        .opcodes = opcode_table((desc && desc->cmos) ? instruction_set_cmos : instruction_set_nmos),
+        .is_profiled = desc && desc->profile
+    };
+    budget_init(&assembly->budget, desc ? &desc->limits : 0, allocator);
+    assembly->allocator = budget_allocator(&assembly->budget);
+    for (int i = 0; i < baron_memory_use_count; i++) {
+        stats_allocator_init(&assembly->allocators[i], &assembly->allocator, &assembly->stats.memory[i]);
+    }
+
+    // Arrays keep a pointer to the allocator, so it must be in place in the assembly before they are made
+    const allocator_t *other = assembly_allocator(assembly, baron_memory_other);
+    assembly->overlays = make_array(overlay_t, other, 4);
+    assembly->memory_map = make_array(char, other, 256);
+    bool success = array_is_valid(&assembly->overlays) &&
+                   array_is_valid(&assembly->memory_map) &&
+                   memmap_init(&assembly->memmap, other) &&
+                   symtab_init(&assembly->symbols, assembly_allocator(assembly, baron_memory_symbols)) &&
+                   vfs_init(&assembly->files, assembly_allocator(assembly, baron_memory_files), desc ? &desc->file_system : 0) &&
+                   profile_init(&assembly->profile, other);
+
+    log_init(&assembly->log, assembly_allocator(assembly, baron_memory_logs));
+    for (uint32_t i = 0; desc && i < LOG_NUM_CHANNELS; i++) {
+        log_set_sink(&assembly->log, i, desc->log_sinks[i].write_fn, desc->log_sinks[i].context);
+    }
+
+    if (!success || assembly_add_overlay(assembly, STRVIEW("")) == invalid_index) {
+        assembly_destroy(assembly);
+        return 0;
+    }
+
+    // Text is always kept zero-terminated, so that it can be returned directly as a C string
+    assembly->memory_map.data[0] = 0;
+
+    return assembly;
+}
+
+
+void assembly_destroy(baron_assembly_t *assembly) {
+    if (!assembly) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < assembly->overlays.size; i++) {
+        array_deinit(&assembly->overlays.data[i].object_code);
+    }
+    log_deinit(&assembly->log);
+    array_deinit(&assembly->overlays);
+    array_deinit(&assembly->memory_map);
+    memmap_deinit(&assembly->memmap);
+    symtab_deinit(&assembly->symbols);
+    vfs_deinit(&assembly->files);
+    profile_deinit(&assembly->profile);
+
+    // The assembly itself was allocated before the budget existed, so is given straight back to its parent
+    allocator_t allocator = assembly->budget.parent;
+    allocator_free(&allocator, assembly);
+}
+
+
+void assembly_reset(baron_assembly_t *assembly) {
+    ASSERT(assembly);
+    ASSERT(assembly->overlays.size > 0);
+
+    for (uint32_t i = 1; i < assembly->overlays.size; i++) {
+        array_deinit(&assembly->overlays.data[i].object_code);
+    }
+    overlay_t *default_overlay = &assembly->overlays.data[0];
+    array_reset(&default_overlay->object_code);
+    *default_overlay = (overlay_t){.name = default_overlay->name, .object_code = default_overlay->object_code};
+    assembly->overlays.size = 1;
+
+    assembly->status = 0;
+    assembly->stats = (baron_stats_t){0};
+    budget_reset(&assembly->budget);
+    memmap_reset(&assembly->memmap);
+    log_reset(&assembly->log);
+    symtab_reset(&assembly->symbols);
+    vfs_reset(&assembly->files);
+    profile_reset(&assembly->profile);
+    array_reset(&assembly->memory_map);
+    assembly->memory_map.data[0] = 0;
+}
+
+
+uint32_t assembly_add_overlay(baron_assembly_t *assembly, strview_t name) {
+    ASSERT(assembly);
+    overlay_t overlay = {
+        .name = name,
+        .object_code = make_array(uint8_t, assembly_allocator(assembly, baron_memory_object_code), 256)
+    };
+
+    if (!array_is_valid(&overlay.object_code)) {
+        return invalid_index;
+    }
+    if (!array_add(&assembly->overlays, overlay)) {
+        array_deinit(&overlay.object_code);
+        return invalid_index;
+    }
+    return assembly->overlays.size - 1;
+}
+
+
+uint32_t assembly_find_overlay(const baron_assembly_t *assembly, strview_t name) {
+    ASSERT(assembly);
+    for (uint32_t i = 0; i < assembly->overlays.size; i++) {
+        if (strview_equal(assembly->overlays.data[i].name, name)) {
+            return i;
+        }
+    }
+    return invalid_index;
+}
+
+
+void assembly_save_overlay(baron_assembly_t *assembly, uint32_t overlay_index, uint32_t load_address, uint32_t exec_address) {
+    ASSERT(assembly);
+    ASSERT(overlay_index < assembly->overlays.size);
+    overlay_t *overlay = &assembly->overlays.data[overlay_index];
+    overlay->load_address = load_address;
+    overlay->exec_address = exec_address;
+    overlay->is_saved = true;
+}
+
+
+static bool text_vprintf(array_char *text, const char *format, va_list args) {
+    va_list args_copy;
+    va_copy(args_copy, args);
+    int length = vsnprintf(0, 0, format, args_copy);
+    va_end(args_copy);
+
+    // Reserve room for the zero terminator, which is kept in place but not counted in the size
+    if (length < 0 || !array_reserve(text, text->size + (uint32_t)length + 1)) {
+        return false;
+    }
+    vsnprintf(text->data + text->size, (size_t)length + 1, format, args);
+    text->size += (uint32_t)length;
+    return true;
+}
+
+
+static bool text_printf(array_char *text, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    bool success = text_vprintf(text, format, args);
+    va_end(args);
+    return success;
+}
+
+
+lex_result_t assembly_lex(baron_assembly_t *assembly, strview_t source, array_token_t *tokens) {
+    ASSERT(assembly);
+    ASSERT(tokens);
+    uint32_t first_token = tokens->size;
+    lex_result_t result = lex(source, tokens);
+    assembly->stats.tokens_lexed += tokens->size - first_token;
+    return result;
+}
+
+
+void assembly_begin_pass(baron_assembly_t *assembly, bool is_final_pass) {
+    ASSERT(assembly);
+    log_begin_pass(&assembly->log, is_final_pass);
+    assembly->pass_start_time = stats_now();
+    profile_start_sampling(&assembly->profile);
+}
+
+
+void assembly_end_pass(baron_assembly_t *assembly) {
+    ASSERT(assembly);
+    baron_stats_t *stats = &assembly->stats;
+    uint32_t index = math_min_uint32(stats->num_passes, BARON_STATS_MAX_PASSES - 1);
+    stats->pass_seconds[index] += stats_now() - assembly->pass_start_time;
+    stats->num_passes++;
+}
+
+
+bool assembly_finish(baron_assembly_t *assembly) {
+    ASSERT(assembly);
+
+    double start_time = stats_now();
+
+    // Overlays may be saved before they're complete, or saved again on a later pass, so their regions are only
+    // indexed now, from their final sizes
+    memmap_reset(&assembly->memmap);
+    bool success = true;
+    for (uint32_t i = 0; success && i < assembly->overlays.size; i++) {
+        const overlay_t *overlay = &assembly->overlays.data[i];
+        if (overlay->is_saved) {
+            success = memmap_add_region(&assembly->memmap, i, overlay->load_address,
+                                        overlay->load_address + overlay->object_code.size);
+        }
+    }
+
+    array_memmap_overlap_t overlaps = make_array(memmap_overlap_t, assembly_allocator(assembly, baron_memory_other), 8);
+    success = success && array_is_valid(&overlaps) && memmap_find_overlaps(&assembly->memmap, &overlaps);
+
+    // memmap_find_overlaps leaves the regions sorted by address
+    array_reset(&assembly->memory_map);
+    assembly->memory_map.data[0] = 0;
+    for (uint32_t i = 0; success && i < assembly->memmap.regions.size; i++) {
+        const memmap_region_t *region = &assembly->memmap.regions.data[i];
+        success = text_printf(&assembly->memory_map, "region %04X %04X " STR_FORMAT "\n",
+            region->start, region->end, STR_PRINT(assembly->overlays.data[region->overlay_index].name));
+    }
+
+    for (uint32_t i = 0; success && i < overlaps.size; i++) {
+        const memmap_overlap_t *overlap = &overlaps.data[i];
+        strview_t first_name = assembly->overlays.data[overlap->first_overlay_index].name;
+        strview_t second_name = assembly->overlays.data[overlap->second_overlay_index].name;
+        success = text_printf(&assembly->memory_map, "overlap %04X %04X " STR_FORMAT " " STR_FORMAT "\n",
+                overlap->start, overlap->end, STR_PRINT(first_name), STR_PRINT(second_name)) &&
+            log_write(&assembly->log, LOG_CHANNEL_ERRORS, log_message_overlays_overlap, 0,
+                first_name, second_name, overlap->start, overlap->end - 1);
+    }
+
+    array_deinit(&overlaps);
+
+    // A limit which stopped the assembly takes precedence over the errors it caused
+    if (assembly->budget.status != baron_status_ok) {
+        assembly->status = assembly->budget.status;
+    }
+
+    // Whatever is still buffered for the log sinks is written last, after the warnings above. Other channels are only
+    // formatted when their text is asked for.
+    success = log_flush(&assembly->log) && success;
+    assembly->stats.finish_seconds += stats_now() - start_time;
+    return success;
+}
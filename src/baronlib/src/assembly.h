@@ -0,0 +1,188 @@
+/**
+ *  @file   assembly.h
+ * 
+ *  Internal representation of baron_assembly_t, holding the overlays, logs and derived data produced by an assembly
+ */
+
+#ifndef BARONLIB_ASSEMBLY_H_
+#define BARONLIB_ASSEMBLY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "base/allocator.h"
+#include "base/array.h"
+#include "base/str.h"
+#include "baron/baron.h"
+#include "budget.h"
+#include "lexer.h"
+#include "log.h"
+#include "memmap.h"
+#include "opcodes.h"
+#include "profile.h"
+#include "stats.h"
+#include "symtab.h"
+#include "vfs.h"
+
+
+typedef struct overlay_t overlay_t;
+
+
+/**
+ *  A named stream of object code.
+ *  Overlays which are saved have a load address and occupy memory in the target machine.
+ */
+struct overlay_t {
+    strview_t name;
+    array_uint8_t object_code;
+    uint32_t load_address;
+    uint32_t exec_address;
+    bool is_saved;
+};
+
+def_slice(overlay_t);
+
+
+struct baron_assembly_t {
+    allocator_t allocator;          // Counts allocations against the budget if there is a memory limit
+    int status;
+    budget_t budget;
+    const opcode_table_t *opcodes;
+    array_overlay_t overlays;
+    memmap_t memmap;
+    log_t log;
+    symtab_t symbols;
+    vfs_t files;
+    array_char memory_map;
+    baron_stats_t stats;            // Symbol lookups are counted by the symbol table, and added by baron_assembly_stats
+    stats_allocator_t allocators[baron_memory_use_count];
+    double pass_start_time;
+    profile_t profile;
+    bool is_profiled;
+};
+
+
+/**
+ *  Get the allocator to use for one use of an assembly's memory, which counts the allocations made for it
+ */
+static inline const allocator_t *assembly_allocator(baron_assembly_t *assembly, baron_memory_use_t use) {
+    return &assembly->allocators[use].allocator;
+}
+
+
+/**
+ *  Get the profile which work done by the assembly should be counted in, or null if the assembly isn't profiled
+ */
+static inline profile_t *assembly_profile(baron_assembly_t *assembly) {
+    return assembly->is_profiled ? &assembly->profile : 0;
+}
+
+
+/**
+ *  Make a baron_allocator_t which passes allocations on to an allocator_t, such as a tracker, so that it can be given
+ *  to an assembly through baron_desc_t. The allocator must outlive it.
+ */
+baron_allocator_t make_baron_allocator(const allocator_t *allocator);
+
+
+/**
+ *  Create an empty assembly, with a default overlay, using the environment described by desc
+ * 
+ *  @param  desc            Description of the environment, or null to use defaults
+ * 
+ *  @return Pointer to the new assembly, or null if allocation failed
+ */
+baron_assembly_t *assembly_create(const baron_desc_t *desc);
+
+
+/**
+ *  Destroy an assembly, freeing all its allocations
+ * 
+ *  @param  assembly        Pointer to the assembly to destroy. If null, this does nothing.
+ */
+void assembly_destroy(baron_assembly_t *assembly);
+
+
+/**
+ *  Reset an assembly to the state assembly_create left it in, ready to be reused for another assembly.
+ *  Allocations are kept wherever they can be reused: the default overlay's object code buffer, the symbol table, the
+ *  first region of each log channel's arena and so on, so a reset assembly needs few or no allocations to get going.
+ *
+ *  @param  assembly        Pointer to the assembly to reset
+ */
+void assembly_reset(baron_assembly_t *assembly);
+
+
+/**
+ *  Add a new, empty, unsaved overlay
+ * 
+ *  @param  assembly        Pointer to the assembly
+ *  @param  name            Name of the overlay. This must remain valid for the lifetime of the assembly.
+ * 
+ *  @return Index of the new overlay, or invalid_index if allocation failed
+ */
+uint32_t assembly_add_overlay(baron_assembly_t *assembly, strview_t name);
+
+
+/**
+ *  Find an overlay by name
+ * 
+ *  @param  assembly        Pointer to the assembly
+ *  @param  name            Name of the overlay to find
+ * 
+ *  @return Index of the overlay, or invalid_index if there is none with that name
+ */
+uint32_t assembly_find_overlay(const baron_assembly_t *assembly, strview_t name);
+
+
+/**
+ *  Mark an overlay as saved, to be loaded at the given address.
+ *  The memory it will occupy is indexed when the assembly finishes, once its object code is complete.
+ * 
+ *  @param  assembly        Pointer to the assembly
+ *  @param  overlay_index   Index of the overlay to save
+ *  @param  load_address    Address at which the overlay's object code will be loaded
+ *  @param  exec_address    Address at which execution of the overlay will begin
+ */
+void assembly_save_overlay(baron_assembly_t *assembly, uint32_t overlay_index, uint32_t load_address, uint32_t exec_address);
+
+
+/**
+ *  Tokenize source for the assembly, counting the tokens lexed
+ *
+ *  @param  assembly        Pointer to the assembly
+ *  @param  source          Text to tokenize
+ *  @param  tokens          Pointer to an initialized array to which the tokens will be added
+ *
+ *  @return lex_result_t whose error field is null on success
+ */
+lex_result_t assembly_lex(baron_assembly_t *assembly, strview_t source, array_token_t *tokens);
+
+
+/**
+ *  Begin a pass over the source, starting its timer
+ *
+ *  @param  assembly        Pointer to the assembly
+ *  @param  is_final_pass   Whether this is the final pass, which streams the logs to their sinks
+ */
+void assembly_begin_pass(baron_assembly_t *assembly, bool is_final_pass);
+
+
+/**
+ *  End the pass begun by assembly_begin_pass, recording the time it took
+ */
+void assembly_end_pass(baron_assembly_t *assembly);
+
+
+/**
+ *  Complete the assembly once all passes are done.
+ *  This reports any saved overlays which overwrite each other to the error log as warnings, builds the memory map,
+ *  and passes any text still buffered to the log sinks.
+ * 
+ *  @param  assembly        Pointer to the assembly
+ * 
+ *  @return Success true/false
+ */
+bool assembly_finish(baron_assembly_t *assembly);
+
+
+#endif // ifndef BARONLIB_ASSEMBLY_H_
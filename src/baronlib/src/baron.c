@@ -1,16 +1,336 @@
+#include <stdio.h>
+#include <string.h>
 #include "base/defines.h"
 #include "baron.h"
+#include "assembly.h"
+
+
+struct baron_context_t {
+    baron_assembly_t *assembly;
+};
+
+
+/**
+ *  Assemble source into an empty assembly.
+ *  Statements cannot yet be assembled, so this always fails.
+ */
+static bool assemble_source(baron_assembly_t *assembly, strview_t filename, strview_t source) {
+    UNUSED(source);
+
+    // Work is profiled against the lines of the file being assembled
+    profile_t *profile = assembly_profile(assembly);
+    if (profile && !profile_enter_file(profile, filename)) {
+        return false;
+    }
+
+    log_write(&assembly->log, LOG_CHANNEL_ERRORS, log_message_error, 0, STRVIEW("Statements cannot yet be assembled"));
+    return false;
+}
+
+
+static bool assemble_text(baron_assembly_t *assembly, const char *text) {
+    ASSERT(text);
+    return assemble_source(assembly, STRVIEW("<text>"), make_strview(text));
+}
+
+
+/**
+ *  Assemble a source file into an empty assembly, reading it through the assembly's file system
+ */
+static bool assemble_file(baron_assembly_t *assembly, const char *filename) {
+    ASSERT(filename);
+    strview_t source = vfs_load(&assembly->files, make_strview(filename));
+    if (!strview_is_valid(source)) {
+        log_write(&assembly->log, LOG_CHANNEL_ERRORS, log_message_file_unreadable, 0, make_strview(filename));
+        return false;
+    }
+    return assemble_source(assembly, make_strview(filename), source);
+}
+
+
+/**
+ *  Finish an assembly whether or not its source was assembled, so that its status and error log can be read.
+ *  A limit which stopped it is reported in preference to the errors it caused.
+ */
+static void finish_assembly(baron_assembly_t *assembly, bool is_assembled) {
+    if ((!assembly_finish(assembly) || !is_assembled) && assembly->status == baron_status_ok) {
+        assembly->status = baron_status_error;
+    }
+}
 
 
 baron_assembly_t *baron_assemble(const baron_desc_t *desc, const char *text) {
-    UNUSED(desc);
-    UNUSED(text);
-    return 0;
+    baron_assembly_t *assembly = assembly_create(desc);
+    if (assembly) {
+        finish_assembly(assembly, assemble_text(assembly, text));
+    }
+    return assembly;
 }
 
 
 baron_assembly_t *baron_assemble_from_file(const baron_desc_t *desc, const char *filename) {
-    UNUSED(desc);
-    UNUSED(filename);
-    return 0;
+    baron_assembly_t *assembly = assembly_create(desc);
+    if (assembly) {
+        finish_assembly(assembly, assemble_file(assembly, filename));
+    }
+    return assembly;
+}
+
+
+baron_context_t *baron_context_create(const baron_desc_t *desc) {
+    baron_assembly_t *assembly = assembly_create(desc);
+    if (!assembly) {
+        return 0;
+    }
+    baron_context_t *context = allocator_alloc(&assembly->allocator, sizeof(baron_context_t));
+    if (!context) {
+        assembly_destroy(assembly);
+        return 0;
+    }
+    context->assembly = assembly;
+    return context;
+}
+
+
+void baron_context_destroy(baron_context_t *context) {
+    if (!context) {
+        return;
+    }
+    baron_assembly_t *assembly = context->assembly;
+    allocator_free(&assembly->allocator, context);
+    assembly_destroy(assembly);
+}
+
+
+const baron_assembly_t *baron_context_assemble(baron_context_t *context, const char *text) {
+    ASSERT(context);
+    assembly_reset(context->assembly);
+    finish_assembly(context->assembly, assemble_text(context->assembly, text));
+    return context->assembly;
+}
+
+
+const baron_assembly_t *baron_context_assemble_from_file(baron_context_t *context, const char *filename) {
+    ASSERT(context);
+    assembly_reset(context->assembly);
+    finish_assembly(context->assembly, assemble_file(context->assembly, filename));
+    return context->assembly;
+}
+
+
+void baron_assembly_destroy(baron_assembly_t *baron_assembly) {
+    assembly_destroy(baron_assembly);
+}
+
+
+int baron_assembly_status(const baron_assembly_t *baron_assembly) {
+    ASSERT(baron_assembly);
+    return baron_assembly->status;
+}
+
+
+size_t baron_assembly_hot_lines(const baron_assembly_t *baron_assembly, baron_hot_line_t *hot_lines, size_t max_lines) {
+    ASSERT(baron_assembly);
+    return profile_hot_lines(&baron_assembly->profile, hot_lines, max_lines);
+}
+
+
+bool baron_assembly_profile_write(const baron_assembly_t *baron_assembly, size_t max_lines, baron_write_fn_t write_fn, void *context) {
+    ASSERT(baron_assembly);
+    ASSERT(write_fn);
+
+    // As with symbols, this allocates from the allocator the assembly was created with
+    const allocator_t *allocator = &baron_assembly->budget.parent;
+    if (max_lines == 0 || max_lines > UINT32_MAX / sizeof(baron_hot_line_t)) {
+        return false;
+    }
+    baron_hot_line_t *hot_lines = allocator_alloc(allocator, (uint32_t)(max_lines * sizeof(baron_hot_line_t)));
+    if (!hot_lines) {
+        return false;
+    }
+
+    size_t num_lines = profile_hot_lines(&baron_assembly->profile, hot_lines, max_lines);
+    char text[256];
+    int length = snprintf(text, sizeof text, "%10s %14s %14s  %s\n", "seconds", "steps", "evaluations", "line");
+    bool success = write_fn(text, (size_t)length, context);
+    for (size_t i = 0; success && i < num_lines; i++) {
+        const baron_hot_line_t *hot_line = &hot_lines[i];
+        length = snprintf(text, sizeof text, "%10.6f %14llu %14llu  %s:%u\n", hot_line->seconds,
+            (unsigned long long)hot_line->steps, (unsigned long long)hot_line->evaluations, hot_line->filename, hot_line->line);
+        success = length > 0 && write_fn(text, math_min_uint32((uint32_t)length, sizeof text - 1), context);
+    }
+
+    allocator_free(allocator, hot_lines);
+    return success;
+}
+
+
+void baron_assembly_stats(const baron_assembly_t *baron_assembly, baron_stats_t *stats) {
+    ASSERT(baron_assembly);
+    ASSERT(stats);
+    *stats = baron_assembly->stats;
+    stats->symbol_lookups = baron_assembly->symbols.num_lookups;
+    stats->symbol_probes = baron_assembly->symbols.num_probes;
+    stats->max_symbol_probe_length = baron_assembly->symbols.max_probe_length;
+}
+
+
+baron_object_code_t baron_assembly_object_code(const baron_assembly_t *baron_assembly, const char *overlay_name) {
+    ASSERT(baron_assembly);
+    uint32_t overlay_index = overlay_name ? assembly_find_overlay(baron_assembly, make_strview(overlay_name)) : 0;
+    if (overlay_index == invalid_index) {
+        return (baron_object_code_t){0};
+    }
+    const overlay_t *overlay = &baron_assembly->overlays.data[overlay_index];
+    return (baron_object_code_t){overlay->object_code.data, overlay->object_code.size};
+}
+
+
+const char *baron_assembly_errors(const baron_assembly_t *baron_assembly) {
+    return baron_assembly_log(baron_assembly, LOG_CHANNEL_ERRORS);
+}
+
+
+const char *baron_assembly_log(const baron_assembly_t *baron_assembly, int log_number) {
+    ASSERT(baron_assembly);
+    if (log_number < 0 || log_number >= LOG_NUM_CHANNELS) {
+        return 0;
+    }
+    // Records were formatted when the assembly finished, so reading the text changes nothing
+    return log_text(&baron_assembly->log, (uint32_t)log_number);
+}
+
+
+const char *baron_assembly_memory_map(const baron_assembly_t *baron_assembly) {
+    ASSERT(baron_assembly);
+    return baron_assembly->memory_map.data;
+}
+
+
+baron_value_type_t baron_assembly_symbol_type(const baron_assembly_t *baron_assembly, const char *symbol_name) {
+    ASSERT(baron_assembly);
+    ASSERT(symbol_name);
+    const symbol_t *symbol = symtab_find(&baron_assembly->symbols, make_strview(symbol_name));
+    return symbol ? symbol->value.type : baron_value_none;
+}
+
+
+const double *baron_assembly_symbol_numeric(const baron_assembly_t *baron_assembly, const char *symbol_name) {
+    ASSERT(baron_assembly);
+    ASSERT(symbol_name);
+    const symbol_t *symbol = symtab_find(&baron_assembly->symbols, make_strview(symbol_name));
+    return (symbol && symbol->value.type == baron_value_numeric) ? &symbol->value.number : 0;
+}
+
+
+static baron_symbol_t make_symbol_view(const symbol_t *symbol) {
+    baron_symbol_t view = {
+        .name = (const char *)symbol->name.data,
+        .name_length = symbol->name.length,
+        .type = symbol->value.type
+    };
+    if (symbol->value.type == baron_value_numeric) {
+        view.number = symbol->value.number;
+    }
+    else if (symbol->value.type == baron_value_string) {
+        strview_t string = string_view(&symbol->value);
+        view.string = (const char *)string.data;
+        view.string_length = string.length;
+    }
+    return view;
+}
+
+
+static bool is_in_scope(strview_t name, strview_t scope) {
+    return name.length > scope.length && name.data[scope.length] == '.' && strview_startswith(name, scope);
+}
+
+
+size_t baron_assembly_visit_symbols(const baron_assembly_t *baron_assembly, const baron_symbol_filter_t *filter,
+                                    bool (*visit_fn)(const baron_symbol_t *symbol, void *context), void *context) {
+    ASSERT(baron_assembly);
+    ASSERT(visit_fn);
+    strview_t scope = (filter && filter->scope) ? make_strview(filter->scope) : (strview_t){0};
+    uint32_t types = (filter && filter->types) ? filter->types : ~0U;
+
+    size_t num_visited = 0;
+    const array_symbol_t *symbols = &baron_assembly->symbols.symbols;
+    for (uint32_t i = 0; i < symbols->size; i++) {
+        const symbol_t *symbol = &symbols->data[i];
+        if (!(types & (1U << symbol->value.type)) || (scope.data && !is_in_scope(symbol->name, scope))) {
+            continue;
+        }
+        baron_symbol_t view = make_symbol_view(symbol);
+        num_visited++;
+        if (!visit_fn(&view, context)) {
+            break;
+        }
+    }
+    return num_visited;
+}
+
+
+size_t baron_assembly_find_symbols(const baron_assembly_t *baron_assembly, const char *const *names, size_t num_names,
+                                   baron_symbol_t *symbols) {
+    ASSERT(baron_assembly);
+    ASSERT(names || num_names == 0);
+    ASSERT(symbols || num_names == 0);
+    size_t num_found = 0;
+    for (size_t i = 0; i < num_names; i++) {
+        const symbol_t *symbol = symtab_find(&baron_assembly->symbols, make_strview(names[i]));
+        symbols[i] = symbol ? make_symbol_view(symbol) : (baron_symbol_t){0};
+        num_found += !!symbol;
+    }
+    return num_found;
+}
+
+
+bool baron_assembly_symbols_write(const baron_assembly_t *baron_assembly, baron_write_fn_t write_fn, void *context) {
+    ASSERT(baron_assembly);
+    // A finished assembly may be read from several threads at once, so this allocates from the allocator the assembly
+    // was created with, rather than one which counts allocations for the assembly's statistics or budget
+    return symtab_write_binary(&baron_assembly->symbols, &baron_assembly->budget.parent, write_fn, context);
+}
+
+
+static bool write_to_file(const void *data, size_t size, void *context) {
+    return fwrite(data, 1, size, context) == size;
+}
+
+
+bool baron_assembly_symbols_save(const baron_assembly_t *baron_assembly, const char *filename) {
+    ASSERT(filename);
+    FILE *file = fopen(filename, "wb");
+    if (!file) {
+        return false;
+    }
+
+    bool success = baron_assembly_symbols_write(baron_assembly, write_to_file, file);
+    return (fclose(file) == 0) && success;
+}
+
+
+size_t baron_assembly_disk_files(const baron_assembly_t *baron_assembly, baron_disk_file_t *files, size_t max_files) {
+    ASSERT(baron_assembly);
+    size_t num_files = 0;
+    for (uint32_t i = 0; i < baron_assembly->overlays.size; i++) {
+        const overlay_t *overlay = &baron_assembly->overlays.data[i];
+        if (!overlay->is_saved) {
+            continue;
+        }
+        if (files && num_files < max_files) {
+            baron_disk_file_t *file = &files[num_files];
+            *file = (baron_disk_file_t){
+                .load_address = overlay->load_address,
+                .exec_address = overlay->exec_address,
+                .object_code = {overlay->object_code.data, overlay->object_code.size}
+            };
+            // A name too long to be a DFS filename is left empty, so that writing the disk image rejects it
+            if (overlay->name.length < sizeof file->name) {
+                memcpy(file->name, overlay->name.data, overlay->name.length);
+            }
+        }
+        num_files++;
+    }
+    return num_files;
 }
@@ -21,11 +21,15 @@ typedef struct allocator_t allocator_t;
 struct arena_t {
     const allocator_t *child_allocator;
     struct arena_region_t *_region;
+    uint32_t region_size;
 };
 
 
 /**
- *  Make an arena
+ *  Make an arena. No memory is allocated until the first allocation is made from it.
+ *
+ *  @param  allocator       Allocator from which regions are allocated
+ *  @param  region_size     Size of each region; larger allocations get a region of their own. If 0, a default is used.
  */
 arena_t make_arena(const allocator_t *allocator, uint32_t region_size);
 
@@ -37,19 +41,29 @@ void arena_init(arena_t *arena, const allocator_t *allocator, uint32_t initial_s
 
 
 /**
- *  Deinitialize an arena
+ *  Deinitialize an arena, freeing all of its regions
  */
 void arena_deinit(arena_t *arena);
 
 
 /**
- *  Allocate from an arena
+ *  Allocate zeroed memory from an arena, aligned to 16 bytes
  */
 void *arena_alloc(arena_t *arena, uint32_t size);
 
 
 /**
- *  Reset an arena, deallocating everything
+ *  Reallocate memory from an arena.
+ *  The most recent allocation is resized in place if there is room, so a buffer which is repeatedly grown while nothing
+ *  else is allocated doesn't leave copies of itself behind. Otherwise a new allocation is made, and the data copied.
+ *
+ *  @return Pointer to the allocation, or null if it failed, in which case the old allocation is unaffected
+ */
+void *arena_realloc(arena_t *arena, void *ptr, uint32_t size);
+
+
+/**
+ *  Reset an arena, deallocating everything. The most recent region is kept for reuse.
  */
 void arena_reset(arena_t *arena);
 
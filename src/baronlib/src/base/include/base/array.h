@@ -124,7 +124,8 @@ def_slice(double);
  * 
  *  @return true/false
  */
-#define array_contains_slice(array, slice) ((slice).data - (array)->data >= 0 && (slice).data - (array)->data < (array)->size)
+#define array_contains_slice(array, slice) \
+    ((uintptr_t)(slice).data - (uintptr_t)(array)->data < (uintptr_t)(array)->size * sizeof *(array)->data)
 
 
 /**
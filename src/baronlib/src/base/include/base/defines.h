@@ -71,11 +71,13 @@
 
 static inline int32_t math_min_int32(int32_t a, int32_t b) { return a < b ? a : b; }
 static inline uint32_t math_min_uint32(uint32_t a, uint32_t b) { return a < b ? a : b; }
+static inline uint64_t math_min_uint64(uint64_t a, uint64_t b) { return a < b ? a : b; }
 static inline float math_min_float(float a, float b) { return a < b ? a : b; }
 static inline double math_min_double(double a, double b) { return a < b ? a : b; }
 
 static inline int32_t math_max_int32(int32_t a, int32_t b) { return a > b ? a : b; }
 static inline uint32_t math_max_uint32(uint32_t a, uint32_t b) { return a > b ? a : b; }
+static inline uint64_t math_max_uint64(uint64_t a, uint64_t b) { return a > b ? a : b; }
 static inline float math_max_float(float a, float b) { return a > b ? a : b; }
 static inline double math_max_double(double a, double b) { return a > b ? a : b; }
 
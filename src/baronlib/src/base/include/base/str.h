@@ -12,6 +12,7 @@
 
 typedef struct str_t str_t;
 typedef struct strview_t strview_t;
+typedef struct allocator_t allocator_t;
 
 struct strview_t {
 	const uint8_t *data;
@@ -26,6 +27,8 @@ struct str_t {
 		};
 		strview_t view;
 	};
+	uint32_t capacity;
+	const allocator_t *allocator;
 };
 
 
@@ -41,14 +44,16 @@ struct str_t {
 
 
 /**
- *  Make an empty str with the given capacity
+ *  Make an empty str with the given capacity.
+ *  A str's data is always followed by a zero terminator, which isn't counted in its length or capacity.
  * 
+ *  @param	allocator		The allocator used to hold the string's data, e.g. an arena allocator
  *  @param	capacity		The initial capacity that will be reserved for the string
  * 
  *  @return A new str_t instance.
  *          If allocation failed, the str is invalid.
  */
-str_t make_str(uint32_t capacity);
+str_t make_str(const allocator_t *allocator, uint32_t capacity);
 
 
 /**
@@ -90,10 +95,22 @@ void str_deinit(str_t *str);
 
 
 /**
- *  Append a strview to the given str
+ *  Reserve capacity in a str
+ * 
+ *  @param	str				Pointer to the str
+ *  @param	capacity		The capacity required
+ * 
+ *  @return	Whether successful, true/false. On failure the str is unchanged.
+ */
+bool str_reserve(str_t *str, uint32_t capacity);
+
+
+/**
+ *  Append a strview to the given str.
+ *  The capacity grows by doubling, so the cost of repeated appends is amortised constant per byte.
  * 
  *  @param	str				Pointer to the str to be appended to
- *  @param	append_str		strview to be appended
+ *  @param	append_str		strview to be appended, which may be a view of the str itself
  * 
  *  @return	Whether the append was successful, true/false
  */
@@ -146,6 +163,16 @@ bool strview_equal(strview_t a, strview_t b);
 int strview_compare(strview_t a, strview_t b);
 
 
+/**
+ *	Calculate a hash of a strview's contents, suitable for hash table lookups
+ * 
+ *  @param	s			strview to hash
+ *
+ *  @return 32-bit FNV-1a hash
+ */
+uint32_t strview_hash(strview_t s);
+
+
 /**
  *	Get the leftmost chars of a strview
  */
@@ -249,10 +276,12 @@ typedef struct strview_parse_int_result_t strview_parse_int_result_t;
 struct strview_parse_int_result_t {
 	int64_t value;
 	uint32_t length_parsed;
+	bool overflow;
 };
 
 /**
- *  Parses the given strview as a decimal numeric value
+ *  Parses the given strview as a decimal numeric value, with an optional leading minus sign.
+ *  If the value doesn't fit in an int64_t, overflow is set, the value saturates, and all the digits are still parsed.
  */
 strview_parse_int_result_t strview_parse_int(strview_t src);
 
@@ -261,14 +290,59 @@ typedef struct strview_parse_hex_result_t strview_parse_hex_result_t;
 struct strview_parse_hex_result_t {
 	uint64_t value;
 	uint32_t length_parsed;
+	bool overflow;
 };
 
 /**
- *  Parses the given strview as a hex numeric value
+ *  Parses the given strview as a hex numeric value, without any prefix.
+ *  If the value doesn't fit in a uint64_t, overflow is set, the value saturates, and all the digits are still parsed.
  */
 strview_parse_hex_result_t strview_parse_hex(strview_t src);
 
 
+/**
+ *  Parses the given strview as a binary numeric value, without any prefix, in the same way as strview_parse_hex
+ */
+strview_parse_hex_result_t strview_parse_bin(strview_t src);
+
+
+typedef struct strview_parse_float_result_t strview_parse_float_result_t;
+struct strview_parse_float_result_t {
+	double value;
+	uint32_t length_parsed;
+};
+
+/**
+ *  Parses the given strview as a decimal floating point value, with an optional leading minus sign, an optional
+ *  fractional part and an optional exponent, e.g. -1.5E-3. The leading digits may be omitted, as in .5.
+ *  The result is correctly rounded, and doesn't depend on the C locale.
+ */
+strview_parse_float_result_t strview_parse_float(strview_t src);
+
+
+// Maximum length of a double formatted by str_format_double
+#define STR_DOUBLE_MAX_LENGTH 32
+
+/**
+ *  Formats a double with the fewest significant digits which parse back to the same value, e.g. 0.1, 42, 1.5E-7.
+ *  Numbers from 0.00001 up to 1E17 are written without an exponent. The C locale is not used.
+ *
+ *  @param	value			The value to format
+ *  @param	buffer			Buffer to receive the text, which is not zero terminated
+ *
+ *  @return	The length of the text
+ */
+uint32_t str_format_double(double value, uint8_t buffer[STR_DOUBLE_MAX_LENGTH]);
+
+
+/**
+ *  Appends a double to the given str, formatted as by str_format_double
+ *
+ *  @return	Whether the append was successful, true/false
+ */
+bool str_append_double(str_t *str, double value);
+
+
 /**
  *	Macro to output {length, data} parameters to a %.*s printf formatter, to print a cstr
  */
@@ -5,6 +5,15 @@
 #include "base/str.h"
 
 
+// ELF linkers only synthesize __start_/__stop_ symbols for sections whose names are valid C identifiers,
+// whereas MSVC and COFF targets sort "test$a".."test$c" sections alphabetically
+#if COMPILER_GCC
+#define TEST_SECTION SECTION("test")
+#else
+#define TEST_SECTION SECTION("test$b")
+#endif
+
+
 typedef struct test_item test_item;
 
 struct test_item {
@@ -25,7 +34,7 @@ struct test_item {
 		.test_name = #test, \
 		.test_fn = test_##group##_##test \
 	}; \
-    SECTION("test$b") const test_item *test_item_ptr_##group##_##test = &test_item_##group##_##test; \
+    TEST_SECTION const test_item *test_item_ptr_##group##_##test = &test_item_##group##_##test; \
 	static void test_##group##_##test(void)
 
 #define DEF_TEST_SKIP(group, test) \
@@ -34,7 +43,7 @@ struct test_item {
 		.group_name = #group, \
 		.test_name = #test, \
 	}; \
-    SECTION("test$b") const test_item *test_item_ptr_##group##_##test = &test_item_##group##_##test; \
+    TEST_SECTION const test_item *test_item_ptr_##group##_##test = &test_item_##group##_##test; \
 	static void test_##group##_##test(void)
 
 #define DEF_TEST_GROUP_DATA(group) \
@@ -64,7 +73,7 @@ struct test_item {
 		.deinit_fn = (void(**)(void *))&test_group_deinitfn_##group, \
 		.context = &test_group_data_##group##_##test \
 	}; \
-    SECTION("test$b") const test_item *test_item_ptr_##group##_##test = &test_item_##group##_##test; \
+    TEST_SECTION const test_item *test_item_ptr_##group##_##test = &test_item_##group##_##test; \
 	static void test_##group##_##test(struct test_group_data_##group *data)
 
 #define DEF_TEST_STEP_SKIP(group, test) \
@@ -75,7 +84,7 @@ struct test_item {
 		.test_name = #test, \
 		.context = &test_group_data_##group##_##test \
 	}; \
-    SECTION("test$b") const test_item *test_item_ptr_##group##_##test = &test_item_##group##_##test; \
+    TEST_SECTION const test_item *test_item_ptr_##group##_##test = &test_item_##group##_##test; \
 	static void test_##group##_##test(struct test_group_data_##group *data)
 
 
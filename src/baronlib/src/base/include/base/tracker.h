@@ -0,0 +1,104 @@
+/**
+ *  @file   tracker.h
+ *
+ *  A tracker wraps another allocator, recording what is allocated through it: how many calls are made, how many bytes
+ *  are requested, how many remain live and the peak live at any time. Allocations are also counted into a histogram of
+ *  their sizes, and attributed to a tag naming the call site or phase which made them, so that the places where
+ *  allocations are made most often, or leaked, can be found.
+ *
+ *  Each allocation is given a 16 byte header holding its size and tag, so every allocation made through a tracker must
+ *  also be reallocated and freed through it.
+ */
+
+#ifndef TRACKER_H_
+#define TRACKER_H_
+
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct tracker_t tracker_t;
+typedef struct tracker_counts_t tracker_counts_t;
+typedef struct tracker_tag_t tracker_tag_t;
+typedef struct allocator_t allocator_t;
+
+
+// Maximum number of distinct tags; allocations made under any further tags are counted as untagged
+#define TRACKER_MAX_TAGS 32
+
+// Size classes of the histogram: class 0 holds empty allocations, and class n sizes from 2^(n-1) to 2^n - 1
+#define TRACKER_NUM_SIZE_CLASSES 33
+
+
+struct tracker_counts_t {
+    uint64_t num_allocs;            // Calls to alloc, and to realloc with a null pointer
+    uint64_t num_reallocs;          // Calls to realloc which resize an existing allocation
+    uint64_t num_frees;
+    uint64_t bytes_requested;       // Total of the sizes passed to alloc and realloc
+    uint64_t live_blocks;
+    uint64_t live_bytes;
+    uint64_t peak_bytes;
+};
+
+
+struct tracker_tag_t {
+    const char *name;               // Null for untagged allocations
+    tracker_counts_t counts;
+};
+
+
+struct tracker_t {
+    const allocator_t *child_allocator;
+    const char *tag;                // Tag given to allocations made now
+    uint32_t tag_index;             // Index of that tag in tags
+    tracker_counts_t totals;
+    uint64_t size_classes[TRACKER_NUM_SIZE_CLASSES];
+    tracker_tag_t tags[TRACKER_MAX_TAGS];   // The first is for untagged allocations
+    uint32_t num_tags;
+};
+
+
+/**
+ *  Initialize a tracker, with nothing recorded and no current tag
+ *
+ *  @param  tracker         Pointer to the tracker to initialize
+ *  @param  allocator       Allocator which tracked allocations are passed on to
+ */
+void tracker_init(tracker_t *tracker, const allocator_t *allocator);
+
+
+/**
+ *  Set the tag given to subsequent allocations.
+ *  Tags with equal names are counted together; the name must outlive the tracker.
+ *
+ *  @param  tracker         Pointer to the tracker
+ *  @param  tag             Name of the tag, or null to leave subsequent allocations untagged
+ *
+ *  @return The previous tag, so that it can be restored
+ */
+const char *tracker_set_tag(tracker_t *tracker, const char *tag);
+
+
+/**
+ *  Print the counts of a tracker: the totals, the histogram of allocation sizes, and the counts of each tag.
+ *  Allocations which are still live are reported as leaks.
+ *
+ *  @param  tracker         Pointer to the tracker
+ *  @param  file            File to print to
+ */
+void tracker_print(const tracker_t *tracker, FILE *file);
+
+
+/**
+ *  Return an allocator which tracks allocations with the given tracker
+ */
+allocator_t tracker_allocator(tracker_t *tracker);
+
+
+/**
+ *  Get the size requested for a live allocation made through a tracker
+ */
+uint32_t tracker_block_size(const void *ptr);
+
+
+#endif // ifndef TRACKER_H_
@@ -1,3 +1,4 @@
+#include <stdbool.h>
 #include <string.h>
 #include "arena.h"
 #include "allocator.h"
@@ -16,54 +17,111 @@ struct arena_region_t {
 };
 
 struct arena_region_alloc_header_t {
-    uint32_t prev;
+    uint32_t size;
 };
 
 
+#define ARENA_REGION_HEADER_SIZE ((uint32_t)((sizeof(arena_region_t) + 0x0F) & ~0x0F))
+
+
 static uint32_t get_aligned_size(uint32_t size) {
     return ((size + 0x0F) & ~0x0F) + 0x10;
 }
 
 
+static arena_region_alloc_header_t *get_alloc_header(void *ptr) {
+    return (arena_region_alloc_header_t *)((uint8_t *)ptr - 0x10);
+}
+
+
 arena_t make_arena(const allocator_t *allocator, uint32_t region_size) {
     return (arena_t){
         .child_allocator = allocator,
-        ._region = allocator_alloc(allocator, get_aligned_size(region_size))
+        .region_size = (region_size > 0) ? region_size : ARENA_REGION_SIZE
     };
 }
 
 
 void arena_init(arena_t *arena, const allocator_t *allocator, uint32_t initial_size) {
     ASSERT(arena);
-    UNUSED(initial_size);
-    arena_deinit(arena);
-    arena->child_allocator = allocator;
+    *arena = make_arena(allocator, initial_size);
 }
 
 
 void arena_deinit(arena_t *arena) {
     ASSERT(arena);
+    arena_region_t *region = arena->_region;
+    while (region) {
+        arena_region_t *to_free = region;
+        region = region->next;
+        allocator_free(arena->child_allocator, to_free);
+    }
+    arena->_region = 0;
 }
 
 
 void *arena_alloc(arena_t *arena, uint32_t size) {
     ASSERT(arena);
 
-    size = ((size + 0x0F) & ~0x0F) + 0x10;
-    if (!arena->_region || arena->_region->end - arena->_region->start < size) {
+    uint32_t aligned_size = get_aligned_size(size);
+    if (aligned_size < size) {
+        return 0;
+    }
 
-        uint32_t region_size = (size > ARENA_REGION_SIZE) ? size : ARENA_REGION_SIZE;
-        arena_region_t *new_region = allocator_alloc(arena->child_allocator, region_size);
-        if (!new_region) {
+    arena_region_t *region = arena->_region;
+    if (!region || region->end - region->start < aligned_size) {
+
+        uint32_t region_size = math_max_uint32(aligned_size + ARENA_REGION_HEADER_SIZE, arena->region_size);
+        if (region_size < aligned_size) {
+            return 0;
+        }
+        region = allocator_alloc(arena->child_allocator, region_size);
+        if (!region) {
             return 0;
         }
 
-        new_region->next = arena->_region;
-        new_region->start = (sizeof(arena_region_t) + 0x0F) & ~0x0F;
-        new_region->end = region_size;
+        region->next = arena->_region;
+        region->start = ARENA_REGION_HEADER_SIZE;
+        region->end = region_size;
+        arena->_region = region;
     }
 
-    return 0; //todo
+    // Allocations are zeroed, like those of the default allocator
+    uint8_t *ptr = (uint8_t *)region + region->start + 0x10;
+    region->start += aligned_size;
+    get_alloc_header(ptr)->size = size;
+    memset(ptr, 0, size);
+    return ptr;
+}
+
+
+void *arena_realloc(arena_t *arena, void *ptr, uint32_t size) {
+    ASSERT(arena);
+    if (!ptr) {
+        return arena_alloc(arena, size);
+    }
+
+    // The most recent allocation can be resized in place, if its region has room
+    arena_region_alloc_header_t *header = get_alloc_header(ptr);
+    arena_region_t *region = arena->_region;
+    uint32_t old_aligned_size = get_aligned_size(header->size);
+    uint32_t new_aligned_size = get_aligned_size(size);
+    if (new_aligned_size < size) {
+        return 0;
+    }
+
+    bool is_last = region && (uint8_t *)header + old_aligned_size == (uint8_t *)region + region->start;
+    if (is_last && (new_aligned_size <= old_aligned_size || new_aligned_size - old_aligned_size <= region->end - region->start)) {
+        region->start = region->start - old_aligned_size + new_aligned_size;
+        header->size = size;
+        return ptr;
+    }
+
+    void *new_ptr = arena_alloc(arena, size);
+    if (new_ptr) {
+        memcpy(new_ptr, ptr, math_min_uint32(size, header->size));
+    }
+    return new_ptr;
 }
 
 
@@ -76,6 +134,8 @@ void arena_reset(arena_t *arena) {
             ptr = ptr->next;
             allocator_free(arena->child_allocator, to_free);
         }
+        arena->_region->next = 0;
+        arena->_region->start = ARENA_REGION_HEADER_SIZE;
     }
 }
 
@@ -86,16 +146,7 @@ static void *arena_allocator_alloc(uint32_t size, void *context) {
 
 
 static void *arena_allocator_realloc(void *ptr, uint32_t size, void *context) {
-    void *new_ptr = arena_alloc(context, size);
-    if (new_ptr) {
-        if (ptr) {
-            memcpy(new_ptr, ptr, size);
-        }
-        return new_ptr;
-    }
-    else {
-        return 0;
-    }
+    return arena_realloc(context, ptr, size);
 }
 
 
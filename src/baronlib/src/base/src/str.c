@@ -1,9 +1,89 @@
 #include <string.h>
+#include "base/allocator.h"
 #include "base/defines.h"
 #include "base/str.h"
 
 
 
+str_t make_str(const allocator_t *allocator, uint32_t capacity) {
+	str_t str = {.capacity = capacity, .allocator = allocator};
+	if (capacity < UINT32_MAX) {
+		str.data = allocator_alloc(allocator, capacity + 1);
+	}
+	if (str.data) {
+		str.data[0] = 0;
+	}
+	return str;
+}
+
+
+void str_reset(str_t *str) {
+	ASSERT(str_is_valid(str));
+	str->length = 0;
+	str->data[0] = 0;
+}
+
+
+bool str_is_empty(const str_t *str) {
+	ASSERT(str);
+	return str->length == 0;
+}
+
+
+void str_deinit(str_t *str) {
+	ASSERT(str);
+	allocator_free(str->allocator, str->data);
+	*str = (str_t){0};
+}
+
+
+bool str_reserve(str_t *str, uint32_t capacity) {
+	if (!str_is_valid(str) || capacity == UINT32_MAX) {
+		return false;
+	}
+	if (capacity > str->capacity) {
+		uint8_t *data = allocator_realloc(str->allocator, str->data, capacity + 1);
+		if (!data) {
+			return false;
+		}
+		str->data = data;
+		str->capacity = capacity;
+	}
+	return true;
+}
+
+
+bool str_append(str_t *str, strview_t append_str) {
+	ASSERT(strview_is_valid(append_str));
+	if (!str_is_valid(str)) {
+		return false;
+	}
+
+	uint32_t required = str->length + append_str.length;
+	if (required < str->length) {
+		return false;
+	}
+
+	if (required > str->capacity) {
+		// The strview may be a view of the str itself, so find it again after the data moves
+		uintptr_t offset = (uintptr_t)append_str.data - (uintptr_t)str->data;
+		bool is_own = offset <= str->length;
+		uint32_t doubled = (str->capacity < UINT32_MAX / 2) ? str->capacity * 2 : UINT32_MAX - 1;
+		if (!str_reserve(str, math_max_uint32(required, doubled))) {
+			return false;
+		}
+		if (is_own) {
+			append_str.data = str->data + offset;
+		}
+	}
+
+	memmove(str->data + str->length, append_str.data, append_str.length);
+	str->length = required;
+	str->data[required] = 0;
+	return true;
+}
+
+
 strview_t make_strview(const char *s) {
 	return (strview_t){(const uint8_t *)s, (uint32_t)strlen(s)};
 }
@@ -27,6 +107,16 @@ int strview_compare(strview_t a, strview_t b) {
 }
 
 
+uint32_t strview_hash(strview_t s) {
+	ASSERT(strview_is_valid(s));
+	uint32_t hash = 2166136261U;
+	for (uint32_t i = 0; i < s.length; i++) {
+		hash = (hash ^ s.data[i]) * 16777619U;
+	}
+	return hash;
+}
+
+
 strview_t strview_left(strview_t s, uint32_t count) {
 	ASSERT(strview_is_valid(s));
 	return (strview_t){s.data, math_min_uint32(count, s.length)};
@@ -75,22 +165,76 @@ bool strview_endswith(strview_t a, strview_t b) {
 
 
 uint32_t strview_find_first(strview_t a, strview_t b) {
-	uint32_t count = (a.length >= b.length) ? a.length - b.length + 1 : 0;
-	for (uint32_t i = 0; i < count; i++) {
-		if (memcmp(a.data + i, b.data, b.length) == 0) {
-			return i;
+	if (a.length < b.length) {
+		return invalid_index;
+	}
+	if (b.length == 0) {
+		return 0;
+	}
+
+	// Scan for the first byte of b with memchr, which is vectorised by the C library, and only then compare the rest
+	const uint8_t *start = a.data;
+	const uint8_t *last = a.data + a.length - b.length;
+	while (start <= last) {
+		const uint8_t *found = memchr(start, b.data[0], (size_t)(last - start) + 1);
+		if (!found) {
+			break;
+		}
+		if (memcmp(found + 1, b.data + 1, b.length - 1) == 0) {
+			return (uint32_t)(found - a.data);
 		}
+		start = found + 1;
 	}
 	return invalid_index;
 }
 
 
+/**
+ *	Find the last occurrence of a byte, in the manner of the non-standard memrchr.
+ *	Eight bytes are tested at a time, by checking the word for a zero byte after XORing it with the byte sought.
+ *	The test can give false positives in the bytes above a match, so a word which passes is then scanned bytewise.
+ */
+static const uint8_t *find_last_byte(const uint8_t *data, uint32_t length, uint8_t c) {
+	const uint64_t ones = 0x0101010101010101U;
+	const uint64_t highs = 0x8080808080808080U;
+	const uint64_t pattern = ones * c;
+
+	while (length >= 8) {
+		uint64_t word;
+		memcpy(&word, data + length - 8, 8);
+		word ^= pattern;
+		if (((word - ones) & ~word & highs) != 0) {
+			break;
+		}
+		length -= 8;
+	}
+	while (length > 0) {
+		if (data[--length] == c) {
+			return data + length;
+		}
+	}
+	return 0;
+}
+
+
 uint32_t strview_find_last(strview_t a, strview_t b) {
-	uint32_t start = (a.length >= b.length) ? a.length - b.length + 1 : 0;
-	for (uint32_t i = start; i-- > 0; ) {
-		if (memcmp(a.data + i, b.data, b.length) == 0) {
-			return i;
+	if (a.length < b.length) {
+		return invalid_index;
+	}
+	if (b.length == 0) {
+		return a.length;
+	}
+
+	uint32_t count = a.length - b.length + 1;
+	while (count > 0) {
+		const uint8_t *found = find_last_byte(a.data, count, b.data[0]);
+		if (!found) {
+			break;
 		}
+		if (memcmp(found + 1, b.data + 1, b.length - 1) == 0) {
+			return (uint32_t)(found - a.data);
+		}
+		count = (uint32_t)(found - a.data);
 	}
 	return invalid_index;
 }
@@ -141,35 +285,101 @@ strview_pair_t strview_last_split(strview_t src, strview_t split_by) {
 }
 
 
-strview_parse_int_result_t strview_parse_int(strview_t src) {
-	int64_t value = 0;
-	uint32_t i = 0;
+// Loads 8 bytes as a little-endian word, so that the first byte is the least significant whatever the platform.
+// Compilers reduce this to a single load on little-endian targets.
+static uint64_t load_le64(const uint8_t *p) {
+	return (uint64_t)p[0]       | (uint64_t)p[1] << 8  | (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24 |
+	       (uint64_t)p[4] << 32 | (uint64_t)p[5] << 40 | (uint64_t)p[6] << 48 | (uint64_t)p[7] << 56;
+}
 
-	bool negative = (src.length > 0 && src.data[0] == '-' && src.data[1] >= '0' && src.data[1] <= '9');
-	if (negative) {
-		i++;
+
+// Sets the top bit of each byte of the word which lies within [lo, hi]; every byte must be below 0x80
+#define SWAR_IN_RANGE(word, lo, hi) \
+	(((word) + 0x0101010101010101U * (0x80 - (lo))) & ~((word) + 0x0101010101010101U * (0x7F - (hi))) & 0x8080808080808080U)
+
+
+// Parses 8 decimal digits at once, returning false if they're not all digits
+static bool parse_8_decimal_digits(const uint8_t *p, uint64_t *value) {
+	uint64_t word = load_le64(p);
+	if ((word & 0x8080808080808080U) || SWAR_IN_RANGE(word, '0', '9') != 0x8080808080808080U) {
+		return false;
 	}
+	// Combine pairs of digits, then pairs of pairs, and so on
+	word = (word & 0x0F0F0F0F0F0F0F0FU) * ((10 << 8) + 1) >> 8;
+	word = (word & 0x00FF00FF00FF00FFU) * ((100 << 16) + 1) >> 16;
+	word = (word & 0x0000FFFF0000FFFFU) * ((10000ULL << 32) + 1) >> 32;
+	*value = word;
+	return true;
+}
 
-	while (i < src.length && src.data[i] >= '0' && src.data[i] <= '9') {
-		// @todo: catch overflow
-		value = value * 10 + (src.data[i] - '0');
-		i++;
+
+// Parses 8 hex digits at once, returning false if they're not all hex digits
+static bool parse_8_hex_digits(const uint8_t *p, uint64_t *value) {
+	uint64_t word = load_le64(p);
+	if (word & 0x8080808080808080U) {
+		return false;
+	}
+	uint64_t digits = SWAR_IN_RANGE(word, '0', '9');
+	uint64_t letters = SWAR_IN_RANGE(word | 0x2020202020202020U, 'a', 'f');
+	if ((digits | letters) != 0x8080808080808080U) {
+		return false;
 	}
+	// Letters have 9 added to their low nibble, then adjacent nibbles, bytes and halfwords are combined
+	word = (word & 0x0F0F0F0F0F0F0F0FU) + (letters >> 7) * 9;
+	word = (word & 0x000F000F000F000FU) << 4 | (word & 0x0F000F000F000F00U) >> 8;
+	word = (word & 0x000000FF000000FFU) << 8 | (word & 0x00FF000000FF0000U) >> 16;
+	*value = (word & 0xFFFF) << 16 | (word >> 32 & 0xFFFF);
+	return true;
+}
 
-	if (negative) {
-		value = -value;
+
+// Parses 8 binary digits at once, returning false if they're not all binary digits
+static bool parse_8_binary_digits(const uint8_t *p, uint64_t *value) {
+	uint64_t word = load_le64(p);
+	if ((word & 0xFEFEFEFEFEFEFEFEU) != 0x3030303030303030U) {
+		return false;
 	}
+	// Gather the low bit of each byte into the top byte, with the first digit the most significant
+	*value = (word & 0x0101010101010101U) * 0x8040201008040201U >> 56;
+	return true;
+}
+
 
-	return (strview_parse_int_result_t){value, i};
+// Accumulates digits, 8 at a time where possible, into an unsigned value, flagging overflow.
+// After overflow, any remaining digits are still consumed.
+typedef bool (*parse_8_digits_fn_t)(const uint8_t *p, uint64_t *value);
+
+static uint32_t parse_digits(strview_t src, uint32_t i, uint32_t base, uint32_t (*digit_value)(uint8_t c),
+                             parse_8_digits_fn_t parse_8_digits, uint64_t chunk_multiplier, uint64_t *value, bool *overflow) {
+	uint64_t result = 0;
+	uint64_t chunk;
+	while (i + 8 <= src.length && parse_8_digits(src.data + i, &chunk)) {
+		if (result > (UINT64_MAX - chunk) / chunk_multiplier) {
+			*overflow = true;
+		}
+		result = result * chunk_multiplier + chunk;
+		i += 8;
+	}
+
+	uint32_t digit;
+	while (i < src.length && (digit = digit_value(src.data[i])) < base) {
+		if (result > (UINT64_MAX - digit) / base) {
+			*overflow = true;
+		}
+		result = result * base + digit;
+		i++;
+	}
+
+	*value = result;
+	return i;
 }
 
 
-static bool is_hex_digit(uint8_t c) {
-	return (c >= '0' && c <= '9') ||
-	       (c >= 'A' && c <= 'F') ||
-		   (c >= 'a' && c <= 'f');
+static uint32_t get_decimal_digit_value(uint8_t c) {
+	return (uint32_t)(c - '0') < 10 ? (uint32_t)(c - '0') : invalid_index;
 }
 
+
 static uint32_t get_hex_digit_value(uint8_t c) {
 	if (c >= '0' && c <= '9') {
 		return c - '0';
@@ -180,18 +390,52 @@ static uint32_t get_hex_digit_value(uint8_t c) {
 	else if (c >= 'a' && c <= 'f') {
 		return c + 10 - 'a';
 	}
-	UNREACHABLE();
+	return invalid_index;
 }
 
-strview_parse_hex_result_t strview_parse_hex(strview_t src) {
-	uint64_t value = 0;
+
+static uint32_t get_binary_digit_value(uint8_t c) {
+	return (uint32_t)(c - '0') < 2 ? (uint32_t)(c - '0') : invalid_index;
+}
+
+
+strview_parse_int_result_t strview_parse_int(strview_t src) {
 	uint32_t i = 0;
 
-	while (i < src.length && is_hex_digit(src.data[i])) {
-		// @todo: catch overflow
-		value = value * 16 + get_hex_digit_value(src.data[i]);
+	bool negative = (src.length > 1 && src.data[0] == '-' && src.data[1] >= '0' && src.data[1] <= '9');
+	if (negative) {
 		i++;
 	}
 
-	return (strview_parse_hex_result_t){value, i};
+	uint64_t magnitude;
+	bool overflow = false;
+	i = parse_digits(src, i, 10, get_decimal_digit_value, parse_8_decimal_digits, 100000000U, &magnitude, &overflow);
+
+	int64_t value;
+	if (negative) {
+		overflow |= magnitude > (uint64_t)INT64_MAX + 1;
+		value = overflow ? INT64_MIN : (int64_t)(0 - magnitude);
+	}
+	else {
+		overflow |= magnitude > (uint64_t)INT64_MAX;
+		value = overflow ? INT64_MAX : (int64_t)magnitude;
+	}
+
+	return (strview_parse_int_result_t){value, i, overflow};
+}
+
+
+strview_parse_hex_result_t strview_parse_hex(strview_t src) {
+	uint64_t value;
+	bool overflow = false;
+	uint32_t length = parse_digits(src, 0, 16, get_hex_digit_value, parse_8_hex_digits, 1ULL << 32, &value, &overflow);
+	return (strview_parse_hex_result_t){overflow ? UINT64_MAX : value, length, overflow};
+}
+
+
+strview_parse_hex_result_t strview_parse_bin(strview_t src) {
+	uint64_t value;
+	bool overflow = false;
+	uint32_t length = parse_digits(src, 0, 2, get_binary_digit_value, parse_8_binary_digits, 1U << 8, &value, &overflow);
+	return (strview_parse_hex_result_t){overflow ? UINT64_MAX : value, length, overflow};
 }
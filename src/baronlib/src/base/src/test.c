@@ -5,6 +5,7 @@
  */
 
 #include "base/test.h"
+#include <inttypes.h>
 #include <math.h>
 #include <setjmp.h>
 #include <stdbool.h>
@@ -22,6 +23,14 @@ extern const test_item *__start_test[];
 extern const test_item *__stop_test[];
 #endif
 
+#if COMPILER_GCC
+#define TEST_ITEMS_BEGIN (__start_test)
+#define TEST_ITEMS_END (__stop_test)
+#else
+#define TEST_ITEMS_BEGIN (&__start_test)
+#define TEST_ITEMS_END (&__stop_test)
+#endif
+
 
 static jmp_buf env;
 static double epsilon = 0.0001;
@@ -47,25 +56,25 @@ void test_require_bool(bool actual, const char *op, bool expected, const char *e
 void test_require_int(int64_t actual, const char *op, int64_t expected, const char *expr, const char *file, int line) {
 	if (is_op2(op, "==")) { if (actual == expected) return; } else
 	if (is_op2(op, "!=")) { if (actual != expected) return; } else
-	if (is_op1(op, "<" )) { if (actual <  expected) return; } else
-	if (is_op1(op, ">" )) { if (actual >  expected) return; } else
 	if (is_op2(op, "<=")) { if (actual <= expected) return; } else
-	if (is_op2(op, ">=")) { if (actual >= expected) return; }
+	if (is_op2(op, ">=")) { if (actual >= expected) return; } else
+	if (is_op1(op, "<" )) { if (actual <  expected) return; } else
+	if (is_op1(op, ">" )) { if (actual >  expected) return; }
 	else {
 		printf("[FAIL]\n%s:%d: Unsupported operation: %s\n", file, line, op);
 	}
-	printf("[FAIL]\n%s:%d: %s: actual %lld\n", file, line, expr, actual);
+	printf("[FAIL]\n%s:%d: %s: actual %" PRId64 "\n", file, line, expr, actual);
 	longjmp(env, 1);
 }
 
 void test_require_float(double actual, const char *op, double expected, const char *expr, const char *file, int line) {
 	if (is_op2(op, "==")) { if (actual == expected) return; } else
-    if (is_op2(op, "~=")) { if (fabs(actual - expected) < epsilon) return; } else
+	if (is_op2(op, "~=")) { if (fabs(actual - expected) < epsilon) return; } else
 	if (is_op2(op, "!=")) { if (actual != expected) return; } else
-	if (is_op1(op, "<" )) { if (actual <  expected) return; } else
-	if (is_op1(op, ">" )) { if (actual >  expected) return; } else
 	if (is_op2(op, "<=")) { if (actual <= expected) return; } else
-	if (is_op2(op, ">=")) { if (actual >= expected) return; }
+	if (is_op2(op, ">=")) { if (actual >= expected) return; } else
+	if (is_op1(op, "<" )) { if (actual <  expected) return; } else
+	if (is_op1(op, ">" )) { if (actual >  expected) return; }
 	else {
 		printf("[FAIL]\n%s:%d: Unsupported operation: %s\n", file, line, op);
 	}
@@ -93,7 +102,7 @@ int test_run(const char *filter_string) {
 	// Count number of tests we're going to run
 	int total = 0;
 	int max_width = 0;
-	for (const test_item **start = &__start_test; start != &__stop_test; start++) {
+	for (const test_item **start = TEST_ITEMS_BEGIN; start != TEST_ITEMS_END; start++) {
 		const test_item *test_item = *start;
 		if (test_item) {
 			strview_t group_name = make_strview(test_item->group_name);
@@ -110,7 +119,7 @@ int test_run(const char *filter_string) {
 	
 	// Iterate through tests
 	int count = 1;
-	for (const test_item **start = &__start_test; start != &__stop_test; start++) {
+	for (const test_item **start = TEST_ITEMS_BEGIN; start != TEST_ITEMS_END; start++) {
 		const test_item *test_item = *start;
 		if (test_item) {
 			strview_t group_name = make_strview(test_item->group_name);
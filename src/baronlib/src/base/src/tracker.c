@@ -0,0 +1,212 @@
+#include <stdbool.h>
+#include <string.h>
+#include "tracker.h"
+#include "allocator.h"
+#include "defines.h"
+
+
+#define TRACKER_HEADER_SIZE 0x10
+#define TRACKER_HISTOGRAM_WIDTH 40
+
+typedef struct tracker_header_t tracker_header_t;
+
+struct tracker_header_t {
+    uint32_t size;
+    uint32_t tag_index;
+};
+
+
+static uint32_t get_size_class(uint32_t size) {
+    uint32_t size_class = 0;
+    while (size > 0) {
+        size_class++;
+        size >>= 1;
+    }
+    return size_class;
+}
+
+
+static void add_block(tracker_counts_t *counts, uint32_t size) {
+    counts->bytes_requested += size;
+    counts->live_blocks++;
+    counts->live_bytes += size;
+    counts->peak_bytes = math_max_uint64(counts->peak_bytes, counts->live_bytes);
+}
+
+
+static void remove_block(tracker_counts_t *counts, uint32_t size) {
+    counts->live_blocks--;
+    counts->live_bytes -= size;
+}
+
+
+// Counts a new or resized block under the current tag, writing its header
+static void *track_block(tracker_t *tracker, tracker_header_t *header, uint32_t size, bool is_realloc) {
+    tracker_counts_t *counts[2] = {&tracker->totals, &tracker->tags[tracker->tag_index].counts};
+    for (int i = 0; i < 2; i++) {
+        counts[i]->num_allocs += !is_realloc;
+        counts[i]->num_reallocs += is_realloc;
+        add_block(counts[i], size);
+    }
+    tracker->size_classes[get_size_class(size)]++;
+    *header = (tracker_header_t){size, tracker->tag_index};
+    return (uint8_t *)header + TRACKER_HEADER_SIZE;
+}
+
+
+static tracker_header_t *get_header(void *ptr) {
+    return (tracker_header_t *)((uint8_t *)ptr - TRACKER_HEADER_SIZE);
+}
+
+
+void tracker_init(tracker_t *tracker, const allocator_t *allocator) {
+    ASSERT(tracker);
+    *tracker = (tracker_t){
+        .child_allocator = allocator,
+        .num_tags = 1
+    };
+}
+
+
+const char *tracker_set_tag(tracker_t *tracker, const char *tag) {
+    ASSERT(tracker);
+    const char *previous = tracker->tag;
+    tracker->tag = tag;
+    tracker->tag_index = 0;
+    if (!tag) {
+        return previous;
+    }
+
+    uint32_t index = 1;
+    while (index < tracker->num_tags && strcmp(tracker->tags[index].name, tag) != 0) {
+        index++;
+    }
+    if (index == tracker->num_tags) {
+        if (index == TRACKER_MAX_TAGS) {
+            return previous;
+        }
+        tracker->tags[index] = (tracker_tag_t){.name = tag};
+        tracker->num_tags++;
+    }
+    tracker->tag_index = index;
+    return previous;
+}
+
+
+static void *tracker_alloc(uint32_t size, void *context) {
+    tracker_t *tracker = context;
+    if (size > UINT32_MAX - TRACKER_HEADER_SIZE) {
+        return 0;
+    }
+    tracker_header_t *header = allocator_alloc(tracker->child_allocator, size + TRACKER_HEADER_SIZE);
+    return header ? track_block(tracker, header, size, false) : 0;
+}
+
+
+static void *tracker_realloc(void *ptr, uint32_t size, void *context) {
+    tracker_t *tracker = context;
+    if (!ptr) {
+        return tracker_alloc(size, context);
+    }
+    if (size > UINT32_MAX - TRACKER_HEADER_SIZE) {
+        return 0;
+    }
+
+    tracker_header_t old_header = *get_header(ptr);
+    tracker_header_t *header = allocator_realloc(tracker->child_allocator, get_header(ptr), size + TRACKER_HEADER_SIZE);
+    if (!header) {
+        return 0;
+    }
+
+    // The block is moved to the current tag, as though it had been freed and allocated again
+    remove_block(&tracker->totals, old_header.size);
+    remove_block(&tracker->tags[old_header.tag_index].counts, old_header.size);
+    return track_block(tracker, header, size, true);
+}
+
+
+static void tracker_free(void *ptr, void *context) {
+    tracker_t *tracker = context;
+    if (!ptr) {
+        return;
+    }
+
+    tracker_header_t *header = get_header(ptr);
+    tracker_counts_t *counts[2] = {&tracker->totals, &tracker->tags[header->tag_index].counts};
+    for (int i = 0; i < 2; i++) {
+        counts[i]->num_frees++;
+        remove_block(counts[i], header->size);
+    }
+    allocator_free(tracker->child_allocator, header);
+}
+
+
+void tracker_print(const tracker_t *tracker, FILE *file) {
+    ASSERT(tracker);
+    ASSERT(file);
+
+    const tracker_counts_t *totals = &tracker->totals;
+    fprintf(file, "%llu allocs, %llu reallocs, %llu frees, %llu bytes requested, peak %llu bytes live\n",
+            (unsigned long long)totals->num_allocs, (unsigned long long)totals->num_reallocs,
+            (unsigned long long)totals->num_frees, (unsigned long long)totals->bytes_requested,
+            (unsigned long long)totals->peak_bytes);
+
+    uint64_t max_count = 0;
+    for (int i = 0; i < TRACKER_NUM_SIZE_CLASSES; i++) {
+        max_count = math_max_uint64(max_count, tracker->size_classes[i]);
+    }
+    fprintf(file, "\n%-23s %12s\n", "size (allocs, reallocs)", "count");
+    for (int i = 0; i < TRACKER_NUM_SIZE_CLASSES; i++) {
+        uint64_t count = tracker->size_classes[i];
+        if (count == 0) {
+            continue;
+        }
+        uint64_t low = (i == 0) ? 0 : (uint64_t)1 << (i - 1);
+        uint64_t high = (i == 0) ? 0 : ((uint64_t)1 << i) - 1;
+        // Every nonempty class gets at least one mark, however small
+        int width = (int)((count * TRACKER_HISTOGRAM_WIDTH + max_count - 1) / max_count);
+        fprintf(file, "%10llu - %-10llu %12llu  %.*s\n", (unsigned long long)low, (unsigned long long)high,
+                (unsigned long long)count, width, "########################################");
+    }
+
+    fprintf(file, "\n%-16s %10s %10s %10s %14s %14s %10s %14s\n",
+            "tag", "allocs", "reallocs", "frees", "bytes", "peak bytes", "leaks", "leaked bytes");
+    for (uint32_t i = 0; i < tracker->num_tags; i++) {
+        const tracker_tag_t *tag = &tracker->tags[i];
+        if (tag->counts.num_allocs == 0 && tag->counts.num_reallocs == 0 && tag->counts.num_frees == 0) {
+            continue;
+        }
+        fprintf(file, "%-16s %10llu %10llu %10llu %14llu %14llu %10llu %14llu\n", tag->name ? tag->name : "(untagged)",
+                (unsigned long long)tag->counts.num_allocs, (unsigned long long)tag->counts.num_reallocs,
+                (unsigned long long)tag->counts.num_frees, (unsigned long long)tag->counts.bytes_requested,
+                (unsigned long long)tag->counts.peak_bytes, (unsigned long long)tag->counts.live_blocks,
+                (unsigned long long)tag->counts.live_bytes);
+    }
+
+    if (totals->live_blocks > 0) {
+        fprintf(file, "\nLeaked %llu blocks, %llu bytes\n",
+                (unsigned long long)totals->live_blocks, (unsigned long long)totals->live_bytes);
+    }
+}
+
+
+allocator_t tracker_allocator(tracker_t *tracker) {
+    ASSERT(tracker);
+
+    static const allocator_vtable_t allocator_vtable = {
+        tracker_alloc,
+        tracker_realloc,
+        tracker_free
+    };
+
+    return (allocator_t){
+        tracker,
+        &allocator_vtable
+    };
+}
+
+
+uint32_t tracker_block_size(const void *ptr) {
+    ASSERT(ptr);
+    return ((const tracker_header_t *)((const uint8_t *)ptr - TRACKER_HEADER_SIZE))->size;
+}
@@ -1,8 +1,97 @@
 #include "base/arena.h"
 #include "base/allocator.h"
+#include "base/tracker.h"
+#include "base/array.h"
+#include "base/defines.h"
 #include "base/test.h"
+#include "base/str.h"
+
+
+static tracker_t tracker;
+static allocator_t tracking_allocator;
+
+// Starts counting the blocks allocated through tracking_allocator afresh
+static void start_tracking(void) {
+    tracker_init(&tracker, allocator_default());
+    tracking_allocator = tracker_allocator(&tracker);
+}
 
 
 DEF_TEST(arena, common_ops) {
+    start_tracking();
+    arena_t arena = make_arena(&tracking_allocator, 0x1000);
+    REQUIRE(tracker.totals.live_blocks,==,0);
+
+    uint8_t *a = arena_alloc(&arena, 10);
+    uint8_t *b = arena_alloc(&arena, 100);
+    REQUIRE_TRUE(a && b);
+    REQUIRE(tracker.totals.live_blocks,==,1);
+    REQUIRE((uint32_t)((uintptr_t)a & 0x0F),==,0);
+    REQUIRE((uint32_t)((uintptr_t)b & 0x0F),==,0);
+    REQUIRE_TRUE(b >= a + 16);
+    REQUIRE(b[99],==,0);
+
+    // Filling the region starts another; oversized allocations get a region of their own
+    for (int i = 0; i < 100; i++) {
+        REQUIRE_TRUE(arena_alloc(&arena, 64) != 0);
+    }
+    REQUIRE(tracker.totals.live_blocks,>,1);
+    uint64_t before = tracker.totals.live_blocks;
+    uint8_t *big = arena_alloc(&arena, 0x10000);
+    REQUIRE_TRUE(big != 0);
+    REQUIRE(tracker.totals.live_blocks,==,before + 1);
+    big[0xFFFF] = 1;
+
+    // Reset keeps only the most recent region
+    arena_reset(&arena);
+    REQUIRE(tracker.totals.live_blocks,==,1);
+    REQUIRE_TRUE(arena_alloc(&arena, 10) != 0);
+    REQUIRE(tracker.totals.live_blocks,==,1);
+
+    arena_deinit(&arena);
+    REQUIRE(tracker.totals.live_blocks,==,0);
+}
+
+DEF_TEST(arena, realloc) {
+    start_tracking();
+    arena_t arena = make_arena(&tracking_allocator, 0x1000);
+
+    // The most recent allocation grows in place
+    uint8_t *a = arena_alloc(&arena, 16);
+    a[15] = 42;
+    REQUIRE_TRUE(arena_realloc(&arena, a, 1000) == a);
+    REQUIRE_TRUE(arena_realloc(&arena, a, 8) == a);
+    REQUIRE_TRUE(arena_realloc(&arena, a, 100) == a);
+
+    // Anything else moves, keeping its contents
+    uint8_t *b = arena_alloc(&arena, 16);
+    uint8_t *c = arena_realloc(&arena, a, 200);
+    REQUIRE_TRUE(c != a && c > b);
+    REQUIRE(c[15],==,42);
+
+    arena_deinit(&arena);
+    REQUIRE(tracker.totals.live_blocks,==,0);
+}
+
+DEF_TEST(arena, allocator) {
+    start_tracking();
+    arena_t arena = make_arena(&tracking_allocator, 0x4000);
+    allocator_t allocator = arena_allocator(&arena);
+
+    // A string built in an arena grows within a single region
+    str_t str = make_str(&allocator, 4);
+    for (int i = 0; i < 1000; i++) {
+        REQUIRE_TRUE(str_append(&str, STRVIEW("0123456789")));
+    }
+    REQUIRE(str.length,==,10000);
+    REQUIRE(tracker.totals.live_blocks,==,1);
+
+    array_int32_t arr = make_array(int32_t, &allocator, 0);
+    for (int32_t i = 0; i < 100; i++) {
+        REQUIRE_TRUE(array_add(&arr, i));
+    }
+    REQUIRE(arr.data[99],==,99);
 
+    arena_deinit(&arena);
+    REQUIRE(tracker.totals.live_blocks,==,0);
 }
@@ -18,9 +18,7 @@ DEF_TEST(array, common_ops) {
     REQUIRE(arr.size,==,4);
     REQUIRE(array_capacity(&arr),==,arr.size);
 
-    int32_t *oldptr = arr.data;
     REQUIRE_TRUE(array_add(&arr, 69));
-    REQUIRE_TRUE(arr.data != oldptr);
     REQUIRE(arr.size,==,5);
     REQUIRE(array_capacity(&arr),>,arr.size);
 
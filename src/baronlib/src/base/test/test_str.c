@@ -1,3 +1,6 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "base/test.h"
 #include "base/allocator.h"
 #include "base/str.h"
@@ -20,6 +23,13 @@ DEF_TEST(strview, comparison) {
     REQUIRE(strview_compare(STRVIEW(""), STRVIEW("")),==,0);
 }
 
+DEF_TEST(strview, hash) {
+    REQUIRE(strview_hash(STRVIEW("")),==,2166136261U);
+    REQUIRE(strview_hash(STRVIEW("a")),==,0xE40C292CU);
+    REQUIRE(strview_hash(STRVIEW("foobar")),==,0xBF9CF968U);
+    REQUIRE(strview_hash(make_strview("foobar")),==,strview_hash(STRVIEW("foobar")));
+}
+
 DEF_TEST(strview, find) {
     REQUIRE_TRUE(strview_startswith(STRVIEW("camel"), STRVIEW("cam")));
     REQUIRE_FALSE(strview_startswith(STRVIEW("camel"), STRVIEW("cat")));
@@ -131,6 +141,37 @@ DEF_TEST(strview, parseint) {
     result = strview_parse_int(STRVIEW("nothing"));
     REQUIRE(result.value,==,0);
     REQUIRE(result.length_parsed,==,0);
+
+    // Eight digits at a time
+    result = strview_parse_int(STRVIEW("12345678901234567x"));
+    REQUIRE(result.value,==,12345678901234567);
+    REQUIRE(result.length_parsed,==,17);
+    REQUIRE_FALSE(result.overflow);
+
+    result = strview_parse_int(STRVIEW("1234567/"));
+    REQUIRE(result.value,==,1234567);
+    REQUIRE(result.length_parsed,==,7);
+
+    result = strview_parse_int(STRVIEW("9223372036854775807"));
+    REQUIRE(result.value,==,INT64_MAX);
+    REQUIRE_FALSE(result.overflow);
+
+    result = strview_parse_int(STRVIEW("-9223372036854775808"));
+    REQUIRE(result.value,==,INT64_MIN);
+    REQUIRE_FALSE(result.overflow);
+
+    result = strview_parse_int(STRVIEW("9223372036854775808"));
+    REQUIRE(result.value,==,INT64_MAX);
+    REQUIRE_TRUE(result.overflow);
+
+    result = strview_parse_int(STRVIEW("-99999999999999999999999999,"));
+    REQUIRE(result.value,==,INT64_MIN);
+    REQUIRE(result.length_parsed,==,27);
+    REQUIRE_TRUE(result.overflow);
+
+    result = strview_parse_int(STRVIEW("00000000000000000000000000042"));
+    REQUIRE(result.value,==,42);
+    REQUIRE_FALSE(result.overflow);
 }
 
 DEF_TEST(strview, parsehex) {
@@ -139,8 +180,254 @@ DEF_TEST(strview, parsehex) {
     result = strview_parse_hex(STRVIEW("D00B1E5"));
     REQUIRE(result.value,==,0xD00B1E5);
     REQUIRE(result.length_parsed,==,7);
+
+    result = strview_parse_hex(STRVIEW("0123456789abcdefG"));
+    REQUIRE(result.value,==,0x0123456789ABCDEFU);
+    REQUIRE(result.length_parsed,==,16);
+    REQUIRE_FALSE(result.overflow);
+
+    result = strview_parse_hex(STRVIEW("FfFfFfFfFfFfFfFf"));
+    REQUIRE(result.value,==,UINT64_MAX);
+    REQUIRE_FALSE(result.overflow);
+
+    result = strview_parse_hex(STRVIEW("1ABCDEF9G"));
+    REQUIRE(result.value,==,0x1ABCDEF9);
+    REQUIRE(result.length_parsed,==,8);
+
+    result = strview_parse_hex(STRVIEW("ABCDEFG@`0123456"));
+    REQUIRE(result.value,==,0xABCDEF);
+    REQUIRE(result.length_parsed,==,6);
+
+    result = strview_parse_hex(STRVIEW("10000000000000000"));
+    REQUIRE(result.length_parsed,==,17);
+    REQUIRE_TRUE(result.overflow);
+}
+
+DEF_TEST(strview, parsebin) {
+    strview_parse_hex_result_t result;
+
+    result = strview_parse_bin(STRVIEW("1010"));
+    REQUIRE(result.value,==,10);
+    REQUIRE(result.length_parsed,==,4);
+
+    result = strview_parse_bin(STRVIEW("110000001010101012"));
+    REQUIRE(result.value,==,0x18155);
+    REQUIRE(result.length_parsed,==,17);
+    REQUIRE_FALSE(result.overflow);
+
+    result = strview_parse_bin(STRVIEW("2"));
+    REQUIRE(result.length_parsed,==,0);
+
+    result = strview_parse_bin(STRVIEW("11111111111111111111111111111111111111111111111111111111111111111"));
+    REQUIRE(result.length_parsed,==,65);
+    REQUIRE_TRUE(result.overflow);
+}
+
+static double parse_float(const char *s) {
+    strview_parse_float_result_t result = strview_parse_float(make_strview(s));
+    return (result.length_parsed == strlen(s)) ? result.value : -12345.0;
+}
+
+static uint64_t bits_of(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof bits);
+    return bits;
+}
+
+static uint64_t random_bits(uint64_t *state) {
+    *state = *state * 6364136223846793005U + 1442695040888963407U;
+    uint64_t x = *state;
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDU;
+    return x ^ (x >> 33);
 }
 
 DEF_TEST(strview, parsefloat) {
-    
+    REQUIRE(parse_float("1.5"),==,1.5);
+    REQUIRE(parse_float("-0.25"),==,-0.25);
+    REQUIRE(parse_float(".5"),==,0.5);
+    REQUIRE(parse_float("1."),==,1.0);
+    REQUIRE(parse_float("1e10"),==,1e10);
+    REQUIRE(parse_float("000123.4500E-2"),==,1.2345);
+    REQUIRE_TRUE(parse_float("0.1") == 0.1);
+    REQUIRE_TRUE(parse_float("3.14159265358979323846264338327950288") == 3.14159265358979323846264338327950288);
+    REQUIRE_TRUE(parse_float("1.7976931348623157e308") == 1.7976931348623157e308);
+    REQUIRE_TRUE(parse_float("2.2250738585072014E-308") == 2.2250738585072014e-308);
+    REQUIRE_TRUE(parse_float("4.9e-324") == 4.9e-324);
+    REQUIRE_TRUE(parse_float("1e400") == 1e300 * 1e300);
+    REQUIRE_TRUE(parse_float("1e-400") == 0.0);
+    REQUIRE_TRUE(parse_float("1e-99999999999999999999") == 0.0);
+
+    // Ties round to even, however many digits it takes to find out
+    REQUIRE_TRUE(parse_float("9007199254740993") == 9007199254740992.0);
+    REQUIRE_TRUE(parse_float("9007199254740993.0000000000000000000001") == 9007199254740994.0);
+    REQUIRE_TRUE(parse_float("9007199254740992.9999999999999999999999") == 9007199254740992.0);
+    REQUIRE_TRUE(parse_float("2.4703282292062327208828439643411068618252990130716238221279284125033775363510437593264991818081799618989828234772285886546332835517796989819938739800539093906315035659515570226392290858392449105184435931802849936536152500319370457678249219365623669863658480757001585769269903706311928279558551332927834338409351978015531246597263579574622766465272827220056374006485499977096599470454020828166226237857393450736339007967761930577506740176324673600968951340535537458516661134223766678604162159680461914467291840300530057530849048765391711386591646239524912623653881879636239373280423891018672348497668235089863388587925628302755995657524455507255189313690836254779186948667994968324049705821028513185451396213837722826145437693412532098591327667236328125e-324") == 0.0);
+    REQUIRE_TRUE(parse_float("2.47032822920623272088284396434110686182529901307162382212792841250337753635104375932649918180817996189898282347722858865463328355177969898199387398005390939063150356595155702263922908583924491051844359318028499365361525003193704576782492193656236698636584807570015857692699037063119282795585513329278343384093519780155312465972635795746227664652728272200563740064854999770965994704540208281662262378573934507363390079677619305775067401763246736009689513405355374585166611342237666786041621596804619144672918403005300575308490487653917113865916462395249126236538818796362393732804238910186723484976682350898633885879256283027559956575244555072551893136908362547791869486679949683240497058210285131854513962138377228261454376934125320985913276672363281250000000000000001e-324") == 4.9e-324);
+
+    // Partial parses
+    strview_parse_float_result_t result = strview_parse_float(STRVIEW("2.5E+x"));
+    REQUIRE(result.value,==,2.5);
+    REQUIRE(result.length_parsed,==,3);
+    result = strview_parse_float(STRVIEW("-."));
+    REQUIRE(result.length_parsed,==,0);
+    result = strview_parse_float(STRVIEW("7e2e3"));
+    REQUIRE(result.value,==,700.0);
+    REQUIRE(result.length_parsed,==,3);
+
+    // Random digit strings agree with the C library
+    uint64_t state = 1;
+    for (int i = 0; i < 20000; i++) {
+        char buffer[64];
+        int length = 0;
+        int num_digits = 1 + (int)(random_bits(&state) % 25);
+        for (int d = 0; d < num_digits; d++) {
+            buffer[length++] = (char)('0' + random_bits(&state) % 10);
+            if (d == 0 && num_digits > 1) {
+                buffer[length++] = '.';
+            }
+        }
+        length += snprintf(buffer + length, sizeof buffer - length, "e%d", (int)(random_bits(&state) % 660) - 330);
+        double expected = strtod(buffer, 0);
+        REQUIRE(bits_of(parse_float(buffer)),==,bits_of(expected));
+    }
+}
+
+DEF_TEST(str, format_double) {
+    uint8_t buffer[STR_DOUBLE_MAX_LENGTH];
+    #define FORMAT(value) ((strview_t){buffer, str_format_double(value, buffer)})
+    REQUIRE(FORMAT(0.0),==,STRVIEW("0"));
+    REQUIRE(FORMAT(-0.0),==,STRVIEW("-0"));
+    REQUIRE(FORMAT(42.0),==,STRVIEW("42"));
+    REQUIRE(FORMAT(-1.5),==,STRVIEW("-1.5"));
+    REQUIRE(FORMAT(0.1),==,STRVIEW("0.1"));
+    REQUIRE(FORMAT(0.1 + 0.2),==,STRVIEW("0.30000000000000004"));
+    REQUIRE(FORMAT(1.0 / 3.0),==,STRVIEW("0.3333333333333333"));
+    REQUIRE(FORMAT(123456.789),==,STRVIEW("123456.789"));
+    REQUIRE(FORMAT(0.00001),==,STRVIEW("0.00001"));
+    REQUIRE(FORMAT(1.5e-7),==,STRVIEW("1.5E-7"));
+    REQUIRE(FORMAT(1e16),==,STRVIEW("10000000000000000"));
+    REQUIRE(FORMAT(1e17),==,STRVIEW("1E17"));
+    REQUIRE(FORMAT(65536.0 * 65536.0 * 65536.0 * 65536.0),==,STRVIEW("1.8446744073709552E19"));
+    REQUIRE(FORMAT(1.7976931348623157e308),==,STRVIEW("1.7976931348623157E308"));
+    REQUIRE(FORMAT(-2.2250738585072014e-308),==,STRVIEW("-2.2250738585072014E-308"));
+    REQUIRE(FORMAT(4.9e-324),==,STRVIEW("5E-324"));
+    REQUIRE(FORMAT(1e300 * 1e300),==,STRVIEW("Inf"));
+    #undef FORMAT
+
+    // Random doubles round trip, in no more digits than the shortest printf precision which round trips
+    uint64_t state = 2;
+    for (int i = 0; i < 20000; i++) {
+        uint64_t bits = random_bits(&state);
+        if ((bits & 0x7FF0000000000000U) == 0x7FF0000000000000U) {
+            continue;
+        }
+        double value;
+        memcpy(&value, &bits, sizeof value);
+
+        uint32_t length = str_format_double(value, buffer);
+        strview_parse_float_result_t result = strview_parse_float((strview_t){buffer, length});
+        REQUIRE(result.length_parsed,==,length);
+        REQUIRE(bits_of(result.value),==,bits);
+
+        int precision = 1;
+        char reference[32];
+        for (; precision < 17; precision++) {
+            snprintf(reference, sizeof reference, "%.*e", precision - 1, value);
+            if (strtod(reference, 0) == value) {
+                break;
+            }
+        }
+        // Count the significant digits, from the first non-zero one to the last
+        uint32_t num_digits = 0;
+        uint32_t num_significant = 0;
+        for (uint32_t j = 0; j < length && buffer[j] != 'E'; j++) {
+            if (buffer[j] >= '0' && buffer[j] <= '9' && (num_digits > 0 || buffer[j] != '0')) {
+                num_digits++;
+                num_significant = (buffer[j] != '0') ? num_digits : num_significant;
+            }
+        }
+        REQUIRE(num_significant,<=,(uint32_t)precision);
+    }
+
+    str_t str = make_str(allocator_default(), 0);
+    REQUIRE_TRUE(str_append_double(&str, 0.5));
+    REQUIRE_TRUE(str_append(&str, STRVIEW(",")));
+    REQUIRE_TRUE(str_append_double(&str, -1e-10));
+    REQUIRE(str.view,==,STRVIEW("0.5,-1E-10"));
+    str_deinit(&str);
+}
+
+DEF_TEST(str, append) {
+    str_t str = make_str(allocator_default(), 4);
+    REQUIRE_TRUE(str_is_valid(&str));
+    REQUIRE_TRUE(str_is_empty(&str));
+    REQUIRE(str.capacity,==,4);
+
+    REQUIRE_TRUE(str_append(&str, STRVIEW("Hello")));
+    REQUIRE(str.view,==,STRVIEW("Hello"));
+    REQUIRE(str.capacity,==,8);
+    REQUIRE_TRUE(str_append(&str, STRVIEW(", world")));
+    REQUIRE(str.view,==,STRVIEW("Hello, world"));
+    REQUIRE(str.capacity,==,16);
+    REQUIRE(str.data[str.length],==,0);
+
+    // Appending a str to itself
+    REQUIRE_TRUE(str_append(&str, str.view));
+    REQUIRE(str.view,==,STRVIEW("Hello, worldHello, world"));
+    REQUIRE_TRUE(str_append(&str, strview_left(str.view, 5)));
+    REQUIRE(strview_right(str.view, 6),==,STRVIEW("dHello"));
+
+    uint32_t capacity = str.capacity;
+    str_reset(&str);
+    REQUIRE_TRUE(str_is_empty(&str));
+    REQUIRE(str.capacity,==,capacity);
+
+    REQUIRE_TRUE(str_reserve(&str, 100));
+    REQUIRE(str.capacity,==,100);
+
+    str_deinit(&str);
+    REQUIRE_FALSE(str_is_valid(&str));
+    REQUIRE_FALSE(str_append(&str, STRVIEW("x")));
+}
+
+static uint32_t naive_find_first(strview_t a, strview_t b) {
+    for (uint32_t i = 0; i + b.length <= a.length; i++) {
+        if (memcmp(a.data + i, b.data, b.length) == 0) {
+            return i;
+        }
+    }
+    return invalid_index;
+}
+
+static uint32_t naive_find_last(strview_t a, strview_t b) {
+    for (uint32_t i = (a.length >= b.length) ? a.length - b.length + 1 : 0; i-- > 0; ) {
+        if (memcmp(a.data + i, b.data, b.length) == 0) {
+            return i;
+        }
+    }
+    return invalid_index;
+}
+
+DEF_TEST(strview, find_long) {
+    // A long path-like haystack, searched for separators and names near either end
+    enum { haystack_size = 1 << 16 };
+    static uint8_t buffer[haystack_size];
+    uint32_t seed = 12345;
+    for (uint32_t i = 0; i < haystack_size; i++) {
+        seed = seed * 1103515245U + 12345U;
+        buffer[i] = (uint8_t)("abcdefghijklmnop"[(seed >> 16) & 15]);
+    }
+    memcpy(buffer + 1000, "/include", 8);
+    memcpy(buffer + haystack_size - 1000, "/include", 8);
+    strview_t haystack = {buffer, haystack_size};
+
+    static const char *const needles[] = {"/", "/include", "include", "abcdefgh", "pppp", "zz"};
+    for (uint32_t n = 0; n < sizeof needles / sizeof *needles; n++) {
+        strview_t needle = make_strview(needles[n]);
+        REQUIRE(strview_find_first(haystack, needle),==,naive_find_first(haystack, needle));
+        REQUIRE(strview_find_last(haystack, needle),==,naive_find_last(haystack, needle));
+        REQUIRE(strview_find_first(strview_mid(haystack, 3), needle),==,naive_find_first(strview_mid(haystack, 3), needle));
+        REQUIRE(strview_find_last(strview_left(haystack, 1005), needle),==,naive_find_last(strview_left(haystack, 1005), needle));
+    }
 }
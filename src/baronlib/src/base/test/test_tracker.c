@@ -0,0 +1,94 @@
+#include "base/tracker.h"
+#include "base/allocator.h"
+#include "base/defines.h"
+#include "base/test.h"
+
+
+DEF_TEST(tracker, counts) {
+    tracker_t tracker;
+    tracker_init(&tracker, allocator_default());
+    allocator_t allocator = tracker_allocator(&tracker);
+
+    uint8_t *a = allocator_alloc(&allocator, 100);
+    uint8_t *b = allocator_alloc(&allocator, 20);
+    REQUIRE_TRUE(a && b);
+    REQUIRE((uint32_t)((uintptr_t)a & 0x0F),==,0);
+    a[99] = 42;
+
+    a = allocator_realloc(&allocator, a, 1000);
+    REQUIRE_TRUE(a != 0);
+    REQUIRE(a[99],==,42);
+    REQUIRE(tracker_block_size(a),==,1000);
+    allocator_free(&allocator, b);
+
+    REQUIRE(tracker.totals.num_allocs,==,2);
+    REQUIRE(tracker.totals.num_reallocs,==,1);
+    REQUIRE(tracker.totals.num_frees,==,1);
+    REQUIRE(tracker.totals.bytes_requested,==,1120);
+    REQUIRE(tracker.totals.peak_bytes,==,1020);
+    REQUIRE(tracker.totals.live_blocks,==,1);
+    REQUIRE(tracker.totals.live_bytes,==,1000);
+
+    // 100 is in the class from 64 to 127, 20 from 16 to 31, and 1000 from 512 to 1023
+    REQUIRE(tracker.size_classes[7],==,1);
+    REQUIRE(tracker.size_classes[5],==,1);
+    REQUIRE(tracker.size_classes[10],==,1);
+
+    allocator_free(&allocator, a);
+    allocator_free(&allocator, 0);
+    REQUIRE(tracker.totals.num_frees,==,2);
+    REQUIRE(tracker.totals.live_blocks,==,0);
+    REQUIRE(tracker.totals.live_bytes,==,0);
+}
+
+DEF_TEST(tracker, tags) {
+    tracker_t tracker;
+    tracker_init(&tracker, allocator_default());
+    allocator_t allocator = tracker_allocator(&tracker);
+
+    void *untagged = allocator_alloc(&allocator, 8);
+    REQUIRE_TRUE(tracker_set_tag(&tracker, "lex") == 0);
+    uint8_t *block = allocator_alloc(&allocator, 16);
+    block = allocator_realloc(&allocator, block, 64);
+    REQUIRE_TRUE(tracker_set_tag(&tracker, "pass") != 0);
+    void *leaked = allocator_alloc(&allocator, 32);
+
+    // Tags are matched by name, and a block which is resized moves to the current tag
+    char name[] = "lex";
+    tracker_set_tag(&tracker, name);
+    REQUIRE(tracker.num_tags,==,3);
+    block = allocator_realloc(&allocator, block, 128);
+    tracker_set_tag(&tracker, "pass");
+    block = allocator_realloc(&allocator, block, 256);
+    REQUIRE_TRUE(untagged && block && leaked);
+    allocator_free(&allocator, untagged);
+
+    const tracker_tag_t *lex = &tracker.tags[1];
+    const tracker_tag_t *pass = &tracker.tags[2];
+    REQUIRE(tracker.tags[0].counts.num_allocs,==,1);
+    REQUIRE(tracker.tags[0].counts.num_frees,==,1);
+    REQUIRE(tracker.tags[0].counts.live_blocks,==,0);
+    REQUIRE(lex->counts.num_allocs,==,1);
+    REQUIRE(lex->counts.num_reallocs,==,2);
+    REQUIRE(lex->counts.live_blocks,==,0);
+    REQUIRE(lex->counts.peak_bytes,==,128);
+    REQUIRE(pass->counts.num_allocs,==,1);
+    REQUIRE(pass->counts.num_reallocs,==,1);
+    REQUIRE(pass->counts.live_blocks,==,2);
+    REQUIRE(pass->counts.live_bytes,==,288);
+
+    allocator_free(&allocator, block);
+    allocator_free(&allocator, leaked);
+    REQUIRE(tracker.totals.live_blocks,==,0);
+
+    // Tags beyond the maximum are counted as untagged
+    static const char *const names[TRACKER_MAX_TAGS] = {
+        "t0", "t1", "t2", "t3", "t4", "t5", "t6", "t7", "t8", "t9", "t10", "t11", "t12", "t13", "t14", "t15",
+        "t16", "t17", "t18", "t19", "t20", "t21", "t22", "t23", "t24", "t25", "t26", "t27", "t28", "t29", "t30", "t31"
+    };
+    for (int i = 0; i < TRACKER_MAX_TAGS; i++) {
+        tracker_set_tag(&tracker, names[i]);
+    }
+    REQUIRE(tracker.num_tags,==,TRACKER_MAX_TAGS);
+    REQUIRE(tracker.tag_index,==,0);
+}
@@ -0,0 +1,127 @@
+#include "base/defines.h"
+#include "budget.h"
+
+
+static uint64_t next_poll(const budget_t *budget) {
+    uint64_t next = budget->limits.cancel_fn ? budget->steps + BUDGET_POLL_INTERVAL : UINT64_MAX;
+    // The step limit is checked as soon as it's passed
+    if (budget->limits.max_steps) {
+        next = math_min_uint64(next, budget->limits.max_steps + 1);
+    }
+    return next;
+}
+
+
+void budget_init(budget_t *budget, const baron_limits_t *limits, allocator_t parent) {
+    ASSERT(budget);
+    *budget = (budget_t){
+        .limits = limits ? *limits : (baron_limits_t){0},
+        .parent = parent
+    };
+    tracker_init(&budget->tracker, &budget->parent);
+    budget->next_poll = next_poll(budget);
+}
+
+
+void budget_reset(budget_t *budget) {
+    ASSERT(budget);
+    budget->steps = 0;
+    budget->macro_depth = 0;
+    budget->status = baron_status_ok;
+    budget->next_poll = next_poll(budget);
+}
+
+
+bool budget_check(budget_t *budget) {
+    ASSERT(budget);
+    if (budget->status == baron_status_ok) {
+        if (budget->limits.max_steps && budget->steps > budget->limits.max_steps) {
+            budget->status = baron_status_step_limit;
+        }
+        else if (budget->limits.cancel_fn && budget->limits.cancel_fn(budget->limits.cancel_context)) {
+            budget->status = baron_status_cancelled;
+        }
+        budget->next_poll = next_poll(budget);
+    }
+    return budget->status == baron_status_ok;
+}
+
+
+bool budget_enter_macro(budget_t *budget) {
+    ASSERT(budget);
+    if (budget->limits.max_macro_depth && budget->macro_depth >= budget->limits.max_macro_depth) {
+        budget->status = baron_status_macro_depth_limit;
+    }
+    if (budget->status != baron_status_ok) {
+        return false;
+    }
+    budget->macro_depth++;
+    return true;
+}
+
+
+/**
+ *  Check that a block can be resized from old_size bytes (0 for a new one) to size without exceeding the memory limit
+ */
+static bool can_resize(budget_t *budget, uint32_t old_size, uint32_t size) {
+    // The limit is never exceeded, so the bytes live in other blocks are within it
+    uint64_t other_bytes = budget->tracker.totals.live_bytes - old_size;
+    if (budget->status == baron_status_ok && budget->limits.max_memory - other_bytes < size) {
+        budget->status = baron_status_memory_limit;
+    }
+    return budget->status != baron_status_memory_limit;
+}
+
+
+static void *budget_alloc(uint32_t size, void *context) {
+    budget_t *budget = context;
+    allocator_t allocator = tracker_allocator(&budget->tracker);
+    return can_resize(budget, 0, size) ? allocator_alloc(&allocator, size) : 0;
+}
+
+
+static void *budget_realloc(void *ptr, uint32_t size, void *context) {
+    budget_t *budget = context;
+    allocator_t allocator = tracker_allocator(&budget->tracker);
+    return can_resize(budget, ptr ? tracker_block_size(ptr) : 0, size) ? allocator_realloc(&allocator, ptr, size) : 0;
+}
+
+
+static void budget_free(void *ptr, void *context) {
+    budget_t *budget = context;
+    allocator_t allocator = tracker_allocator(&budget->tracker);
+    allocator_free(&allocator, ptr);
+}
+
+
+allocator_t budget_allocator(budget_t *budget) {
+    ASSERT(budget);
+
+    static const allocator_vtable_t budget_vtable = {
+        budget_alloc,
+        budget_realloc,
+        budget_free
+    };
+
+    if (!budget->limits.max_memory) {
+        return budget->parent;
+    }
+    return (allocator_t){budget, &budget_vtable};
+}
+
+
+const char *budget_error(const budget_t *budget) {
+    ASSERT(budget);
+    switch (budget->status) {
+        case baron_status_cancelled:
+            return "Assembly cancelled";
+        case baron_status_step_limit:
+            return "Too many statements executed";
+        case baron_status_macro_depth_limit:
+            return "Macros nested too deeply";
+        case baron_status_memory_limit:
+            return "Out of memory";
+        default:
+            return 0;
+    }
+}
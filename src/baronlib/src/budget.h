@@ -0,0 +1,103 @@
+/**
+ *  @file   budget.h
+ *
+ *  Enforcement of the limits in baron_limits_t.
+ *
+ *  Work is accounted for where it happens: the statements executed (including every iteration of a loop body), the
+ *  depth of nested macro invocations, and the bytes live in the assembly's allocator. Once a limit is exceeded, or
+ *  the cancel function asks to stop, the budget records why and every subsequent check fails, so the assembly unwinds
+ *  through its ordinary error paths.
+ */
+
+#ifndef BARONLIB_BUDGET_H_
+#define BARONLIB_BUDGET_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "base/allocator.h"
+#include "base/tracker.h"
+#include "baron/baron.h"
+
+typedef struct budget_t budget_t;
+
+
+// Number of steps between polls of the cancel function
+#define BUDGET_POLL_INTERVAL 4096
+
+
+struct budget_t {
+    baron_limits_t limits;
+    allocator_t parent;             // Allocator which counted allocations are passed on to
+    tracker_t tracker;              // Counts the bytes live in budget_allocator
+    uint64_t steps;
+    uint64_t next_poll;             // Step count at which the cancel function is next polled
+    uint32_t macro_depth;
+    baron_status_t status;          // baron_status_ok until a limit is exceeded or the assembly is cancelled
+};
+
+
+/**
+ *  Initialize a budget
+ *
+ *  @param  budget          Pointer to the budget to initialize
+ *  @param  limits          Limits to enforce, or null for none
+ *  @param  parent          Allocator which budget_allocator passes counted allocations on to
+ */
+void budget_init(budget_t *budget, const baron_limits_t *limits, allocator_t parent);
+
+
+/**
+ *  Reset a budget's counts, ready for another assembly.
+ *  Memory is still live until it is freed, so it remains counted against the memory limit.
+ */
+void budget_reset(budget_t *budget);
+
+
+/**
+ *  Make an allocator which counts the bytes live against the budget's memory limit, passing allocations on to its
+ *  parent through the budget's tracker, and failing any which would take it over the limit. If there is no memory
+ *  limit, this is just the parent. The allocator refers to the budget, which must outlive it and must not move.
+ */
+allocator_t budget_allocator(budget_t *budget);
+
+
+/**
+ *  Poll the cancel function and check the step limit; called by budget_step when either may have been reached
+ */
+bool budget_check(budget_t *budget);
+
+
+/**
+ *  Account for executing a number of statements
+ *
+ *  @return true if the assembly may continue
+ */
+static inline bool budget_step(budget_t *budget, uint64_t count) {
+    budget->steps += count;
+    return (budget->steps < budget->next_poll && budget->status == baron_status_ok) || budget_check(budget);
+}
+
+
+/**
+ *  Enter a macro invocation
+ *
+ *  @return true if the assembly may continue; if not, budget_leave_macro must not be called
+ */
+bool budget_enter_macro(budget_t *budget);
+
+
+/**
+ *  Leave a macro invocation entered by budget_enter_macro
+ */
+static inline void budget_leave_macro(budget_t *budget) {
+    budget->macro_depth--;
+}
+
+
+/**
+ *  Get an error message describing why a budget stopped the assembly
+ */
+const char *budget_error(const budget_t *budget);
+
+
+#endif // ifndef BARONLIB_BUDGET_H_
@@ -0,0 +1,279 @@
+/**
+ *  @file   dfs.c
+ *
+ *  Acorn DFS disk image writer.
+ *
+ *  Each side of a disk holds a two sector catalogue followed by the files, laid out contiguously from sector 2.
+ *  Rather than building the image in memory, each side is treated as a virtual byte stream made of the catalogue,
+ *  the files' object code and zero padding, and the image is produced by emitting runs of that stream directly from
+ *  wherever the bytes already live. A double-sided image simply alternates between the two sides' streams a track
+ *  at a time.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "base/defines.h"
+#include "baron.h"
+
+
+#define DFS_SECTOR_SIZE 256
+#define DFS_SECTORS_PER_TRACK 10
+#define DFS_TRACK_SIZE (DFS_SECTOR_SIZE * DFS_SECTORS_PER_TRACK)
+#define DFS_CATALOGUE_SIZE (DFS_SECTOR_SIZE * 2)
+#define DFS_MAX_FILES 31
+#define DFS_TITLE_LENGTH 12
+#define DFS_FILENAME_LENGTH 7
+
+typedef struct dfs_side_t dfs_side_t;
+typedef struct dfs_stream_t dfs_stream_t;
+typedef struct dfs_file_t dfs_file_t;
+
+
+struct dfs_side_t {
+    const baron_disk_file_t *files[DFS_MAX_FILES];
+    uint32_t start_sectors[DFS_MAX_FILES];
+    uint32_t num_files;
+    uint32_t num_sectors;
+    uint8_t catalogue[DFS_CATALOGUE_SIZE];
+};
+
+
+struct dfs_stream_t {
+    const dfs_side_t *side;
+    uint32_t offset;
+    uint32_t file_index;
+};
+
+
+struct dfs_file_t {
+    const char *filename;
+    FILE *file;                     // Null until the first write
+};
+
+
+static const uint8_t zeros[DFS_TRACK_SIZE];
+
+
+static bool is_valid_filename_char(char c) {
+    return c > ' ' && c < 0x7F && c != '.' && c != ':' && c != '"' && c != '#' && c != '*';
+}
+
+
+static baron_disk_image_status_t split_filename(const char *name, char *directory, char filename[DFS_FILENAME_LENGTH]) {
+    *directory = '$';
+    if (name[0] && name[1] == '.') {
+        if (!is_valid_filename_char(name[0])) {
+            return baron_disk_image_invalid_filename;
+        }
+        *directory = name[0];
+        name += 2;
+    }
+
+    uint32_t length = 0;
+    while (name[length]) {
+        if (length == DFS_FILENAME_LENGTH || !is_valid_filename_char(name[length])) {
+            return baron_disk_image_invalid_filename;
+        }
+        filename[length] = name[length];
+        length++;
+    }
+
+    if (length == 0) {
+        return baron_disk_image_invalid_filename;
+    }
+
+    memset(filename + length, ' ', DFS_FILENAME_LENGTH - length);
+    return baron_disk_image_ok;
+}
+
+
+static baron_disk_image_status_t build_catalogue(dfs_side_t *side, const baron_disk_image_desc_t *desc) {
+    uint8_t *sector0 = side->catalogue;
+    uint8_t *sector1 = side->catalogue + DFS_SECTOR_SIZE;
+    memset(side->catalogue, 0, DFS_CATALOGUE_SIZE);
+
+    if (desc->title) {
+        size_t title_length = strlen(desc->title);
+        if (title_length > DFS_TITLE_LENGTH) {
+            title_length = DFS_TITLE_LENGTH;
+        }
+        memcpy(sector0, desc->title, title_length < 8 ? title_length : 8);
+        if (title_length > 8) {
+            memcpy(sector1, desc->title + 8, title_length - 8);
+        }
+    }
+
+    sector1[5] = (uint8_t)(side->num_files * 8);
+    sector1[6] = (uint8_t)(((side->num_sectors >> 8) & 0x03) | ((desc->boot_option & 0x03) << 4));
+    sector1[7] = (uint8_t)(side->num_sectors & 0xFF);
+
+    // Catalogue entries are ordered by descending start sector, so the last file on the disk comes first
+    uint32_t next_sector = 2;
+    for (uint32_t i = 0; i < side->num_files; i++) {
+        const baron_disk_file_t *file = side->files[i];
+        uint32_t entry = (side->num_files - 1 - i) * 8 + 8;
+        uint32_t length = (uint32_t)file->object_code.size;
+        uint32_t start_sector = next_sector;
+
+        char directory;
+        baron_disk_image_status_t status = split_filename(file->name, &directory, (char *)sector0 + entry);
+        if (status != baron_disk_image_ok) {
+            return status;
+        }
+        sector0[entry + 7] = (uint8_t)(directory | (file->locked ? 0x80 : 0));
+
+        sector1[entry + 0] = (uint8_t)(file->load_address & 0xFF);
+        sector1[entry + 1] = (uint8_t)((file->load_address >> 8) & 0xFF);
+        sector1[entry + 2] = (uint8_t)(file->exec_address & 0xFF);
+        sector1[entry + 3] = (uint8_t)((file->exec_address >> 8) & 0xFF);
+        sector1[entry + 4] = (uint8_t)(length & 0xFF);
+        sector1[entry + 5] = (uint8_t)((length >> 8) & 0xFF);
+        sector1[entry + 6] = (uint8_t)(((start_sector >> 8) & 0x03) |
+                                       (((file->load_address >> 16) & 0x03) << 2) |
+                                       (((length >> 16) & 0x03) << 4) |
+                                       (((file->exec_address >> 16) & 0x03) << 6));
+        sector1[entry + 7] = (uint8_t)(start_sector & 0xFF);
+
+        side->start_sectors[i] = start_sector;
+        next_sector += (length + DFS_SECTOR_SIZE - 1) / DFS_SECTOR_SIZE;
+        if (next_sector > side->num_sectors) {
+            return baron_disk_image_disk_full;
+        }
+    }
+
+    return baron_disk_image_ok;
+}
+
+
+static bool emit(dfs_stream_t *stream, uint32_t count, baron_write_fn_t write_fn, void *context) {
+    const dfs_side_t *side = stream->side;
+
+    while (count > 0) {
+        const uint8_t *src;
+        uint32_t available;
+        uint32_t offset = stream->offset;
+
+        // Skip past any files which have been fully emitted
+        while (stream->file_index < side->num_files &&
+               offset >= side->start_sectors[stream->file_index] * DFS_SECTOR_SIZE + side->files[stream->file_index]->object_code.size) {
+            stream->file_index++;
+        }
+
+        if (offset < DFS_CATALOGUE_SIZE) {
+            src = side->catalogue + offset;
+            available = DFS_CATALOGUE_SIZE - offset;
+        }
+        else if (stream->file_index < side->num_files && offset >= side->start_sectors[stream->file_index] * DFS_SECTOR_SIZE) {
+            const baron_disk_file_t *file = side->files[stream->file_index];
+            uint32_t file_offset = offset - side->start_sectors[stream->file_index] * DFS_SECTOR_SIZE;
+            src = file->object_code.data + file_offset;
+            available = (uint32_t)file->object_code.size - file_offset;
+        }
+        else {
+            uint32_t padding_end = (stream->file_index < side->num_files)
+                ? side->start_sectors[stream->file_index] * DFS_SECTOR_SIZE
+                : side->num_sectors * DFS_SECTOR_SIZE;
+            src = zeros;
+            available = math_min_uint32(padding_end - offset, DFS_TRACK_SIZE);
+        }
+
+        uint32_t size = math_min_uint32(available, count);
+        if (!write_fn(src, size, context)) {
+            return false;
+        }
+        stream->offset += size;
+        count -= size;
+    }
+
+    return true;
+}
+
+
+baron_disk_image_status_t baron_disk_image_write(const baron_disk_image_desc_t *desc, baron_write_fn_t write_fn, void *context) {
+    ASSERT(desc);
+    ASSERT(write_fn);
+
+    int num_tracks = desc->num_tracks ? desc->num_tracks : 80;
+    int num_sides = desc->double_sided ? 2 : 1;
+    if ((num_tracks != 40 && num_tracks != 80) || desc->boot_option < 0 || desc->boot_option > 3 || (desc->num_files && !desc->files)) {
+        return baron_disk_image_invalid_desc;
+    }
+
+    dfs_side_t sides[2];
+    for (int i = 0; i < num_sides; i++) {
+        sides[i].num_files = 0;
+        sides[i].num_sectors = (uint32_t)num_tracks * DFS_SECTORS_PER_TRACK;
+    }
+
+    for (size_t i = 0; i < desc->num_files; i++) {
+        const baron_disk_file_t *file = &desc->files[i];
+        if (file->side < 0 || file->side >= num_sides || (file->object_code.size && !file->object_code.data)) {
+            return baron_disk_image_invalid_desc;
+        }
+        dfs_side_t *side = &sides[file->side];
+        if (side->num_files == DFS_MAX_FILES) {
+            return baron_disk_image_too_many_files;
+        }
+        side->files[side->num_files++] = file;
+    }
+
+    for (int i = 0; i < num_sides; i++) {
+        baron_disk_image_status_t status = build_catalogue(&sides[i], desc);
+        if (status != baron_disk_image_ok) {
+            return status;
+        }
+    }
+
+    dfs_stream_t streams[2] = {
+        {.side = &sides[0]},
+        {.side = &sides[1]}
+    };
+
+    if (num_sides == 1) {
+        if (!emit(&streams[0], sides[0].num_sectors * DFS_SECTOR_SIZE, write_fn, context)) {
+            return baron_disk_image_write_failed;
+        }
+    }
+    else {
+        for (int track = 0; track < num_tracks; track++) {
+            if (!emit(&streams[0], DFS_TRACK_SIZE, write_fn, context) ||
+                !emit(&streams[1], DFS_TRACK_SIZE, write_fn, context)) {
+                return baron_disk_image_write_failed;
+            }
+        }
+    }
+
+    return baron_disk_image_ok;
+}
+
+
+static bool write_to_file(const void *data, size_t size, void *context) {
+    // The file is only opened by the first write, as an image is written only once its description has been checked,
+    // so that an invalid description leaves any existing image alone
+    dfs_file_t *file = context;
+    if (!file->file) {
+        file->file = fopen(file->filename, "wb");
+        if (!file->file) {
+            return false;
+        }
+    }
+    return fwrite(data, 1, size, file->file) == size;
+}
+
+
+baron_disk_image_status_t baron_disk_image_save(const baron_disk_image_desc_t *desc, const char *filename) {
+    ASSERT(filename);
+    dfs_file_t file = {.filename = filename};
+    baron_disk_image_status_t status = baron_disk_image_write(desc, write_to_file, &file);
+    if (file.file) {
+        if (fclose(file.file) != 0 && status == baron_disk_image_ok) {
+            status = baron_disk_image_write_failed;
+        }
+
+        // A partly written image is no use to anyone
+        if (status != baron_disk_image_ok) {
+            remove(filename);
+        }
+    }
+    return status;
+}
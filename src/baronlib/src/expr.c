@@ -0,0 +1,450 @@
+#include <math.h>
+#include "base/allocator.h"
+#include "base/defines.h"
+#include "expr.h"
+
+typedef struct parser_t parser_t;
+typedef struct binary_op_t binary_op_t;
+typedef struct named_op_t named_op_t;
+
+
+#define PI_VALUE 3.14159265358979323846
+
+// Guards against unbounded recursion on pathological input, e.g. thousands of nested brackets
+#define MAX_NESTING 64
+
+
+struct parser_t {
+    slice_const_token_t tokens;
+    uint32_t pos;
+    array_expr_op_t *ops;
+    expr_resolve_fn_t resolve;
+    void *context;
+    uint32_t depth;             // Depth of the evaluation stack after the ops emitted so far
+    uint32_t nesting;
+    const char *error;
+};
+
+
+struct binary_op_t {
+    const char *text;
+    bool is_keyword;
+    expr_op_type_t type;
+    int precedence;
+};
+
+
+struct named_op_t {
+    const char *name;
+    expr_op_type_t type;
+};
+
+
+static const binary_op_t binary_ops[] = {
+    {"OR",  true,  expr_op_or,             1},
+    {"EOR", true,  expr_op_eor,            1},
+    {"AND", true,  expr_op_and,            2},
+    {"=",   false, expr_op_equal,          3},
+    {"==",  false, expr_op_equal,          3},
+    {"<>",  false, expr_op_not_equal,      3},
+    {"!=",  false, expr_op_not_equal,      3},
+    {"<",   false, expr_op_less,           3},
+    {"<=",  false, expr_op_less_equal,     3},
+    {">",   false, expr_op_greater,        3},
+    {">=",  false, expr_op_greater_equal,  3},
+    {"<<",  false, expr_op_shift_left,     4},
+    {">>",  false, expr_op_shift_right,    4},
+    {"+",   false, expr_op_add,            5},
+    {"-",   false, expr_op_subtract,       5},
+    {"*",   false, expr_op_multiply,       6},
+    {"/",   false, expr_op_divide,         6},
+    {"DIV", true,  expr_op_div,            6},
+    {"MOD", true,  expr_op_mod,            6},
+    {"^",   false, expr_op_power,          7}
+};
+
+#define POWER_PRECEDENCE 7
+
+
+static const named_op_t functions[] = {
+    {"LO",  expr_op_lo},
+    {"HI",  expr_op_hi},
+    {"INT", expr_op_int},
+    {"ABS", expr_op_abs},
+    {"SGN", expr_op_sgn},
+    {"SQR", expr_op_sqr},
+    {"SIN", expr_op_sin},
+    {"COS", expr_op_cos},
+    {"TAN", expr_op_tan},
+    {"ATN", expr_op_atn},
+    {"LN",  expr_op_ln},
+    {"EXP", expr_op_exp},
+    {"RAD", expr_op_rad},
+    {"DEG", expr_op_deg},
+    {"NOT", expr_op_not}
+};
+
+
+static uint32_t op_arity(expr_op_type_t type) {
+    return (type <= expr_op_variable) ? 0 : (type < expr_op_add) ? 1 : 2;
+}
+
+
+// Integer operations act on 32-bit values, as in BBC BASIC; values up to &FFFFFFFF are accepted and wrap
+static bool to_int(double value, int32_t *result) {
+    if (!(value >= -2147483648.0 && value < 4294967296.0)) {
+        return false;
+    }
+    *result = (int32_t)(uint32_t)(int64_t)value;
+    return true;
+}
+
+
+static const char *apply_op(expr_op_type_t type, const double *args, double *result) {
+    double a = args[0];
+    double b = args[1];
+    int32_t ia = 0;
+    int32_t ib = 0;
+
+    switch (type) {
+        case expr_op_negate:        *result = -a; return 0;
+        case expr_op_int:           *result = floor(a); return 0;
+        case expr_op_abs:           *result = fabs(a); return 0;
+        case expr_op_sgn:           *result = (a > 0) - (a < 0); return 0;
+        case expr_op_sin:           *result = sin(a); return 0;
+        case expr_op_cos:           *result = cos(a); return 0;
+        case expr_op_tan:           *result = tan(a); return 0;
+        case expr_op_atn:           *result = atan(a); return 0;
+        case expr_op_exp:           *result = exp(a); return 0;
+        case expr_op_rad:           *result = a * (PI_VALUE / 180.0); return 0;
+        case expr_op_deg:           *result = a * (180.0 / PI_VALUE); return 0;
+        case expr_op_add:           *result = a + b; return 0;
+        case expr_op_subtract:      *result = a - b; return 0;
+        case expr_op_multiply:      *result = a * b; return 0;
+        case expr_op_power:         *result = pow(a, b); return 0;
+        case expr_op_equal:         *result = -(a == b); return 0;
+        case expr_op_not_equal:     *result = -(a != b); return 0;
+        case expr_op_less:          *result = -(a < b); return 0;
+        case expr_op_less_equal:    *result = -(a <= b); return 0;
+        case expr_op_greater:       *result = -(a > b); return 0;
+        case expr_op_greater_equal: *result = -(a >= b); return 0;
+
+        case expr_op_sqr:
+            if (a < 0) {
+                return "Invalid argument";
+            }
+            *result = sqrt(a);
+            return 0;
+
+        case expr_op_ln:
+            if (a <= 0) {
+                return "Invalid argument";
+            }
+            *result = log(a);
+            return 0;
+
+        case expr_op_divide:
+            if (b == 0) {
+                return "Division by zero";
+            }
+            *result = a / b;
+            return 0;
+
+        case expr_op_not:
+        case expr_op_lo:
+        case expr_op_hi:
+            if (!to_int(a, &ia)) {
+                return "Number out of range";
+            }
+            *result = (type == expr_op_not) ? ~ia : (type == expr_op_lo) ? (ia & 0xFF) : ((ia >> 8) & 0xFF);
+            return 0;
+
+        case expr_op_div:
+        case expr_op_mod:
+        case expr_op_shift_left:
+        case expr_op_shift_right:
+        case expr_op_and:
+        case expr_op_or:
+        case expr_op_eor:
+            if (!to_int(a, &ia) || !to_int(b, &ib)) {
+                return "Number out of range";
+            }
+            switch (type) {
+                case expr_op_div:
+                case expr_op_mod:
+                    if (ib == 0) {
+                        return "Division by zero";
+                    }
+                    // Widen, so that -&80000000 DIV -1 doesn't overflow
+                    *result = (double)((type == expr_op_div) ? (int64_t)ia / ib : (int64_t)ia % ib);
+                    return 0;
+                case expr_op_shift_left:
+                    *result = (ib < 0 || ib > 31) ? 0 : (int32_t)((uint32_t)ia << ib);
+                    return 0;
+                case expr_op_shift_right:
+                    *result = (ib < 0 || ib > 31) ? -(ia < 0) : (ia >> ib);
+                    return 0;
+                case expr_op_and:           *result = ia & ib; return 0;
+                case expr_op_or:            *result = ia | ib; return 0;
+                default:                    *result = ia ^ ib; return 0;
+            }
+
+        default:
+            UNREACHABLE();
+    }
+}
+
+
+static const token_t end_token = {.type = token_end_of_file};
+
+static const token_t *peek(const parser_t *parser) {
+    return (parser->pos < parser->tokens.size) ? &parser->tokens.data[parser->pos] : &end_token;
+}
+
+
+static bool emit(parser_t *parser, expr_op_t op) {
+    uint32_t arity = op_arity(op.type);
+    parser->depth = parser->depth + 1 - arity;
+    if (parser->depth > EXPR_MAX_DEPTH) {
+        parser->error = "Expression too complex";
+        return false;
+    }
+    if (!array_add(parser->ops, op)) {
+        parser->error = "Out of memory";
+        return false;
+    }
+    return true;
+}
+
+
+static bool fail(parser_t *parser, const char *error) {
+    parser->error = error;
+    return false;
+}
+
+
+static bool parse_expression(parser_t *parser, int min_precedence);
+
+static bool parse_unary(parser_t *parser) {
+    if (++parser->nesting > MAX_NESTING) {
+        return fail(parser, "Expression too complex");
+    }
+
+    const token_t *token = peek(parser);
+    bool success;
+
+    if (token_is_symbol(token, STRVIEW("-"))) {
+        parser->pos++;
+        success = parse_unary(parser) && emit(parser, (expr_op_t){.type = expr_op_negate});
+    }
+    else if (token_is_symbol(token, STRVIEW("+"))) {
+        parser->pos++;
+        success = parse_unary(parser);
+    }
+    else if (token_is_symbol(token, STRVIEW("("))) {
+        parser->pos++;
+        success = parse_expression(parser, 1);
+        if (success && !token_is_symbol(peek(parser), STRVIEW(")"))) {
+            success = fail(parser, "Missing closing bracket");
+        }
+        parser->pos++;
+    }
+    else if (token->type == token_number) {
+        parser->pos++;
+        success = emit(parser, (expr_op_t){.type = expr_op_constant, .value = token->number});
+    }
+    else if (token->type == token_identifier) {
+        parser->pos++;
+        for (uint32_t i = 0; i < sizeof functions / sizeof functions[0]; i++) {
+            if (token_is_keyword(token, make_strview(functions[i].name))) {
+                success = parse_unary(parser) && emit(parser, (expr_op_t){.type = functions[i].type});
+                parser->nesting--;
+                return success;
+            }
+        }
+
+        double value;
+        if (token_is_keyword(token, STRVIEW("PI"))) {
+            value = PI_VALUE;
+        }
+        else if (token_is_keyword(token, STRVIEW("TRUE"))) {
+            value = -1;
+        }
+        else if (token_is_keyword(token, STRVIEW("FALSE"))) {
+            value = 0;
+        }
+        else {
+            uint32_t slot = parser->resolve ? parser->resolve(token->text, parser->context) : invalid_index;
+            parser->nesting--;
+            if (slot == invalid_index) {
+                return fail(parser, "Unknown symbol");
+            }
+            return emit(parser, (expr_op_t){.type = expr_op_variable, .slot = slot});
+        }
+        success = emit(parser, (expr_op_t){.type = expr_op_constant, .value = value});
+    }
+    else {
+        success = fail(parser, "Expected a value");
+    }
+
+    parser->nesting--;
+    return success;
+}
+
+
+static const binary_op_t *find_binary_op(const token_t *token) {
+    if (token->type != token_symbol && token->type != token_identifier) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < sizeof binary_ops / sizeof binary_ops[0]; i++) {
+        strview_t text = make_strview(binary_ops[i].text);
+        if (binary_ops[i].is_keyword ? token_is_keyword(token, text) : token_is_symbol(token, text)) {
+            return &binary_ops[i];
+        }
+    }
+    return 0;
+}
+
+
+static bool parse_expression(parser_t *parser, int min_precedence) {
+    if (++parser->nesting > MAX_NESTING) {
+        return fail(parser, "Expression too complex");
+    }
+
+    bool success = parse_unary(parser);
+    while (success) {
+        const binary_op_t *op = find_binary_op(peek(parser));
+        if (!op || op->precedence < min_precedence) {
+            break;
+        }
+        parser->pos++;
+        // ^ is right-associative; everything else is left-associative
+        int next_precedence = (op->precedence == POWER_PRECEDENCE) ? op->precedence : op->precedence + 1;
+        success = parse_expression(parser, next_precedence) && emit(parser, (expr_op_t){.type = op->type});
+    }
+
+    parser->nesting--;
+    return success;
+}
+
+
+const char *expr_compile(expr_t *expr, const allocator_t *allocator, slice_const_token_t tokens, expr_resolve_fn_t resolve, void *context) {
+    ASSERT(expr);
+    *expr = (expr_t){
+        .ops = make_array(expr_op_t, allocator, 8)
+    };
+    if (!array_is_valid(&expr->ops)) {
+        return "Out of memory";
+    }
+
+    parser_t parser = {
+        .tokens = tokens,
+        .ops = &expr->ops,
+        .resolve = resolve,
+        .context = context
+    };
+
+    if (parse_expression(&parser, 1) && parser.pos != tokens.size) {
+        parser.error = "Unexpected token in expression";
+    }
+    return parser.error;
+}
+
+
+void expr_deinit(expr_t *expr) {
+    ASSERT(expr);
+    array_deinit(&expr->ops);
+}
+
+
+const char *expr_evaluate(const expr_t *expr, const double *values, double *result) {
+    ASSERT(expr);
+    ASSERT(result);
+    double stack[EXPR_MAX_DEPTH + 1];
+    uint32_t sp = 0;
+
+    for (uint32_t i = 0; i < expr->ops.size; i++) {
+        const expr_op_t *op = &expr->ops.data[i];
+        switch (op->type) {
+            case expr_op_constant:
+                stack[sp++] = op->value;
+                break;
+            case expr_op_variable:
+                stack[sp++] = values[op->slot];
+                break;
+            default: {
+                sp -= op_arity(op->type);
+                const char *error = apply_op(op->type, &stack[sp], &stack[sp]);
+                if (error) {
+                    return error;
+                }
+                sp++;
+                break;
+            }
+        }
+    }
+
+    ASSERT(sp == 1);
+    *result = stack[0];
+    return 0;
+}
+
+
+bool expr_depends_on(const expr_t *expr, uint32_t first_slot) {
+    ASSERT(expr);
+    for (uint32_t i = 0; i < expr->ops.size; i++) {
+        if (expr->ops.data[i].type == expr_op_variable && expr->ops.data[i].slot >= first_slot) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+bool expr_specialize(const expr_t *expr, const double *values, uint32_t first_slot, expr_t *result) {
+    ASSERT(expr);
+    ASSERT(result);
+
+    // Each stack entry is a subexpression already written to the result. An invariant one is always a single constant.
+    struct {
+        uint32_t start;
+        bool is_invariant;
+    } stack[EXPR_MAX_DEPTH + 1];
+    uint32_t sp = 0;
+
+    array_reset(&result->ops);
+    for (uint32_t i = 0; i < expr->ops.size; i++) {
+        expr_op_t op = expr->ops.data[i];
+        uint32_t arity = op_arity(op.type);
+        sp -= arity;
+        uint32_t start = arity ? stack[sp].start : result->ops.size;
+        bool is_invariant = (op.type != expr_op_variable || op.slot < first_slot);
+        double args[2] = {0, 0};
+        for (uint32_t j = 0; j < arity; j++) {
+            is_invariant = is_invariant && stack[sp + j].is_invariant;
+            if (is_invariant) {
+                args[j] = result->ops.data[stack[sp + j].start].value;
+            }
+        }
+
+        if (is_invariant && op.type == expr_op_variable) {
+            op = (expr_op_t){.type = expr_op_constant, .value = values[op.slot]};
+        }
+        else if (is_invariant && arity) {
+            double value;
+            is_invariant = !apply_op(op.type, args, &value);
+            if (is_invariant) {
+                result->ops.size = start;
+                op = (expr_op_t){.type = expr_op_constant, .value = value};
+            }
+        }
+
+        if (!array_add(&result->ops, op)) {
+            return false;
+        }
+        stack[sp].start = start;
+        stack[sp].is_invariant = is_invariant;
+        sp++;
+    }
+    return true;
+}
@@ -0,0 +1,167 @@
+/**
+ *  @file   expr.h
+ *
+ *  Compiled numeric expressions.
+ *
+ *  An expression is parsed from its tokens once, into a sequence of operations in reverse Polish order, which can then
+ *  be evaluated any number of times on a small fixed stack. Symbols are resolved at compile time into slots, indexing
+ *  an array of values supplied at evaluation, so evaluation never looks anything up by name.
+ */
+
+#ifndef BARONLIB_EXPR_H_
+#define BARONLIB_EXPR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "base/array.h"
+#include "base/str.h"
+#include "lexer.h"
+
+typedef struct expr_t expr_t;
+typedef struct expr_op_t expr_op_t;
+typedef struct allocator_t allocator_t;
+
+
+// Maximum depth of the evaluation stack
+#define EXPR_MAX_DEPTH 32
+
+
+typedef enum expr_op_type_t {
+    // Operands
+    expr_op_constant,
+    expr_op_variable,
+
+    // Unary operators and functions
+    expr_op_negate,
+    expr_op_not,
+    expr_op_lo,
+    expr_op_hi,
+    expr_op_int,
+    expr_op_abs,
+    expr_op_sgn,
+    expr_op_sqr,
+    expr_op_sin,
+    expr_op_cos,
+    expr_op_tan,
+    expr_op_atn,
+    expr_op_ln,
+    expr_op_exp,
+    expr_op_rad,
+    expr_op_deg,
+
+    // Binary operators
+    expr_op_add,
+    expr_op_subtract,
+    expr_op_multiply,
+    expr_op_divide,
+    expr_op_div,
+    expr_op_mod,
+    expr_op_power,
+    expr_op_shift_left,
+    expr_op_shift_right,
+    expr_op_and,
+    expr_op_or,
+    expr_op_eor,
+    expr_op_equal,
+    expr_op_not_equal,
+    expr_op_less,
+    expr_op_less_equal,
+    expr_op_greater,
+    expr_op_greater_equal,
+
+    expr_op_count
+} expr_op_type_t;
+
+
+struct expr_op_t {
+    expr_op_type_t type;
+    union {
+        double value;           // Value of an expr_op_constant
+        uint32_t slot;          // Slot of an expr_op_variable
+    };
+};
+
+def_slice(expr_op_t);
+
+
+struct expr_t {
+    array_expr_op_t ops;
+};
+
+def_slice(expr_t);
+
+
+/**
+ *  Resolve a symbol name to the slot holding its value
+ *
+ *  @return The slot, or invalid_index if the symbol is unknown
+ */
+typedef uint32_t (*expr_resolve_fn_t)(strview_t name, void *context);
+
+
+/**
+ *  Compile an expression from its tokens
+ *
+ *  @param  expr            Pointer to the expression to initialize
+ *  @param  allocator       Allocator used to hold the compiled expression
+ *  @param  tokens          Tokens of the expression, which must all be consumed
+ *  @param  resolve         Function used to resolve symbols into slots
+ *  @param  context         Context passed to resolve
+ *
+ *  @return Null on success, otherwise a description of the error. The expression must be deinitialized either way.
+ */
+const char *expr_compile(expr_t *expr, const allocator_t *allocator, slice_const_token_t tokens, expr_resolve_fn_t resolve, void *context);
+
+
+/**
+ *  Deinitialize an expression, freeing its allocations
+ */
+void expr_deinit(expr_t *expr);
+
+
+/**
+ *  Evaluate a compiled expression
+ *
+ *  @param  expr            Pointer to the expression
+ *  @param  values          Values of the slots referenced by the expression
+ *  @param  result          Receives the value of the expression
+ *
+ *  @return Null on success, otherwise a description of the error
+ */
+const char *expr_evaluate(const expr_t *expr, const double *values, double *result);
+
+
+/**
+ *  Determine whether an expression refers to any slot at or above first_slot
+ */
+bool expr_depends_on(const expr_t *expr, uint32_t first_slot);
+
+
+/**
+ *  Partially evaluate an expression, replacing each subexpression which refers to no slot at or above first_slot by
+ *  its value. Subexpressions whose evaluation fails are left as they are, so that the error is raised when the
+ *  result is evaluated.
+ *
+ *  @param  expr            Pointer to the expression to specialize
+ *  @param  values          Values of the slots below first_slot
+ *  @param  first_slot      First slot whose value is still to vary
+ *  @param  result          Pointer to an initialized expression which receives the result, replacing its contents
+ *
+ *  @return Success true/false
+ */
+bool expr_specialize(const expr_t *expr, const double *values, uint32_t first_slot, expr_t *result);
+
+
+/**
+ *  If an expression is a single constant, get its value
+ */
+static inline bool expr_is_constant(const expr_t *expr, double *value) {
+    if (expr->ops.size == 1 && expr->ops.data[0].type == expr_op_constant) {
+        *value = expr->ops.data[0].value;
+        return true;
+    }
+    return false;
+}
+
+
+#endif // ifndef BARONLIB_EXPR_H_
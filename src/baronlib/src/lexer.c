@@ -0,0 +1,194 @@
+#include <string.h>
+#include "base/defines.h"
+#include "lexer.h"
+
+
+static bool is_digit(uint8_t c) {
+    return c >= '0' && c <= '9';
+}
+
+
+static bool is_identifier_start(uint8_t c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_';
+}
+
+
+static bool is_identifier_char(uint8_t c) {
+    return is_identifier_start(c) || is_digit(c);
+}
+
+
+static bool is_space(uint8_t c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+
+static uint32_t get_symbol_length(strview_t src) {
+    static const char two_char_symbols[][2] = {
+        {'<', '='}, {'>', '='}, {'<', '>'}, {'=', '='}, {'!', '='}, {'<', '<'}, {'>', '>'}
+    };
+
+    if (src.length >= 2) {
+        for (uint32_t i = 0; i < sizeof two_char_symbols / sizeof two_char_symbols[0]; i++) {
+            if (src.data[0] == two_char_symbols[i][0] && src.data[1] == two_char_symbols[i][1]) {
+                return 2;
+            }
+        }
+    }
+    return strchr("+-*/^()[]{},#=<>!?.@~|&%$", src.data[0]) ? 1 : 0;
+}
+
+
+// Parses a number, returning its length, or 0 if it's not a valid number.
+// A & or $ prefix denotes hex, and % denotes binary.
+static uint32_t parse_number(strview_t src, double *value) {
+    if (src.data[0] == '&' || src.data[0] == '$' || src.data[0] == '%') {
+        strview_parse_hex_result_t result = (src.data[0] == '%') ? strview_parse_bin(strview_mid(src, 1))
+                                                                 : strview_parse_hex(strview_mid(src, 1));
+        *value = (double)result.value;
+        return (result.length_parsed && !result.overflow) ? result.length_parsed + 1 : 0;
+    }
+
+    strview_parse_float_result_t result = strview_parse_float(src);
+    *value = result.value;
+    return result.length_parsed;
+}
+
+
+static bool is_number_start(strview_t src) {
+    if (is_digit(src.data[0])) {
+        return true;
+    }
+    if (src.length < 2) {
+        return false;
+    }
+    uint8_t next = src.data[1];
+    switch (src.data[0]) {
+        case '&':
+        case '$':
+            return is_digit(next) || (next >= 'A' && next <= 'F') || (next >= 'a' && next <= 'f');
+        case '%':
+            return next == '0' || next == '1';
+        case '.':
+            return is_digit(next);
+        default:
+            return false;
+    }
+}
+
+
+lex_result_t lex(strview_t source, array_token_t *tokens) {
+    ASSERT(tokens);
+    lex_result_t result = {0};
+    uint32_t line = 1;
+    uint32_t i = 0;
+
+    while (i < source.length && !result.error) {
+        uint8_t c = source.data[i];
+        strview_t rest = strview_mid(source, i);
+        token_t token = {.line = line};
+
+        if (is_space(c)) {
+            i++;
+            continue;
+        }
+
+        if (c == ';' || c == '\\') {
+            while (i < source.length && source.data[i] != '\n') {
+                i++;
+            }
+            continue;
+        }
+
+        if (c == '\n' || c == ':') {
+            token.type = token_end_of_statement;
+            token.text = strview_left(rest, 1);
+            line += (c == '\n');
+        }
+        else if (is_identifier_start(c)) {
+            uint32_t length = 1;
+            while (length < rest.length && is_identifier_char(rest.data[length])) {
+                length++;
+            }
+            token.type = token_identifier;
+            token.text = strview_left(rest, length);
+        }
+        else if (is_number_start(rest)) {
+            uint32_t length = parse_number(rest, &token.number);
+            if (length == 0) {
+                result.error = "Invalid number";
+                break;
+            }
+            token.type = token_number;
+            token.text = strview_left(rest, length);
+        }
+        else if (c == '"') {
+            uint32_t length = 1;
+            while (length < rest.length && rest.data[length] != '\n') {
+                if (rest.data[length] == '"') {
+                    if (length + 1 < rest.length && rest.data[length + 1] == '"') {
+                        length += 2;
+                        continue;
+                    }
+                    break;
+                }
+                length++;
+            }
+            if (length == rest.length || rest.data[length] != '"') {
+                result.error = "Missing closing quote";
+                break;
+            }
+            token.type = token_string;
+            token.text = strview_substr(rest, 1, length - 1);
+            i += length + 1;
+            if (!array_add(tokens, token)) {
+                result.error = "Out of memory";
+            }
+            continue;
+        }
+        else {
+            uint32_t length = get_symbol_length(rest);
+            if (length == 0) {
+                result.error = "Unexpected character";
+                break;
+            }
+            token.type = token_symbol;
+            token.text = strview_left(rest, length);
+        }
+
+        i += token.text.length;
+        if (!array_add(tokens, token)) {
+            result.error = "Out of memory";
+        }
+    }
+
+    if (result.error) {
+        result.line = line;
+    }
+
+    token_t end = {
+        .type = token_end_of_file,
+        .line = line,
+        .text = strview_mid(source, source.length)
+    };
+    if (!array_add(tokens, end) && !result.error) {
+        result = (lex_result_t){"Out of memory", line};
+    }
+
+    return result;
+}
+
+
+bool token_is_keyword(const token_t *token, strview_t keyword) {
+    ASSERT(token);
+    if (token->type != token_identifier || token->text.length != keyword.length) {
+        return false;
+    }
+    for (uint32_t i = 0; i < keyword.length; i++) {
+        uint8_t c = token->text.data[i];
+        if ((c >= 'a' && c <= 'z' ? c - 0x20 : c) != keyword.data[i]) {
+            return false;
+        }
+    }
+    return true;
+}
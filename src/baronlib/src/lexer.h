@@ -0,0 +1,79 @@
+/**
+ *  @file   lexer.h
+ *
+ *  Conversion of source text into tokens.
+ *  Source is tokenized once, and all subsequent passes, macro expansions and loop iterations work on the tokens.
+ */
+
+#ifndef BARONLIB_LEXER_H_
+#define BARONLIB_LEXER_H_
+
+#include <stdint.h>
+#include "base/array.h"
+#include "base/str.h"
+
+typedef struct token_t token_t;
+typedef struct lex_result_t lex_result_t;
+
+
+typedef enum token_type_t {
+    token_end_of_file,
+    token_end_of_statement,     // A newline or a colon
+    token_identifier,
+    token_number,
+    token_string,               // text excludes the quotes; doubled quotes within it are not unescaped
+    token_symbol,               // An operator or punctuation, e.g. ( , # <= <<
+    token_param                 // A reference to a macro parameter, only found in macro bodies
+} token_type_t;
+
+
+struct token_t {
+    token_type_t type;
+    uint32_t line;
+    strview_t text;
+    union {
+        double number;          // Value of a token_number
+        uint32_t slot;          // Parameter index of a token_param
+    };
+};
+
+def_slice(token_t);
+
+
+struct lex_result_t {
+    const char *error;          // Null on success, otherwise a description of the error
+    uint32_t line;              // Line on which the error occurred
+};
+
+
+/**
+ *  Tokenize source text, appending the tokens to an array.
+ *  The tokens are always terminated by a token_end_of_file, even on error.
+ *  Token text references the source, which must outlive the tokens.
+ *
+ *  @param  source          Text to tokenize
+ *  @param  tokens          Pointer to an initialized array to which the tokens will be added
+ *
+ *  @return lex_result_t whose error field is null on success
+ */
+lex_result_t lex(strview_t source, array_token_t *tokens);
+
+
+/**
+ *  Determine whether a token is the given symbol
+ */
+static inline bool token_is_symbol(const token_t *token, strview_t symbol) {
+    return token->type == token_symbol && strview_equal(token->text, symbol);
+}
+
+
+/**
+ *  Determine whether a token is the given keyword, ignoring case
+ *
+ *  @param  token           Token to test
+ *  @param  keyword         Keyword, in upper case
+ */
+bool token_is_keyword(const token_t *token, strview_t keyword);
+
+
+#endif // ifndef BARONLIB_LEXER_H_
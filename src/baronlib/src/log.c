@@ -0,0 +1,482 @@
+#include <stdarg.h>
+#include <string.h>
+#include "base/allocator.h"
+#include "base/defines.h"
+#include "log.h"
+
+
+// Size of the blocks holding records, and of the arena regions they're allocated from
+#define LOG_BLOCK_SIZE 0x1000
+#define LOG_REGION_SIZE 0x10000
+
+// Amount of text buffered for a sink before it's passed on
+#define LOG_SINK_BUFFER_SIZE 0x10000
+
+
+typedef struct log_record_header_t log_record_header_t;
+
+typedef enum log_text_state_t {
+    log_text_pending,               // Records have been written since the text was formatted
+    log_text_formatted,
+    log_text_failed
+} log_text_state_t;
+
+struct log_block_t {
+    log_block_t *next;
+    uint32_t capacity;
+    uint32_t size;
+    uint8_t data[];
+};
+
+
+struct log_record_header_t {
+    uint32_t size;                  // Size of the record, including this header
+    uint32_t message;
+    uint32_t line;
+};
+
+
+static const char *const message_formats[] = {
+#define X(name, format) format,
+    LOG_MESSAGES(X)
+#undef X
+};
+
+
+void log_init(log_t *log, const allocator_t *allocator) {
+    ASSERT(log);
+    *log = (log_t){.allocator = allocator, .is_final_pass = true};
+    atomic_flag_clear(&log->format_lock);
+    for (int i = 0; i < LOG_NUM_CHANNELS; i++) {
+        log->channels[i].arena = make_arena(allocator, LOG_REGION_SIZE);
+    }
+}
+
+
+void log_deinit(log_t *log) {
+    ASSERT(log);
+    for (int i = 0; i < LOG_NUM_CHANNELS; i++) {
+        arena_deinit(&log->channels[i].arena);
+        log_text_t *text = log->channels[i].text;
+        if (text && str_is_valid(&text->text)) {
+            str_deinit(&text->text);
+        }
+        allocator_free(log->allocator, text);
+        if (str_is_valid(&log->channels[i].sink_text)) {
+            str_deinit(&log->channels[i].sink_text);
+        }
+    }
+}
+
+
+/**
+ *  Discard a channel's records and the text formatted from them, keeping the first region of its arena for reuse
+ */
+static void clear_records(log_channel_t *channel) {
+    arena_reset(&channel->arena);
+    channel->first_block = 0;
+    channel->last_block = 0;
+    channel->num_records = 0;
+    log_text_t *text = channel->text;
+    if (text) {
+        atomic_store_explicit(&text->state, log_text_pending, memory_order_relaxed);
+        text->format_block = 0;
+        text->format_offset = 0;
+        if (str_is_valid(&text->text)) {
+            str_reset(&text->text);
+        }
+    }
+}
+
+
+void log_reset(log_t *log) {
+    ASSERT(log);
+    log->is_final_pass = true;
+    for (int i = 0; i < LOG_NUM_CHANNELS; i++) {
+        log_channel_t *channel = &log->channels[i];
+        clear_records(channel);
+        channel->sink_failed = false;
+        if (str_is_valid(&channel->sink_text)) {
+            str_reset(&channel->sink_text);
+        }
+    }
+}
+
+
+void log_set_sink(log_t *log, uint32_t channel, baron_write_fn_t write_fn, void *context) {
+    ASSERT(log);
+    ASSERT(channel < LOG_NUM_CHANNELS);
+    ASSERT(log->channels[channel].num_records == 0);
+    log->channels[channel].sink = write_fn;
+    log->channels[channel].sink_context = context;
+}
+
+
+void log_begin_pass(log_t *log, bool is_final_pass) {
+    ASSERT(log);
+    log->is_final_pass = is_final_pass;
+
+    // Each pass writes its messages afresh, so only those of the last pass are kept
+    for (int i = 0; i < LOG_NUM_CHANNELS; i++) {
+        if (!log->channels[i].sink) {
+            clear_records(&log->channels[i]);
+        }
+    }
+}
+
+
+static bool flush_sink(log_channel_t *channel) {
+    if (!channel->sink_failed && channel->sink_text.length > 0 &&
+        !channel->sink(channel->sink_text.data, channel->sink_text.length, channel->sink_context)) {
+        channel->sink_failed = true;
+    }
+    str_reset(&channel->sink_text);
+    return !channel->sink_failed;
+}
+
+
+bool log_flush(log_t *log) {
+    ASSERT(log);
+    bool success = true;
+    for (int i = 0; i < LOG_NUM_CHANNELS; i++) {
+        log_channel_t *channel = &log->channels[i];
+        if (channel->sink) {
+            success = (str_is_valid(&channel->sink_text) ? flush_sink(channel) : !channel->sink_failed) && success;
+        }
+    }
+    return success;
+}
+
+
+/**
+ *  Find the next conversion in a format, returning a pointer to its type character, or null if there are no more.
+ *  Any zero flag and width are skipped.
+ */
+static const char *next_conversion(const char *format) {
+    for (;;) {
+        format = strchr(format, '%');
+        if (!format) {
+            return 0;
+        }
+        format++;
+        while (*format >= '0' && *format <= '9') {
+            format++;
+        }
+        if (*format != '%') {
+            return format;
+        }
+        format++;
+    }
+}
+
+
+static uint32_t get_argument_size(char type) {
+    switch (type) {
+        case 'd':
+        case 'u':
+        case 'X':
+            return sizeof(uint32_t);
+        case 'f':
+            return sizeof(double);
+        case 's':
+            return sizeof(uint32_t);    // Length, followed by the characters
+        default:
+            UNREACHABLE();
+    }
+}
+
+
+static uint8_t *reserve_record(log_channel_t *channel, uint32_t size) {
+    log_block_t *block = channel->last_block;
+    if (!block || block->capacity - block->size < size) {
+        uint32_t capacity = math_max_uint32(LOG_BLOCK_SIZE - (uint32_t)sizeof(log_block_t), size);
+        log_block_t *new_block = arena_alloc(&channel->arena, (uint32_t)sizeof(log_block_t) + capacity);
+        if (!new_block) {
+            return 0;
+        }
+        new_block->capacity = capacity;
+        if (block) {
+            block->next = new_block;
+        }
+        else {
+            channel->first_block = new_block;
+        }
+        channel->last_block = new_block;
+        block = new_block;
+    }
+    uint8_t *record = block->data + block->size;
+    block->size += size;
+    return record;
+}
+
+
+/**
+ *  Format a record just written to a channel with a sink, passing the text on once enough has been buffered.
+ *  The record is only needed until it's formatted, so its space is given back to be reused by the next one.
+ */
+static bool stream_record(log_t *log, log_channel_t *channel, uint8_t *record) {
+    uint32_t size;
+    memcpy(&size, record, sizeof size);
+    ASSERT(record + size == channel->last_block->data + channel->last_block->size);
+
+    if (!str_is_valid(&channel->sink_text)) {
+        channel->sink_text = make_str(log->allocator, LOG_SINK_BUFFER_SIZE);
+    }
+    bool success = str_is_valid(&channel->sink_text) && log_format_record(record, &channel->sink_text);
+
+    channel->last_block->size -= size;
+
+    if (!success) {
+        channel->sink_failed = true;
+        return false;
+    }
+    return (channel->sink_text.length < LOG_SINK_BUFFER_SIZE) || flush_sink(channel);
+}
+
+
+bool log_write(log_t *log, uint32_t channel, log_message_t message, uint32_t line, ...) {
+    ASSERT(log);
+    ASSERT(channel < LOG_NUM_CHANNELS);
+    ASSERT(message < log_message_count);
+    const char *format = message_formats[message];
+    log_channel_t *ch = &log->channels[channel];
+    if (ch->sink && (!log->is_final_pass || ch->sink_failed)) {
+        return !ch->sink_failed;
+    }
+    if (!ch->sink && !ch->text) {
+        ch->text = allocator_alloc(log->allocator, sizeof(log_text_t));
+        if (!ch->text) {
+            return false;
+        }
+        *ch->text = (log_text_t){.state = log_text_pending};
+    }
+
+    // Measure the record first, so that it can be written in place
+    va_list args;
+    va_start(args, line);
+    uint32_t size = (uint32_t)sizeof(log_record_header_t);
+    for (const char *type = next_conversion(format); type; type = next_conversion(type + 1)) {
+        size += get_argument_size(*type);
+        switch (*type) {
+            case 'd': (void)va_arg(args, int32_t); break;
+            case 'u':
+            case 'X': (void)va_arg(args, uint32_t); break;
+            case 'f': (void)va_arg(args, double); break;
+            case 's': size += va_arg(args, strview_t).length; break;
+        }
+    }
+    va_end(args);
+
+    uint8_t *record = reserve_record(ch, size);
+    if (!record) {
+        return false;
+    }
+
+    log_record_header_t header = {size, (uint32_t)message, line};
+    memcpy(record, &header, sizeof header);
+    uint8_t *ptr = record + sizeof header;
+
+    va_start(args, line);
+    for (const char *type = next_conversion(format); type; type = next_conversion(type + 1)) {
+        switch (*type) {
+            case 'd': {
+                int32_t value = va_arg(args, int32_t);
+                memcpy(ptr, &value, sizeof value);
+                ptr += sizeof value;
+                break;
+            }
+            case 'u':
+            case 'X': {
+                uint32_t value = va_arg(args, uint32_t);
+                memcpy(ptr, &value, sizeof value);
+                ptr += sizeof value;
+                break;
+            }
+            case 'f': {
+                double value = va_arg(args, double);
+                memcpy(ptr, &value, sizeof value);
+                ptr += sizeof value;
+                break;
+            }
+            case 's': {
+                strview_t value = va_arg(args, strview_t);
+                memcpy(ptr, &value.length, sizeof value.length);
+                ptr += sizeof value.length;
+                if (value.length > 0) {
+                    memcpy(ptr, value.data, value.length);
+                }
+                ptr += value.length;
+                break;
+            }
+        }
+    }
+    va_end(args);
+
+    ASSERT(ptr == record + size);
+    ch->num_records++;
+    if (ch->sink) {
+        return stream_record(log, ch, record);
+    }
+
+    // Nothing reads the log while it's written to, so the text can simply be marked as out of date
+    if (atomic_load_explicit(&ch->text->state, memory_order_relaxed) == log_text_formatted) {
+        atomic_store_explicit(&ch->text->state, log_text_pending, memory_order_relaxed);
+    }
+    return true;
+}
+
+
+static bool append_uint(str_t *text, uint32_t value, uint32_t base, uint32_t width, bool zero_pad) {
+    uint8_t digits[32];
+    uint32_t length = 0;
+    do {
+        digits[length++] = (uint8_t)"0123456789ABCDEF"[value % base];
+        value /= base;
+    } while (value > 0);
+
+    uint8_t buffer[64];
+    uint32_t padding = (width > length) ? math_min_uint32(width - length, (uint32_t)sizeof buffer - length) : 0;
+    memset(buffer, zero_pad ? '0' : ' ', padding);
+    for (uint32_t i = 0; i < length; i++) {
+        buffer[padding + i] = digits[length - 1 - i];
+    }
+    return str_append(text, (strview_t){buffer, padding + length});
+}
+
+
+bool log_format_record(const uint8_t *record, str_t *text) {
+    ASSERT(record);
+    log_record_header_t header;
+    memcpy(&header, record, sizeof header);
+    const uint8_t *ptr = record + sizeof header;
+    const char *format = message_formats[header.message];
+
+    bool success = true;
+    if (header.line != 0) {
+        success = str_append(text, STRVIEW("Line ")) &&
+                  append_uint(text, header.line, 10, 0, false) &&
+                  str_append(text, STRVIEW(": "));
+    }
+
+    while (success && *format) {
+        const char *percent = strchr(format, '%');
+        uint32_t literal_length = percent ? (uint32_t)(percent - format) : (uint32_t)strlen(format);
+        success = str_append(text, (strview_t){(const uint8_t *)format, literal_length});
+        if (!percent || !success) {
+            break;
+        }
+
+        format = percent + 1;
+        bool zero_pad = (*format == '0');
+        uint32_t width = 0;
+        while (*format >= '0' && *format <= '9') {
+            width = width * 10 + (uint32_t)(*format++ - '0');
+        }
+
+        switch (*format++) {
+            case '%':
+                success = str_append(text, STRVIEW("%"));
+                break;
+            case 'd': {
+                int32_t value;
+                memcpy(&value, ptr, sizeof value);
+                ptr += sizeof value;
+                if (value < 0) {
+                    success = str_append(text, STRVIEW("-"));
+                }
+                success = success && append_uint(text, (value < 0) ? 0U - (uint32_t)value : (uint32_t)value, 10, width, zero_pad);
+                break;
+            }
+            case 'u':
+            case 'X': {
+                uint32_t value;
+                memcpy(&value, ptr, sizeof value);
+                ptr += sizeof value;
+                success = append_uint(text, value, (format[-1] == 'X') ? 16 : 10, width, zero_pad);
+                break;
+            }
+            case 'f': {
+                double value;
+                memcpy(&value, ptr, sizeof value);
+                ptr += sizeof value;
+                success = str_append_double(text, value);
+                break;
+            }
+            case 's': {
+                uint32_t length;
+                memcpy(&length, ptr, sizeof length);
+                ptr += sizeof length;
+                success = str_append(text, (strview_t){ptr, length});
+                ptr += length;
+                break;
+            }
+            default:
+                UNREACHABLE();
+        }
+    }
+
+    return success && str_append(text, STRVIEW("\n"));
+}
+
+
+static bool format_channel(const allocator_t *allocator, const log_channel_t *ch, log_text_t *text) {
+    if (!str_is_valid(&text->text)) {
+        text->text = make_str(allocator, 256);
+        if (!str_is_valid(&text->text)) {
+            return false;
+        }
+    }
+
+    // Blocks are only ever appended to, so formatting resumes from where it last stopped
+    if (!text->format_block) {
+        text->format_block = ch->first_block;
+        text->format_offset = 0;
+    }
+    for (log_block_t *block = text->format_block; block; block = block->next) {
+        if (block != text->format_block) {
+            text->format_block = block;
+            text->format_offset = 0;
+        }
+        while (text->format_offset < block->size) {
+            const uint8_t *record = block->data + text->format_offset;
+            if (!log_format_record(record, &text->text)) {
+                return false;
+            }
+            uint32_t size;
+            memcpy(&size, record, sizeof size);
+            text->format_offset += size;
+        }
+    }
+    return true;
+}
+
+
+const char *log_text(const log_t *log, uint32_t channel) {
+    ASSERT(log);
+    ASSERT(channel < LOG_NUM_CHANNELS);
+    const log_channel_t *ch = &log->channels[channel];
+    log_text_t *text = ch->text;
+    if (!text) {
+        return "";
+    }
+
+    // The first thread to find the text out of date formats it while holding the lock, and any others wait for it to
+    // finish, which they won't do for long. The log is only const to the caller, so the lock can be taken through it.
+    int state = atomic_load_explicit(&text->state, memory_order_acquire);
+    if (state == log_text_pending) {
+        atomic_flag *lock = (atomic_flag *)&log->format_lock;
+        while (atomic_flag_test_and_set_explicit(lock, memory_order_acquire)) {
+        }
+        state = atomic_load_explicit(&text->state, memory_order_relaxed);
+        if (state == log_text_pending) {
+            state = format_channel(log->allocator, ch, text) ? log_text_formatted : log_text_failed;
+            atomic_store_explicit(&text->state, state, memory_order_release);
+        }
+        atomic_flag_clear_explicit(lock, memory_order_release);
+    }
+
+    if (state == log_text_failed) {
+        return 0;
+    }
+    return str_is_valid(&text->text) ? (const char *)text->text.data : "";
+}
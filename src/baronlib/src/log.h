@@ -0,0 +1,200 @@
+/**
+ *  @file   log.h
+ *
+ *  Log channels holding messages as compact binary records, which are only formatted as text when a channel's text is
+ *  first asked for.
+ *
+ *  Each record holds a message id, the source line, and the values of the message's arguments, packed as described by
+ *  the conversions in the message's format. Records are written into blocks allocated from the channel's own arena,
+ *  so a channel which is never written to allocates nothing, and records written during passes which are discarded
+ *  are dropped at the start of the next pass, without being formatted. Most channels are never read, so their records
+ *  are never formatted at all. A channel is formatted at most once however many threads ask for its text at the same
+ *  time: the first formats it, and the rest wait for it to finish.
+ *
+ *  A channel may instead have a sink, to which its text is streamed as it's written: each record is formatted as soon
+ *  as it's written, into a buffer which is passed to the sink whenever it fills, and the record's space is reused by
+ *  the next one. Memory held by such a channel is bounded by the buffer size, however much is written to it. Sinks
+ *  are only written to during the final pass; records written to a channel with a sink during earlier passes are
+ *  discarded.
+ *
+ *  Formats use a subset of printf conversions, with their own argument types:
+ *    %s        strview_t, copied into the record
+ *    %d        int32_t
+ *    %u, %X    uint32_t, with an optional zero flag and width, e.g. %04X
+ *    %f        double, formatted with the fewest digits which round trip
+ *    %%        a literal %
+ */
+
+#ifndef BARONLIB_LOG_H_
+#define BARONLIB_LOG_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "base/arena.h"
+#include "base/str.h"
+#include "baron/baron.h"
+
+typedef struct log_t log_t;
+typedef struct log_channel_t log_channel_t;
+typedef struct log_block_t log_block_t;
+typedef struct log_text_t log_text_t;
+typedef struct allocator_t allocator_t;
+
+
+// Channel 0 is the error log, which also holds warnings; channels 1-7 are written by the source
+#define LOG_CHANNEL_ERRORS 0
+#define LOG_NUM_CHANNELS BARON_NUM_LOG_CHANNELS
+
+
+#define LOG_MESSAGES(X) \
+    X(text,                 "%s") \
+    X(error,                "Error: %s") \
+    X(file_unreadable,      "Error: Unable to read file '%s'") \
+    X(overlays_overlap,     "Warning: saved overlays '%s' and '%s' overlap at &%04X-&%04X") \
+    X(symbol_value,         "%s = %f") \
+    X(listing,              "%04X  %s")
+
+typedef enum log_message_t {
+#define X(name, format) log_message_##name,
+    LOG_MESSAGES(X)
+#undef X
+    log_message_count
+} log_message_t;
+
+
+/**
+ *  Text formatted from a channel's records. It is allocated separately from the channel, by the first write to it, so
+ *  that it can be formatted through a const log.
+ */
+struct log_text_t {
+    atomic_int state;               // log_text_state_t: whether the text is up to date with the records
+    str_t text;                     // Text of the records formatted so far
+    log_block_t *format_block;      // Block holding the next record to be formatted
+    uint32_t format_offset;         // Offset of the next record to be formatted within format_block
+};
+
+
+struct log_channel_t {
+    arena_t arena;
+    log_block_t *first_block;
+    log_block_t *last_block;
+    uint32_t num_records;
+    log_text_t *text;               // Null until a record is kept
+    baron_write_fn_t sink;          // If set, text is streamed here instead of records being kept
+    void *sink_context;
+    str_t sink_text;                // Text formatted but not yet passed to the sink
+    bool sink_failed;               // Whether the sink has failed, or text couldn't be formatted for it
+};
+
+
+struct log_t {
+    const allocator_t *allocator;
+    bool is_final_pass;             // Whether sinks are currently being written to
+    atomic_flag format_lock;        // Held while a channel is formatted, as the allocator is shared by every channel
+    log_channel_t channels[LOG_NUM_CHANNELS];
+};
+
+
+/**
+ *  Initialize a log. Nothing is allocated until a channel is written to.
+ *
+ *  @param  log             Pointer to the log to initialize
+ *  @param  allocator       Allocator used for the channels' arenas and text
+ */
+void log_init(log_t *log, const allocator_t *allocator);
+
+
+/**
+ *  Deinitialize a log, freeing all its allocations
+ */
+void log_deinit(log_t *log);
+
+
+/**
+ *  Discard every channel's records and text, keeping the first region of each channel's arena for reuse.
+ *  Sinks remain set, and the log goes back to treating its pass as the final one.
+ *
+ *  @param  log             Pointer to the log to reset
+ */
+void log_reset(log_t *log);
+
+
+/**
+ *  Stream a channel's text to a sink instead of keeping its records
+ *
+ *  @param  log             Pointer to the log
+ *  @param  channel         Channel to stream
+ *  @param  write_fn        Function called with each buffer of text, or null to keep the channel's records
+ *  @param  context         Context passed to write_fn
+ */
+void log_set_sink(log_t *log, uint32_t channel, baron_write_fn_t write_fn, void *context);
+
+
+/**
+ *  Begin a pass of the assembly, discarding the records written to channels without sinks during any earlier pass.
+ *  A log starts out treating its pass as the final one, so sinks are written to by an assembly which makes only a
+ *  single pass.
+ *
+ *  @param  log             Pointer to the log
+ *  @param  is_final_pass   Whether records written during this pass should be streamed to sinks
+ */
+void log_begin_pass(log_t *log, bool is_final_pass);
+
+
+/**
+ *  Append a message to a channel, storing its arguments without formatting them
+ *
+ *  @param  log             Pointer to the log
+ *  @param  channel         Channel to write to
+ *  @param  message         Message whose format describes the arguments which follow
+ *  @param  line            Source line the message relates to, or 0 if none
+ *
+ *  @return Success true/false. This fails if the record couldn't be stored, or if the channel has a sink which failed.
+ */
+bool log_write(log_t *log, uint32_t channel, log_message_t message, uint32_t line, ...);
+
+
+/**
+ *  Pass any text still buffered to the sinks
+ *
+ *  @param  log             Pointer to the log
+ *
+ *  @return Success true/false. This fails if any sink has failed since the log was initialized.
+ */
+bool log_flush(log_t *log);
+
+
+/**
+ *  Get the number of records written to a channel, including those streamed to a sink
+ */
+static inline uint32_t log_num_records(const log_t *log, uint32_t channel) {
+    return log->channels[channel].num_records;
+}
+
+
+/**
+ *  Format a record as a line of text, appending it to a str
+ *
+ *  @param  record          Pointer to the record
+ *  @param  text            str to append to
+ *
+ *  @return Success true/false
+ */
+bool log_format_record(const uint8_t *record, str_t *text);
+
+
+/**
+ *  Get the text of a channel, formatting any records written since it was last asked for.
+ *  This may be called from several threads at once, as long as nothing is written to the log meanwhile.
+ *  A channel with a sink keeps no records, so its text is always empty.
+ *
+ *  @param  log             Pointer to the log
+ *  @param  channel         Channel to get the text of
+ *
+ *  @return The zero-terminated text, valid until the log is next written to or reset, or null if formatting failed
+ */
+const char *log_text(const log_t *log, uint32_t channel);
+
+
+#endif // ifndef BARONLIB_LOG_H_
@@ -0,0 +1,579 @@
+#include <string.h>
+#include "base/allocator.h"
+#include "base/defines.h"
+#include "loop.h"
+
+typedef struct compiler_t compiler_t;
+typedef struct runner_t runner_t;
+
+
+// Guards against loops which would never finish, e.g. where the step is too small to change the loop variable
+#define MAX_ITERATIONS 0x1000000
+
+
+struct compiler_t {
+    loop_t *loop;
+    const allocator_t *allocator;
+    slice_const_token_t tokens;
+    uint32_t pos;
+    expr_resolve_fn_t resolve;
+    void *context;
+    strview_t names[LOOP_MAX_DEPTH];    // Names of the loop variables in scope, outermost first
+    uint32_t num_names;
+    loop_result_t result;
+};
+
+
+struct runner_t {
+    loop_t *loop;
+    double *values;
+    array_uint8_t *object_code;
+    uint32_t pc;
+    budget_t *budget;
+    profile_t *profile;
+    uint64_t num_evaluations;
+    loop_result_t result;
+};
+
+
+static bool fail(loop_result_t *result, const char *error, uint32_t line) {
+    *result = (loop_result_t){.error = error, .line = line};
+    return false;
+}
+
+
+// Loop variables shadow any other symbol of the same name
+static uint32_t resolve_symbol(strview_t name, void *context) {
+    const compiler_t *compiler = context;
+    for (uint32_t i = compiler->num_names; i-- > 0; ) {
+        if (strview_equal(compiler->names[i], name)) {
+            return compiler->loop->first_slot + i;
+        }
+    }
+    return compiler->resolve ? compiler->resolve(name, compiler->context) : invalid_index;
+}
+
+
+// Gets the tokens of the next statement, excluding its terminator, and moves past it
+static slice_const_token_t next_statement(compiler_t *compiler) {
+    uint32_t start = compiler->pos;
+    uint32_t end = start;
+    while (end < compiler->tokens.size &&
+           compiler->tokens.data[end].type != token_end_of_statement &&
+           compiler->tokens.data[end].type != token_end_of_file) {
+        end++;
+    }
+    compiler->pos = (end < compiler->tokens.size && compiler->tokens.data[end].type == token_end_of_statement) ? end + 1 : end;
+    return (slice_const_token_t){compiler->tokens.data + start, end - start};
+}
+
+
+// Gets the next comma-separated item of a list, ignoring commas nested within brackets
+static slice_const_token_t next_list_item(slice_const_token_t tokens, uint32_t *pos) {
+    uint32_t start = *pos;
+    uint32_t i = start;
+    int depth = 0;
+    for (; i < tokens.size; i++) {
+        const token_t *token = &tokens.data[i];
+        if (depth == 0 && token_is_symbol(token, STRVIEW(","))) {
+            break;
+        }
+        if (token_is_symbol(token, STRVIEW("(")) || token_is_symbol(token, STRVIEW("["))) {
+            depth++;
+        }
+        else if (token_is_symbol(token, STRVIEW(")")) || token_is_symbol(token, STRVIEW("]"))) {
+            depth--;
+        }
+    }
+    *pos = i + 1;
+    return (slice_const_token_t){tokens.data + start, i - start};
+}
+
+
+// Compiles an expression, returning its index, or invalid_index on error
+static uint32_t add_expr(compiler_t *compiler, slice_const_token_t tokens, uint32_t line) {
+    loop_t *loop = compiler->loop;
+    expr_t expr;
+    const char *error = expr_compile(&expr, compiler->allocator, tokens, resolve_symbol, compiler);
+    if (error) {
+        expr_deinit(&expr);
+        fail(&compiler->result, error, line);
+        return invalid_index;
+    }
+
+    // exprs and specialized are kept the same size, so reserve both before adding to either
+    expr_t specialized = {make_array(expr_op_t, compiler->allocator, expr.ops.size)};
+    if (!array_is_valid(&specialized.ops) ||
+        !array_reserve(&loop->exprs, loop->exprs.size + 1) ||
+        !array_reserve(&loop->specialized, loop->specialized.size + 1)) {
+        expr_deinit(&expr);
+        expr_deinit(&specialized);
+        fail(&compiler->result, "Out of memory", line);
+        return invalid_index;
+    }
+
+    array_add(&loop->exprs, expr);
+    array_add(&loop->specialized, specialized);
+    return loop->exprs.size - 1;
+}
+
+
+static bool compile_list(compiler_t *compiler, slice_const_token_t tokens, loop_statement_t *statement) {
+    statement->first_expr = compiler->loop->exprs.size;
+    for (uint32_t pos = 0; pos <= tokens.size; ) {
+        if (add_expr(compiler, next_list_item(tokens, &pos), statement->line) == invalid_index) {
+            return false;
+        }
+        statement->num_exprs++;
+    }
+    return true;
+}
+
+
+static bool compile_instruction(compiler_t *compiler, slice_const_token_t tokens, loop_statement_t *statement) {
+    const opcode_table_t *opcodes = compiler->loop->opcodes;
+    statement->mnemonic = (tokens.data[0].type == token_identifier) ? mnemonic_lookup(tokens.data[0].text) : mnemonic_count;
+    if (statement->mnemonic == mnemonic_count) {
+        return fail(&compiler->result, "Statement not supported in a FOR loop", statement->line);
+    }
+    if (!mnemonic_is_supported(opcodes, statement->mnemonic)) {
+        return fail(&compiler->result, "Instruction not supported by this CPU", statement->line);
+    }
+
+    operand_t operand;
+    if (!operand_parse((slice_const_token_t){tokens.data + 1, tokens.size - 1}, &operand)) {
+        return fail(&compiler->result, "Invalid operand", statement->line);
+    }
+    statement->mode = operand.mode;
+    statement->first_expr = compiler->loop->exprs.size;
+    if (operand.mode != addr_mode_implied && operand.mode != addr_mode_accumulator) {
+        if (add_expr(compiler, operand.expression, statement->line) == invalid_index) {
+            return false;
+        }
+        statement->num_exprs = 1;
+    }
+    return true;
+}
+
+
+static bool compile_node(compiler_t *compiler, uint32_t depth, uint32_t *node_index);
+
+// Compiles statements up to and including the NEXT which closes the loop at the given depth
+static bool compile_body(compiler_t *compiler, uint32_t depth, strview_t name, array_loop_statement_t *body, loop_node_t *node) {
+    for (;;) {
+        if (compiler->pos >= compiler->tokens.size || compiler->tokens.data[compiler->pos].type == token_end_of_file) {
+            return fail(&compiler->result, "FOR without NEXT", node->line);
+        }
+
+        const token_t *first = &compiler->tokens.data[compiler->pos];
+        loop_statement_t statement = {.line = first->line};
+
+        if (token_is_keyword(first, STRVIEW("FOR"))) {
+            statement.type = loop_statement_for;
+            node->is_replicable = false;
+            if (!compile_node(compiler, depth + 1, &statement.node)) {
+                return false;
+            }
+        }
+        else {
+            slice_const_token_t tokens = next_statement(compiler);
+            if (tokens.size == 0) {
+                continue;
+            }
+
+            if (token_is_keyword(first, STRVIEW("NEXT"))) {
+                if (tokens.size > 2 || (tokens.size == 2 && !strview_equal(tokens.data[1].text, name))) {
+                    return fail(&compiler->result, "NEXT does not match FOR", statement.line);
+                }
+                compiler->loop->length = (uint32_t)(tokens.data + tokens.size - compiler->tokens.data);
+                return true;
+            }
+
+            slice_const_token_t rest = {tokens.data + 1, tokens.size - 1};
+            if (token_is_keyword(first, STRVIEW("EQUB")) ||
+                token_is_keyword(first, STRVIEW("EQUW")) ||
+                token_is_keyword(first, STRVIEW("EQUD"))) {
+                static const uint32_t widths[] = {1, 2, 4};
+                uint8_t suffix = first->text.data[3] & ~0x20;
+                statement.type = (suffix == 'B') ? loop_statement_equb : (suffix == 'W') ? loop_statement_equw : loop_statement_equd;
+                if (!compile_list(compiler, rest, &statement)) {
+                    return false;
+                }
+                node->max_size += statement.num_exprs * widths[statement.type - loop_statement_equb];
+            }
+            else {
+                statement.type = loop_statement_instruction;
+                if (!compile_instruction(compiler, tokens, &statement)) {
+                    return false;
+                }
+                // A branch's operand depends on the address it's assembled at, so it's never invariant
+                if ((*compiler->loop->opcodes)[statement.mnemonic][addr_mode_relative]) {
+                    node->is_replicable = false;
+                }
+                node->max_size += 3;
+            }
+        }
+
+        if (!array_add(body, statement)) {
+            return fail(&compiler->result, "Out of memory", statement.line);
+        }
+    }
+}
+
+
+static bool compile_node(compiler_t *compiler, uint32_t depth, uint32_t *node_index) {
+    slice_const_token_t header = next_statement(compiler);
+    loop_node_t node = {
+        .depth = depth,
+        .line = header.data[0].line,
+        .step_expr = invalid_index,
+        .is_replicable = true
+    };
+
+    if (depth >= LOOP_MAX_DEPTH) {
+        return fail(&compiler->result, "FOR loops nested too deeply", node.line);
+    }
+
+    // FOR var, start, end [, step]
+    slice_const_token_t params = {header.data + 1, header.size - 1};
+    uint32_t pos = 0;
+    slice_const_token_t var = next_list_item(params, &pos);
+    if (var.size != 1 || var.data[0].type != token_identifier || pos > params.size) {
+        return fail(&compiler->result, "Expected FOR variable, start, end [, step]", node.line);
+    }
+
+    // The range is evaluated outside the loop, so can't refer to its own variable
+    ASSERT(compiler->num_names == depth);
+    node.start_expr = add_expr(compiler, next_list_item(params, &pos), node.line);
+    if (node.start_expr == invalid_index) {
+        return false;
+    }
+    if (pos > params.size) {
+        return fail(&compiler->result, "Expected FOR variable, start, end [, step]", node.line);
+    }
+    node.end_expr = add_expr(compiler, next_list_item(params, &pos), node.line);
+    if (node.end_expr == invalid_index) {
+        return false;
+    }
+    if (pos <= params.size) {
+        node.step_expr = add_expr(compiler, next_list_item(params, &pos), node.line);
+        if (node.step_expr == invalid_index) {
+            return false;
+        }
+        if (pos <= params.size) {
+            return fail(&compiler->result, "Expected FOR variable, start, end [, step]", node.line);
+        }
+    }
+
+    // Claim the node's index before compiling the body, so that the outermost loop is node 0
+    loop_t *loop = compiler->loop;
+    *node_index = loop->nodes.size;
+    if (!array_add(&loop->nodes, node)) {
+        return fail(&compiler->result, "Out of memory", node.line);
+    }
+    loop->num_slots = math_max_uint32(loop->num_slots, loop->first_slot + depth + 1);
+
+    array_loop_statement_t body = make_array(loop_statement_t, compiler->allocator, 8);
+    if (!array_is_valid(&body)) {
+        return fail(&compiler->result, "Out of memory", node.line);
+    }
+
+    compiler->names[depth] = var.data[0].text;
+    compiler->num_names = depth + 1;
+    bool success = compile_body(compiler, depth, var.data[0].text, &body, &node);
+    compiler->num_names = depth;
+
+    // Nested loops have already added their statements, so this node's statements are kept contiguous by adding
+    // them all at once, now that the body is complete
+    node.first_statement = loop->statements.size;
+    node.num_statements = body.size;
+    if (success && !array_append(&loop->statements, body)) {
+        success = fail(&compiler->result, "Out of memory", node.line);
+    }
+    loop->nodes.data[*node_index] = node;
+    array_deinit(&body);
+    return success;
+}
+
+
+loop_result_t loop_compile(loop_t *loop, const allocator_t *allocator, slice_const_token_t tokens, const opcode_table_t *opcodes,
+                           expr_resolve_fn_t resolve, void *context, uint32_t first_slot) {
+    ASSERT(loop);
+    ASSERT(opcodes);
+    *loop = (loop_t){
+        .opcodes = opcodes,
+        .first_slot = first_slot,
+        .num_slots = first_slot,
+        .nodes = make_array(loop_node_t, allocator, 4),
+        .statements = make_array(loop_statement_t, allocator, 16),
+        .exprs = make_array(expr_t, allocator, 16),
+        .specialized = make_array(expr_t, allocator, 16)
+    };
+
+    compiler_t compiler = {
+        .loop = loop,
+        .allocator = allocator,
+        .tokens = tokens,
+        .resolve = resolve,
+        .context = context
+    };
+
+    if (!array_is_valid(&loop->nodes) || !array_is_valid(&loop->statements) ||
+        !array_is_valid(&loop->exprs) || !array_is_valid(&loop->specialized)) {
+        fail(&compiler.result, "Out of memory", tokens.size ? tokens.data[0].line : 0);
+        return compiler.result;
+    }
+
+    ASSERT(tokens.size > 0 && token_is_keyword(&tokens.data[0], STRVIEW("FOR")));
+    uint32_t node_index;
+    compile_node(&compiler, 0, &node_index);
+    return compiler.result;
+}
+
+
+void loop_deinit(loop_t *loop) {
+    ASSERT(loop);
+    for (uint32_t i = 0; i < loop->exprs.size; i++) {
+        expr_deinit(&loop->exprs.data[i]);
+    }
+    for (uint32_t i = 0; i < loop->specialized.size; i++) {
+        expr_deinit(&loop->specialized.data[i]);
+    }
+    array_deinit(&loop->nodes);
+    array_deinit(&loop->statements);
+    array_deinit(&loop->exprs);
+    array_deinit(&loop->specialized);
+}
+
+
+// Makes room for at least size more bytes of object code, growing geometrically
+static bool reserve_object_code(runner_t *runner, uint64_t size, uint32_t line) {
+    array_uint8_t *object_code = runner->object_code;
+    uint64_t required = object_code->size + size;
+    uint32_t capacity = array_capacity(object_code);
+    if (required <= capacity) {
+        return true;
+    }
+    if (required > UINT32_MAX || !array_reserve(object_code, (uint32_t)math_max_uint64(required, (uint64_t)capacity * 2))) {
+        return fail(&runner->result, "Out of memory", line);
+    }
+    return true;
+}
+
+
+static bool evaluate(runner_t *runner, uint32_t expr_index, uint32_t line, double *value) {
+    const expr_t *expr = &runner->loop->specialized.data[expr_index];
+    if (expr_is_constant(expr, value)) {
+        return true;
+    }
+    runner->num_evaluations++;
+    const char *error = expr_evaluate(expr, runner->values, value);
+    return !error || fail(&runner->result, error, line);
+}
+
+
+static bool run_node(runner_t *runner, uint32_t node_index);
+
+
+static bool charge_budget(runner_t *runner, uint64_t num_statements, uint32_t line) {
+    return !runner->budget || budget_step(runner->budget, num_statements) ||
+           fail(&runner->result, budget_error(runner->budget), line);
+}
+
+static bool run_statement(runner_t *runner, const loop_statement_t *statement) {
+    // This is normally already reserved for the whole loop, unless a nested loop has used it
+    uint32_t max_size = (statement->type == loop_statement_instruction) ? 3 : statement->num_exprs * 4;
+    if (statement->type != loop_statement_for && !reserve_object_code(runner, max_size, statement->line)) {
+        return false;
+    }
+    array_uint8_t *object_code = runner->object_code;
+
+    switch (statement->type) {
+        case loop_statement_equb:
+        case loop_statement_equw:
+        case loop_statement_equd: {
+            static const double min_values[] = {-128, -32768, -2147483648.0};
+            static const double max_values[] = {255, 65535, 4294967295.0};
+            static const char *const errors[] = {"Byte out of range", "Word out of range", "Value out of range"};
+            uint32_t index = statement->type - loop_statement_equb;
+            uint32_t width = 1U << index;
+
+            for (uint32_t i = 0; i < statement->num_exprs; i++) {
+                double value;
+                if (!evaluate(runner, statement->first_expr + i, statement->line, &value)) {
+                    return false;
+                }
+                if (!(value >= min_values[index] && value <= max_values[index])) {
+                    return fail(&runner->result, errors[index], statement->line);
+                }
+                uint32_t bits = (uint32_t)(int64_t)value;
+                uint8_t *bytes = object_code->data + object_code->size;
+                for (uint32_t j = 0; j < width; j++) {
+                    bytes[j] = (uint8_t)(bits >> (j * 8));
+                }
+                object_code->size += width;
+                runner->pc += width;
+            }
+            return true;
+        }
+
+        case loop_statement_instruction: {
+            double value = 0;
+            if (statement->num_exprs && !evaluate(runner, statement->first_expr, statement->line, &value)) {
+                return false;
+            }
+            if (!(value >= -2147483648.0 && value < 2147483648.0)) {
+                return fail(&runner->result, "Operand out of range", statement->line);
+            }
+
+            int32_t operand = (int32_t)value;
+            addr_mode_t mode = opcode_select_mode(runner->loop->opcodes, statement->mnemonic, statement->mode, operand >= 0 && operand <= 255);
+            if (mode == addr_mode_count) {
+                return fail(&runner->result, "Invalid addressing mode", statement->line);
+            }
+            if (mode == addr_mode_relative) {
+                operand -= (int32_t)(runner->pc + 2);
+            }
+
+            uint32_t size = instruction_encode(runner->loop->opcodes, statement->mnemonic, mode, operand, object_code->data + object_code->size);
+            if (size == 0) {
+                return fail(&runner->result, (mode == addr_mode_relative) ? "Branch out of range" : "Operand out of range", statement->line);
+            }
+            object_code->size += size;
+            runner->pc += size;
+            return true;
+        }
+
+        case loop_statement_for:
+            return run_node(runner, statement->node);
+
+        default:
+            UNREACHABLE();
+    }
+}
+
+
+// Repeats the bytes assembled since mark until they have been assembled count times in total
+static bool replicate(runner_t *runner, uint32_t mark, uint64_t count, uint32_t line) {
+    uint64_t size = runner->object_code->size - mark;
+    uint64_t total = size * count;
+    if (!reserve_object_code(runner, total - size, line)) {
+        return false;
+    }
+
+    // Double the copied region each time, so that there are only log2(count) copies
+    uint8_t *base = runner->object_code->data + mark;
+    for (uint64_t filled = size; filled < total; ) {
+        uint64_t copy_size = math_min_uint64(filled, total - filled);
+        memcpy(base + filled, base, copy_size);
+        filled += copy_size;
+    }
+    runner->object_code->size = mark + (uint32_t)total;
+    runner->pc += (uint32_t)(total - size);
+    return true;
+}
+
+
+static bool run_node(runner_t *runner, uint32_t node_index) {
+    loop_t *loop = runner->loop;
+    const loop_node_t *node = &loop->nodes.data[node_index];
+    double start, end, step = 1;
+    const char *error = expr_evaluate(&loop->exprs.data[node->start_expr], runner->values, &start);
+    error = error ? error : expr_evaluate(&loop->exprs.data[node->end_expr], runner->values, &end);
+    if (!error && node->step_expr != invalid_index) {
+        error = expr_evaluate(&loop->exprs.data[node->step_expr], runner->values, &step);
+    }
+    runner->num_evaluations += (node->step_expr != invalid_index) ? 3 : 2;
+    if (error) {
+        return fail(&runner->result, error, node->line);
+    }
+    if (step == 0) {
+        return fail(&runner->result, "FOR step is zero", node->line);
+    }
+    if (runner->profile) {
+        profile_count(runner->profile, node->line, 1, (node->step_expr != invalid_index) ? 3 : 2);
+    }
+
+    // As in BBC BASIC, the body always runs at least once, and the variable is compared with the end after stepping
+    uint64_t count = 0;
+    for (double v = start; ; v += step) {
+        if (++count > MAX_ITERATIONS) {
+            return fail(&runner->result, "FOR loop has too many iterations", node->line);
+        }
+        if (step > 0 ? v + step > end : v + step < end) {
+            break;
+        }
+    }
+
+    // Hoist everything which doesn't depend on this loop's variable out of the loop
+    uint32_t slot = loop->first_slot + node->depth;
+    bool is_invariant = node->is_replicable;
+    for (uint32_t i = 0; i < node->num_statements; i++) {
+        const loop_statement_t *statement = &loop->statements.data[node->first_statement + i];
+        for (uint32_t j = 0; j < statement->num_exprs; j++) {
+            uint32_t index = statement->first_expr + j;
+            double value;
+            if (!expr_specialize(&loop->exprs.data[index], runner->values, slot, &loop->specialized.data[index])) {
+                return fail(&runner->result, "Out of memory", statement->line);
+            }
+            is_invariant = is_invariant && expr_is_constant(&loop->specialized.data[index], &value);
+        }
+    }
+
+    // Reserve the whole loop at once, unless the size is unknown because of nested loops
+    if (node->is_replicable && !reserve_object_code(runner, count * node->max_size, node->line)) {
+        return false;
+    }
+
+    uint32_t mark = runner->object_code->size;
+    double v = start;
+    for (uint64_t i = 0; i < count; i++, v += step) {
+        runner->values[slot] = v;
+        if (is_invariant && i == 1) {
+            // Replicated iterations are charged, and profiled, as though they were executed
+            for (uint32_t j = 0; runner->profile && j < node->num_statements; j++) {
+                profile_count(runner->profile, loop->statements.data[node->first_statement + j].line, count - 1, 0);
+            }
+            return charge_budget(runner, (count - 1) * node->num_statements, node->line) &&
+                   replicate(runner, mark, count, node->line);
+        }
+        if (!charge_budget(runner, node->num_statements, node->line)) {
+            return false;
+        }
+        for (uint32_t j = 0; j < node->num_statements; j++) {
+            const loop_statement_t *statement = &loop->statements.data[node->first_statement + j];
+            uint64_t num_evaluations = runner->num_evaluations;
+            if (!run_statement(runner, statement)) {
+                return false;
+            }
+            // A nested loop profiles its own lines
+            if (runner->profile && statement->type != loop_statement_for) {
+                profile_count(runner->profile, statement->line, 1, runner->num_evaluations - num_evaluations);
+            }
+        }
+    }
+    return true;
+}
+
+
+loop_result_t loop_run(loop_t *loop, double *values, array_uint8_t *object_code, uint32_t *pc, budget_t *budget,
+                       profile_t *profile) {
+    ASSERT(loop);
+    ASSERT(values);
+    ASSERT(object_code);
+    ASSERT(pc);
+    ASSERT(loop->nodes.size > 0);
+
+    runner_t runner = {
+        .loop = loop,
+        .values = values,
+        .object_code = object_code,
+        .pc = *pc,
+        .budget = budget,
+        .profile = profile
+    };
+    run_node(&runner, 0);
+    *pc = runner.pc;
+    runner.result.num_evaluations = runner.num_evaluations;
+    return runner.result;
+}
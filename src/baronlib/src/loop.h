@@ -0,0 +1,134 @@
+/**
+ *  @file   loop.h
+ *
+ *  Compiled FOR..NEXT loops.
+ *
+ *  A loop is compiled once from its tokens into statements holding compiled expressions, and then run without
+ *  re-parsing anything. Each time a loop starts, every expression in its body is specialized against the current
+ *  values of the symbols it uses, so that any part which doesn't depend on the loop variable is evaluated once per
+ *  loop rather than once per iteration. If nothing in the body depends on the loop variable at all, the body is
+ *  assembled once and its bytes replicated.
+ *
+ *  Object code is written directly into the overlay's buffer, which is reserved up front for the whole loop.
+ */
+
+#ifndef BARONLIB_LOOP_H_
+#define BARONLIB_LOOP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "base/array.h"
+#include "addrmode.h"
+#include "budget.h"
+#include "expr.h"
+#include "lexer.h"
+#include "opcodes.h"
+#include "profile.h"
+
+typedef struct loop_t loop_t;
+typedef struct loop_node_t loop_node_t;
+typedef struct loop_statement_t loop_statement_t;
+typedef struct loop_result_t loop_result_t;
+
+
+// Maximum nesting depth of loops
+#define LOOP_MAX_DEPTH 16
+
+
+typedef enum loop_statement_type_t {
+    loop_statement_equb,
+    loop_statement_equw,
+    loop_statement_equd,
+    loop_statement_instruction,
+    loop_statement_for
+} loop_statement_type_t;
+
+
+struct loop_statement_t {
+    loop_statement_type_t type;
+    uint32_t line;
+    uint32_t first_expr;        // Index into the loop's expressions
+    uint32_t num_exprs;
+    mnemonic_t mnemonic;        // Instruction only
+    addr_mode_t mode;           // Instruction only: mode given by operand_parse
+    uint32_t node;              // FOR only: index of the nested loop
+};
+
+def_slice(loop_statement_t);
+
+
+struct loop_node_t {
+    uint32_t depth;             // Nesting depth; the loop variable is in slot first_slot + depth
+    uint32_t line;
+    uint32_t start_expr;
+    uint32_t end_expr;
+    uint32_t step_expr;         // invalid_index for a step of 1
+    uint32_t first_statement;
+    uint32_t num_statements;
+    uint32_t max_size;          // Maximum bytes assembled by an iteration, not counting nested loops
+    bool is_replicable;         // Whether the body can be replicated when invariant, i.e. no nested loops or branches
+};
+
+def_slice(loop_node_t);
+
+
+struct loop_t {
+    const opcode_table_t *opcodes;
+    uint32_t first_slot;
+    uint32_t num_slots;         // Number of values needed to run the loop, including those of the loop variables
+    uint32_t length;            // Number of tokens from FOR to NEXT inclusive, excluding NEXT's terminator
+    array_loop_node_t nodes;    // The outermost loop is node 0
+    array_loop_statement_t statements;
+    array_expr_t exprs;
+    array_expr_t specialized;   // Working copies of exprs, specialized each time their loop starts
+};
+
+
+struct loop_result_t {
+    const char *error;          // Null on success, otherwise a description of the error
+    uint32_t line;              // Line on which the error occurred
+    uint64_t num_evaluations;   // loop_run only: number of expressions evaluated, not counting those hoisted as constant
+};
+
+
+/**
+ *  Compile a FOR..NEXT loop.
+ *  The loop body may contain EQUB, EQUW and EQUD statements, instructions, and nested loops.
+ *
+ *  @param  loop            Pointer to the loop to initialize
+ *  @param  allocator       Allocator used to hold the compiled loop
+ *  @param  tokens          Tokens starting with the FOR keyword, and extending at least as far as the matching NEXT
+ *  @param  opcodes         Opcode table of the instruction set
+ *  @param  resolve         Function used to resolve symbols other than loop variables into slots
+ *  @param  context         Context passed to resolve
+ *  @param  first_slot      Slot of the outermost loop variable; nested loop variables take the slots which follow it
+ *
+ *  @return loop_result_t whose error field is null on success. The loop must be deinitialized either way.
+ */
+loop_result_t loop_compile(loop_t *loop, const allocator_t *allocator, slice_const_token_t tokens, const opcode_table_t *opcodes,
+                           expr_resolve_fn_t resolve, void *context, uint32_t first_slot);
+
+
+/**
+ *  Deinitialize a loop, freeing its allocations
+ */
+void loop_deinit(loop_t *loop);
+
+
+/**
+ *  Run a compiled loop, assembling its object code
+ *
+ *  @param  loop            Pointer to the compiled loop
+ *  @param  values          Values of the slots, with space for loop->num_slots
+ *  @param  object_code     Overlay buffer to which object code is appended
+ *  @param  pc              Pointer to the program counter, which is advanced by the size of the object code
+ *  @param  budget          Budget charged for every statement executed, or null for none
+ *  @param  profile         Profile counting the work done by each line of the loop, or null for none
+ *
+ *  @return loop_result_t whose error field is null on success
+ */
+loop_result_t loop_run(loop_t *loop, double *values, array_uint8_t *object_code, uint32_t *pc, budget_t *budget,
+                       profile_t *profile);
+
+
+#endif // ifndef BARONLIB_LOOP_H_
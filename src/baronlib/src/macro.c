@@ -0,0 +1,229 @@
+#include <string.h>
+#include "base/defines.h"
+#include "macro.h"
+
+
+static uint32_t find_param(slice_const_strview_t params, strview_t name) {
+    for (uint32_t i = 0; i < params.size; i++) {
+        if (strview_equal(params.data[i], name)) {
+            return i;
+        }
+    }
+    return invalid_index;
+}
+
+
+bool macro_init(macro_t *macro, const allocator_t *allocator, strview_t name, slice_const_strview_t params, slice_const_token_t body) {
+    ASSERT(macro);
+    *macro = (macro_t){
+        .name = name,
+        .num_params = params.size,
+        .body = make_array(token_t, allocator, body.size + 1),
+        .statements = make_array(macro_statement_t, allocator, 8)
+    };
+
+    if (!array_is_valid(&macro->body) || !array_is_valid(&macro->statements)) {
+        macro_deinit(macro);
+        return false;
+    }
+
+    bool success = true;
+    uint32_t statement_start = 0;
+    for (uint32_t i = 0; success && i <= body.size; i++) {
+        token_t token = (i < body.size) ? body.data[i] : (token_t){.type = token_end_of_file};
+        if (token.type == token_identifier) {
+            uint32_t slot = find_param(params, token.text);
+            if (slot != invalid_index) {
+                token.type = token_param;
+                token.slot = slot;
+            }
+        }
+        else if (token.type == token_end_of_statement || token.type == token_end_of_file) {
+            if (macro->body.size > statement_start) {
+                macro_statement_t statement = {statement_start, macro->body.size - statement_start};
+                success = array_add(&macro->statements, statement);
+            }
+            statement_start = macro->body.size + 1;
+            if (token.type == token_end_of_file) {
+                break;
+            }
+        }
+        success = success && array_add(&macro->body, token);
+    }
+
+    token_t end = {
+        .type = token_end_of_file,
+        .line = macro->body.size ? macro->body.data[macro->body.size - 1].line : 0
+    };
+    if (!success || !array_add(&macro->body, end)) {
+        macro_deinit(macro);
+        return false;
+    }
+
+    return true;
+}
+
+
+void macro_deinit(macro_t *macro) {
+    ASSERT(macro);
+    array_deinit(&macro->body);
+    array_deinit(&macro->statements);
+}
+
+
+bool macro_bind(const macro_t *macro, slice_const_token_t call_args, slice_const_token_t *args) {
+    ASSERT(macro);
+    if (call_args.size == 0) {
+        return macro->num_params == 0;
+    }
+
+    uint32_t num_args = 0;
+    uint32_t start = 0;
+    int depth = 0;
+    for (uint32_t i = 0; i <= call_args.size; i++) {
+        const token_t *token = &call_args.data[i];
+        if (i == call_args.size || (depth == 0 && token_is_symbol(token, STRVIEW(",")))) {
+            if (num_args == macro->num_params) {
+                return false;
+            }
+            args[num_args++] = (slice_const_token_t){call_args.data + start, i - start};
+            start = i + 1;
+        }
+        else if (token_is_symbol(token, STRVIEW("(")) || token_is_symbol(token, STRVIEW("["))) {
+            depth++;
+        }
+        else if (token_is_symbol(token, STRVIEW(")")) || token_is_symbol(token, STRVIEW("]"))) {
+            depth--;
+        }
+    }
+
+    return num_args == macro->num_params;
+}
+
+
+slice_const_token_t macro_statement(const macro_t *macro, uint32_t statement_index) {
+    ASSERT(macro);
+    ASSERT(statement_index < macro->statements.size);
+    macro_statement_t statement = macro->statements.data[statement_index];
+    return (slice_const_token_t){macro->body.data + statement.start, statement.length};
+}
+
+
+bool macro_table_init(macro_table_t *table, const allocator_t *allocator) {
+    ASSERT(table);
+    *table = (macro_table_t){
+        .allocator = allocator,
+        .macros = make_array(macro_t, allocator, 16),
+        .entries = make_array(macro_table_entry_t, allocator, 32)
+    };
+
+    if (!array_is_valid(&table->macros) || !array_resize(&table->entries, 32)) {
+        macro_table_deinit(table);
+        return false;
+    }
+    memset(table->entries.data, 0, table->entries.size * sizeof(macro_table_entry_t));
+    return true;
+}
+
+
+void macro_table_deinit(macro_table_t *table) {
+    ASSERT(table);
+    for (uint32_t i = 0; i < table->macros.size; i++) {
+        macro_deinit(&table->macros.data[i]);
+    }
+    array_deinit(&table->macros);
+    array_deinit(&table->entries);
+}
+
+
+// Empty slots are recognised by a null name
+static macro_table_entry_t *find_slot(macro_table_entry_t *entries, uint32_t num_slots, strview_t name, uint32_t hash) {
+    uint32_t mask = num_slots - 1;
+    for (uint32_t i = hash & mask; ; i = (i + 1) & mask) {
+        macro_table_entry_t *entry = &entries[i];
+        if (!entry->name.data || (entry->hash == hash && strview_equal(entry->name, name))) {
+            return entry;
+        }
+    }
+}
+
+
+static bool grow_entries(macro_table_t *table) {
+    uint32_t num_slots = table->entries.size * 2;
+    array_macro_table_entry_t entries = make_array(macro_table_entry_t, table->allocator, num_slots);
+    if (!array_resize(&entries, num_slots)) {
+        array_deinit(&entries);
+        return false;
+    }
+    memset(entries.data, 0, num_slots * sizeof(macro_table_entry_t));
+
+    for (uint32_t i = 0; i < table->entries.size; i++) {
+        const macro_table_entry_t *entry = &table->entries.data[i];
+        if (entry->name.data) {
+            *find_slot(entries.data, num_slots, entry->name, entry->hash) = *entry;
+        }
+    }
+
+    array_deinit(&table->entries);
+    table->entries = entries;
+    return true;
+}
+
+
+bool macro_table_add(macro_table_t *table, macro_t *macro, addr_mode_t mode) {
+    ASSERT(table);
+    ASSERT(macro);
+    ASSERT(mode <= MACRO_ANY_MODE);
+
+    // Keep the load factor at most 1/2 so that probe sequences stay short
+    if ((table->num_entries + 1) * 2 > table->entries.size && !grow_entries(table)) {
+        macro_deinit(macro);
+        return false;
+    }
+
+    uint32_t hash = strview_hash(macro->name);
+    macro_table_entry_t *entry = find_slot(table->entries.data, table->entries.size, macro->name, hash);
+    bool is_new_entry = !entry->name.data;
+    uint32_t mode_bit = (mode == MACRO_ANY_MODE) ? (1U << addr_mode_count) : (1U << mode);
+
+    if ((entry->explicit_modes & mode_bit) || !array_add(&table->macros, *macro)) {
+        macro_deinit(macro);
+        return false;
+    }
+
+    if (is_new_entry) {
+        entry->name = macro->name;
+        entry->hash = hash;
+        for (int i = 0; i < addr_mode_count; i++) {
+            entry->overloads[i] = invalid_index;
+        }
+        table->num_entries++;
+    }
+
+    uint32_t macro_index = table->macros.size - 1;
+    if (mode == MACRO_ANY_MODE) {
+        // Any mode without an overload falls back to this one
+        for (int i = 0; i < addr_mode_count; i++) {
+            if (entry->overloads[i] == invalid_index) {
+                entry->overloads[i] = macro_index;
+            }
+        }
+    }
+    else {
+        // A zero page operand uses an absolute overload in preference to a catch-all one, unless it has its own
+        addr_mode_t zero_page_mode = addr_mode_zero_page_form(mode);
+        entry->overloads[mode] = macro_index;
+        if (!(entry->explicit_modes & (1U << zero_page_mode))) {
+            entry->overloads[zero_page_mode] = macro_index;
+        }
+    }
+    entry->explicit_modes |= mode_bit;
+    return true;
+}
+
+
+const macro_table_entry_t *macro_table_find(const macro_table_t *table, strview_t name) {
+    ASSERT(table);
+    const macro_table_entry_t *entry = find_slot(table->entries.data, table->entries.size, name, strview_hash(name));
+    return entry->name.data ? entry : 0;
+}
@@ -0,0 +1,175 @@
+/**
+ *  @file   macro.h
+ *
+ *  Macro definitions.
+ *
+ *  A macro body is tokenized once, when the macro is defined, and split into statements. Any identifier which names
+ *  one of the macro's parameters is resolved there and then into a token_param holding the parameter's slot index.
+ *  Invoking a macro then only needs to bind the call's arguments to an array indexed by slot; the body is never
+ *  re-parsed, and parameter references never need looking up by name.
+ *
+ *  Macros may be overloaded by the addressing mode of their operand. Each macro name has a single entry in a hash
+ *  table, holding a table of overloads indexed by addressing mode, so a call resolves with one hash lookup and one
+ *  array index. Fallbacks (e.g. a zero page operand using the absolute overload) are filled into the overload table
+ *  as definitions are added, rather than searched for at each call.
+ */
+
+#ifndef BARONLIB_MACRO_H_
+#define BARONLIB_MACRO_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "base/array.h"
+#include "base/str.h"
+#include "addrmode.h"
+#include "lexer.h"
+
+typedef struct macro_t macro_t;
+typedef struct macro_statement_t macro_statement_t;
+typedef struct macro_table_t macro_table_t;
+typedef struct macro_table_entry_t macro_table_entry_t;
+typedef struct allocator_t allocator_t;
+
+def_slice(strview_t);
+
+
+struct macro_statement_t {
+    uint32_t start;                 // Index into the body of the statement's first token
+    uint32_t length;                // Number of tokens, excluding the terminator
+};
+
+def_slice(macro_statement_t);
+
+
+struct macro_t {
+    strview_t name;
+    uint32_t num_params;
+    array_token_t body;             // Tokens of the body, ending with token_end_of_file
+    array_macro_statement_t statements;
+};
+
+def_slice(macro_t);
+
+
+// Mode used to add a macro which is not overloaded by addressing mode, and so accepts any operand
+#define MACRO_ANY_MODE addr_mode_count
+
+
+struct macro_table_entry_t {
+    strview_t name;
+    uint32_t hash;
+    uint32_t explicit_modes;                    // Bit mask of the modes with their own overload; bit addr_mode_count for MACRO_ANY_MODE
+    uint32_t overloads[addr_mode_count];        // Index into macros of the overload for each mode, or invalid_index
+};
+
+def_slice(macro_table_entry_t);
+
+
+struct macro_table_t {
+    const allocator_t *allocator;
+    array_macro_t macros;
+    array_macro_table_entry_t entries;          // Open addressed hash table; a power of two in size
+    uint32_t num_entries;
+};
+
+
+/**
+ *  Initialize a macro from its definition
+ *
+ *  @param  macro           Pointer to the macro to initialize
+ *  @param  allocator       Allocator used to hold the compiled body
+ *  @param  name            Name of the macro
+ *  @param  params          Names of the macro's parameters, in order
+ *  @param  body            Tokens of the macro body. Token text must outlive the macro.
+ *
+ *  @return Success true/false
+ */
+bool macro_init(macro_t *macro, const allocator_t *allocator, strview_t name, slice_const_strview_t params, slice_const_token_t body);
+
+
+/**
+ *  Deinitialize a macro, freeing all its allocations
+ *
+ *  @param  macro           Pointer to the macro to deinitialize
+ */
+void macro_deinit(macro_t *macro);
+
+
+/**
+ *  Bind the arguments of a macro call to the macro's parameter slots.
+ *  Arguments are separated by commas which are not nested within brackets.
+ *
+ *  @param  macro           Pointer to the macro being invoked
+ *  @param  call_args       Tokens of the argument list, not including the statement terminator
+ *  @param  args            Array with space for macro->num_params slices, which receive each argument's tokens
+ *
+ *  @return true if the number of arguments matched the number of parameters
+ */
+bool macro_bind(const macro_t *macro, slice_const_token_t call_args, slice_const_token_t *args);
+
+
+/**
+ *  Get the tokens of the given statement of a macro body, excluding its terminator
+ */
+slice_const_token_t macro_statement(const macro_t *macro, uint32_t statement_index);
+
+
+/**
+ *  Initialize an empty macro table
+ *
+ *  @param  table           Pointer to the table to initialize
+ *  @param  allocator       Allocator used to hold the table
+ *
+ *  @return Success true/false
+ */
+bool macro_table_init(macro_table_t *table, const allocator_t *allocator);
+
+
+/**
+ *  Deinitialize a macro table, including all the macros it holds
+ *
+ *  @param  table           Pointer to the table to deinitialize
+ */
+void macro_table_deinit(macro_table_t *table);
+
+
+/**
+ *  Add a macro to the table, which takes ownership of it
+ *
+ *  @param  table           Pointer to the table
+ *  @param  macro           Pointer to the macro to add. It is moved into the table, and on failure is deinitialized.
+ *  @param  mode            Addressing mode of the operand this overload accepts, or MACRO_ANY_MODE
+ *
+ *  @return false if the overload is already defined, or allocation failed
+ */
+bool macro_table_add(macro_table_t *table, macro_t *macro, addr_mode_t mode);
+
+
+/**
+ *  Find the entry for the named macro
+ *
+ *  @param  table           Pointer to the table
+ *  @param  name            Name of the macro
+ *
+ *  @return Pointer to the entry, or null if there is no macro with that name.
+ *          An entry with no explicit modes accepts any operand, so its operand need not be classified.
+ */
+const macro_table_entry_t *macro_table_find(const macro_table_t *table, strview_t name);
+
+
+/**
+ *  Get the overload of a macro for the given addressing mode
+ *
+ *  @param  table           Pointer to the table
+ *  @param  entry           Entry returned by macro_table_find
+ *  @param  mode            Addressing mode of the call's operand
+ *
+ *  @return Pointer to the macro, or null if no overload accepts that mode
+ */
+static inline const macro_t *macro_table_resolve(const macro_table_t *table, const macro_table_entry_t *entry, addr_mode_t mode) {
+    uint32_t index = entry->overloads[mode];
+    return (index != invalid_index) ? &table->macros.data[index] : 0;
+}
+
+
+#endif // ifndef BARONLIB_MACRO_H_
@@ -0,0 +1,134 @@
+#include <stdlib.h>
+#include "base/defines.h"
+#include "memmap.h"
+
+
+bool memmap_init(memmap_t *memmap, const allocator_t *allocator) {
+    ASSERT(memmap);
+    *memmap = (memmap_t){
+        .allocator = allocator,
+        .regions = make_array(memmap_region_t, allocator, 16),
+        .is_sorted = true
+    };
+    return array_is_valid(&memmap->regions);
+}
+
+
+void memmap_deinit(memmap_t *memmap) {
+    ASSERT(memmap);
+    array_deinit(&memmap->regions);
+}
+
+
+void memmap_reset(memmap_t *memmap) {
+    ASSERT(memmap);
+    array_reset(&memmap->regions);
+    memmap->is_sorted = true;
+}
+
+
+bool memmap_add_region(memmap_t *memmap, uint32_t overlay_index, uint32_t start, uint32_t end) {
+    ASSERT(memmap);
+    if (start >= end) {
+        return true;
+    }
+    memmap->is_sorted = false;
+    return array_add(&memmap->regions, ((memmap_region_t){start, end, overlay_index}));
+}
+
+
+static int compare_regions(const void *a, const void *b) {
+    const memmap_region_t *region_a = a;
+    const memmap_region_t *region_b = b;
+    if (region_a->start != region_b->start) {
+        return (region_a->start > region_b->start) - (region_a->start < region_b->start);
+    }
+    if (region_a->end != region_b->end) {
+        return (region_a->end > region_b->end) - (region_a->end < region_b->end);
+    }
+    return (region_a->overlay_index > region_b->overlay_index) - (region_a->overlay_index < region_b->overlay_index);
+}
+
+
+static int compare_overlay_regions(const void *a, const void *b) {
+    const memmap_region_t *region_a = a;
+    const memmap_region_t *region_b = b;
+    if (region_a->overlay_index != region_b->overlay_index) {
+        return (region_a->overlay_index > region_b->overlay_index) - (region_a->overlay_index < region_b->overlay_index);
+    }
+    return (region_a->start > region_b->start) - (region_a->start < region_b->start);
+}
+
+
+/**
+ *  Merge the regions of each overlay which intersect or touch, so that no two regions of the same overlay are open at
+ *  any address
+ */
+static void merge_overlay_regions(memmap_t *memmap) {
+    qsort(memmap->regions.data, memmap->regions.size, sizeof(memmap_region_t), compare_overlay_regions);
+    uint32_t num_merged = 0;
+    for (uint32_t i = 0; i < memmap->regions.size; i++) {
+        const memmap_region_t *region = &memmap->regions.data[i];
+        memmap_region_t *last = num_merged ? &memmap->regions.data[num_merged - 1] : 0;
+        if (last && last->overlay_index == region->overlay_index && region->start <= last->end) {
+            last->end = math_max_uint32(last->end, region->end);
+        }
+        else {
+            memmap->regions.data[num_merged++] = *region;
+        }
+    }
+    memmap->regions.size = num_merged;
+    memmap->is_sorted = false;
+}
+
+
+void memmap_sort(memmap_t *memmap) {
+    ASSERT(memmap);
+    if (!memmap->is_sorted) {
+        qsort(memmap->regions.data, memmap->regions.size, sizeof(memmap_region_t), compare_regions);
+        memmap->is_sorted = true;
+    }
+}
+
+
+bool memmap_find_overlaps(memmap_t *memmap, array_memmap_overlap_t *overlaps) {
+    ASSERT(memmap);
+    ASSERT(overlaps);
+    merge_overlay_regions(memmap);
+    memmap_sort(memmap);
+
+    // Indices of the regions which are still open at the start address of the current region
+    array_uint32_t open = make_array(uint32_t, memmap->allocator, 16);
+    if (!array_is_valid(&open)) {
+        return false;
+    }
+
+    bool success = true;
+    for (uint32_t i = 0; success && i < memmap->regions.size; i++) {
+        const memmap_region_t *region = &memmap->regions.data[i];
+
+        // Every open region either intersects this one, and being of another overlay is reported, or has ended and is
+        // dropped for good, so each visit is paid for by an overlap or by a region's end
+        uint32_t num_open = 0;
+        for (uint32_t j = 0; j < open.size; j++) {
+            const memmap_region_t *other = &memmap->regions.data[open.data[j]];
+            if (other->end > region->start) {
+                open.data[num_open++] = open.data[j];
+                if (other->overlay_index != region->overlay_index) {
+                    memmap_overlap_t overlap = {
+                        .start = region->start,
+                        .end = math_min_uint32(region->end, other->end),
+                        .first_overlay_index = other->overlay_index,
+                        .second_overlay_index = region->overlay_index
+                    };
+                    success = success && array_add(overlaps, overlap);
+                }
+            }
+        }
+        open.size = num_open;
+        success = success && array_add(&open, i);
+    }
+
+    array_deinit(&open);
+    return success;
+}
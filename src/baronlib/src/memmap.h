@@ -0,0 +1,117 @@
+/**
+ *  @file   memmap.h
+ * 
+ *  Index of the address ranges occupied by saved overlays, used to detect overlays which overwrite each other
+ *  when loaded.
+ */
+
+#ifndef BARONLIB_MEMMAP_H_
+#define BARONLIB_MEMMAP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "base/array.h"
+
+typedef struct memmap_t memmap_t;
+typedef struct memmap_region_t memmap_region_t;
+typedef struct memmap_overlap_t memmap_overlap_t;
+typedef struct allocator_t allocator_t;
+
+
+/**
+ *  A half-open address range [start, end) occupied by the given overlay
+ */
+struct memmap_region_t {
+    uint32_t start;
+    uint32_t end;
+    uint32_t overlay_index;
+};
+
+def_slice(memmap_region_t);
+
+
+/**
+ *  The address range [start, end) where the regions of two different overlays intersect
+ */
+struct memmap_overlap_t {
+    uint32_t start;
+    uint32_t end;
+    uint32_t first_overlay_index;
+    uint32_t second_overlay_index;
+};
+
+def_slice(memmap_overlap_t);
+
+
+struct memmap_t {
+    const allocator_t *allocator;
+    array_memmap_region_t regions;
+    bool is_sorted;
+};
+
+
+/**
+ *  Initialize an empty memory map
+ * 
+ *  @param  memmap          Pointer to the memmap to initialize
+ *  @param  allocator       Allocator used to hold the regions
+ * 
+ *  @return Success true/false
+ */
+bool memmap_init(memmap_t *memmap, const allocator_t *allocator);
+
+
+/**
+ *  Deinitialize a memory map, freeing all allocations
+ * 
+ *  @param  memmap          Pointer to the memmap to deinitialize
+ */
+void memmap_deinit(memmap_t *memmap);
+
+
+/**
+ *  Remove all regions from a memory map, keeping its allocations for reuse
+ *
+ *  @param  memmap          Pointer to the memmap to reset
+ */
+void memmap_reset(memmap_t *memmap);
+
+
+/**
+ *  Record that the given overlay occupies the address range [start, end) once loaded.
+ *  Empty regions are ignored.
+ * 
+ *  @param  memmap          Pointer to the memmap to add to
+ *  @param  overlay_index   Index of the overlay which occupies the region
+ *  @param  start           First address occupied
+ *  @param  end             One past the last address occupied
+ * 
+ *  @return Success true/false
+ */
+bool memmap_add_region(memmap_t *memmap, uint32_t overlay_index, uint32_t start, uint32_t end);
+
+
+/**
+ *  Sort the regions by start address (and end address where equal), so that they can be iterated in address order.
+ * 
+ *  @param  memmap          Pointer to the memmap to sort
+ */
+void memmap_sort(memmap_t *memmap);
+
+
+/**
+ *  Find every intersection between regions belonging to different overlays.
+ *  The regions of each overlay are first merged where they intersect or touch, then sorted and swept once, holding
+ *  only the regions still open at the current address. At most one region of each overlay is open at once, so every
+ *  open region visited is either reported or dropped, and this takes O(n log n + k) time for n regions and k reported
+ *  overlaps.
+ * 
+ *  @param  memmap          Pointer to the memmap to query. Its regions will be merged and sorted.
+ *  @param  overlaps        Pointer to an initialized array to which the overlaps will be added, in order of start address
+ * 
+ *  @return Success true/false
+ */
+bool memmap_find_overlaps(memmap_t *memmap, array_memmap_overlap_t *overlaps);
+
+
+#endif // ifndef BARONLIB_MEMMAP_H_
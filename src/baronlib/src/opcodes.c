@@ -0,0 +1,292 @@
+#include "base/defines.h"
+#include "opcodes.h"
+
+
+/**
+ *  Opcodes of each instruction, as (mnemonic, addressing mode, opcode, instruction set).
+ *  Instructions in the 'all' set belong to every table; 'cmos' ones only to the 65C02 table, and 'undoc' ones only to
+ *  the table of NMOS with undocumented instructions.
+ */
+#define OPCODES(X) \
+    X(adc, immediate, 0x69, all) X(adc, zero_page, 0x65, all) X(adc, zero_page_x, 0x75, all) \
+    X(adc, absolute, 0x6D, all) X(adc, absolute_x, 0x7D, all) X(adc, absolute_y, 0x79, all) \
+    X(adc, indirect_x, 0x61, all) X(adc, indirect_y, 0x71, all) X(adc, indirect_zero_page, 0x72, cmos) \
+    X(and, immediate, 0x29, all) X(and, zero_page, 0x25, all) X(and, zero_page_x, 0x35, all) \
+    X(and, absolute, 0x2D, all) X(and, absolute_x, 0x3D, all) X(and, absolute_y, 0x39, all) \
+    X(and, indirect_x, 0x21, all) X(and, indirect_y, 0x31, all) X(and, indirect_zero_page, 0x32, cmos) \
+    X(asl, accumulator, 0x0A, all) X(asl, zero_page, 0x06, all) X(asl, zero_page_x, 0x16, all) \
+    X(asl, absolute, 0x0E, all) X(asl, absolute_x, 0x1E, all) \
+    X(bcc, relative, 0x90, all) X(bcs, relative, 0xB0, all) X(beq, relative, 0xF0, all) \
+    X(bmi, relative, 0x30, all) X(bne, relative, 0xD0, all) X(bpl, relative, 0x10, all) \
+    X(bvc, relative, 0x50, all) X(bvs, relative, 0x70, all) \
+    X(bit, zero_page, 0x24, all) X(bit, absolute, 0x2C, all) X(bit, immediate, 0x89, cmos) \
+    X(bit, zero_page_x, 0x34, cmos) X(bit, absolute_x, 0x3C, cmos) \
+    X(brk, implied, 0x00, all) \
+    X(clc, implied, 0x18, all) X(cld, implied, 0xD8, all) X(cli, implied, 0x58, all) X(clv, implied, 0xB8, all) \
+    X(cmp, immediate, 0xC9, all) X(cmp, zero_page, 0xC5, all) X(cmp, zero_page_x, 0xD5, all) \
+    X(cmp, absolute, 0xCD, all) X(cmp, absolute_x, 0xDD, all) X(cmp, absolute_y, 0xD9, all) \
+    X(cmp, indirect_x, 0xC1, all) X(cmp, indirect_y, 0xD1, all) X(cmp, indirect_zero_page, 0xD2, cmos) \
+    X(cpx, immediate, 0xE0, all) X(cpx, zero_page, 0xE4, all) X(cpx, absolute, 0xEC, all) \
+    X(cpy, immediate, 0xC0, all) X(cpy, zero_page, 0xC4, all) X(cpy, absolute, 0xCC, all) \
+    X(dec, zero_page, 0xC6, all) X(dec, zero_page_x, 0xD6, all) X(dec, absolute, 0xCE, all) \
+    X(dec, absolute_x, 0xDE, all) X(dec, accumulator, 0x3A, cmos) \
+    X(dex, implied, 0xCA, all) X(dey, implied, 0x88, all) \
+    X(eor, immediate, 0x49, all) X(eor, zero_page, 0x45, all) X(eor, zero_page_x, 0x55, all) \
+    X(eor, absolute, 0x4D, all) X(eor, absolute_x, 0x5D, all) X(eor, absolute_y, 0x59, all) \
+    X(eor, indirect_x, 0x41, all) X(eor, indirect_y, 0x51, all) X(eor, indirect_zero_page, 0x52, cmos) \
+    X(inc, zero_page, 0xE6, all) X(inc, zero_page_x, 0xF6, all) X(inc, absolute, 0xEE, all) \
+    X(inc, absolute_x, 0xFE, all) X(inc, accumulator, 0x1A, cmos) \
+    X(inx, implied, 0xE8, all) X(iny, implied, 0xC8, all) \
+    X(jmp, absolute, 0x4C, all) X(jmp, indirect, 0x6C, all) X(jmp, indirect_absolute_x, 0x7C, cmos) \
+    X(jsr, absolute, 0x20, all) \
+    X(lda, immediate, 0xA9, all) X(lda, zero_page, 0xA5, all) X(lda, zero_page_x, 0xB5, all) \
+    X(lda, absolute, 0xAD, all) X(lda, absolute_x, 0xBD, all) X(lda, absolute_y, 0xB9, all) \
+    X(lda, indirect_x, 0xA1, all) X(lda, indirect_y, 0xB1, all) X(lda, indirect_zero_page, 0xB2, cmos) \
+    X(ldx, immediate, 0xA2, all) X(ldx, zero_page, 0xA6, all) X(ldx, zero_page_y, 0xB6, all) \
+    X(ldx, absolute, 0xAE, all) X(ldx, absolute_y, 0xBE, all) \
+    X(ldy, immediate, 0xA0, all) X(ldy, zero_page, 0xA4, all) X(ldy, zero_page_x, 0xB4, all) \
+    X(ldy, absolute, 0xAC, all) X(ldy, absolute_x, 0xBC, all) \
+    X(lsr, accumulator, 0x4A, all) X(lsr, zero_page, 0x46, all) X(lsr, zero_page_x, 0x56, all) \
+    X(lsr, absolute, 0x4E, all) X(lsr, absolute_x, 0x5E, all) \
+    X(nop, implied, 0xEA, all) \
+    X(ora, immediate, 0x09, all) X(ora, zero_page, 0x05, all) X(ora, zero_page_x, 0x15, all) \
+    X(ora, absolute, 0x0D, all) X(ora, absolute_x, 0x1D, all) X(ora, absolute_y, 0x19, all) \
+    X(ora, indirect_x, 0x01, all) X(ora, indirect_y, 0x11, all) X(ora, indirect_zero_page, 0x12, cmos) \
+    X(pha, implied, 0x48, all) X(php, implied, 0x08, all) X(pla, implied, 0x68, all) X(plp, implied, 0x28, all) \
+    X(rol, accumulator, 0x2A, all) X(rol, zero_page, 0x26, all) X(rol, zero_page_x, 0x36, all) \
+    X(rol, absolute, 0x2E, all) X(rol, absolute_x, 0x3E, all) \
+    X(ror, accumulator, 0x6A, all) X(ror, zero_page, 0x66, all) X(ror, zero_page_x, 0x76, all) \
+    X(ror, absolute, 0x6E, all) X(ror, absolute_x, 0x7E, all) \
+    X(rti, implied, 0x40, all) X(rts, implied, 0x60, all) \
+    X(sbc, immediate, 0xE9, all) X(sbc, zero_page, 0xE5, all) X(sbc, zero_page_x, 0xF5, all) \
+    X(sbc, absolute, 0xED, all) X(sbc, absolute_x, 0xFD, all) X(sbc, absolute_y, 0xF9, all) \
+    X(sbc, indirect_x, 0xE1, all) X(sbc, indirect_y, 0xF1, all) X(sbc, indirect_zero_page, 0xF2, cmos) \
+    X(sec, implied, 0x38, all) X(sed, implied, 0xF8, all) X(sei, implied, 0x78, all) \
+    X(sta, zero_page, 0x85, all) X(sta, zero_page_x, 0x95, all) X(sta, absolute, 0x8D, all) \
+    X(sta, absolute_x, 0x9D, all) X(sta, absolute_y, 0x99, all) X(sta, indirect_x, 0x81, all) \
+    X(sta, indirect_y, 0x91, all) X(sta, indirect_zero_page, 0x92, cmos) \
+    X(stx, zero_page, 0x86, all) X(stx, zero_page_y, 0x96, all) X(stx, absolute, 0x8E, all) \
+    X(sty, zero_page, 0x84, all) X(sty, zero_page_x, 0x94, all) X(sty, absolute, 0x8C, all) \
+    X(tax, implied, 0xAA, all) X(tay, implied, 0xA8, all) X(tsx, implied, 0xBA, all) \
+    X(txa, implied, 0x8A, all) X(txs, implied, 0x9A, all) X(tya, implied, 0x98, all) \
+    \
+    X(bra, relative, 0x80, cmos) \
+    X(phx, implied, 0xDA, cmos) X(phy, implied, 0x5A, cmos) X(plx, implied, 0xFA, cmos) X(ply, implied, 0x7A, cmos) \
+    X(stz, zero_page, 0x64, cmos) X(stz, zero_page_x, 0x74, cmos) X(stz, absolute, 0x9C, cmos) \
+    X(stz, absolute_x, 0x9E, cmos) \
+    X(trb, zero_page, 0x14, cmos) X(trb, absolute, 0x1C, cmos) \
+    X(tsb, zero_page, 0x04, cmos) X(tsb, absolute, 0x0C, cmos) \
+    \
+    X(slo, zero_page, 0x07, undoc) X(slo, zero_page_x, 0x17, undoc) X(slo, absolute, 0x0F, undoc) \
+    X(slo, absolute_x, 0x1F, undoc) X(slo, absolute_y, 0x1B, undoc) X(slo, indirect_x, 0x03, undoc) \
+    X(slo, indirect_y, 0x13, undoc) \
+    X(rla, zero_page, 0x27, undoc) X(rla, zero_page_x, 0x37, undoc) X(rla, absolute, 0x2F, undoc) \
+    X(rla, absolute_x, 0x3F, undoc) X(rla, absolute_y, 0x3B, undoc) X(rla, indirect_x, 0x23, undoc) \
+    X(rla, indirect_y, 0x33, undoc) \
+    X(sre, zero_page, 0x47, undoc) X(sre, zero_page_x, 0x57, undoc) X(sre, absolute, 0x4F, undoc) \
+    X(sre, absolute_x, 0x5F, undoc) X(sre, absolute_y, 0x5B, undoc) X(sre, indirect_x, 0x43, undoc) \
+    X(sre, indirect_y, 0x53, undoc) \
+    X(rra, zero_page, 0x67, undoc) X(rra, zero_page_x, 0x77, undoc) X(rra, absolute, 0x6F, undoc) \
+    X(rra, absolute_x, 0x7F, undoc) X(rra, absolute_y, 0x7B, undoc) X(rra, indirect_x, 0x63, undoc) \
+    X(rra, indirect_y, 0x73, undoc) \
+    X(sax, zero_page, 0x87, undoc) X(sax, zero_page_y, 0x97, undoc) X(sax, absolute, 0x8F, undoc) \
+    X(sax, indirect_x, 0x83, undoc) \
+    X(lax, zero_page, 0xA7, undoc) X(lax, zero_page_y, 0xB7, undoc) X(lax, absolute, 0xAF, undoc) \
+    X(lax, absolute_y, 0xBF, undoc) X(lax, indirect_x, 0xA3, undoc) X(lax, indirect_y, 0xB3, undoc) \
+    X(dcp, zero_page, 0xC7, undoc) X(dcp, zero_page_x, 0xD7, undoc) X(dcp, absolute, 0xCF, undoc) \
+    X(dcp, absolute_x, 0xDF, undoc) X(dcp, absolute_y, 0xDB, undoc) X(dcp, indirect_x, 0xC3, undoc) \
+    X(dcp, indirect_y, 0xD3, undoc) \
+    X(isc, zero_page, 0xE7, undoc) X(isc, zero_page_x, 0xF7, undoc) X(isc, absolute, 0xEF, undoc) \
+    X(isc, absolute_x, 0xFF, undoc) X(isc, absolute_y, 0xFB, undoc) X(isc, indirect_x, 0xE3, undoc) \
+    X(isc, indirect_y, 0xF3, undoc) \
+    X(anc, immediate, 0x0B, undoc) X(alr, immediate, 0x4B, undoc) X(arr, immediate, 0x6B, undoc) \
+    X(sbx, immediate, 0xCB, undoc)
+
+
+// Each table is built by pasting the instruction set of a row onto a prefix, which either expands to an entry or to nothing
+#define OPCODE_ENTRY(mnemonic, mode, opcode)    [mnemonic_##mnemonic][addr_mode_##mode] = 0x100 | (opcode),
+#define OPCODE_SKIP(mnemonic, mode, opcode)
+
+#define NMOS_all        OPCODE_ENTRY
+#define NMOS_cmos       OPCODE_SKIP
+#define NMOS_undoc      OPCODE_SKIP
+#define NMOS_UNDOC_all  OPCODE_ENTRY
+#define NMOS_UNDOC_cmos OPCODE_SKIP
+#define NMOS_UNDOC_undoc OPCODE_ENTRY
+#define CMOS_all        OPCODE_ENTRY
+#define CMOS_cmos       OPCODE_ENTRY
+#define CMOS_undoc      OPCODE_SKIP
+
+#define NMOS_ROW(mnemonic, mode, opcode, set)       NMOS_##set(mnemonic, mode, opcode)
+#define NMOS_UNDOC_ROW(mnemonic, mode, opcode, set) NMOS_UNDOC_##set(mnemonic, mode, opcode)
+#define CMOS_ROW(mnemonic, mode, opcode, set)       CMOS_##set(mnemonic, mode, opcode)
+
+static const opcode_table_t nmos_opcodes = { OPCODES(NMOS_ROW) };
+static const opcode_table_t nmos_undocumented_opcodes = { OPCODES(NMOS_UNDOC_ROW) };
+static const opcode_table_t cmos_opcodes = { OPCODES(CMOS_ROW) };
+
+static const opcode_table_t *const opcode_tables[instruction_set_count] = {
+    [instruction_set_nmos] = &nmos_opcodes,
+    [instruction_set_nmos_undocumented] = &nmos_undocumented_opcodes,
+    [instruction_set_cmos] = &cmos_opcodes
+};
+
+
+const opcode_table_t *opcode_table(instruction_set_t instruction_set) {
+    ASSERT(instruction_set < instruction_set_count);
+    return opcode_tables[instruction_set];
+}
+
+
+/**
+ *  Mnemonics are keyed by packing their three letters into 5 bits each. The multiplier was found by search, such that
+ *  the top 8 bits of the product are distinct for every mnemonic. A collision would be reported at compile time, as
+ *  two designated initializers for the same slot (-Woverride-init).
+ */
+#define MNEMONIC_KEY(c0, c1, c2)    ((uint32_t)((c0) - 'a') << 10 | (uint32_t)((c1) - 'a') << 5 | (uint32_t)((c2) - 'a'))
+#define MNEMONIC_HASH(key)          ((uint32_t)((key) * 0xF7231FF9U) >> 24)
+
+typedef struct mnemonic_slot_t {
+    uint16_t key;               // Key + 1, so that empty slots never match
+    uint8_t mnemonic;
+} mnemonic_slot_t;
+
+#define MNEMONIC_SLOT(name, c0, c1, c2) \
+    [MNEMONIC_HASH(MNEMONIC_KEY(c0, c1, c2))] = {MNEMONIC_KEY(c0, c1, c2) + 1, mnemonic_##name},
+
+static const mnemonic_slot_t mnemonic_slots[256] = { MNEMONICS(MNEMONIC_SLOT) };
+
+#define MNEMONIC_NAME(name, c0, c1, c2) [mnemonic_##name] = {(c0) ^ 0x20, (c1) ^ 0x20, (c2) ^ 0x20},
+
+static const uint8_t mnemonic_names[mnemonic_count][3] = { MNEMONICS(MNEMONIC_NAME) };
+
+
+mnemonic_t mnemonic_lookup(strview_t name) {
+    if (name.length != 3) {
+        return mnemonic_count;
+    }
+
+    // Anything other than a letter maps outside 0-25; values which would spill into the next field are rejected here,
+    // and the remainder (26-31) never match a stored key
+    uint32_t c0 = (uint32_t)((name.data[0] | 0x20) - 'a');
+    uint32_t c1 = (uint32_t)((name.data[1] | 0x20) - 'a');
+    uint32_t c2 = (uint32_t)((name.data[2] | 0x20) - 'a');
+    uint32_t key = c0 << 10 | c1 << 5 | c2;
+    const mnemonic_slot_t *slot = &mnemonic_slots[MNEMONIC_HASH(key)];
+    return ((c0 | c1 | c2) < 32 && slot->key == key + 1) ? (mnemonic_t)slot->mnemonic : mnemonic_count;
+}
+
+
+strview_t mnemonic_name(mnemonic_t mnemonic) {
+    ASSERT(mnemonic < mnemonic_count);
+    return (strview_t){mnemonic_names[mnemonic], 3};
+}
+
+
+bool mnemonic_is_supported(const opcode_table_t *table, mnemonic_t mnemonic) {
+    ASSERT(table);
+    ASSERT(mnemonic < mnemonic_count);
+    uint16_t any = 0;
+    for (int i = 0; i < addr_mode_count; i++) {
+        any |= (*table)[mnemonic][i];
+    }
+    return any != 0;
+}
+
+
+addr_mode_t opcode_select_mode(const opcode_table_t *table, mnemonic_t mnemonic, addr_mode_t operand_mode, bool is_zero_page) {
+    ASSERT(table);
+    ASSERT(mnemonic < mnemonic_count);
+    ASSERT(operand_mode < addr_mode_count);
+    const uint16_t *opcodes = (*table)[mnemonic];
+
+    addr_mode_t mode = operand_mode;
+    if (mode == addr_mode_absolute && opcodes[addr_mode_relative]) {
+        return addr_mode_relative;
+    }
+    if (mode == addr_mode_implied && !opcodes[addr_mode_implied]) {
+        // e.g. ASL meaning ASL A
+        mode = addr_mode_accumulator;
+    }
+    else if (mode == addr_mode_indirect_x && !opcodes[addr_mode_indirect_x]) {
+        // e.g. JMP (addr,X)
+        mode = addr_mode_indirect_absolute_x;
+    }
+
+    if (is_zero_page) {
+        addr_mode_t zero_page_mode = addr_mode_zero_page_form(mode);
+        if (opcodes[zero_page_mode]) {
+            return zero_page_mode;
+        }
+    }
+    return opcodes[mode] ? mode : addr_mode_count;
+}
+
+
+static const uint8_t instruction_sizes[addr_mode_count] = {
+    [addr_mode_implied] = 1,
+    [addr_mode_accumulator] = 1,
+    [addr_mode_immediate] = 2,
+    [addr_mode_zero_page] = 2,
+    [addr_mode_zero_page_x] = 2,
+    [addr_mode_zero_page_y] = 2,
+    [addr_mode_absolute] = 3,
+    [addr_mode_absolute_x] = 3,
+    [addr_mode_absolute_y] = 3,
+    [addr_mode_indirect] = 3,
+    [addr_mode_indirect_x] = 2,
+    [addr_mode_indirect_y] = 2,
+    [addr_mode_indirect_zero_page] = 2,
+    [addr_mode_indirect_absolute_x] = 3,
+    [addr_mode_relative] = 2
+};
+
+
+// Range of operand values accepted by each mode
+static const int32_t operand_min[addr_mode_count] = {
+    [addr_mode_immediate] = -128,
+    [addr_mode_relative] = -128
+};
+
+static const int32_t operand_max[addr_mode_count] = {
+    [addr_mode_implied] = INT32_MAX,
+    [addr_mode_accumulator] = INT32_MAX,
+    [addr_mode_immediate] = 255,
+    [addr_mode_zero_page] = 255,
+    [addr_mode_zero_page_x] = 255,
+    [addr_mode_zero_page_y] = 255,
+    [addr_mode_absolute] = 65535,
+    [addr_mode_absolute_x] = 65535,
+    [addr_mode_absolute_y] = 65535,
+    [addr_mode_indirect] = 65535,
+    [addr_mode_indirect_x] = 255,
+    [addr_mode_indirect_y] = 255,
+    [addr_mode_indirect_zero_page] = 255,
+    [addr_mode_indirect_absolute_x] = 65535,
+    [addr_mode_relative] = 127
+};
+
+
+uint32_t instruction_size(addr_mode_t mode) {
+    ASSERT(mode < addr_mode_count);
+    return instruction_sizes[mode];
+}
+
+
+uint32_t instruction_encode(const opcode_table_t *table, mnemonic_t mnemonic, addr_mode_t mode, int32_t operand, uint8_t bytes[3]) {
+    ASSERT(table);
+    ASSERT(mnemonic < mnemonic_count);
+    ASSERT(mode < addr_mode_count);
+    ASSERT(bytes);
+
+    uint16_t opcode = (*table)[mnemonic][mode];
+    if (!opcode || operand < operand_min[mode] || operand > operand_max[mode]) {
+        return 0;
+    }
+
+    // Unused operand bytes are harmless to write, so every instruction is written the same way
+    bytes[0] = (uint8_t)opcode;
+    bytes[1] = (uint8_t)operand;
+    bytes[2] = (uint8_t)(operand >> 8);
+    return instruction_sizes[mode];
+}
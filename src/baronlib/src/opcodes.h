@@ -0,0 +1,131 @@
+/**
+ *  @file   opcodes.h
+ *
+ *  Table-driven 6502 / 65C02 instruction encoding.
+ *
+ *  Mnemonics are recognised by a perfect hash of their three letters, and each instruction set is a static table
+ *  of opcodes indexed by [mnemonic][addressing mode], built at compile time. Selecting the CPU is just a matter of
+ *  choosing which table to use.
+ */
+
+#ifndef BARONLIB_OPCODES_H_
+#define BARONLIB_OPCODES_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "base/str.h"
+#include "addrmode.h"
+
+
+#define MNEMONICS(X) \
+    X(adc, 'a', 'd', 'c') X(and, 'a', 'n', 'd') X(asl, 'a', 's', 'l') X(bcc, 'b', 'c', 'c') X(bcs, 'b', 'c', 's') \
+    X(beq, 'b', 'e', 'q') X(bit, 'b', 'i', 't') X(bmi, 'b', 'm', 'i') X(bne, 'b', 'n', 'e') X(bpl, 'b', 'p', 'l') \
+    X(brk, 'b', 'r', 'k') X(bvc, 'b', 'v', 'c') X(bvs, 'b', 'v', 's') X(clc, 'c', 'l', 'c') X(cld, 'c', 'l', 'd') \
+    X(cli, 'c', 'l', 'i') X(clv, 'c', 'l', 'v') X(cmp, 'c', 'm', 'p') X(cpx, 'c', 'p', 'x') X(cpy, 'c', 'p', 'y') \
+    X(dec, 'd', 'e', 'c') X(dex, 'd', 'e', 'x') X(dey, 'd', 'e', 'y') X(eor, 'e', 'o', 'r') X(inc, 'i', 'n', 'c') \
+    X(inx, 'i', 'n', 'x') X(iny, 'i', 'n', 'y') X(jmp, 'j', 'm', 'p') X(jsr, 'j', 's', 'r') X(lda, 'l', 'd', 'a') \
+    X(ldx, 'l', 'd', 'x') X(ldy, 'l', 'd', 'y') X(lsr, 'l', 's', 'r') X(nop, 'n', 'o', 'p') X(ora, 'o', 'r', 'a') \
+    X(pha, 'p', 'h', 'a') X(php, 'p', 'h', 'p') X(pla, 'p', 'l', 'a') X(plp, 'p', 'l', 'p') X(rol, 'r', 'o', 'l') \
+    X(ror, 'r', 'o', 'r') X(rti, 'r', 't', 'i') X(rts, 'r', 't', 's') X(sbc, 's', 'b', 'c') X(sec, 's', 'e', 'c') \
+    X(sed, 's', 'e', 'd') X(sei, 's', 'e', 'i') X(sta, 's', 't', 'a') X(stx, 's', 't', 'x') X(sty, 's', 't', 'y') \
+    X(tax, 't', 'a', 'x') X(tay, 't', 'a', 'y') X(tsx, 't', 's', 'x') X(txa, 't', 'x', 'a') X(txs, 't', 'x', 's') \
+    X(tya, 't', 'y', 'a') \
+    /* 65C02 */ \
+    X(bra, 'b', 'r', 'a') X(phx, 'p', 'h', 'x') X(phy, 'p', 'h', 'y') X(plx, 'p', 'l', 'x') X(ply, 'p', 'l', 'y') \
+    X(stz, 's', 't', 'z') X(trb, 't', 'r', 'b') X(tsb, 't', 's', 'b') \
+    /* Undocumented NMOS */ \
+    X(slo, 's', 'l', 'o') X(rla, 'r', 'l', 'a') X(sre, 's', 'r', 'e') X(rra, 'r', 'r', 'a') X(sax, 's', 'a', 'x') \
+    X(lax, 'l', 'a', 'x') X(dcp, 'd', 'c', 'p') X(isc, 'i', 's', 'c') X(anc, 'a', 'n', 'c') X(alr, 'a', 'l', 'r') \
+    X(arr, 'a', 'r', 'r') X(sbx, 's', 'b', 'x')
+
+
+#define MNEMONIC_ENUM(name, c0, c1, c2) mnemonic_##name,
+
+typedef enum mnemonic_t {
+    MNEMONICS(MNEMONIC_ENUM)
+    mnemonic_count
+} mnemonic_t;
+
+#undef MNEMONIC_ENUM
+
+
+typedef enum instruction_set_t {
+    instruction_set_nmos,
+    instruction_set_nmos_undocumented,
+    instruction_set_cmos,
+    instruction_set_count
+} instruction_set_t;
+
+
+/**
+ *  Opcodes indexed by [mnemonic][addressing mode].
+ *  Valid entries have bit 8 set, with the opcode in the low 8 bits; unsupported combinations are zero.
+ */
+typedef uint16_t opcode_table_t[mnemonic_count][addr_mode_count];
+
+
+/**
+ *  Get the opcode table for an instruction set
+ */
+const opcode_table_t *opcode_table(instruction_set_t instruction_set);
+
+
+/**
+ *  Look up a mnemonic, case-insensitively
+ *
+ *  @param  name            Name to look up
+ *
+ *  @return The mnemonic, or mnemonic_count if the name is not a mnemonic in any instruction set.
+ *          The instruction set's opcode table determines whether it can actually be used.
+ */
+mnemonic_t mnemonic_lookup(strview_t name);
+
+
+/**
+ *  Get the name of a mnemonic, in upper case
+ */
+strview_t mnemonic_name(mnemonic_t mnemonic);
+
+
+/**
+ *  Determine whether a mnemonic is defined in the given opcode table
+ */
+bool mnemonic_is_supported(const opcode_table_t *table, mnemonic_t mnemonic);
+
+
+/**
+ *  Select the addressing mode with which to encode an instruction.
+ *  The zero page form of the operand's mode is chosen if the operand fits and the instruction supports it.
+ *  An address operand selects relative mode for branches, and (abs,X) for the 65C02 JMP (addr,X).
+ *
+ *  @param  table           Opcode table of the instruction set
+ *  @param  mnemonic        Mnemonic of the instruction
+ *  @param  operand_mode    Addressing mode given by operand_parse
+ *  @param  is_zero_page    Whether the operand's value is in the range 0-255
+ *
+ *  @return The addressing mode, or addr_mode_count if the instruction does not support the operand
+ */
+addr_mode_t opcode_select_mode(const opcode_table_t *table, mnemonic_t mnemonic, addr_mode_t operand_mode, bool is_zero_page);
+
+
+/**
+ *  Get the size in bytes of an instruction with the given addressing mode
+ */
+uint32_t instruction_size(addr_mode_t mode);
+
+
+/**
+ *  Encode an instruction
+ *
+ *  @param  table           Opcode table of the instruction set
+ *  @param  mnemonic        Mnemonic of the instruction
+ *  @param  mode            Addressing mode, as returned by opcode_select_mode
+ *  @param  operand         Value of the operand; for relative mode, the signed offset from the following instruction
+ *  @param  bytes           Receives the encoded instruction
+ *
+ *  @return Size of the instruction in bytes, or 0 if the instruction does not support the addressing mode
+ */
+uint32_t instruction_encode(const opcode_table_t *table, mnemonic_t mnemonic, addr_mode_t mode, int32_t operand, uint8_t bytes[3]);
+
+
+#endif // ifndef BARONLIB_OPCODES_H_
@@ -0,0 +1,139 @@
+#include <string.h>
+#include "base/allocator.h"
+#include "base/defines.h"
+#include "profile.h"
+#include "stats.h"
+
+
+#define PROFILE_NAMES_REGION_SIZE 0x400
+
+
+bool profile_init(profile_t *profile, const allocator_t *allocator) {
+    ASSERT(profile);
+    *profile = (profile_t){
+        .allocator = allocator,
+        .files = make_array(profile_file_t, allocator, 4),
+        .names = make_arena(allocator, PROFILE_NAMES_REGION_SIZE),
+        .file = invalid_index
+    };
+    return array_is_valid(&profile->files);
+}
+
+
+void profile_deinit(profile_t *profile) {
+    ASSERT(profile);
+    for (uint32_t i = 0; i < profile->files.size; i++) {
+        array_deinit(&profile->files.data[i].lines);
+    }
+    array_deinit(&profile->files);
+    arena_deinit(&profile->names);
+}
+
+
+void profile_reset(profile_t *profile) {
+    ASSERT(profile);
+    for (uint32_t i = 0; i < profile->files.size; i++) {
+        array_deinit(&profile->files.data[i].lines);
+    }
+    array_reset(&profile->files);
+    arena_reset(&profile->names);
+    profile->file = invalid_index;
+    profile->steps_since_sample = 0;
+}
+
+
+bool profile_enter_file(profile_t *profile, strview_t filename) {
+    ASSERT(profile);
+    for (uint32_t i = 0; i < profile->files.size; i++) {
+        if (strview_equal(profile->files.data[i].name, filename)) {
+            profile->file = i;
+            return true;
+        }
+    }
+
+    uint8_t *name = arena_alloc(&profile->names, filename.length + 1);
+    profile_file_t file = {
+        .name = {name, filename.length},
+        .lines = make_array(profile_line_t, profile->allocator, 256)
+    };
+    if (!name || !array_is_valid(&file.lines) || !array_add(&profile->files, file)) {
+        array_deinit(&file.lines);
+        return false;
+    }
+    memcpy(name, filename.data, filename.length);
+    profile->file = profile->files.size - 1;
+    return true;
+}
+
+
+void profile_start_sampling(profile_t *profile) {
+    ASSERT(profile);
+    profile->steps_since_sample = 0;
+    profile->sample_time = stats_now();
+}
+
+
+void profile_count(profile_t *profile, uint32_t line, uint64_t steps, uint64_t evaluations) {
+    ASSERT(profile);
+    if (profile->file == invalid_index) {
+        return;
+    }
+
+    array_profile_line_t *lines = &profile->files.data[profile->file].lines;
+    if (line >= lines->size) {
+        uint32_t size = lines->size;
+        if (!array_resize(lines, math_max_uint32(line + 1, size * 2))) {
+            return;
+        }
+        memset(lines->data + size, 0, (lines->size - size) * sizeof(profile_line_t));
+    }
+
+    profile_line_t *counts = &lines->data[line];
+    counts->steps += steps;
+    counts->evaluations += evaluations;
+
+    profile->steps_since_sample += (uint32_t)math_min_uint64(steps, PROFILE_SAMPLE_INTERVAL);
+    if (profile->steps_since_sample >= PROFILE_SAMPLE_INTERVAL) {
+        double now = stats_now();
+        counts->seconds += now - profile->sample_time;
+        profile->sample_time = now;
+        profile->steps_since_sample = 0;
+    }
+}
+
+
+static bool is_hotter(const baron_hot_line_t *a, const baron_hot_line_t *b) {
+    return a->seconds > b->seconds || (a->seconds == b->seconds && a->steps > b->steps);
+}
+
+
+size_t profile_hot_lines(const profile_t *profile, baron_hot_line_t *hot_lines, size_t max_lines) {
+    ASSERT(profile);
+    ASSERT(hot_lines || max_lines == 0);
+
+    // Only a few lines are wanted, out of many, so each line is insertion sorted into the few kept so far
+    size_t num_lines = 0;
+    for (uint32_t i = 0; i < profile->files.size; i++) {
+        const profile_file_t *file = &profile->files.data[i];
+        for (uint32_t line = 0; line < file->lines.size; line++) {
+            const profile_line_t *counts = &file->lines.data[line];
+            baron_hot_line_t hot_line = {
+                .filename = (const char *)file->name.data,
+                .line = line,
+                .steps = counts->steps,
+                .evaluations = counts->evaluations,
+                .seconds = counts->seconds
+            };
+            if (hot_line.steps == 0 || (num_lines == max_lines && (max_lines == 0 || !is_hotter(&hot_line, &hot_lines[max_lines - 1])))) {
+                continue;
+            }
+            size_t j = (num_lines < max_lines) ? num_lines++ : max_lines - 1;
+            while (j > 0 && is_hotter(&hot_line, &hot_lines[j - 1])) {
+                hot_lines[j] = hot_lines[j - 1];
+                j--;
+            }
+            hot_lines[j] = hot_line;
+        }
+    }
+    return num_lines;
+}
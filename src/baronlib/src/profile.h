@@ -0,0 +1,136 @@
+/**
+ *  @file   profile.h
+ *
+ *  Attribution of assembly work to source lines, so that the lines which cost the most can be found.
+ *
+ *  Steps (statements executed) and expression evaluations are counted exactly, against the file and line of the
+ *  statement which did them; statements of a macro body carry the lines of the body, so work done through a macro
+ *  expansion lands on the macro's lines. Time is sampled rather than measured per statement, which would cost more
+ *  than most statements do: every PROFILE_SAMPLE_INTERVAL steps the clock is read, and the time since the last sample
+ *  is given to the line being counted at that moment. Over many samples, the time of each line is proportional to
+ *  the time really spent there.
+ *
+ *  Counts for each file are held in an array indexed directly by line number, so counting needs no hashing.
+ */
+
+#ifndef BARONLIB_PROFILE_H_
+#define BARONLIB_PROFILE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "base/arena.h"
+#include "base/array.h"
+#include "base/str.h"
+#include "baron/baron.h"
+
+typedef struct profile_t profile_t;
+typedef struct profile_line_t profile_line_t;
+typedef struct profile_file_t profile_file_t;
+typedef struct allocator_t allocator_t;
+
+
+// Number of steps between samples of the clock
+#define PROFILE_SAMPLE_INTERVAL 64
+
+
+struct profile_line_t {
+    uint64_t steps;
+    uint64_t evaluations;
+    double seconds;
+};
+
+def_slice(profile_line_t);
+
+
+struct profile_file_t {
+    strview_t name;                 // Zero-terminated copy of the file's name
+    array_profile_line_t lines;     // Indexed by line number
+};
+
+def_slice(profile_file_t);
+
+
+struct profile_t {
+    const allocator_t *allocator;
+    array_profile_file_t files;
+    arena_t names;
+    uint32_t file;                  // Index of the file whose lines are being counted
+    uint32_t steps_since_sample;
+    double sample_time;             // Time of the last sample
+};
+
+
+/**
+ *  Initialize an empty profile
+ *
+ *  @param  profile         Pointer to the profile to initialize
+ *  @param  allocator       Allocator used to hold the profile
+ *
+ *  @return Success true/false
+ */
+bool profile_init(profile_t *profile, const allocator_t *allocator);
+
+
+/**
+ *  Deinitialize a profile, freeing its allocations
+ */
+void profile_deinit(profile_t *profile);
+
+
+/**
+ *  Discard all counts, keeping the profile's allocations for reuse
+ */
+void profile_reset(profile_t *profile);
+
+
+/**
+ *  Make subsequent counts apply to the named file, e.g. on entering an included file or a macro defined in one.
+ *  The file counted before is profile->file, which can be saved to be restored by profile_restore_file.
+ *
+ *  @param  profile         Pointer to the profile
+ *  @param  filename        Name of the file, which is copied
+ *
+ *  @return Success true/false
+ */
+bool profile_enter_file(profile_t *profile, strview_t filename);
+
+
+/**
+ *  Make subsequent counts apply to a file entered before, e.g. on leaving an included file
+ */
+static inline void profile_restore_file(profile_t *profile, uint32_t file) {
+    profile->file = file;
+}
+
+
+/**
+ *  Restart the sample clock, e.g. at the start of a pass, so that time outside the assembly isn't attributed
+ */
+void profile_start_sampling(profile_t *profile);
+
+
+/**
+ *  Count work done by a line of the current file.
+ *  Counts are best effort: if the profile can't grow to hold the line, they are dropped.
+ *
+ *  @param  profile         Pointer to the profile
+ *  @param  line            Line number
+ *  @param  steps           Statements executed
+ *  @param  evaluations     Expressions evaluated
+ */
+void profile_count(profile_t *profile, uint32_t line, uint64_t steps, uint64_t evaluations);
+
+
+/**
+ *  Find the lines with the most sampled time, ties going to those with the most steps
+ *
+ *  @param  profile         Pointer to the profile
+ *  @param  hot_lines       Array receiving up to max_lines lines, hottest first
+ *  @param  max_lines       Size of the hot_lines array
+ *
+ *  @return Number of lines written to hot_lines
+ */
+size_t profile_hot_lines(const profile_t *profile, baron_hot_line_t *hot_lines, size_t max_lines);
+
+
+#endif // ifndef BARONLIB_PROFILE_H_
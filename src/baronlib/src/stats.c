@@ -0,0 +1,60 @@
+// clock_gettime is POSIX rather than standard C
+#if defined(__unix__) || defined(__APPLE__)
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include <time.h>
+#include "base/defines.h"
+#include "stats.h"
+
+
+static void *stats_alloc(uint32_t size, void *context) {
+    stats_allocator_t *stats_allocator = context;
+    stats_allocator->stats->num_allocations++;
+    stats_allocator->stats->bytes_requested += size;
+    return allocator_alloc(stats_allocator->parent, size);
+}
+
+
+static void *stats_realloc(void *ptr, uint32_t size, void *context) {
+    stats_allocator_t *stats_allocator = context;
+    stats_allocator->stats->num_allocations++;
+    stats_allocator->stats->bytes_requested += size;
+    return allocator_realloc(stats_allocator->parent, ptr, size);
+}
+
+
+static void stats_free(void *ptr, void *context) {
+    stats_allocator_t *stats_allocator = context;
+    allocator_free(stats_allocator->parent, ptr);
+}
+
+
+void stats_allocator_init(stats_allocator_t *stats_allocator, const allocator_t *parent, baron_memory_stats_t *stats) {
+    ASSERT(stats_allocator);
+    ASSERT(stats);
+
+    static const allocator_vtable_t stats_vtable = {
+        stats_alloc,
+        stats_realloc,
+        stats_free
+    };
+
+    *stats_allocator = (stats_allocator_t){
+        .allocator = {stats_allocator, &stats_vtable},
+        .parent = parent,
+        .stats = stats
+    };
+}
+
+
+double stats_now(void) {
+    // A monotonic clock can't jump when the system time is changed, so timings are never negative or inflated
+    struct timespec ts;
+#if defined(CLOCK_MONOTONIC)
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+    timespec_get(&ts, TIME_UTC);
+#endif
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1E-9;
+}
@@ -0,0 +1,41 @@
+/**
+ *  @file   stats.h
+ *
+ *  Support for gathering the statistics in baron_stats_t: a clock for timing passes, and allocators which count the
+ *  allocations made for each use of an assembly's memory before passing them on.
+ */
+
+#ifndef BARONLIB_STATS_H_
+#define BARONLIB_STATS_H_
+
+#include "base/allocator.h"
+#include "baron/baron.h"
+
+typedef struct stats_allocator_t stats_allocator_t;
+
+
+struct stats_allocator_t {
+    allocator_t allocator;          // Allocator to use, which refers back to this
+    const allocator_t *parent;      // Allocator which counted allocations are passed on to
+    baron_memory_stats_t *stats;
+};
+
+
+/**
+ *  Initialize an allocator which counts allocations into stats.
+ *  The stats_allocator_t must not move while its allocator is in use.
+ *
+ *  @param  stats_allocator Pointer to the allocator to initialize
+ *  @param  parent          Allocator which allocations are passed on to
+ *  @param  stats           Counts to add the allocations to
+ */
+void stats_allocator_init(stats_allocator_t *stats_allocator, const allocator_t *parent, baron_memory_stats_t *stats);
+
+
+/**
+ *  Get the time in seconds from an arbitrary starting point, by a monotonic clock where there is one
+ */
+double stats_now(void);
+
+
+#endif // ifndef BARONLIB_STATS_H_
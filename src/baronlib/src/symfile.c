@@ -0,0 +1,101 @@
+/**
+ *  @file   symfile.c
+ *
+ *  Queries on binary symbol files, made in place on the file's bytes, typically mapped straight into memory.
+ *  Nothing is parsed or allocated: a name is found through the file's hash index, and an address by binary search
+ *  of the numeric records, which are sorted by value.
+ */
+
+#include <string.h>
+#include "base/defines.h"
+#include "base/str.h"
+#include "baron.h"
+
+
+const baron_symbol_file_header_t *baron_symbol_file_open(const void *data, size_t size) {
+    const baron_symbol_file_header_t *file = data;
+    if (!data || ((uintptr_t)data & 7) || size < sizeof *file ||
+        file->magic != BARON_SYMBOL_FILE_MAGIC || file->version != BARON_SYMBOL_FILE_VERSION) {
+        return 0;
+    }
+
+    // Sizes are checked in 64 bits, so that a corrupt header can't make them wrap
+    uint64_t records_end = (uint64_t)file->records_offset + (uint64_t)file->num_symbols * sizeof(baron_symbol_record_t);
+    uint64_t hash_end = (uint64_t)file->hash_offset + (uint64_t)file->num_hash_slots * sizeof(uint32_t);
+    uint64_t strings_end = (uint64_t)file->strings_offset + file->strings_size;
+    bool is_valid = (file->records_offset & 7) == 0 && (file->hash_offset & 3) == 0 &&
+                    file->records_offset >= sizeof *file && records_end <= size &&
+                    hash_end <= size && strings_end <= size &&
+                    file->num_numeric_symbols <= file->num_symbols &&
+                    file->num_hash_slots != 0 && (file->num_hash_slots & (file->num_hash_slots - 1)) == 0 &&
+                    file->num_hash_slots >= file->num_symbols * 2ULL;
+    return is_valid ? file : 0;
+}
+
+
+static const baron_symbol_record_t *get_records(const baron_symbol_file_header_t *file) {
+    return (const baron_symbol_record_t *)((const uint8_t *)file + file->records_offset);
+}
+
+
+const char *baron_symbol_file_string(const baron_symbol_file_header_t *file, uint32_t offset) {
+    ASSERT(file);
+    return (offset < file->strings_size) ? (const char *)file + file->strings_offset + offset : 0;
+}
+
+
+const baron_symbol_record_t *baron_symbol_file_find(const baron_symbol_file_header_t *file, const char *name) {
+    ASSERT(file);
+    ASSERT(name);
+    strview_t name_view = make_strview(name);
+    uint32_t hash = strview_hash(name_view);
+    const uint32_t *slots = (const uint32_t *)((const uint8_t *)file + file->hash_offset);
+    const baron_symbol_record_t *records = get_records(file);
+
+    // A valid file always has an empty slot to end the probe, but a corrupt one may not, so no more than every slot is
+    // examined
+    uint32_t mask = file->num_hash_slots - 1;
+    uint32_t i = hash & mask;
+    for (uint32_t num_probes = 0; num_probes < file->num_hash_slots && slots[i] < file->num_symbols; num_probes++) {
+        const baron_symbol_record_t *record = &records[slots[i]];
+        i = (i + 1) & mask;
+        if (record->hash == hash && record->name_length == name_view.length &&
+            (uint64_t)record->name_offset + record->name_length <= file->strings_size &&
+            memcmp(baron_symbol_file_string(file, record->name_offset), name, name_view.length) == 0) {
+            return record;
+        }
+    }
+    return 0;
+}
+
+
+/**
+ *  Count the numeric records whose value is below the given one, or not above it if is_inclusive is set
+ */
+static uint32_t count_numeric_below(const baron_symbol_file_header_t *file, double value, bool is_inclusive) {
+    const baron_symbol_record_t *records = get_records(file);
+    uint32_t low = 0;
+    uint32_t high = file->num_numeric_symbols;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (records[mid].number < value || (is_inclusive && records[mid].number == value)) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+
+const baron_symbol_record_t *baron_symbol_file_find_address(const baron_symbol_file_header_t *file, double address) {
+    ASSERT(file);
+    uint32_t count = count_numeric_below(file, address, true);
+    if (count == 0) {
+        return 0;
+    }
+    // Symbols sharing a value are in definition order, so return the first of them
+    const baron_symbol_record_t *records = get_records(file);
+    return &records[count_numeric_below(file, records[count - 1].number, false)];
+}
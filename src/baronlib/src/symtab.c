@@ -0,0 +1,269 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "base/allocator.h"
+#include "base/defines.h"
+#include "symtab.h"
+
+
+#define SYMTAB_INITIAL_SLOTS 64
+#define SYMTAB_NAMES_REGION_SIZE 0x4000
+
+typedef const symbol_t *symbol_ref_t;
+
+def_slice(baron_symbol_record_t);
+def_slice(symbol_ref_t);
+
+
+bool symtab_init(symtab_t *symtab, const allocator_t *allocator) {
+    ASSERT(symtab);
+    *symtab = (symtab_t){
+        .allocator = allocator,
+        .symbols = make_array(symbol_t, allocator, 32),
+        .slots = make_array(uint32_t, allocator, SYMTAB_INITIAL_SLOTS),
+        .names = make_arena(allocator, SYMTAB_NAMES_REGION_SIZE)
+    };
+
+    if (!array_is_valid(&symtab->symbols) || !array_resize(&symtab->slots, SYMTAB_INITIAL_SLOTS)) {
+        symtab_deinit(symtab);
+        return false;
+    }
+    memset(symtab->slots.data, 0xFF, symtab->slots.size * sizeof(uint32_t));
+    return true;
+}
+
+
+void symtab_deinit(symtab_t *symtab) {
+    ASSERT(symtab);
+    for (uint32_t i = 0; i < symtab->symbols.size; i++) {
+        value_release(&symtab->symbols.data[i].value);
+    }
+    array_deinit(&symtab->symbols);
+    array_deinit(&symtab->slots);
+    arena_deinit(&symtab->names);
+}
+
+
+void symtab_reset(symtab_t *symtab) {
+    ASSERT(symtab);
+    for (uint32_t i = 0; i < symtab->symbols.size; i++) {
+        value_release(&symtab->symbols.data[i].value);
+    }
+    array_reset(&symtab->symbols);
+    memset(symtab->slots.data, 0xFF, symtab->slots.size * sizeof(uint32_t));
+    arena_reset(&symtab->names);
+    symtab->num_lookups = 0;
+    symtab->num_probes = 0;
+    symtab->max_probe_length = 0;
+}
+
+
+// Returns the index of the slot holding the named symbol, or of the empty slot where it would go.
+// Empty slots hold invalid_index.
+static uint32_t find_slot(const array_symbol_t *symbols, const array_uint32_t *slots, strview_t name, uint32_t hash) {
+    uint32_t mask = slots->size - 1;
+    for (uint32_t i = hash & mask; ; i = (i + 1) & mask) {
+        uint32_t index = slots->data[i];
+        if (index == invalid_index ||
+            (symbols->data[index].hash == hash && strview_equal(symbols->data[index].name, name))) {
+            return i;
+        }
+    }
+}
+
+
+// Counts a lookup which found the given slot, having started its probe sequence at the slot given by the hash
+static uint32_t count_probes(symtab_t *symtab, uint32_t slot, uint32_t hash) {
+    uint32_t length = ((slot - hash) & (symtab->slots.size - 1)) + 1;
+    symtab->num_lookups++;
+    symtab->num_probes += length;
+    symtab->max_probe_length = math_max_uint32(symtab->max_probe_length, length);
+    return slot;
+}
+
+
+static bool grow_slots(symtab_t *symtab) {
+    uint32_t num_slots = symtab->slots.size * 2;
+    array_uint32_t slots = make_array(uint32_t, symtab->allocator, num_slots);
+    if (!array_resize(&slots, num_slots)) {
+        array_deinit(&slots);
+        return false;
+    }
+    memset(slots.data, 0xFF, num_slots * sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < symtab->symbols.size; i++) {
+        const symbol_t *symbol = &symtab->symbols.data[i];
+        slots.data[find_slot(&symtab->symbols, &slots, symbol->name, symbol->hash)] = i;
+    }
+
+    array_deinit(&symtab->slots);
+    symtab->slots = slots;
+    return true;
+}
+
+
+bool symtab_set(symtab_t *symtab, strview_t name, value_t value) {
+    ASSERT(symtab);
+    ASSERT(strview_is_valid(name));
+
+    uint32_t hash = strview_hash(name);
+    uint32_t slot = count_probes(symtab, find_slot(&symtab->symbols, &symtab->slots, name, hash), hash);
+    if (symtab->slots.data[slot] != invalid_index) {
+        value_t *existing = &symtab->symbols.data[symtab->slots.data[slot]].value;
+        value_release(existing);
+        *existing = value;
+        return true;
+    }
+
+    // Keep the load factor at most 1/2 so that probe sequences stay short
+    if ((symtab->symbols.size + 1) * 2 > symtab->slots.size) {
+        if (!grow_slots(symtab)) {
+            value_release(&value);
+            return false;
+        }
+        slot = find_slot(&symtab->symbols, &symtab->slots, name, hash);
+    }
+
+    uint8_t *name_copy = arena_alloc(&symtab->names, name.length + 1);
+    symbol_t symbol = {{name_copy, name.length}, hash, value};
+    if (!name_copy || !array_add(&symtab->symbols, symbol)) {
+        value_release(&value);
+        return false;
+    }
+    memcpy(name_copy, name.data, name.length);
+    symtab->slots.data[slot] = symtab->symbols.size - 1;
+    return true;
+}
+
+
+const symbol_t *symtab_find(const symtab_t *symtab, strview_t name) {
+    ASSERT(symtab);
+    uint32_t index = symtab->slots.data[find_slot(&symtab->symbols, &symtab->slots, name, strview_hash(name))];
+    return (index != invalid_index) ? &symtab->symbols.data[index] : 0;
+}
+
+
+const symbol_t *symtab_lookup(symtab_t *symtab, strview_t name) {
+    ASSERT(symtab);
+    uint32_t hash = strview_hash(name);
+    uint32_t index = symtab->slots.data[count_probes(symtab, find_slot(&symtab->symbols, &symtab->slots, name, hash), hash)];
+    return (index != invalid_index) ? &symtab->symbols.data[index] : 0;
+}
+
+
+static int compare_symbols(const void *a, const void *b) {
+    const symbol_t *sa = *(const symbol_ref_t *)a;
+    const symbol_t *sb = *(const symbol_ref_t *)b;
+    if (sa->value.type != sb->value.type) {
+        return (sa->value.type == baron_value_numeric) ? -1 : 1;
+    }
+    if (sa->value.type == baron_value_string) {
+        // Names are unique, so strings never tie
+        return strview_compare(sa->name, sb->name);
+    }
+    // NaN compares unequal to everything, so it's ordered explicitly, after every other number
+    bool is_a_nan = isnan(sa->value.number);
+    bool is_b_nan = isnan(sb->value.number);
+    if (is_a_nan != is_b_nan) {
+        return is_a_nan ? 1 : -1;
+    }
+    if (!is_a_nan && sa->value.number != sb->value.number) {
+        return (sa->value.number < sb->value.number) ? -1 : 1;
+    }
+    // Symbols are stored in definition order, so ties between numeric symbols keep that order
+    return (sa > sb) - (sa < sb);
+}
+
+
+static bool add_to_pool(array_uint8_t *pool, strview_t text, uint32_t *offset) {
+    static const uint8_t zero = 0;
+    *offset = pool->size;
+    return array_append(pool, ((slice_const_uint8_t){text.data, text.length})) && array_add(pool, zero);
+}
+
+
+bool symtab_write_binary(const symtab_t *symtab, const allocator_t *allocator, baron_write_fn_t write_fn, void *context) {
+    ASSERT(symtab);
+    ASSERT(write_fn);
+
+    array_symbol_ref_t sorted = make_array(symbol_ref_t, allocator, symtab->symbols.size + 1);
+    array_baron_symbol_record_t records = make_array(baron_symbol_record_t, allocator, symtab->symbols.size + 1);
+    array_uint8_t pool = make_array(uint8_t, allocator, 16 * symtab->symbols.size + 16);
+    array_uint32_t slots = {0};
+    bool success = array_is_valid(&sorted) && array_is_valid(&records) && array_is_valid(&pool);
+
+    // The symbols are sorted before their records are made, as string records are ordered by name, which isn't
+    // reachable from a record until the pool is complete
+    for (uint32_t i = 0; success && i < symtab->symbols.size; i++) {
+        const symbol_t *symbol = &symtab->symbols.data[i];
+        if (symbol->value.type == baron_value_numeric || symbol->value.type == baron_value_string) {
+            success = array_add(&sorted, symbol);
+        }
+    }
+    if (success) {
+        qsort(sorted.data, sorted.size, sizeof(symbol_ref_t), compare_symbols);
+    }
+
+    uint32_t num_numeric_symbols = 0;
+    for (uint32_t i = 0; success && i < sorted.size; i++) {
+        const symbol_t *symbol = sorted.data[i];
+        baron_symbol_record_t record = {
+            .name_length = symbol->name.length,
+            .type = symbol->value.type,
+            .hash = symbol->hash
+        };
+        success = add_to_pool(&pool, symbol->name, &record.name_offset);
+        if (symbol->value.type == baron_value_numeric) {
+            record.number = symbol->value.number;
+            num_numeric_symbols++;
+        }
+        else {
+            strview_t string = string_view(&symbol->value);
+            record.string_length = string.length;
+            success = success && add_to_pool(&pool, string, &record.string_offset);
+        }
+        success = success && array_add(&records, record);
+    }
+
+    uint32_t num_slots = 16;
+    while (success && num_slots < records.size * 2) {
+        num_slots *= 2;
+    }
+    if (success) {
+        slots = make_array(uint32_t, allocator, num_slots);
+        success = array_resize(&slots, num_slots);
+    }
+    if (success) {
+        memset(slots.data, 0xFF, num_slots * sizeof(uint32_t));
+        uint32_t mask = num_slots - 1;
+        for (uint32_t i = 0; i < records.size; i++) {
+            uint32_t slot = records.data[i].hash & mask;
+            while (slots.data[slot] != invalid_index) {
+                slot = (slot + 1) & mask;
+            }
+            slots.data[slot] = i;
+        }
+
+        baron_symbol_file_header_t header = {
+            .magic = BARON_SYMBOL_FILE_MAGIC,
+            .version = BARON_SYMBOL_FILE_VERSION,
+            .num_symbols = records.size,
+            .num_numeric_symbols = num_numeric_symbols,
+            .num_hash_slots = num_slots,
+            .records_offset = (uint32_t)sizeof header,
+            .hash_offset = (uint32_t)(sizeof header + records.size * sizeof(baron_symbol_record_t)),
+            .strings_size = pool.size
+        };
+        header.strings_offset = header.hash_offset + num_slots * (uint32_t)sizeof(uint32_t);
+        success = write_fn(&header, sizeof header, context) &&
+                  (records.size == 0 || write_fn(records.data, records.size * sizeof(baron_symbol_record_t), context)) &&
+                  write_fn(slots.data, num_slots * sizeof(uint32_t), context) &&
+                  (pool.size == 0 || write_fn(pool.data, pool.size, context));
+    }
+
+    array_deinit(&sorted);
+    array_deinit(&records);
+    array_deinit(&pool);
+    array_deinit(&slots);
+    return success;
+}
@@ -0,0 +1,122 @@
+/**
+ *  @file   symtab.h
+ *
+ *  The symbol table of an assembly.
+ *
+ *  Symbols are held in an array in the order they were first defined, indexed by an open addressed hash table of
+ *  symbol indices. Symbol names are copied into the table's own arena, so they need not outlive the source they were
+ *  defined in.
+ */
+
+#ifndef BARONLIB_SYMTAB_H_
+#define BARONLIB_SYMTAB_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "base/arena.h"
+#include "base/array.h"
+#include "base/str.h"
+#include "value.h"
+
+typedef struct symbol_t symbol_t;
+typedef struct symtab_t symtab_t;
+typedef struct allocator_t allocator_t;
+
+
+struct symbol_t {
+    strview_t name;                 // Scope qualified name, separated by periods
+    uint32_t hash;
+    value_t value;
+};
+
+def_slice(symbol_t);
+
+
+struct symtab_t {
+    const allocator_t *allocator;
+    array_symbol_t symbols;
+    array_uint32_t slots;           // Open addressed hash table of indices into symbols; a power of two in size
+    arena_t names;
+    uint64_t num_lookups;           // Lookups made by symtab_set and symtab_lookup
+    uint64_t num_probes;            // Slots examined by those lookups
+    uint32_t max_probe_length;
+};
+
+
+/**
+ *  Initialize an empty symbol table
+ *
+ *  @param  symtab          Pointer to the table to initialize
+ *  @param  allocator       Allocator used to hold the table
+ *
+ *  @return Success true/false
+ */
+bool symtab_init(symtab_t *symtab, const allocator_t *allocator);
+
+
+/**
+ *  Deinitialize a symbol table, releasing all the values it holds
+ *
+ *  @param  symtab          Pointer to the table to deinitialize
+ */
+void symtab_deinit(symtab_t *symtab);
+
+
+/**
+ *  Remove all symbols from a table, releasing their values but keeping its allocations for reuse
+ *
+ *  @param  symtab          Pointer to the table to reset
+ */
+void symtab_reset(symtab_t *symtab);
+
+
+/**
+ *  Set the value of a symbol, defining it if it doesn't already exist
+ *
+ *  @param  symtab          Pointer to the table
+ *  @param  name            Name of the symbol, which is copied
+ *  @param  value           New value; the table takes ownership of it, even on failure
+ *
+ *  @return Success true/false
+ */
+bool symtab_set(symtab_t *symtab, strview_t name, value_t value);
+
+
+/**
+ *  Find a symbol by name
+ *
+ *  @param  symtab          Pointer to the table
+ *  @param  name            Name of the symbol
+ *
+ *  @return Pointer to the symbol, valid until the next symbol is defined, or null if there is none with that name
+ */
+const symbol_t *symtab_find(const symtab_t *symtab, strview_t name);
+
+
+/**
+ *  Find a symbol by name, as symtab_find, counting the lookup in the table's statistics.
+ *  This is used during assembly; symtab_find is left for queries of a finished assembly, which may be concurrent.
+ *
+ *  @param  symtab          Pointer to the table
+ *  @param  name            Name of the symbol
+ *
+ *  @return Pointer to the symbol, valid until the next symbol is defined, or null if there is none with that name
+ */
+const symbol_t *symtab_lookup(symtab_t *symtab, strview_t name);
+
+
+/**
+ *  Write the numeric and string symbols in the binary format described by baron_symbol_file_header_t.
+ *  List symbols have no representation in the format, and are omitted.
+ *
+ *  @param  symtab          Pointer to the table
+ *  @param  allocator       Allocator used for the tables built while writing
+ *  @param  write_fn        Function called with successive blocks of the file; it returns false on failure
+ *  @param  context         Context passed to write_fn
+ *
+ *  @return Success true/false
+ */
+bool symtab_write_binary(const symtab_t *symtab, const allocator_t *allocator, baron_write_fn_t write_fn, void *context);
+
+
+#endif // ifndef BARONLIB_SYMTAB_H_
@@ -0,0 +1,337 @@
+#include <string.h>
+#include "base/allocator.h"
+#include "base/defines.h"
+#include "value.h"
+
+
+struct list_storage_t {
+    const allocator_t *allocator;
+    uint32_t refcount;
+    array_value_t items;
+};
+
+
+struct string_storage_t {
+    const allocator_t *allocator;
+    uint32_t refcount;
+    array_uint8_t bytes;
+};
+
+
+value_t make_list_value(const allocator_t *allocator, uint32_t capacity) {
+    list_storage_t *storage = allocator_alloc(allocator, sizeof(list_storage_t));
+    if (!storage) {
+        return (value_t){0};
+    }
+
+    *storage = (list_storage_t){
+        .allocator = allocator,
+        .refcount = 1,
+        .items = make_array(value_t, allocator, capacity)
+    };
+    if (!array_is_valid(&storage->items)) {
+        allocator_free(allocator, storage);
+        return (value_t){0};
+    }
+
+    return (value_t){
+        .type = baron_value_list,
+        .list = {storage, 0, 0}
+    };
+}
+
+
+static string_storage_t *make_string_storage(const allocator_t *allocator, uint32_t capacity) {
+    string_storage_t *storage = allocator_alloc(allocator, sizeof(string_storage_t));
+    if (!storage) {
+        return 0;
+    }
+
+    *storage = (string_storage_t){
+        .allocator = allocator,
+        .refcount = 1,
+        .bytes = make_array(uint8_t, allocator, capacity)
+    };
+    if (!array_is_valid(&storage->bytes)) {
+        allocator_free(allocator, storage);
+        return 0;
+    }
+
+    return storage;
+}
+
+
+static value_t make_small_string(strview_t text) {
+    ASSERT(text.length <= VALUE_SMALL_STRING_CAPACITY);
+    value_t value = {
+        .type = baron_value_string,
+        .is_small = true,
+        .small.length = (uint8_t)text.length
+    };
+    if (text.length > 0) {
+        memcpy(value.small.data, text.data, text.length);
+    }
+    return value;
+}
+
+
+value_t make_string_value(const allocator_t *allocator, strview_t text) {
+    ASSERT(strview_is_valid(text));
+    if (text.length <= VALUE_SMALL_STRING_CAPACITY) {
+        return make_small_string(text);
+    }
+
+    string_storage_t *storage = make_string_storage(allocator, text.length);
+    if (!storage) {
+        return (value_t){0};
+    }
+    memcpy(storage->bytes.data, text.data, text.length);
+    storage->bytes.size = text.length;
+
+    return (value_t){
+        .type = baron_value_string,
+        .string = {storage, 0, text.length}
+    };
+}
+
+
+value_t value_copy(const value_t *value) {
+    ASSERT(value);
+    if (value->type == baron_value_list) {
+        value->list.storage->refcount++;
+    }
+    else if (value->type == baron_value_string && !value->is_small) {
+        value->string.storage->refcount++;
+    }
+    return *value;
+}
+
+
+static void free_storage(list_storage_t *storage) {
+    for (uint32_t i = 0; i < storage->items.size; i++) {
+        value_release(&storage->items.data[i]);
+    }
+    array_deinit(&storage->items);
+    allocator_free(storage->allocator, storage);
+}
+
+
+static void free_string_storage(string_storage_t *storage) {
+    array_deinit(&storage->bytes);
+    allocator_free(storage->allocator, storage);
+}
+
+
+void value_release(value_t *value) {
+    ASSERT(value);
+    if (value->type == baron_value_list && --value->list.storage->refcount == 0) {
+        free_storage(value->list.storage);
+    }
+    else if (value->type == baron_value_string && !value->is_small && --value->string.storage->refcount == 0) {
+        free_string_storage(value->string.storage);
+    }
+    *value = (value_t){0};
+}
+
+
+const value_t *list_get(const value_t *list, uint32_t index) {
+    ASSERT(list && list->type == baron_value_list);
+    ASSERT(index < list->list.size);
+    return &list->list.storage->items.data[list->list.start + index];
+}
+
+
+slice_const_value_t list_items(const value_t *list) {
+    ASSERT(list && list->type == baron_value_list);
+    return (slice_const_value_t){list->list.storage->items.data + list->list.start, list->list.size};
+}
+
+
+value_t list_slice(const value_t *list, uint32_t start, uint32_t size) {
+    ASSERT(list && list->type == baron_value_list);
+    start = math_min_uint32(start, list->list.size);
+    size = math_min_uint32(size, list->list.size - start);
+    list->list.storage->refcount++;
+    return (value_t){
+        .type = baron_value_list,
+        .list = {list->list.storage, list->list.start + start, size}
+    };
+}
+
+
+/**
+ *  Ensure that a list is the sole owner of its storage, and views all of it, so that it can be modified in place.
+ *  Shared storage is copied; unshared storage has any items outside the view released and the rest moved down.
+ */
+static bool make_unique(value_t *list, uint32_t extra_capacity) {
+    list_t *view = &list->list;
+    list_storage_t *storage = view->storage;
+
+    if (storage->refcount == 1) {
+        array_value_t *items = &storage->items;
+        if (view->start != 0 || view->size != items->size) {
+            for (uint32_t i = 0; i < items->size; i++) {
+                if (i < view->start || i >= view->start + view->size) {
+                    value_release(&items->data[i]);
+                }
+            }
+            memmove(items->data, items->data + view->start, view->size * sizeof(value_t));
+            items->size = view->size;
+            view->start = 0;
+        }
+        return true;
+    }
+
+    value_t copy = make_list_value(storage->allocator, view->size + extra_capacity);
+    if (copy.type == baron_value_none) {
+        return false;
+    }
+    const value_t *src = storage->items.data + view->start;
+    for (uint32_t i = 0; i < view->size; i++) {
+        copy.list.storage->items.data[i] = value_copy(&src[i]);
+    }
+    copy.list.storage->items.size = view->size;
+    copy.list.size = view->size;
+
+    value_release(list);
+    *list = copy;
+    return true;
+}
+
+
+bool list_append(value_t *list, value_t item) {
+    ASSERT(list && list->type == baron_value_list);
+    if (!make_unique(list, 1) || !array_add(&list->list.storage->items, item)) {
+        value_release(&item);
+        return false;
+    }
+    list->list.size++;
+    return true;
+}
+
+
+bool list_set(value_t *list, uint32_t index, value_t item) {
+    ASSERT(list && list->type == baron_value_list);
+    ASSERT(index < list->list.size);
+    if (!make_unique(list, 0)) {
+        value_release(&item);
+        return false;
+    }
+    value_t *slot = &list->list.storage->items.data[index];
+    value_release(slot);
+    *slot = item;
+    return true;
+}
+
+
+bool list_concat(value_t *list, const value_t *other) {
+    ASSERT(list && list->type == baron_value_list);
+    ASSERT(other && other->type == baron_value_list);
+
+    // Holding a reference keeps the other list's items alive, even if it shares storage with the list being modified
+    value_t source = value_copy(other);
+    bool success = make_unique(list, source.list.size);
+    array_value_t *items = &list->list.storage->items;
+    uint32_t required = items->size + source.list.size;
+    if (success && required > array_capacity(items)) {
+        success = array_reserve(items, math_max_uint32(required, array_capacity(items) * 3 / 2));
+    }
+
+    if (success) {
+        slice_const_value_t append = list_items(&source);
+        for (uint32_t i = 0; i < append.size; i++) {
+            items->data[items->size++] = value_copy(&append.data[i]);
+        }
+        list->list.size = items->size;
+    }
+
+    value_release(&source);
+    return success;
+}
+
+
+strview_t string_view(const value_t *string) {
+    ASSERT(string && string->type == baron_value_string);
+    if (string->is_small) {
+        return (strview_t){string->small.data, string->small.length};
+    }
+    return (strview_t){string->string.storage->bytes.data + string->string.start, string->string.length};
+}
+
+
+value_t string_substr(const value_t *string, uint32_t start, uint32_t length) {
+    ASSERT(string && string->type == baron_value_string);
+    uint32_t string_len = string_length(string);
+    start = math_min_uint32(start, string_len);
+    length = math_min_uint32(length, string_len - start);
+
+    if (string->is_small) {
+        return make_small_string((strview_t){string->small.data + start, length});
+    }
+
+    string->string.storage->refcount++;
+    return (value_t){
+        .type = baron_value_string,
+        .string = {string->string.storage, string->string.start + start, length}
+    };
+}
+
+
+bool string_append(value_t *string, const allocator_t *allocator, strview_t text) {
+    ASSERT(string && string->type == baron_value_string);
+    ASSERT(strview_is_valid(text));
+    uint32_t length = string_length(string);
+    uint32_t required = length + text.length;
+    if (required < length) {
+        return false;
+    }
+
+    if (string->is_small && required <= VALUE_SMALL_STRING_CAPACITY) {
+        if (text.length > 0) {
+            memmove(string->small.data + length, text.data, text.length);
+        }
+        string->small.length = (uint8_t)required;
+        return true;
+    }
+
+    if (!string->is_small) {
+        string_t *view = &string->string;
+        array_uint8_t *bytes = &view->storage->bytes;
+        if (view->start + view->length == bytes->size) {
+            // Nothing beyond the view has been appended, so no other view can see the bytes written here.
+            // The text may be a view of this same storage, so find it again if growing moves it.
+            bool is_own_text = array_contains_slice(bytes, text);
+            uint32_t offset = is_own_text ? (uint32_t)(text.data - bytes->data) : 0;
+            uint32_t capacity = view->start + required;
+            if (capacity > array_capacity(bytes) &&
+                !array_reserve(bytes, math_max_uint32(capacity, array_capacity(bytes) * 2))) {
+                return false;
+            }
+            if (text.length > 0) {
+                memcpy(bytes->data + bytes->size, is_own_text ? bytes->data + offset : text.data, text.length);
+            }
+            bytes->size += text.length;
+            view->length = required;
+            return true;
+        }
+    }
+
+    // Otherwise move the string to new storage, with room for it to grow further
+    string_storage_t *storage = make_string_storage(allocator, math_max_uint32(required, required * 2));
+    if (!storage) {
+        return false;
+    }
+    strview_t current = string_view(string);
+    memcpy(storage->bytes.data, current.data, current.length);
+    if (text.length > 0) {
+        memcpy(storage->bytes.data + current.length, text.data, text.length);
+    }
+    storage->bytes.size = required;
+
+    value_release(string);
+    *string = (value_t){
+        .type = baron_value_string,
+        .string = {storage, 0, required}
+    };
+    return true;
+}
@@ -0,0 +1,225 @@
+/**
+ *  @file   value.h
+ *
+ *  Tagged values, as held by symbols and produced by expressions.
+ *
+ *  A list is a view onto a contiguous, reference-counted array of values. Copying a list, or taking a slice of one,
+ *  only creates another view and adds a reference, so both are O(1). Storage is only copied when a list whose storage
+ *  is shared (or which views only part of its storage) is modified, so a list which is never modified is never
+ *  copied, and a list which has a single owner is modified in place.
+ *
+ *  Short strings are held inline within the value, so making or copying one never allocates. Longer strings are views
+ *  onto a reference-counted byte buffer. Appending to a string whose view extends to the end of its buffer writes the
+ *  new bytes in place, growing the buffer by doubling, even if the buffer is shared: the other views only ever see the
+ *  bytes within their own extent, which are unaffected. This makes building a string by repeated appends linear
+ *  rather than quadratic, even when the intermediate strings are still referenced.
+ */
+
+#ifndef BARONLIB_VALUE_H_
+#define BARONLIB_VALUE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "base/array.h"
+#include "base/str.h"
+#include "baron/baron.h"
+
+typedef struct value_t value_t;
+typedef struct list_t list_t;
+typedef struct list_storage_t list_storage_t;
+typedef struct string_t string_t;
+typedef struct small_string_t small_string_t;
+typedef struct string_storage_t string_storage_t;
+typedef struct allocator_t allocator_t;
+
+
+struct list_t {
+    list_storage_t *storage;
+    uint32_t start;             // Index of the first item of the view within the storage
+    uint32_t size;              // Number of items in the view
+};
+
+
+// Maximum length of a string held inline within a value
+#define VALUE_SMALL_STRING_CAPACITY 15
+
+
+struct string_t {
+    string_storage_t *storage;
+    uint32_t start;             // Offset of the first byte of the view within the storage
+    uint32_t length;            // Number of bytes in the view
+};
+
+
+struct small_string_t {
+    uint8_t length;
+    uint8_t data[VALUE_SMALL_STRING_CAPACITY];
+};
+
+
+struct value_t {
+    baron_value_type_t type;
+    bool is_small;              // Strings only: whether the string is held inline
+    union {
+        double number;
+        string_t string;
+        small_string_t small;
+        list_t list;
+    };
+};
+
+def_slice(value_t);
+
+
+/**
+ *  Make a numeric value
+ */
+static inline value_t make_number_value(double number) {
+    return (value_t){.type = baron_value_numeric, .number = number};
+}
+
+
+/**
+ *  Make an empty list value
+ *
+ *  @param  allocator       Allocator used to hold the list's storage
+ *  @param  capacity        Number of items to reserve space for
+ *
+ *  @return The list, or a value of type baron_value_none if allocation failed
+ */
+value_t make_list_value(const allocator_t *allocator, uint32_t capacity);
+
+
+/**
+ *  Make a string value
+ *
+ *  @param  allocator       Allocator used to hold the string's storage, if it's too long to be held inline
+ *  @param  text            Contents of the string, which are copied
+ *
+ *  @return The string, or a value of type baron_value_none if allocation failed
+ */
+value_t make_string_value(const allocator_t *allocator, strview_t text);
+
+
+/**
+ *  Make another reference to a value.
+ *  Both the original and the copy must be released.
+ */
+value_t value_copy(const value_t *value);
+
+
+/**
+ *  Release a value, freeing a string's or list's storage once it has no more references.
+ *  The value is left as baron_value_none.
+ */
+void value_release(value_t *value);
+
+
+/**
+ *  Get the number of items in a list
+ */
+static inline uint32_t list_size(const value_t *list) {
+    return list->list.size;
+}
+
+
+/**
+ *  Get an item of a list.
+ *  The pointer is only valid until the list is next modified.
+ */
+const value_t *list_get(const value_t *list, uint32_t index);
+
+
+/**
+ *  Get the items of a list as a slice.
+ *  The slice is only valid until the list is next modified.
+ */
+slice_const_value_t list_items(const value_t *list);
+
+
+/**
+ *  Make a slice of a list, which shares its storage, in O(1)
+ *
+ *  @param  list            List to slice
+ *  @param  start           Index of the first item of the slice; clamped to the size of the list
+ *  @param  size            Number of items in the slice; clamped to the items available
+ *
+ *  @return The slice, which must be released
+ */
+value_t list_slice(const value_t *list, uint32_t start, uint32_t size);
+
+
+/**
+ *  Append an item to a list, copying the list's storage first if it's shared
+ *
+ *  @param  list            List to modify
+ *  @param  item            Item to append; the list takes ownership of it, even on failure
+ *
+ *  @return Success true/false
+ */
+bool list_append(value_t *list, value_t item);
+
+
+/**
+ *  Replace an item of a list, copying the list's storage first if it's shared
+ *
+ *  @param  list            List to modify
+ *  @param  index           Index of the item to replace
+ *  @param  item            New item; the list takes ownership of it, even on failure
+ *
+ *  @return Success true/false
+ */
+bool list_set(value_t *list, uint32_t index, value_t item);
+
+
+/**
+ *  Append the items of one list to another, copying the list's storage first if it's shared
+ *
+ *  @param  list            List to modify
+ *  @param  other           List whose items are appended. This may be the same list, or share its storage.
+ *
+ *  @return Success true/false
+ */
+bool list_concat(value_t *list, const value_t *other);
+
+
+/**
+ *  Get the number of bytes in a string
+ */
+static inline uint32_t string_length(const value_t *string) {
+    return string->is_small ? string->small.length : string->string.length;
+}
+
+
+/**
+ *  Get the contents of a string.
+ *  The view is only valid until the string is next modified or released.
+ */
+strview_t string_view(const value_t *string);
+
+
+/**
+ *  Make a substring of a string in O(1). A long string's substring shares its storage.
+ *
+ *  @param  string          String to take the substring of
+ *  @param  start           Offset of the first byte of the substring; clamped to the length of the string
+ *  @param  length          Number of bytes in the substring; clamped to the bytes available
+ *
+ *  @return The substring, which must be released
+ */
+value_t string_substr(const value_t *string, uint32_t start, uint32_t length);
+
+
+/**
+ *  Append text to a string, in place if the string's view extends to the end of its storage
+ *
+ *  @param  string          String to modify
+ *  @param  allocator       Allocator used if the string needs new storage
+ *  @param  text            Text to append. This may be a view of the string itself.
+ *
+ *  @return Success true/false. On failure the string is unchanged.
+ */
+bool string_append(value_t *string, const allocator_t *allocator, strview_t text);
+
+
+#endif // ifndef BARONLIB_VALUE_H_
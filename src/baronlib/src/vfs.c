@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <string.h>
+#include "base/allocator.h"
+#include "base/defines.h"
+#include "vfs.h"
+
+
+#define VFS_NAMES_REGION_SIZE 0x1000
+
+
+bool vfs_init(vfs_t *vfs, const allocator_t *allocator, const baron_file_system_t *file_system) {
+    ASSERT(vfs);
+    *vfs = (vfs_t){
+        .allocator = allocator,
+        .file_system = file_system ? *file_system : (baron_file_system_t){0},
+        .files = make_array(vfs_file_t, allocator, 8),
+        .names = make_arena(allocator, VFS_NAMES_REGION_SIZE)
+    };
+    return array_is_valid(&vfs->files);
+}
+
+
+void vfs_deinit(vfs_t *vfs) {
+    ASSERT(vfs);
+    if (array_is_valid(&vfs->files)) {
+        vfs_reset(vfs);
+    }
+    array_deinit(&vfs->files);
+    arena_deinit(&vfs->names);
+}
+
+
+static void release_file(vfs_t *vfs, const vfs_file_t *file) {
+    if (file->is_from_load_fn && vfs->file_system.release_fn) {
+        vfs->file_system.release_fn((const char *)file->name.data, file->loaded, vfs->file_system.context);
+    }
+    else if (file->is_from_disk) {
+        allocator_free(vfs->allocator, (void *)file->contents.data);
+    }
+}
+
+
+void vfs_reset(vfs_t *vfs) {
+    ASSERT(vfs);
+    for (uint32_t i = 0; i < vfs->files.size; i++) {
+        release_file(vfs, &vfs->files.data[i]);
+    }
+    array_reset(&vfs->files);
+    arena_reset(&vfs->names);
+}
+
+
+static bool read_from_disk(const allocator_t *allocator, const char *filename, strview_t *contents) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        return false;
+    }
+
+    long size = (fseek(file, 0, SEEK_END) == 0) ? ftell(file) : -1;
+    uint8_t *data = (size >= 0 && (unsigned long)size < UINT32_MAX && fseek(file, 0, SEEK_SET) == 0) ?
+        allocator_alloc(allocator, (uint32_t)size + 1) : 0;
+    bool success = data && fread(data, 1, (size_t)size, file) == (size_t)size;
+    fclose(file);
+
+    if (!success) {
+        allocator_free(allocator, data);
+        return false;
+    }
+    *contents = (strview_t){data, (uint32_t)size};
+    return true;
+}
+
+
+strview_t vfs_load(vfs_t *vfs, strview_t filename) {
+    ASSERT(vfs);
+    ASSERT(strview_is_valid(filename));
+
+    for (uint32_t i = 0; i < vfs->files.size; i++) {
+        if (strview_equal(vfs->files.data[i].name, filename)) {
+            return vfs->files.data[i].contents;
+        }
+    }
+
+    // Callbacks and fopen need a zero-terminated name; the arena's allocations are zeroed
+    uint8_t *name = arena_alloc(&vfs->names, filename.length + 1);
+    if (!name) {
+        return (strview_t){0};
+    }
+    memcpy(name, filename.data, filename.length);
+    vfs_file_t file = {.name = {name, filename.length}};
+
+    const baron_file_system_t *fs = &vfs->file_system;
+    bool is_found = false;
+    for (size_t i = 0; !is_found && i < fs->num_files; i++) {
+        const baron_memory_file_t *memory_file = &fs->files[i];
+        if (strview_equal(make_strview(memory_file->name), filename) && memory_file->size <= UINT32_MAX) {
+            file.contents = (strview_t){memory_file->data ? memory_file->data : "", (uint32_t)memory_file->size};
+            is_found = true;
+        }
+    }
+
+    baron_file_contents_t contents = {0};
+    if (!is_found && fs->load_fn && fs->load_fn((const char *)name, &contents, fs->context)) {
+        // As with memory files, contents too large to view can't be used, so they're handed straight back
+        if (contents.size > UINT32_MAX) {
+            if (fs->release_fn) {
+                fs->release_fn((const char *)name, contents, fs->context);
+            }
+        }
+        else {
+            // Empty contents may have no data, but must still be viewable, so the view may differ from what's released
+            file.contents = (strview_t){contents.data ? contents.data : "", (uint32_t)contents.size};
+            file.loaded = contents;
+            file.is_from_load_fn = true;
+            is_found = true;
+        }
+    }
+
+    if (!is_found && !fs->files && !fs->load_fn) {
+        is_found = read_from_disk(vfs->allocator, (const char *)name, &file.contents);
+        file.is_from_disk = is_found;
+    }
+
+    if (!is_found) {
+        return (strview_t){0};
+    }
+    if (!array_add(&vfs->files, file)) {
+        release_file(vfs, &file);
+        return (strview_t){0};
+    }
+    return file.contents;
+}
@@ -0,0 +1,81 @@
+/**
+ *  @file   vfs.h
+ *
+ *  Resolution of the files read by an assembly - the main source file, and those named by INCLUDE and INCBIN -
+ *  through the file system described by baron_file_system_t.
+ *
+ *  Each file is loaded the first time it's asked for and cached for the rest of the assembly, so a file which is
+ *  included many times, or on every pass, is only read once. Memory files and those supplied by a load function are
+ *  referenced where they are; only files read from disk are copied into memory owned by the vfs.
+ */
+
+#ifndef BARONLIB_VFS_H_
+#define BARONLIB_VFS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "base/arena.h"
+#include "base/array.h"
+#include "base/str.h"
+#include "baron/baron.h"
+
+typedef struct vfs_t vfs_t;
+typedef struct vfs_file_t vfs_file_t;
+typedef struct allocator_t allocator_t;
+
+
+struct vfs_file_t {
+    strview_t name;                 // Zero-terminated copy of the name the file was asked for by
+    strview_t contents;
+    baron_file_contents_t loaded;   // Exactly what the file system's load_fn gave, to be given back to its release_fn
+    bool is_from_load_fn;           // Whether the contents must be given back to the file system's release_fn
+    bool is_from_disk;              // Whether the contents were allocated by the vfs
+};
+
+def_slice(vfs_file_t);
+
+
+struct vfs_t {
+    const allocator_t *allocator;
+    baron_file_system_t file_system;
+    array_vfs_file_t files;
+    arena_t names;
+};
+
+
+/**
+ *  Initialize a vfs
+ *
+ *  @param  vfs             Pointer to the vfs to initialize
+ *  @param  allocator       Allocator used for the cache, and for the contents of files read from disk
+ *  @param  file_system     Description of the file system, or null to read every file from disk
+ *
+ *  @return Success true/false
+ */
+bool vfs_init(vfs_t *vfs, const allocator_t *allocator, const baron_file_system_t *file_system);
+
+
+/**
+ *  Deinitialize a vfs, releasing every file it has loaded
+ */
+void vfs_deinit(vfs_t *vfs);
+
+
+/**
+ *  Release every file a vfs has loaded, keeping its allocations for reuse
+ */
+void vfs_reset(vfs_t *vfs);
+
+
+/**
+ *  Get the contents of a file, loading it if it hasn't been asked for before
+ *
+ *  @param  vfs             Pointer to the vfs
+ *  @param  filename        Name of the file
+ *
+ *  @return The contents of the file, valid until the vfs is reset, or an invalid strview if it couldn't be loaded
+ */
+strview_t vfs_load(vfs_t *vfs, strview_t filename);
+
+
+#endif // ifndef BARONLIB_VFS_H_
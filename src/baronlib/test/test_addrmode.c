@@ -0,0 +1,38 @@
+#include "base/test.h"
+#include "base/allocator.h"
+#include "addrmode.h"
+
+static addr_mode_t classify(strview_t source, uint32_t *expression_size) {
+    array_token_t tokens = make_array(token_t, allocator_default(), 16);
+    lex(source, &tokens);
+    operand_t operand;
+    addr_mode_t mode = operand_parse((slice_const_token_t){tokens.data, tokens.size - 1}, &operand) ? operand.mode : addr_mode_count;
+    *expression_size = operand.expression.size;
+    array_deinit(&tokens);
+    return mode;
+}
+
+DEF_TEST(addrmode, classify) {
+    uint32_t size;
+    REQUIRE(classify(STRVIEW(""), &size),==,addr_mode_implied);
+    REQUIRE(classify(STRVIEW("A"), &size),==,addr_mode_accumulator);
+    REQUIRE(classify(STRVIEW("#lo(x+1)"), &size),==,addr_mode_immediate);
+    REQUIRE(size,==,6);
+    REQUIRE(classify(STRVIEW("&70"), &size),==,addr_mode_absolute);
+    REQUIRE(classify(STRVIEW("table,X"), &size),==,addr_mode_absolute_x);
+    REQUIRE(size,==,1);
+    REQUIRE(classify(STRVIEW("table+1,y"), &size),==,addr_mode_absolute_y);
+    REQUIRE(size,==,3);
+    REQUIRE(classify(STRVIEW("(vector)"), &size),==,addr_mode_indirect);
+    REQUIRE(classify(STRVIEW("(zp,X)"), &size),==,addr_mode_indirect_x);
+    REQUIRE(classify(STRVIEW("(zp),Y"), &size),==,addr_mode_indirect_y);
+    REQUIRE(size,==,1);
+    REQUIRE(classify(STRVIEW("(a+b)*2"), &size),==,addr_mode_absolute);
+    REQUIRE(size,==,7);
+    REQUIRE(classify(STRVIEW("(a+b)*2,X"), &size),==,addr_mode_absolute_x);
+    REQUIRE(classify(STRVIEW("#"), &size),==,addr_mode_count);
+    REQUIRE(classify(STRVIEW("()"), &size),==,addr_mode_count);
+
+    REQUIRE(addr_mode_zero_page_form(addr_mode_absolute_y),==,addr_mode_zero_page_y);
+    REQUIRE(addr_mode_zero_page_form(addr_mode_immediate),==,addr_mode_immediate);
+}
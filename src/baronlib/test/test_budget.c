@@ -0,0 +1,192 @@
+#include "base/test.h"
+#include "base/allocator.h"
+#include "assembly.h"
+#include "budget.h"
+#include "loop.h"
+
+static uint32_t resolve(strview_t name, void *context) {
+    UNUSED(name);
+    UNUSED(context);
+    return invalid_index;
+}
+
+static loop_result_t run_loop(strview_t source, budget_t *budget, uint32_t *size) {
+    array_token_t tokens = make_array(token_t, allocator_default(), 64);
+    array_uint8_t object_code = make_array(uint8_t, allocator_default(), 16);
+    double values[LOOP_MAX_DEPTH];
+    uint32_t pc = 0x1900;
+    loop_t loop;
+    lex(source, &tokens);
+    loop_result_t result = loop_compile(&loop, allocator_default(), (slice_const_token_t){tokens.data, tokens.size},
+                                        opcode_table(instruction_set_nmos), resolve, 0, 0);
+    if (!result.error) {
+        result = loop_run(&loop, values, &object_code, &pc, budget, 0);
+    }
+    *size = object_code.size;
+    loop_deinit(&loop);
+    array_deinit(&object_code);
+    array_deinit(&tokens);
+    return result;
+}
+
+static bool cancel_after_polls(void *context) {
+    uint32_t *polls_left = context;
+    return (*polls_left)-- == 0;
+}
+
+DEF_TEST(budget, step_limit) {
+    budget_t budget;
+    budget_init(&budget, &(baron_limits_t){.max_steps = 2500}, *allocator_default());
+    uint32_t size;
+    loop_result_t result = run_loop(STRVIEW("FOR i, 0, 999 : EQUB i AND &FF : EQUW i : NEXT"), &budget, &size);
+    REQUIRE_TRUE(result.error == 0);
+    REQUIRE(size,==,3000);
+
+    // Replicated iterations are charged too, so an invariant body can't escape the limit
+    result = run_loop(STRVIEW("FOR i, 0, 999 : NOP : NEXT"), &budget, &size);
+    REQUIRE_TRUE(result.error != 0);
+    REQUIRE(make_strview(result.error),==,STRVIEW("Too many statements executed"));
+    REQUIRE(budget.status,==,baron_status_step_limit);
+
+    // Once stopped, a budget stays stopped until it is reset
+    REQUIRE_FALSE(budget_step(&budget, 1));
+    budget_reset(&budget);
+    result = run_loop(STRVIEW("FOR i, 0, 9 : FOR j, 0, 9 : EQUB i * 10 + j : NEXT : NEXT"), &budget, &size);
+    REQUIRE_TRUE(result.error == 0);
+    REQUIRE(size,==,100);
+}
+
+DEF_TEST(budget, cancel) {
+    uint32_t polls_left = 2;
+    budget_t budget;
+    budget_init(&budget, &(baron_limits_t){.cancel_fn = cancel_after_polls, .cancel_context = &polls_left}, *allocator_default());
+    uint32_t size;
+    loop_result_t result = run_loop(STRVIEW("FOR i, 0, &FFFF : EQUB i AND &FF : NEXT"), &budget, &size);
+    REQUIRE_TRUE(result.error != 0);
+    REQUIRE(budget.status,==,baron_status_cancelled);
+
+    // The cancel function is only polled every BUDGET_POLL_INTERVAL steps
+    REQUIRE(size,==,3 * BUDGET_POLL_INTERVAL - 1);
+}
+
+DEF_TEST(budget, macro_depth) {
+    budget_t budget;
+    budget_init(&budget, &(baron_limits_t){.max_macro_depth = 2}, *allocator_default());
+    REQUIRE_TRUE(budget_enter_macro(&budget));
+    REQUIRE_TRUE(budget_enter_macro(&budget));
+    budget_leave_macro(&budget);
+    REQUIRE_TRUE(budget_enter_macro(&budget));
+    REQUIRE_FALSE(budget_enter_macro(&budget));
+    REQUIRE(budget.status,==,baron_status_macro_depth_limit);
+    REQUIRE(make_strview(budget_error(&budget)),==,STRVIEW("Macros nested too deeply"));
+}
+
+DEF_TEST(budget, memory_limit) {
+    baron_desc_t desc = {.limits.max_memory = 0x40000};
+    baron_assembly_t *assembly = assembly_create(&desc);
+    REQUIRE_TRUE(assembly);
+
+    array_uint8_t *object_code = &assembly->overlays.data[0].object_code;
+    bool success = true;
+    for (uint32_t i = 0; success && i < 0x40000; i++) {
+        success = array_add(object_code, (uint8_t)i);
+    }
+    REQUIRE_FALSE(success);
+    REQUIRE_FALSE(assembly_finish(assembly));
+    REQUIRE(baron_assembly_status(assembly),==,baron_status_memory_limit);
+
+    // Resetting the assembly restores its budget
+    assembly_reset(assembly);
+    REQUIRE_TRUE(array_resize(object_code, 0x1000));
+    REQUIRE_TRUE(assembly_finish(assembly));
+    REQUIRE(baron_assembly_status(assembly),==,baron_status_ok);
+    assembly_destroy(assembly);
+
+    // Too small a limit to create the assembly at all
+    desc.limits.max_memory = 256;
+    REQUIRE_FALSE(assembly_create(&desc));
+}
+
+DEF_TEST(budget, live_bytes) {
+    budget_t budget;
+    budget_init(&budget, &(baron_limits_t){.max_memory = 1000}, *allocator_default());
+    allocator_t allocator = budget_allocator(&budget);
+
+    // Freed bytes no longer count against the limit, and a resized block only counts at its new size
+    void *a = allocator_alloc(&allocator, 600);
+    REQUIRE_TRUE(a != 0);
+    allocator_free(&allocator, a);
+    REQUIRE(budget.tracker.totals.live_bytes,==,0);
+    a = allocator_alloc(&allocator, 600);
+    REQUIRE_TRUE(a != 0);
+    a = allocator_realloc(&allocator, a, 900);
+    REQUIRE_TRUE(a != 0);
+    REQUIRE(budget.tracker.totals.live_bytes,==,900);
+    void *b = allocator_alloc(&allocator, 200);
+    REQUIRE_TRUE(b == 0);
+    REQUIRE(budget.status,==,baron_status_memory_limit);
+
+    // Memory kept across a reset still counts
+    budget_reset(&budget);
+    REQUIRE(budget.tracker.totals.live_bytes,==,900);
+    REQUIRE_TRUE(allocator_alloc(&allocator, 200) == 0);
+    budget_reset(&budget);
+    a = allocator_realloc(&allocator, a, 100);
+    REQUIRE_TRUE(a != 0);
+    b = allocator_alloc(&allocator, 900);
+    REQUIRE_TRUE(b != 0);
+    REQUIRE(budget.tracker.totals.live_bytes,==,1000);
+    REQUIRE(budget.status,==,baron_status_ok);
+
+    allocator_free(&allocator, a);
+    allocator_free(&allocator, b);
+    REQUIRE(budget.tracker.totals.live_bytes,==,0);
+}
+
+DEF_TEST(budget, reset_assembly) {
+    baron_desc_t desc = {.limits.max_memory = 0x100000};
+    baron_assembly_t *assembly = assembly_create(&desc);
+    REQUIRE_TRUE(assembly);
+
+    // A reset assembly keeps its allocations, which stay counted, so repeated assemblies use no more memory
+    uint64_t live_bytes = 0;
+    for (int i = 0; i < 4; i++) {
+        REQUIRE_TRUE(array_resize(&assembly->overlays.data[0].object_code, 0x8000));
+        REQUIRE_TRUE(symtab_set(&assembly->symbols, STRVIEW("start"), make_number_value(0x1900)));
+        REQUIRE_TRUE(assembly_finish(assembly));
+        assembly_reset(assembly);
+        REQUIRE(assembly->budget.tracker.totals.live_bytes,>=,0x8000);
+        if (i > 0) {
+            REQUIRE(assembly->budget.tracker.totals.live_bytes,==,live_bytes);
+        }
+        live_bytes = assembly->budget.tracker.totals.live_bytes;
+    }
+
+    assembly_destroy(assembly);
+}
+
+DEF_TEST(budget, assembly_status) {
+    static const baron_memory_file_t file = {"main.6502", "NOP\n", 4};
+    baron_desc_t desc = {.file_system = {.files = &file, .num_files = 1}};
+
+    // With only just enough memory to create it, the assembly is returned, stopped by the limit
+    baron_assembly_t *assembly = 0;
+    for (desc.limits.max_memory = 256; !assembly; desc.limits.max_memory += 256) {
+        assembly = baron_assemble_from_file(&desc, "main.6502");
+    }
+    REQUIRE(baron_assembly_status(assembly),==,baron_status_memory_limit);
+    baron_assembly_destroy(assembly);
+
+    // Without the limit, it fails only because statements can't yet be assembled
+    desc.limits.max_memory = 0;
+    assembly = baron_assemble_from_file(&desc, "main.6502");
+    REQUIRE_TRUE(assembly != 0);
+    REQUIRE(baron_assembly_status(assembly),==,baron_status_error);
+    REQUIRE(make_strview(baron_assembly_errors(assembly)),==,STRVIEW("Error: Statements cannot yet be assembled\n"));
+    baron_assembly_destroy(assembly);
+
+    assembly = baron_assemble(&desc, "NOP\n");
+    REQUIRE_TRUE(assembly != 0);
+    REQUIRE(baron_assembly_status(assembly),==,baron_status_error);
+    baron_assembly_destroy(assembly);
+}
@@ -0,0 +1,141 @@
+#include <string.h>
+#include "base/test.h"
+#include "base/allocator.h"
+#include "base/tracker.h"
+#include "assembly.h"
+
+typedef struct loader_t loader_t;
+
+struct loader_t {
+    uint32_t num_loads;
+    uint32_t num_releases;
+};
+
+static bool load_file(const char *filename, baron_file_contents_t *contents, void *context) {
+    loader_t *loader = context;
+    if (strcmp(filename, "main.6502") != 0) {
+        return false;
+    }
+    loader->num_loads++;
+    static const char text[] = "ORG &1900\n.start RTS\n";
+    *contents = (baron_file_contents_t){text, sizeof text - 1};
+    return true;
+}
+
+static void release_file(const char *filename, baron_file_contents_t contents, void *context) {
+    UNUSED(filename);
+    UNUSED(contents);
+    loader_t *loader = context;
+    loader->num_releases++;
+}
+
+static void assemble_overlapping_overlays(baron_assembly_t *assembly) {
+    uint32_t code = assembly_add_overlay(assembly, STRVIEW("code"));
+    uint32_t loader = assembly_add_overlay(assembly, STRVIEW("loader"));
+    array_resize(&assembly->overlays.data[code].object_code, 0x200);
+    array_resize(&assembly->overlays.data[loader].object_code, 0x100);
+    assembly_save_overlay(assembly, code, 0x1900, 0x1900);
+    assembly_save_overlay(assembly, loader, 0x1A80, 0x1A80);
+    symtab_set(&assembly->symbols, STRVIEW("start"), make_number_value(0x1900));
+    log_write(&assembly->log, 1, log_message_text, 0, STRVIEW("assembled"));
+    assembly_finish(assembly);
+}
+
+DEF_TEST(context, create_and_destroy) {
+    baron_context_destroy(0);
+
+    tracker_t tracker;
+    tracker_init(&tracker, allocator_default());
+    allocator_t tracking_allocator = tracker_allocator(&tracker);
+    baron_allocator_t allocator = make_baron_allocator(&tracking_allocator);
+    baron_desc_t desc = {.allocator = &allocator};
+
+    baron_context_t *context = baron_context_create(&desc);
+    REQUIRE_TRUE(context != 0);
+    REQUIRE(tracker.totals.live_blocks,>,0);
+    baron_context_destroy(context);
+    REQUIRE(tracker.totals.live_blocks,==,0);
+
+    context = baron_context_create(0);
+    REQUIRE_TRUE(context != 0);
+    baron_context_destroy(context);
+}
+
+DEF_TEST(context, assemble) {
+    tracker_t tracker;
+    tracker_init(&tracker, allocator_default());
+    allocator_t tracking_allocator = tracker_allocator(&tracker);
+    baron_allocator_t allocator = make_baron_allocator(&tracking_allocator);
+    loader_t loader = {0};
+    baron_desc_t desc = {
+        .allocator = &allocator,
+        .file_system = {.load_fn = load_file, .release_fn = release_file, .context = &loader}
+    };
+    baron_context_t *context = baron_context_create(&desc);
+    REQUIRE_TRUE(context != 0);
+
+    // Statements can't be assembled yet, so every assembly fails, but is still returned with its errors
+    const baron_assembly_t *assembly = baron_context_assemble(context, "ORG &1900\n");
+    REQUIRE_TRUE(assembly != 0);
+    REQUIRE(baron_assembly_status(assembly),==,baron_status_error);
+    REQUIRE(make_strview(baron_assembly_errors(assembly)),==,STRVIEW("Error: Statements cannot yet be assembled\n"));
+    uint64_t before = tracker.totals.num_allocs;
+    REQUIRE_TRUE(baron_context_assemble_from_file(context, "main.6502") == assembly);
+    uint64_t first_allocs = tracker.totals.num_allocs - before;
+    REQUIRE(loader.num_loads,==,1);
+
+    // What an assembly holds stays valid until the context is next used, when it is released
+    REQUIRE(loader.num_releases,==,0);
+    REQUIRE(make_strview(baron_assembly_errors(assembly)),==,STRVIEW("Error: Statements cannot yet be assembled\n"));
+    REQUIRE_TRUE(baron_context_assemble_from_file(context, "missing.6502") == assembly);
+    REQUIRE(baron_assembly_status(assembly),==,baron_status_error);
+    REQUIRE(make_strview(baron_assembly_errors(assembly)),==,STRVIEW("Error: Unable to read file 'missing.6502'\n"));
+    REQUIRE(loader.num_releases,==,1);
+    REQUIRE(loader.num_loads,==,1);
+
+    // Using the context again reuses the allocations it kept
+    before = tracker.totals.num_allocs;
+    REQUIRE_TRUE(baron_context_assemble_from_file(context, "main.6502") == assembly);
+    REQUIRE(loader.num_loads,==,2);
+    REQUIRE(tracker.totals.num_allocs - before,<,first_allocs);
+
+    baron_context_destroy(context);
+    REQUIRE(loader.num_releases,==,2);
+    REQUIRE(tracker.totals.live_blocks,==,0);
+}
+
+DEF_TEST(context, assembly_reset) {
+    tracker_t tracker;
+    tracker_init(&tracker, allocator_default());
+    allocator_t tracking_allocator = tracker_allocator(&tracker);
+    baron_allocator_t allocator = make_baron_allocator(&tracking_allocator);
+    baron_desc_t desc = {.allocator = &allocator};
+    baron_assembly_t *assembly = assembly_create(&desc);
+    REQUIRE_TRUE(assembly != 0);
+
+    uint64_t before = tracker.totals.num_allocs + tracker.totals.num_reallocs;
+    assemble_overlapping_overlays(assembly);
+    uint64_t first_allocations = tracker.totals.num_allocs + tracker.totals.num_reallocs - before;
+    const char *errors = "Warning: saved overlays 'code' and 'loader' overlap at &1A80-&1AFF\n";
+    REQUIRE(make_strview(baron_assembly_errors(assembly)),==,make_strview(errors));
+    REQUIRE(make_strview(baron_assembly_log(assembly, 1)),==,STRVIEW("assembled\n"));
+
+    assembly_reset(assembly);
+    REQUIRE(assembly->overlays.size,==,1);
+    REQUIRE(assembly->overlays.data[0].object_code.size,==,0);
+    REQUIRE(assembly->memmap.regions.size,==,0);
+    REQUIRE(assembly->symbols.symbols.size,==,0);
+    REQUIRE(log_num_records(&assembly->log, LOG_CHANNEL_ERRORS),==,0);
+    REQUIRE(make_strview(baron_assembly_errors(assembly)),==,STRVIEW(""));
+    REQUIRE(make_strview(baron_assembly_memory_map(assembly)),==,STRVIEW(""));
+
+    // The same assembly again gives the same results, reusing most of the first one's allocations
+    before = tracker.totals.num_allocs + tracker.totals.num_reallocs;
+    assemble_overlapping_overlays(assembly);
+    REQUIRE(tracker.totals.num_allocs + tracker.totals.num_reallocs - before,<,first_allocations);
+    REQUIRE(make_strview(baron_assembly_errors(assembly)),==,make_strview(errors));
+    REQUIRE(make_strview(baron_assembly_log(assembly, 1)),==,STRVIEW("assembled\n"));
+    REQUIRE(baron_assembly_symbol_type(assembly, "start"),==,baron_value_numeric);
+
+    baron_assembly_destroy(assembly);
+}
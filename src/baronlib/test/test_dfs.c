@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <string.h>
+#include "base/test.h"
+#include "base/allocator.h"
+#include "base/array.h"
+#include "baron/baron.h"
+
+
+static bool write_to_array(const void *data, size_t size, void *context) {
+    array_uint8_t *image = context;
+    return array_append(image, ((slice_const_uint8_t){data, (uint32_t)size}));
+}
+
+
+static uint8_t code1[600];
+static uint8_t code2[10];
+
+
+DEF_TEST(dfs, single_sided) {
+    for (uint32_t i = 0; i < sizeof code1; i++) {
+        code1[i] = (uint8_t)(i + 1);
+    }
+    memset(code2, 0xEA, sizeof code2);
+
+    baron_disk_file_t files[] = {
+        {.name = "CODE", .load_address = 0x1900, .exec_address = 0x1903, .object_code = {code1, sizeof code1}},
+        {.name = "B.DATA", .load_address = 0xFF3000, .exec_address = 0xFF3000, .object_code = {code2, sizeof code2}, .locked = true}
+    };
+
+    baron_disk_image_desc_t desc = {
+        .title = "Release disk1",
+        .boot_option = 3,
+        .files = files,
+        .num_files = 2
+    };
+
+    array_uint8_t image = make_array(uint8_t, allocator_default(), 1024);
+    REQUIRE(baron_disk_image_write(&desc, write_to_array, &image),==,baron_disk_image_ok);
+    REQUIRE(image.size,==,80 * 10 * 256);
+
+    // Title split across both catalogue sectors, truncated to 12 chars
+    REQUIRE(((strview_t){image.data, 8}),==,STRVIEW("Release "));
+    REQUIRE(((strview_t){image.data + 0x100, 4}),==,STRVIEW("disk"));
+
+    REQUIRE(image.data[0x105],==,16);
+    REQUIRE(image.data[0x106],==,0x33);
+    REQUIRE(image.data[0x107],==,0x20);
+
+    // Entries are in descending order of start sector
+    REQUIRE(((strview_t){image.data + 0x08, 7}),==,STRVIEW("DATA   "));
+    REQUIRE(image.data[0x0F],==,'B' | 0x80);
+    REQUIRE(((strview_t){image.data + 0x10, 7}),==,STRVIEW("CODE   "));
+    REQUIRE(image.data[0x17],==,'$');
+
+    REQUIRE(image.data[0x110],==,0x00);
+    REQUIRE(image.data[0x111],==,0x19);
+    REQUIRE(image.data[0x112],==,0x03);
+    REQUIRE(image.data[0x113],==,0x19);
+    REQUIRE(image.data[0x114],==,0x58);
+    REQUIRE(image.data[0x115],==,0x02);
+    REQUIRE(image.data[0x116],==,0x00);
+    REQUIRE(image.data[0x117],==,2);
+
+    REQUIRE(image.data[0x10E],==,0xCC);
+    REQUIRE(image.data[0x10F],==,5);
+
+    REQUIRE(image.data[0x200],==,1);
+    REQUIRE(image.data[0x200 + 599],==,(uint8_t)600);
+    REQUIRE(image.data[0x200 + 600],==,0);
+    REQUIRE(image.data[0x500],==,0xEA);
+    REQUIRE(image.data[0x509],==,0xEA);
+    REQUIRE(image.data[0x50A],==,0);
+
+    array_deinit(&image);
+}
+
+
+DEF_TEST(dfs, double_sided) {
+    memset(code1, 0x11, sizeof code1);
+    memset(code2, 0x22, sizeof code2);
+
+    baron_disk_file_t files[] = {
+        {.name = "ONE", .object_code = {code1, sizeof code1}, .side = 0},
+        {.name = "TWO", .object_code = {code2, sizeof code2}, .side = 1}
+    };
+
+    baron_disk_image_desc_t desc = {
+        .title = "Two",
+        .num_tracks = 40,
+        .double_sided = true,
+        .files = files,
+        .num_files = 2
+    };
+
+    array_uint8_t image = make_array(uint8_t, allocator_default(), 1024);
+    REQUIRE(baron_disk_image_write(&desc, write_to_array, &image),==,baron_disk_image_ok);
+    REQUIRE(image.size,==,2 * 40 * 10 * 256);
+
+    // Tracks are interleaved: side 0 track 0, side 1 track 0, side 0 track 1...
+    REQUIRE(((strview_t){image.data + 0x08, 7}),==,STRVIEW("ONE    "));
+    REQUIRE(((strview_t){image.data + 0xA08, 7}),==,STRVIEW("TWO    "));
+    REQUIRE(image.data[0x107],==,(uint8_t)400);
+    REQUIRE(image.data[0x200],==,0x11);
+    REQUIRE(image.data[0x200 + 599],==,0x11);
+    REQUIRE(image.data[0xA00 + 0x200],==,0x22);
+    REQUIRE(image.data[0xA00 + 0x20A],==,0);
+
+    array_deinit(&image);
+}
+
+
+DEF_TEST(dfs, errors) {
+    baron_disk_file_t files[32] = {0};
+    for (int i = 0; i < 32; i++) {
+        files[i].name[0] = (char)('A' + i % 26);
+        files[i].name[1] = (char)('0' + i / 26);
+    }
+
+    baron_disk_image_desc_t desc = {.files = files, .num_files = 32};
+    array_uint8_t image = make_array(uint8_t, allocator_default(), 1024);
+    REQUIRE(baron_disk_image_write(&desc, write_to_array, &image),==,baron_disk_image_too_many_files);
+
+    desc.num_files = 1;
+    strcpy(files[0].name, "TOOLONGNAME");
+    REQUIRE(baron_disk_image_write(&desc, write_to_array, &image),==,baron_disk_image_invalid_filename);
+
+    static uint8_t big[200 * 1024];
+    strcpy(files[0].name, "BIG");
+    files[0].object_code = (baron_object_code_t){big, sizeof big};
+    REQUIRE(baron_disk_image_write(&desc, write_to_array, &image),==,baron_disk_image_disk_full);
+
+    files[0].side = 1;
+    REQUIRE(baron_disk_image_write(&desc, write_to_array, &image),==,baron_disk_image_invalid_desc);
+
+    REQUIRE(image.size,==,0);
+    array_deinit(&image);
+}
+
+
+DEF_TEST(dfs, save) {
+    const char *filename = "dfs_test.tmp";
+    FILE *file = fopen(filename, "wb");
+    REQUIRE_TRUE(file != 0);
+    fputs("existing", file);
+    fclose(file);
+
+    // An invalid description is rejected before the file is opened, so the existing image survives
+    baron_disk_file_t files[1] = {{.name = "!BOOT", .side = 1}};
+    baron_disk_image_desc_t desc = {.files = files, .num_files = 1};
+    REQUIRE(baron_disk_image_save(&desc, filename),==,baron_disk_image_invalid_desc);
+    char contents[16] = {0};
+    file = fopen(filename, "rb");
+    REQUIRE_TRUE(file != 0);
+    REQUIRE(fread(contents, 1, sizeof contents, file),==,8);
+    fclose(file);
+    REQUIRE(make_strview(contents),==,STRVIEW("existing"));
+
+    files[0].side = 0;
+    REQUIRE(baron_disk_image_save(&desc, filename),==,baron_disk_image_ok);
+    file = fopen(filename, "rb");
+    REQUIRE_TRUE(file != 0);
+    REQUIRE(fseek(file, 0, SEEK_END),==,0);
+    REQUIRE(ftell(file),==,80 * 10 * 256);
+    fclose(file);
+    remove(filename);
+}
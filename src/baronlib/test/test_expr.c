@@ -0,0 +1,103 @@
+#include <math.h>
+#include "base/test.h"
+#include "base/allocator.h"
+#include "expr.h"
+
+static uint32_t resolve(strview_t name, void *context) {
+    UNUSED(context);
+    if (strview_equal(name, STRVIEW("x"))) {
+        return 0;
+    }
+    if (strview_equal(name, STRVIEW("y"))) {
+        return 1;
+    }
+    return invalid_index;
+}
+
+static const char *evaluate(strview_t source, double *value) {
+    static const double values[] = {3, 10};
+    array_token_t tokens = make_array(token_t, allocator_default(), 16);
+    lex(source, &tokens);
+    expr_t expr;
+    const char *error = expr_compile(&expr, allocator_default(), (slice_const_token_t){tokens.data, tokens.size - 1}, resolve, 0);
+    if (!error) {
+        error = expr_evaluate(&expr, values, value);
+    }
+    expr_deinit(&expr);
+    array_deinit(&tokens);
+    return error;
+}
+
+DEF_TEST(expr, evaluate) {
+    double value;
+    REQUIRE_TRUE(evaluate(STRVIEW("1+2*3"), &value) == 0);
+    REQUIRE(value,==,7);
+    REQUIRE_TRUE(evaluate(STRVIEW("(1+2)*3"), &value) == 0);
+    REQUIRE(value,==,9);
+    REQUIRE_TRUE(evaluate(STRVIEW("2^3^2"), &value) == 0);
+    REQUIRE(value,==,512);
+    REQUIRE_TRUE(evaluate(STRVIEW("10-4-3"), &value) == 0);
+    REQUIRE(value,==,3);
+    REQUIRE_TRUE(evaluate(STRVIEW("-x+y"), &value) == 0);
+    REQUIRE(value,==,7);
+    REQUIRE_TRUE(evaluate(STRVIEW("LO(&1234) + HI(&1234)"), &value) == 0);
+    REQUIRE(value,==,0x34 + 0x12);
+    REQUIRE_TRUE(evaluate(STRVIEW("y DIV x"), &value) == 0);
+    REQUIRE(value,==,3);
+    REQUIRE_TRUE(evaluate(STRVIEW("-7 MOD 2"), &value) == 0);
+    REQUIRE(value,==,-1);
+    REQUIRE_TRUE(evaluate(STRVIEW("&F0 AND &3C OR 1"), &value) == 0);
+    REQUIRE(value,==,0x31);
+    REQUIRE_TRUE(evaluate(STRVIEW("1 << 4 = 16"), &value) == 0);
+    REQUIRE(value,==,-1);
+    REQUIRE_TRUE(evaluate(STRVIEW("NOT 0"), &value) == 0);
+    REQUIRE(value,==,-1);
+    REQUIRE_TRUE(evaluate(STRVIEW("INT(-1.5)"), &value) == 0);
+    REQUIRE(value,==,-2);
+    REQUIRE_TRUE(evaluate(STRVIEW("SIN(PI/2)"), &value) == 0);
+    REQUIRE(fabs(value - 1),<,1e-12);
+}
+
+DEF_TEST(expr, errors) {
+    double value;
+    REQUIRE_TRUE(evaluate(STRVIEW("1/0"), &value) != 0);
+    REQUIRE_TRUE(evaluate(STRVIEW("x MOD 0"), &value) != 0);
+    REQUIRE_TRUE(evaluate(STRVIEW("z"), &value) != 0);
+    REQUIRE_TRUE(evaluate(STRVIEW("(1+2"), &value) != 0);
+    REQUIRE_TRUE(evaluate(STRVIEW("1 2"), &value) != 0);
+    REQUIRE_TRUE(evaluate(STRVIEW(""), &value) != 0);
+    REQUIRE_TRUE(evaluate(STRVIEW("SQR(-1)"), &value) != 0);
+    REQUIRE_TRUE(evaluate(STRVIEW("&100000000 AND 1"), &value) != 0);
+    REQUIRE_TRUE(evaluate(STRVIEW("((((((((((((((((((((((((((((((((((((((((((((((((((((((((((((((((((1))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))))"), &value) != 0);
+}
+
+DEF_TEST(expr, specialize) {
+    array_token_t tokens = make_array(token_t, allocator_default(), 16);
+    lex(STRVIEW("SIN(x * 2) * 100 + y"), &tokens);
+    expr_t expr;
+    expr_t specialized = {make_array(expr_op_t, allocator_default(), 4)};
+    REQUIRE_TRUE(expr_compile(&expr, allocator_default(), (slice_const_token_t){tokens.data, tokens.size - 1}, resolve, 0) == 0);
+    REQUIRE_TRUE(expr_depends_on(&expr, 1));
+    REQUIRE_FALSE(expr_depends_on(&expr, 2));
+
+    // With y varying, SIN(x * 2) * 100 folds into a single constant
+    double values[] = {3, 10};
+    REQUIRE_TRUE(expr_specialize(&expr, values, 1, &specialized));
+    REQUIRE(specialized.ops.size,==,3);
+    double value;
+    REQUIRE_TRUE(expr_evaluate(&specialized, values, &value) == 0);
+    REQUIRE(value,==,sin(6.0) * 100 + 10);
+
+    // With nothing varying, the whole expression folds
+    REQUIRE_TRUE(expr_specialize(&expr, values, 2, &specialized));
+    REQUIRE_TRUE(expr_is_constant(&specialized, &value));
+    REQUIRE(value,==,sin(6.0) * 100 + 10);
+
+    // With x varying, nothing folds
+    REQUIRE_TRUE(expr_specialize(&expr, values, 0, &specialized));
+    REQUIRE(specialized.ops.size,==,expr.ops.size);
+
+    expr_deinit(&specialized);
+    expr_deinit(&expr);
+    array_deinit(&tokens);
+}
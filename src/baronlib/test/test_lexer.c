@@ -0,0 +1,58 @@
+#include "base/test.h"
+#include "base/allocator.h"
+#include "lexer.h"
+
+DEF_TEST(lexer, tokens) {
+    array_token_t tokens = make_array(token_t, allocator_default(), 16);
+    lex_result_t result = lex(STRVIEW(".loop LDA &70,X:STA $2000 ; comment\n  x = %101 + 1.5E1 <= \"say \"\"hi\"\"\""), &tokens);
+    REQUIRE_TRUE(result.error == 0);
+    REQUIRE(tokens.size,==,18);
+
+    REQUIRE(tokens.data[0].type,==,token_symbol);
+    REQUIRE(tokens.data[0].text,==,STRVIEW("."));
+    REQUIRE(tokens.data[1].type,==,token_identifier);
+    REQUIRE(tokens.data[1].text,==,STRVIEW("loop"));
+    REQUIRE(tokens.data[2].text,==,STRVIEW("LDA"));
+    REQUIRE(tokens.data[3].type,==,token_number);
+    REQUIRE(tokens.data[3].number,==,112.0);
+    REQUIRE(tokens.data[4].text,==,STRVIEW(","));
+    REQUIRE(tokens.data[5].text,==,STRVIEW("X"));
+    REQUIRE(tokens.data[6].type,==,token_end_of_statement);
+    REQUIRE(tokens.data[8].number,==,8192.0);
+    REQUIRE(tokens.data[9].type,==,token_end_of_statement);
+    REQUIRE(tokens.data[10].line,==,2);
+    REQUIRE(tokens.data[11].text,==,STRVIEW("="));
+    REQUIRE(tokens.data[12].number,==,5.0);
+    REQUIRE(tokens.data[14].number,==,15.0);
+    REQUIRE(tokens.data[15].text,==,STRVIEW("<="));
+    REQUIRE(tokens.data[16].type,==,token_string);
+    REQUIRE(tokens.data[16].text,==,STRVIEW("say \"\"hi\"\""));
+    REQUIRE(tokens.data[17].type,==,token_end_of_file);
+
+    REQUIRE_TRUE(token_is_keyword(&tokens.data[2], STRVIEW("LDA")));
+    REQUIRE_TRUE(token_is_keyword(&tokens.data[1], STRVIEW("LOOP")));
+    REQUIRE_FALSE(token_is_keyword(&tokens.data[1], STRVIEW("LOO")));
+    REQUIRE_FALSE(token_is_keyword(&tokens.data[0], STRVIEW(".")));
+
+    array_deinit(&tokens);
+}
+
+DEF_TEST(lexer, errors) {
+    array_token_t tokens = make_array(token_t, allocator_default(), 16);
+    lex_result_t result = lex(STRVIEW("x = 1\ny = \"unterminated\n"), &tokens);
+    REQUIRE_TRUE(result.error != 0);
+    REQUIRE(result.line,==,2);
+    REQUIRE(tokens.data[tokens.size - 1].type,==,token_end_of_file);
+
+    array_reset(&tokens);
+    result = lex(STRVIEW("x = `"), &tokens);
+    REQUIRE_TRUE(result.error != 0);
+
+    array_reset(&tokens);
+    result = lex(STRVIEW("x = &12345678\ny = &10000000000000000"), &tokens);
+    REQUIRE_TRUE(result.error != 0);
+    REQUIRE(result.line,==,2);
+    REQUIRE(tokens.data[2].number,==,305419896.0);
+
+    array_deinit(&tokens);
+}
@@ -0,0 +1,164 @@
+#include "base/test.h"
+#include "base/allocator.h"
+#include "base/tracker.h"
+#include "log.h"
+
+static tracker_t tracker;
+static allocator_t tracking_allocator;
+
+// Starts counting the blocks allocated through tracking_allocator afresh
+static void start_tracking(void) {
+    tracker_init(&tracker, allocator_default());
+    tracking_allocator = tracker_allocator(&tracker);
+}
+
+
+DEF_TEST(log, formatting) {
+    start_tracking();
+    log_t log;
+    log_init(&log, &tracking_allocator);
+    REQUIRE(tracker.totals.live_blocks,==,0);
+
+    REQUIRE_TRUE(log_write(&log, LOG_CHANNEL_ERRORS, log_message_error, 12, STRVIEW("Unknown symbol")));
+    REQUIRE_TRUE(log_write(&log, LOG_CHANNEL_ERRORS, log_message_overlays_overlap, 0, STRVIEW("a"), STRVIEW("b"), 0x1A80U, 0x1AFFU));
+    REQUIRE_TRUE(log_write(&log, 1, log_message_symbol_value, 0, STRVIEW("pi"), 3.14159));
+    REQUIRE_TRUE(log_write(&log, 1, log_message_listing, 3, 0x0E00U, STRVIEW("LDA #0")));
+    REQUIRE(log_num_records(&log, LOG_CHANNEL_ERRORS),==,2);
+
+    // Only the two channels written to have allocated anything, and a channel is formatted when it's first read
+    REQUIRE(tracker.totals.live_blocks,==,4);
+    REQUIRE(make_strview(log_text(&log, LOG_CHANNEL_ERRORS)),==,STRVIEW(
+        "Line 12: Error: Unknown symbol\n"
+        "Warning: saved overlays 'a' and 'b' overlap at &1A80-&1AFF\n"));
+    REQUIRE(tracker.totals.live_blocks,==,5);
+    REQUIRE(make_strview(log_text(&log, 1)),==,STRVIEW(
+        "pi = 3.14159\n"
+        "Line 3: 0E00  LDA #0\n"));
+    REQUIRE(make_strview(log_text(&log, 7)),==,STRVIEW(""));
+
+    // Records written since are formatted when the text is next read, resuming where formatting left off
+    REQUIRE_TRUE(log_write(&log, 1, log_message_text, 0, STRVIEW("100%")));
+    REQUIRE(make_strview(log_text(&log, 1)),==,STRVIEW(
+        "pi = 3.14159\n"
+        "Line 3: 0E00  LDA #0\n"
+        "100%\n"));
+
+    log_deinit(&log);
+    REQUIRE(tracker.totals.live_blocks,==,0);
+}
+
+DEF_TEST(log, many_records) {
+    log_t log;
+    log_init(&log, allocator_default());
+
+    // Enough records to span many blocks, including one too big for a single block
+    for (uint32_t i = 0; i < 10000; i++) {
+        REQUIRE_TRUE(log_write(&log, 2, log_message_listing, i + 1, i, STRVIEW("NOP")));
+    }
+    static char big[10000];
+    for (uint32_t i = 0; i < sizeof big; i++) {
+        big[i] = 'x';
+    }
+    REQUIRE_TRUE(log_write(&log, 2, log_message_text, 0, (strview_t){(const uint8_t *)big, sizeof big}));
+    REQUIRE_TRUE(log_write(&log, 2, log_message_text, 0, STRVIEW("end")));
+    REQUIRE(log_num_records(&log, 2),==,10002);
+
+    strview_t text = make_strview(log_text(&log, 2));
+    REQUIRE(strview_left(text, 19),==,STRVIEW("Line 1: 0000  NOP\nL"));
+    REQUIRE_TRUE(strview_contains(text, STRVIEW("Line 10000: 270F  NOP\nxxx")));
+    REQUIRE(strview_right(text, 8),==,STRVIEW("xxx\nend\n"));
+    REQUIRE(text.length,==,9 * 18 + 90 * 19 + 900 * 20 + 9000 * 21 + 1 * 22 + 10001 + 4);
+
+    log_deinit(&log);
+}
+
+DEF_TEST(log, passes) {
+    log_t log;
+    log_init(&log, allocator_default());
+
+    // Every pass writes the same messages, but only those of the last are kept
+    for (int pass = 0; pass < 3; pass++) {
+        log_begin_pass(&log, pass == 2);
+        REQUIRE_TRUE(log_write(&log, 1, log_message_text, 10, STRVIEW("hello")));
+        REQUIRE_TRUE(log_write(&log, LOG_CHANNEL_ERRORS, log_message_error, 11, STRVIEW("Oops")));
+        REQUIRE(log_num_records(&log, 1),==,1);
+    }
+
+    REQUIRE(make_strview(log_text(&log, 1)),==,STRVIEW("Line 10: hello\n"));
+    REQUIRE(make_strview(log_text(&log, LOG_CHANNEL_ERRORS)),==,STRVIEW("Line 11: Error: Oops\n"));
+
+    log_deinit(&log);
+}
+
+typedef struct collected_text_t collected_text_t;
+
+struct collected_text_t {
+    str_t text;
+    uint32_t num_writes;
+    uint32_t max_writes;
+};
+
+static bool collect_text(const void *data, size_t size, void *context) {
+    collected_text_t *collected = context;
+    if (collected->num_writes == collected->max_writes) {
+        return false;
+    }
+    collected->num_writes++;
+    return str_append(&collected->text, (strview_t){data, (uint32_t)size});
+}
+
+DEF_TEST(log, sink) {
+    start_tracking();
+    collected_text_t collected = {make_str(allocator_default(), 0), 0, 1000};
+    log_t log;
+    log_init(&log, &tracking_allocator);
+    log_set_sink(&log, 3, collect_text, &collected);
+
+    // Nothing is streamed before the final pass
+    log_begin_pass(&log, false);
+    REQUIRE_TRUE(log_write(&log, 3, log_message_text, 0, STRVIEW("first pass")));
+    REQUIRE(tracker.totals.live_blocks,==,0);
+
+    log_begin_pass(&log, true);
+    for (uint32_t i = 0; i < 10000; i++) {
+        REQUIRE_TRUE(log_write(&log, 3, log_message_listing, i + 1, i, STRVIEW("NOP")));
+    }
+    REQUIRE_TRUE(log_write(&log, 3, log_message_text, 0, STRVIEW("end")));
+    REQUIRE_TRUE(log_write(&log, 1, log_message_text, 0, STRVIEW("kept")));
+
+    // Text has been passed on in large buffers, and the records' space reused, so memory doesn't grow with the text
+    REQUIRE(collected.num_writes,==,3);
+    REQUIRE(tracker.totals.live_blocks,==,4);
+    REQUIRE(make_strview(log_text(&log, 3)),==,STRVIEW(""));
+    REQUIRE(make_strview(log_text(&log, 1)),==,STRVIEW("kept\n"));
+
+    REQUIRE_TRUE(log_flush(&log));
+    REQUIRE(collected.num_writes,==,4);
+    REQUIRE(log_num_records(&log, 3),==,10001);
+    REQUIRE(strview_left(collected.text.view, 18),==,STRVIEW("Line 1: 0000  NOP\n"));
+    REQUIRE(strview_right(collected.text.view, 26),==,STRVIEW("Line 10000: 270F  NOP\nend\n"));
+    REQUIRE(collected.text.length,==,9 * 18 + 90 * 19 + 900 * 20 + 9000 * 21 + 1 * 22 + 4);
+
+    log_deinit(&log);
+    REQUIRE(tracker.totals.live_blocks,==,0);
+    str_deinit(&collected.text);
+}
+
+DEF_TEST(log, sink_failure) {
+    collected_text_t collected = {make_str(allocator_default(), 0), 0, 0};
+    log_t log;
+    log_init(&log, allocator_default());
+    log_set_sink(&log, 1, collect_text, &collected);
+
+    REQUIRE_TRUE(log_write(&log, 1, log_message_text, 0, STRVIEW("buffered")));
+    REQUIRE_FALSE(log_flush(&log));
+
+    // Once a sink has failed, it's never written to again
+    collected.max_writes = 1000;
+    REQUIRE_FALSE(log_write(&log, 1, log_message_text, 0, STRVIEW("dropped")));
+    REQUIRE_FALSE(log_flush(&log));
+    REQUIRE(collected.num_writes,==,0);
+
+    log_deinit(&log);
+    str_deinit(&collected.text);
+}
@@ -0,0 +1,140 @@
+#include "base/test.h"
+#include "base/allocator.h"
+#include "loop.h"
+
+typedef struct loop_test_t {
+    array_token_t tokens;
+    loop_t loop;
+    array_uint8_t object_code;
+    double values[LOOP_MAX_DEPTH + 1];
+    uint32_t pc;
+} loop_test_t;
+
+// Slot 0 holds 'base'; loop variables start at slot 1
+static uint32_t resolve(strview_t name, void *context) {
+    UNUSED(context);
+    return strview_equal(name, STRVIEW("base")) ? 0 : invalid_index;
+}
+
+static loop_result_t run_loop(loop_test_t *test, strview_t source, const opcode_table_t *opcodes) {
+    *test = (loop_test_t){
+        .tokens = make_array(token_t, allocator_default(), 64),
+        .object_code = make_array(uint8_t, allocator_default(), 16),
+        .values = {0x2000},
+        .pc = 0x1900
+    };
+    lex(source, &test->tokens);
+    slice_const_token_t tokens = {test->tokens.data, test->tokens.size};
+    loop_result_t result = loop_compile(&test->loop, allocator_default(), tokens, opcodes, resolve, 0, 1);
+    if (!result.error) {
+        result = loop_run(&test->loop, test->values, &test->object_code, &test->pc, 0, 0);
+    }
+    return result;
+}
+
+static void deinit_loop_test(loop_test_t *test) {
+    loop_deinit(&test->loop);
+    array_deinit(&test->object_code);
+    array_deinit(&test->tokens);
+}
+
+DEF_TEST(loop, tables) {
+    loop_test_t test;
+    loop_result_t result = run_loop(&test, STRVIEW("FOR i, 0, 255\n  EQUB LO(base + i * 3)\n  EQUW base + i\nNEXT\nRTS"), opcode_table(instruction_set_nmos));
+    REQUIRE_TRUE(result.error == 0);
+    REQUIRE(test.object_code.size,==,256 * 3);
+    REQUIRE(test.object_code.data[3 * 10],==,30);
+    REQUIRE(test.object_code.data[3 * 10 + 1],==,0x0A);
+    REQUIRE(test.object_code.data[3 * 10 + 2],==,0x20);
+    REQUIRE(test.pc,==,0x1900 + 256 * 3);
+    REQUIRE(test.loop.num_slots,==,2);
+    REQUIRE(test.loop.length,==,test.tokens.size - 3);
+    deinit_loop_test(&test);
+
+    // BBC BASIC semantics: the body always runs at least once, and the step may be negative
+    result = run_loop(&test, STRVIEW("FOR i, 10, 0, -2 : EQUB i : NEXT i"), opcode_table(instruction_set_nmos));
+    REQUIRE_TRUE(result.error == 0);
+    REQUIRE(test.object_code.size,==,6);
+    REQUIRE(test.object_code.data[5],==,0);
+    deinit_loop_test(&test);
+
+    result = run_loop(&test, STRVIEW("FOR i, 5, 0 : EQUB i : NEXT"), opcode_table(instruction_set_nmos));
+    REQUIRE_TRUE(result.error == 0);
+    REQUIRE(test.object_code.size,==,1);
+    deinit_loop_test(&test);
+}
+
+DEF_TEST(loop, nested_and_instructions) {
+    loop_test_t test;
+    loop_result_t result = run_loop(&test,
+        STRVIEW("FOR y, 0, 3\n"
+                "  FOR x, 0, 7 : EQUB y * 8 + x : NEXT\n"
+                "  LDA base + y, X\n"
+                "  STA &70 + y\n"
+                "NEXT"),
+        opcode_table(instruction_set_nmos));
+    REQUIRE_TRUE(result.error == 0);
+    REQUIRE(test.object_code.size,==,4 * (8 + 3 + 2));
+    REQUIRE(test.object_code.data[13 + 7],==,15);
+    REQUIRE(test.object_code.data[13 + 8],==,0xBD);
+    REQUIRE(test.object_code.data[13 + 9],==,0x01);
+    REQUIRE(test.object_code.data[13 + 10],==,0x20);
+    REQUIRE(test.object_code.data[13 + 11],==,0x85);
+    REQUIRE(test.object_code.data[13 + 12],==,0x71);
+    REQUIRE(test.loop.num_slots,==,3);
+    deinit_loop_test(&test);
+
+    // Branches are relative to the address of each iteration
+    result = run_loop(&test, STRVIEW("FOR i, 0, 1 : BNE &1900 : NEXT"), opcode_table(instruction_set_nmos));
+    REQUIRE_TRUE(result.error == 0);
+    REQUIRE(test.object_code.data[1],==,0xFE);
+    REQUIRE(test.object_code.data[3],==,0xFC);
+    deinit_loop_test(&test);
+
+    // An invariant body is assembled once and replicated
+    result = run_loop(&test, STRVIEW("FOR i, 1, 1000 : NOP : EQUW base : NEXT"), opcode_table(instruction_set_nmos));
+    REQUIRE_TRUE(result.error == 0);
+    REQUIRE(test.object_code.size,==,3000);
+    REQUIRE(test.object_code.data[2997],==,0xEA);
+    REQUIRE(test.object_code.data[2999],==,0x20);
+    REQUIRE(test.pc,==,0x1900 + 3000);
+    deinit_loop_test(&test);
+}
+
+DEF_TEST(loop, large) {
+    loop_test_t test;
+    loop_result_t result = run_loop(&test, STRVIEW("FOR i, 0, &FFFF : EQUB (i * 7 + base) AND &FF : NEXT"), opcode_table(instruction_set_nmos));
+    REQUIRE_TRUE(result.error == 0);
+    REQUIRE(test.object_code.size,==,65536);
+    REQUIRE(test.object_code.data[40000],==,(40000 * 7) & 0xFF);
+    deinit_loop_test(&test);
+}
+
+DEF_TEST(loop, errors) {
+    loop_test_t test;
+    const opcode_table_t *nmos = opcode_table(instruction_set_nmos);
+    loop_result_t result = run_loop(&test, STRVIEW("FOR i, 0, 3\nEQUB i\n"), nmos);
+    REQUIRE_TRUE(result.error != 0);
+    deinit_loop_test(&test);
+
+    result = run_loop(&test, STRVIEW("FOR i, 0, 3\nEQUB i * 100\nNEXT"), nmos);
+    REQUIRE_TRUE(result.error != 0);
+    REQUIRE(result.line,==,2);
+    deinit_loop_test(&test);
+
+    result = run_loop(&test, STRVIEW("FOR i, 0, 3 : STZ &70 : NEXT"), nmos);
+    REQUIRE_TRUE(result.error != 0);
+    deinit_loop_test(&test);
+
+    result = run_loop(&test, STRVIEW("FOR i, 0, 3 : EQUB j : NEXT"), nmos);
+    REQUIRE_TRUE(result.error != 0);
+    deinit_loop_test(&test);
+
+    result = run_loop(&test, STRVIEW("FOR i, 0, 3, 0 : NEXT"), nmos);
+    REQUIRE_TRUE(result.error != 0);
+    deinit_loop_test(&test);
+
+    result = run_loop(&test, STRVIEW("FOR i, 0, 3 : NEXT j"), nmos);
+    REQUIRE_TRUE(result.error != 0);
+    deinit_loop_test(&test);
+}
@@ -0,0 +1,96 @@
+#include "base/test.h"
+#include "base/allocator.h"
+#include "lexer.h"
+#include "macro.h"
+
+DEF_TEST(macro, define_and_bind) {
+    array_token_t tokens = make_array(token_t, allocator_default(), 16);
+    REQUIRE_TRUE(lex(STRVIEW("LDA #lo(addr)\nSTA dest:LDA #hi(addr)\n\nSTA dest+1\n"), &tokens).error == 0);
+
+    strview_t param_names[] = {STRVIEW("dest"), STRVIEW("addr")};
+    macro_t macro;
+    REQUIRE_TRUE(macro_init(&macro, allocator_default(), STRVIEW("setptr"),
+        (slice_const_strview_t){param_names, 2}, tokens.const_slice));
+
+    REQUIRE(macro.num_params,==,2);
+    REQUIRE(macro.statements.size,==,4);
+
+    slice_const_token_t statement = macro_statement(&macro, 0);
+    REQUIRE(statement.size,==,6);
+    REQUIRE(statement.data[0].text,==,STRVIEW("LDA"));
+    REQUIRE(statement.data[4].type,==,token_param);
+    REQUIRE(statement.data[4].slot,==,1);
+
+    statement = macro_statement(&macro, 3);
+    REQUIRE(statement.size,==,4);
+    REQUIRE(statement.data[1].type,==,token_param);
+    REQUIRE(statement.data[1].slot,==,0);
+    REQUIRE(statement.data[1].line,==,4);
+
+    array_token_t call = make_array(token_t, allocator_default(), 16);
+    REQUIRE_TRUE(lex(STRVIEW("&70, table(1, 2) + 3"), &call).error == 0);
+    slice_const_token_t call_args = {call.data, call.size - 1};
+
+    slice_const_token_t args[2];
+    REQUIRE_TRUE(macro_bind(&macro, call_args, args));
+    REQUIRE(args[0].size,==,1);
+    REQUIRE(args[0].data[0].number,==,112.0);
+    REQUIRE(args[1].size,==,8);
+
+    call_args.size = 1;
+    REQUIRE_FALSE(macro_bind(&macro, call_args, args));
+
+    macro_deinit(&macro);
+    array_deinit(&call);
+    array_deinit(&tokens);
+}
+
+static macro_t make_test_macro(strview_t name, uint32_t num_params) {
+    strview_t param_names[] = {STRVIEW("a"), STRVIEW("b")};
+    token_t end = {.type = token_end_of_file};
+    macro_t macro;
+    macro_init(&macro, allocator_default(), name, (slice_const_strview_t){param_names, num_params}, (slice_const_token_t){&end, 1});
+    return macro;
+}
+
+DEF_TEST(macro, overloads) {
+    macro_table_t table;
+    REQUIRE_TRUE(macro_table_init(&table, allocator_default()));
+
+    macro_t macro = make_test_macro(STRVIEW("inc16"), 1);
+    REQUIRE_TRUE(macro_table_add(&table, &macro, addr_mode_absolute));
+    macro = make_test_macro(STRVIEW("inc16"), 1);
+    REQUIRE_TRUE(macro_table_add(&table, &macro, MACRO_ANY_MODE));
+    macro = make_test_macro(STRVIEW("inc16"), 1);
+    REQUIRE_TRUE(macro_table_add(&table, &macro, addr_mode_absolute_x));
+    macro = make_test_macro(STRVIEW("inc16"), 1);
+    REQUIRE_TRUE(macro_table_add(&table, &macro, addr_mode_zero_page_x));
+    macro = make_test_macro(STRVIEW("inc16"), 1);
+    REQUIRE_FALSE(macro_table_add(&table, &macro, addr_mode_absolute));
+
+    // Enough other macros to force the hash table to grow
+    for (int i = 0; i < 100; i++) {
+        static char names[100][8];
+        names[i][0] = 'm';
+        names[i][1] = (char)('0' + i / 10);
+        names[i][2] = (char)('0' + i % 10);
+        macro = make_test_macro((strview_t){(const uint8_t *)names[i], 3}, 2);
+        REQUIRE_TRUE(macro_table_add(&table, &macro, MACRO_ANY_MODE));
+    }
+
+    const macro_table_entry_t *entry = macro_table_find(&table, STRVIEW("inc16"));
+    REQUIRE_TRUE(entry != 0);
+    REQUIRE_TRUE(macro_table_resolve(&table, entry, addr_mode_absolute) == &table.macros.data[0]);
+    REQUIRE_TRUE(macro_table_resolve(&table, entry, addr_mode_zero_page) == &table.macros.data[0]);
+    REQUIRE_TRUE(macro_table_resolve(&table, entry, addr_mode_immediate) == &table.macros.data[1]);
+    REQUIRE_TRUE(macro_table_resolve(&table, entry, addr_mode_absolute_x) == &table.macros.data[2]);
+    REQUIRE_TRUE(macro_table_resolve(&table, entry, addr_mode_zero_page_x) == &table.macros.data[3]);
+
+    entry = macro_table_find(&table, STRVIEW("m42"));
+    REQUIRE_TRUE(entry != 0);
+    REQUIRE(entry->explicit_modes,==,1U << addr_mode_count);
+    REQUIRE(macro_table_resolve(&table, entry, addr_mode_implied)->num_params,==,2);
+    REQUIRE_TRUE(macro_table_find(&table, STRVIEW("m100")) == 0);
+
+    macro_table_deinit(&table);
+}
@@ -0,0 +1,142 @@
+#include <string.h>
+#include "base/test.h"
+#include "base/allocator.h"
+#include "assembly.h"
+#include "memmap.h"
+
+DEF_TEST(memmap, overlaps) {
+    memmap_t memmap;
+    REQUIRE_TRUE(memmap_init(&memmap, allocator_default()));
+    REQUIRE_TRUE(memmap_add_region(&memmap, 2, 0x3000, 0x3100));
+    REQUIRE_TRUE(memmap_add_region(&memmap, 0, 0x1900, 0x3000));
+    REQUIRE_TRUE(memmap_add_region(&memmap, 1, 0x2F00, 0x3080));
+    REQUIRE_TRUE(memmap_add_region(&memmap, 3, 0x4000, 0x4000));
+    REQUIRE(memmap.regions.size,==,3);
+
+    array_memmap_overlap_t overlaps = make_array(memmap_overlap_t, allocator_default(), 4);
+    REQUIRE_TRUE(memmap_find_overlaps(&memmap, &overlaps));
+    REQUIRE(memmap.regions.data[0].start,==,0x1900);
+    REQUIRE(memmap.regions.data[1].start,==,0x2F00);
+    REQUIRE(memmap.regions.data[2].start,==,0x3000);
+
+    REQUIRE(overlaps.size,==,2);
+    REQUIRE(overlaps.data[0].start,==,0x2F00);
+    REQUIRE(overlaps.data[0].end,==,0x3000);
+    REQUIRE(overlaps.data[0].first_overlay_index,==,0);
+    REQUIRE(overlaps.data[0].second_overlay_index,==,1);
+    REQUIRE(overlaps.data[1].start,==,0x3000);
+    REQUIRE(overlaps.data[1].end,==,0x3080);
+    REQUIRE(overlaps.data[1].first_overlay_index,==,1);
+    REQUIRE(overlaps.data[1].second_overlay_index,==,2);
+
+    array_deinit(&overlaps);
+    memmap_deinit(&memmap);
+}
+
+DEF_TEST(memmap, adjacent_and_same_overlay) {
+    memmap_t memmap;
+    REQUIRE_TRUE(memmap_init(&memmap, allocator_default()));
+    REQUIRE_TRUE(memmap_add_region(&memmap, 0, 0x1000, 0x2000));
+    REQUIRE_TRUE(memmap_add_region(&memmap, 1, 0x2000, 0x3000));
+    REQUIRE_TRUE(memmap_add_region(&memmap, 1, 0x2800, 0x2900));
+
+    array_memmap_overlap_t overlaps = make_array(memmap_overlap_t, allocator_default(), 4);
+    REQUIRE_TRUE(memmap_find_overlaps(&memmap, &overlaps));
+    REQUIRE(overlaps.size,==,0);
+
+    // Regions of the same overlay which intersect or touch are merged
+    REQUIRE(memmap.regions.size,==,2);
+    REQUIRE(memmap.regions.data[1].start,==,0x2000);
+    REQUIRE(memmap.regions.data[1].end,==,0x3000);
+
+    array_deinit(&overlaps);
+    memmap_deinit(&memmap);
+}
+
+DEF_TEST(memmap, many_same_overlay) {
+    memmap_t memmap;
+    REQUIRE_TRUE(memmap_init(&memmap, allocator_default()));
+
+    // Long regions of one overlay, all open at once, which are merged rather than compared with each other
+    for (uint32_t i = 0; i < 20000; i++) {
+        REQUIRE_TRUE(memmap_add_region(&memmap, 0, i, 0x40000 + i));
+    }
+    REQUIRE_TRUE(memmap_add_region(&memmap, 1, 0x30000, 0x30100));
+    REQUIRE_TRUE(memmap_add_region(&memmap, 2, 0x60000, 0x60100));
+
+    array_memmap_overlap_t overlaps = make_array(memmap_overlap_t, allocator_default(), 4);
+    REQUIRE_TRUE(memmap_find_overlaps(&memmap, &overlaps));
+    REQUIRE(memmap.regions.size,==,3);
+    REQUIRE(overlaps.size,==,1);
+    REQUIRE(overlaps.data[0].start,==,0x30000);
+    REQUIRE(overlaps.data[0].end,==,0x30100);
+    REQUIRE(overlaps.data[0].first_overlay_index,==,0);
+    REQUIRE(overlaps.data[0].second_overlay_index,==,1);
+
+    array_deinit(&overlaps);
+    memmap_deinit(&memmap);
+}
+
+DEF_TEST(memmap, assembly_report) {
+    baron_assembly_t *assembly = assembly_create(0);
+    REQUIRE_TRUE(assembly != 0);
+
+    uint32_t code = assembly_add_overlay(assembly, STRVIEW("code"));
+    uint32_t loader = assembly_add_overlay(assembly, STRVIEW("loader"));
+    REQUIRE(assembly_find_overlay(assembly, STRVIEW("loader")),==,loader);
+    REQUIRE_TRUE(array_resize(&assembly->overlays.data[code].object_code, 0x200));
+    REQUIRE_TRUE(array_resize(&assembly->overlays.data[loader].object_code, 0x100));
+    assembly_save_overlay(assembly, code, 0x1900, 0x1900);
+    assembly_save_overlay(assembly, loader, 0x1A80, 0x1A80);
+    REQUIRE_TRUE(assembly_finish(assembly));
+
+    REQUIRE(make_strview(baron_assembly_memory_map(assembly)),==,STRVIEW(
+        "region 1900 1B00 code\n"
+        "region 1A80 1B80 loader\n"
+        "overlap 1A80 1B00 code loader\n"));
+    REQUIRE(make_strview(baron_assembly_errors(assembly)),==,STRVIEW(
+        "Warning: saved overlays 'code' and 'loader' overlap at &1A80-&1AFF\n"));
+    REQUIRE(make_strview(baron_assembly_log(assembly, 1)),==,STRVIEW(""));
+
+    baron_assembly_destroy(assembly);
+}
+
+DEF_TEST(memmap, regions_from_final_sizes) {
+    baron_assembly_t *assembly = assembly_create(0);
+    REQUIRE_TRUE(assembly != 0);
+    uint32_t code = assembly_add_overlay(assembly, STRVIEW("code"));
+    uint32_t loader = assembly_add_overlay(assembly, STRVIEW("loader"));
+    uint32_t data = assembly_add_overlay(assembly, STRVIEW("data"));
+    uint32_t other = assembly_add_overlay(assembly, STRVIEW("other"));
+
+    // Every pass saves the overlays again, some before their object code has been assembled
+    for (int pass = 0; pass < 2; pass++) {
+        assembly_begin_pass(assembly, pass == 1);
+        for (uint32_t i = 0; i < assembly->overlays.size; i++) {
+            array_reset(&assembly->overlays.data[i].object_code);
+        }
+        assembly_save_overlay(assembly, code, 0x1900, 0x1900);
+        REQUIRE_TRUE(array_resize(&assembly->overlays.data[code].object_code, 0x200));
+        REQUIRE_TRUE(array_resize(&assembly->overlays.data[loader].object_code, 0x100));
+        assembly_save_overlay(assembly, loader, 0x1A80, 0x1A80);
+        assembly_save_overlay(assembly, data, 0x3000, 0x3000);
+        REQUIRE_TRUE(array_resize(&assembly->overlays.data[data].object_code, 0x20));
+        REQUIRE_TRUE(array_resize(&assembly->overlays.data[other].object_code, 0x10));
+        assembly_save_overlay(assembly, other, 0x3010, 0x3010);
+        assembly_end_pass(assembly);
+    }
+    REQUIRE_TRUE(assembly_finish(assembly));
+
+    REQUIRE(make_strview(baron_assembly_memory_map(assembly)),==,STRVIEW(
+        "region 1900 1B00 code\n"
+        "region 1A80 1B80 loader\n"
+        "region 3000 3020 data\n"
+        "region 3010 3020 other\n"
+        "overlap 1A80 1B00 code loader\n"
+        "overlap 3010 3020 data other\n"));
+    REQUIRE(make_strview(baron_assembly_errors(assembly)),==,STRVIEW(
+        "Warning: saved overlays 'code' and 'loader' overlap at &1A80-&1AFF\n"
+        "Warning: saved overlays 'data' and 'other' overlap at &3010-&301F\n"));
+
+    baron_assembly_destroy(assembly);
+}
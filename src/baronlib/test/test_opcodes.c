@@ -0,0 +1,74 @@
+#include "base/test.h"
+#include "opcodes.h"
+
+DEF_TEST(opcodes, mnemonic_lookup) {
+    for (int i = 0; i < mnemonic_count; i++) {
+        REQUIRE(mnemonic_lookup(mnemonic_name((mnemonic_t)i)),==,i);
+    }
+    REQUIRE(mnemonic_lookup(STRVIEW("lda")),==,mnemonic_lda);
+    REQUIRE(mnemonic_lookup(STRVIEW("StZ")),==,mnemonic_stz);
+    REQUIRE(mnemonic_lookup(STRVIEW("LD")),==,mnemonic_count);
+    REQUIRE(mnemonic_lookup(STRVIEW("LDAX")),==,mnemonic_count);
+    REQUIRE(mnemonic_lookup(STRVIEW("ABC")),==,mnemonic_count);
+    REQUIRE(mnemonic_lookup(STRVIEW("L[A")),==,mnemonic_count);
+    REQUIRE(mnemonic_lookup(STRVIEW("LD1")),==,mnemonic_count);
+    REQUIRE(mnemonic_lookup(STRVIEW("\xCC" "DA")),==,mnemonic_count);
+    REQUIRE_TRUE(strview_equal(mnemonic_name(mnemonic_and), STRVIEW("AND")));
+}
+
+DEF_TEST(opcodes, instruction_sets) {
+    const opcode_table_t *nmos = opcode_table(instruction_set_nmos);
+    const opcode_table_t *cmos = opcode_table(instruction_set_cmos);
+    const opcode_table_t *undoc = opcode_table(instruction_set_nmos_undocumented);
+    REQUIRE_TRUE(mnemonic_is_supported(nmos, mnemonic_lda));
+    REQUIRE_FALSE(mnemonic_is_supported(nmos, mnemonic_stz));
+    REQUIRE_FALSE(mnemonic_is_supported(nmos, mnemonic_lax));
+    REQUIRE_TRUE(mnemonic_is_supported(cmos, mnemonic_stz));
+    REQUIRE_FALSE(mnemonic_is_supported(cmos, mnemonic_lax));
+    REQUIRE_TRUE(mnemonic_is_supported(undoc, mnemonic_lax));
+    REQUIRE_FALSE(mnemonic_is_supported(undoc, mnemonic_bra));
+}
+
+DEF_TEST(opcodes, select_mode) {
+    const opcode_table_t *nmos = opcode_table(instruction_set_nmos);
+    const opcode_table_t *cmos = opcode_table(instruction_set_cmos);
+    REQUIRE(opcode_select_mode(nmos, mnemonic_lda, addr_mode_absolute, true),==,addr_mode_zero_page);
+    REQUIRE(opcode_select_mode(nmos, mnemonic_lda, addr_mode_absolute, false),==,addr_mode_absolute);
+    REQUIRE(opcode_select_mode(nmos, mnemonic_lda, addr_mode_absolute_y, true),==,addr_mode_absolute_y);
+    REQUIRE(opcode_select_mode(nmos, mnemonic_ldx, addr_mode_absolute_y, true),==,addr_mode_zero_page_y);
+    REQUIRE(opcode_select_mode(nmos, mnemonic_jsr, addr_mode_absolute, true),==,addr_mode_absolute);
+    REQUIRE(opcode_select_mode(nmos, mnemonic_bne, addr_mode_absolute, true),==,addr_mode_relative);
+    REQUIRE(opcode_select_mode(nmos, mnemonic_asl, addr_mode_implied, false),==,addr_mode_accumulator);
+    REQUIRE(opcode_select_mode(nmos, mnemonic_lda, addr_mode_indirect, true),==,addr_mode_count);
+    REQUIRE(opcode_select_mode(cmos, mnemonic_lda, addr_mode_indirect, true),==,addr_mode_indirect_zero_page);
+    REQUIRE(opcode_select_mode(cmos, mnemonic_jmp, addr_mode_indirect, true),==,addr_mode_indirect);
+    REQUIRE(opcode_select_mode(cmos, mnemonic_jmp, addr_mode_indirect_x, false),==,addr_mode_indirect_absolute_x);
+    REQUIRE(opcode_select_mode(nmos, mnemonic_jmp, addr_mode_indirect_x, false),==,addr_mode_count);
+    REQUIRE(opcode_select_mode(nmos, mnemonic_inc, addr_mode_accumulator, false),==,addr_mode_count);
+    REQUIRE(opcode_select_mode(cmos, mnemonic_inc, addr_mode_accumulator, false),==,addr_mode_accumulator);
+}
+
+DEF_TEST(opcodes, encode) {
+    const opcode_table_t *nmos = opcode_table(instruction_set_nmos);
+    const opcode_table_t *cmos = opcode_table(instruction_set_cmos);
+    uint8_t bytes[3];
+    REQUIRE(instruction_encode(nmos, mnemonic_lda, addr_mode_absolute_x, 0x1234, bytes),==,3);
+    REQUIRE(bytes[0],==,0xBD);
+    REQUIRE(bytes[1],==,0x34);
+    REQUIRE(bytes[2],==,0x12);
+    REQUIRE(instruction_encode(nmos, mnemonic_lda, addr_mode_immediate, -1, bytes),==,2);
+    REQUIRE(bytes[0],==,0xA9);
+    REQUIRE(bytes[1],==,0xFF);
+    REQUIRE(instruction_encode(nmos, mnemonic_rts, addr_mode_implied, 0, bytes),==,1);
+    REQUIRE(bytes[0],==,0x60);
+    REQUIRE(instruction_encode(nmos, mnemonic_beq, addr_mode_relative, -2, bytes),==,2);
+    REQUIRE(bytes[1],==,0xFE);
+    REQUIRE(instruction_encode(nmos, mnemonic_beq, addr_mode_relative, 128, bytes),==,0);
+    REQUIRE(instruction_encode(nmos, mnemonic_lda, addr_mode_zero_page, 256, bytes),==,0);
+    REQUIRE(instruction_encode(nmos, mnemonic_stz, addr_mode_zero_page, 0x70, bytes),==,0);
+    REQUIRE(instruction_encode(cmos, mnemonic_stz, addr_mode_zero_page, 0x70, bytes),==,2);
+    REQUIRE(bytes[0],==,0x64);
+    REQUIRE(instruction_encode(cmos, mnemonic_brk, addr_mode_implied, 0, bytes),==,1);
+    REQUIRE(bytes[0],==,0x00);
+    REQUIRE(instruction_size(addr_mode_indirect_absolute_x),==,3);
+}
@@ -0,0 +1,104 @@
+#include <string.h>
+#include "base/test.h"
+#include "base/allocator.h"
+#include "assembly.h"
+#include "loop.h"
+
+static uint32_t resolve_none(strview_t name, void *context) {
+    UNUSED(name);
+    UNUSED(context);
+    return invalid_index;
+}
+
+static bool append_text(const void *data, size_t size, void *context) {
+    return array_append((array_char *)context, ((slice_const_char){data, (uint32_t)size}));
+}
+
+DEF_TEST(profile, hot_lines) {
+    profile_t profile;
+    REQUIRE_TRUE(profile_init(&profile, allocator_default()));
+
+    // Fewer steps are counted than PROFILE_SAMPLE_INTERVAL, so no time is sampled and lines are ranked by steps.
+    // Nothing is counted until a file is entered.
+    profile_count(&profile, 1, 100, 0);
+    REQUIRE_TRUE(profile_enter_file(&profile, STRVIEW("main.6502")));
+    profile_count(&profile, 3, 5, 1);
+    profile_count(&profile, 700, 20, 0);
+    uint32_t main_file = profile.file;
+    REQUIRE_TRUE(profile_enter_file(&profile, STRVIEW("macros.6502")));
+    profile_count(&profile, 3, 8, 4);
+    profile_count(&profile, 3, 8, 4);
+    profile_restore_file(&profile, main_file);
+    profile_count(&profile, 3, 1, 0);
+
+    baron_hot_line_t hot_lines[4];
+    REQUIRE(profile_hot_lines(&profile, hot_lines, 4),==,3);
+    REQUIRE(make_strview(hot_lines[0].filename),==,STRVIEW("main.6502"));
+    REQUIRE(hot_lines[0].line,==,700);
+    REQUIRE(make_strview(hot_lines[1].filename),==,STRVIEW("macros.6502"));
+    REQUIRE(hot_lines[1].steps,==,16);
+    REQUIRE(hot_lines[1].evaluations,==,8);
+    REQUIRE(hot_lines[2].line,==,3);
+    REQUIRE(hot_lines[2].steps,==,6);
+
+    // Only the hottest are kept when there are more lines than asked for
+    REQUIRE(profile_hot_lines(&profile, hot_lines, 1),==,1);
+    REQUIRE(hot_lines[0].line,==,700);
+
+    profile_reset(&profile);
+    REQUIRE(profile_hot_lines(&profile, hot_lines, 4),==,0);
+    profile_deinit(&profile);
+}
+
+DEF_TEST(profile, loop_lines) {
+    baron_desc_t desc = {.profile = true};
+    baron_assembly_t *assembly = assembly_create(&desc);
+    REQUIRE_TRUE(assembly);
+    const allocator_t *other = assembly_allocator(assembly, baron_memory_other);
+    array_token_t tokens = make_array(token_t, other, 16);
+    REQUIRE_TRUE(assembly_lex(assembly, STRVIEW("FOR i, 0, 99\n  EQUB i\n  FOR j, 0, 9 : EQUW i * j : NEXT\n  NOP\nNEXT"), &tokens).error == 0);
+
+    assembly_begin_pass(assembly, true);
+    REQUIRE_TRUE(profile_enter_file(assembly_profile(assembly), STRVIEW("tables.6502")));
+    loop_t loop;
+    REQUIRE_TRUE(loop_compile(&loop, other, tokens.const_slice, assembly->opcodes, resolve_none, 0, 0).error == 0);
+    double values[LOOP_MAX_DEPTH];
+    uint32_t pc = 0x1900;
+    loop_result_t result = loop_run(&loop, values, &assembly->overlays.data[0].object_code, &pc, 0, assembly_profile(assembly));
+    REQUIRE_TRUE(result.error == 0);
+    assembly_end_pass(assembly);
+    loop_deinit(&loop);
+
+    // The inner loop's body is the hottest line, and each loop's FOR is counted once per time it starts
+    baron_hot_line_t hot_lines[8];
+    REQUIRE(baron_assembly_hot_lines(assembly, hot_lines, 8),==,4);
+    uint64_t steps_by_line[6] = {0};
+    for (uint32_t i = 0; i < 4; i++) {
+        REQUIRE(make_strview(hot_lines[i].filename),==,STRVIEW("tables.6502"));
+        REQUIRE(hot_lines[i].line,<,6);
+        steps_by_line[hot_lines[i].line] = hot_lines[i].steps;
+    }
+    REQUIRE(steps_by_line[1],==,1);
+    REQUIRE(steps_by_line[2],==,100);
+    REQUIRE(steps_by_line[3],==,100 + 1000);
+    REQUIRE(steps_by_line[4],==,100);
+
+    array_char report = make_array(char, allocator_default(), 256);
+    REQUIRE_TRUE(baron_assembly_profile_write(assembly, 2, append_text, &report));
+    strview_t text = {(const uint8_t *)report.data, report.size};
+    REQUIRE_TRUE(strview_contains(text, STRVIEW("tables.6502:3\n")));
+    REQUIRE_FALSE(strview_contains(text, STRVIEW("tables.6502:1\n")));
+
+    array_deinit(&report);
+    array_deinit(&tokens);
+    assembly_destroy(assembly);
+}
+
+DEF_TEST(profile, disabled) {
+    baron_assembly_t *assembly = assembly_create(0);
+    REQUIRE_TRUE(assembly);
+    REQUIRE_FALSE(assembly_profile(assembly));
+    baron_hot_line_t hot_line;
+    REQUIRE(baron_assembly_hot_lines(assembly, &hot_line, 1),==,0);
+    assembly_destroy(assembly);
+}
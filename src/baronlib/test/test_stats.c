@@ -0,0 +1,60 @@
+#include "base/test.h"
+#include "base/allocator.h"
+#include "assembly.h"
+#include "loop.h"
+
+static uint32_t resolve_none(strview_t name, void *context) {
+    UNUSED(name);
+    UNUSED(context);
+    return invalid_index;
+}
+
+DEF_TEST(stats, assembly) {
+    baron_assembly_t *assembly = assembly_create(0);
+    REQUIRE_TRUE(assembly);
+    const allocator_t *other = assembly_allocator(assembly, baron_memory_other);
+    array_token_t tokens = make_array(token_t, other, 16);
+
+    assembly_begin_pass(assembly, true);
+    REQUIRE_TRUE(assembly_lex(assembly, STRVIEW("FOR i, 0, 9 : EQUB i * 3, 7 : NEXT"), &tokens).error == 0);
+    loop_t loop;
+    REQUIRE_TRUE(loop_compile(&loop, other, tokens.const_slice, assembly->opcodes, resolve_none, 0, 0).error == 0);
+    double values[LOOP_MAX_DEPTH];
+    uint32_t pc = 0x1900;
+    loop_result_t result = loop_run(&loop, values, &assembly->overlays.data[0].object_code, &pc, &assembly->budget, 0);
+    REQUIRE_TRUE(result.error == 0);
+    loop_deinit(&loop);
+
+    // Start and end, then i * 3 each iteration; the constant 7 is not evaluated
+    REQUIRE(result.num_evaluations,==,2 + 10);
+    assembly->stats.expressions_evaluated += result.num_evaluations;
+    REQUIRE_TRUE(symtab_set(&assembly->symbols, STRVIEW("start"), make_number_value(0x1900)));
+    REQUIRE_TRUE(symtab_lookup(&assembly->symbols, STRVIEW("start")));
+    REQUIRE_FALSE(symtab_lookup(&assembly->symbols, STRVIEW("end")));
+    assembly_end_pass(assembly);
+    assembly_save_overlay(assembly, 0, 0x1900, 0x1900);
+    REQUIRE_TRUE(assembly_finish(assembly));
+
+    baron_stats_t stats;
+    baron_assembly_stats(assembly, &stats);
+    REQUIRE(stats.num_passes,==,1);
+    REQUIRE(stats.pass_seconds[0],>=,0.0);
+    REQUIRE(stats.tokens_lexed,==,tokens.size);
+    REQUIRE(stats.expressions_evaluated,==,12);
+    REQUIRE(stats.symbol_lookups,==,3);
+    REQUIRE(stats.symbol_probes,>=,3);
+    REQUIRE(stats.max_symbol_probe_length,>=,1);
+    REQUIRE(stats.memory[baron_memory_object_code].num_allocations,>,0);
+    REQUIRE(stats.memory[baron_memory_object_code].bytes_requested,>=,20);
+    REQUIRE(stats.memory[baron_memory_other].num_allocations,>,0);
+
+    // Resetting the assembly starts its statistics again
+    array_deinit(&tokens);
+    assembly_reset(assembly);
+    baron_assembly_stats(assembly, &stats);
+    REQUIRE(stats.num_passes,==,0);
+    REQUIRE(stats.tokens_lexed,==,0);
+    REQUIRE(stats.symbol_lookups,==,0);
+    REQUIRE(stats.memory[baron_memory_other].bytes_requested,==,0);
+    assembly_destroy(assembly);
+}
@@ -0,0 +1,192 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "base/test.h"
+#include "base/allocator.h"
+#include "assembly.h"
+#include "symtab.h"
+
+static bool append_bytes(const void *data, size_t size, void *context) {
+    return array_append((array_uint8_t *)context, ((slice_const_uint8_t){data, (uint32_t)size}));
+}
+
+typedef struct visited_t visited_t;
+
+struct visited_t {
+    const char *names[8];
+    uint32_t num_names;
+    uint32_t max_names;
+};
+
+static bool visit_symbol(const baron_symbol_t *symbol, void *context) {
+    visited_t *visited = context;
+    visited->names[visited->num_names++] = symbol->name;
+    return visited->num_names < visited->max_names;
+}
+
+DEF_TEST(symtab, set_and_find) {
+    symtab_t symtab;
+    REQUIRE_TRUE(symtab_init(&symtab, allocator_default()));
+
+    // Enough symbols to grow the hash table several times
+    for (uint32_t i = 0; i < 1000; i++) {
+        char name[16];
+        snprintf(name, sizeof name, "label%u", i);
+        REQUIRE_TRUE(symtab_set(&symtab, make_strview(name), make_number_value(0x1900 + i)));
+    }
+    REQUIRE_TRUE(symtab_set(&symtab, STRVIEW("title"), make_string_value(allocator_default(), STRVIEW("A long string value"))));
+    REQUIRE_TRUE(symtab_set(&symtab, STRVIEW("label500"), make_number_value(-1)));
+    REQUIRE(symtab.symbols.size,==,1001);
+
+    const symbol_t *symbol = symtab_find(&symtab, STRVIEW("label999"));
+    REQUIRE_TRUE(symbol);
+    REQUIRE(symbol->value.number,==,0x1900 + 999);
+    REQUIRE(symtab_find(&symtab, STRVIEW("label500"))->value.number,==,-1);
+    REQUIRE(string_view(&symtab_find(&symtab, STRVIEW("title"))->value),==,STRVIEW("A long string value"));
+    REQUIRE_FALSE(symtab_find(&symtab, STRVIEW("label1000")));
+
+    symtab_deinit(&symtab);
+}
+
+DEF_TEST(symtab, binary_file) {
+    symtab_t symtab;
+    REQUIRE_TRUE(symtab_init(&symtab, allocator_default()));
+    REQUIRE_TRUE(symtab_set(&symtab, STRVIEW("zeta"), make_string_value(allocator_default(), STRVIEW("last"))));
+    REQUIRE_TRUE(symtab_set(&symtab, STRVIEW("loop"), make_number_value(0x1910)));
+    REQUIRE_TRUE(symtab_set(&symtab, STRVIEW("start"), make_number_value(0x1900)));
+    REQUIRE_TRUE(symtab_set(&symtab, STRVIEW("version"), make_string_value(allocator_default(), STRVIEW("1.0"))));
+    REQUIRE_TRUE(symtab_set(&symtab, STRVIEW("entry"), make_number_value(0x1900)));
+    REQUIRE_TRUE(symtab_set(&symtab, STRVIEW("table"), make_list_value(allocator_default(), 4)));
+    REQUIRE_TRUE(symtab_set(&symtab, STRVIEW("end"), make_number_value(0x1A00)));
+    REQUIRE_TRUE(symtab_set(&symtab, STRVIEW("alpha"), make_string_value(allocator_default(), STRVIEW("first"))));
+
+    array_uint8_t bytes = make_array(uint8_t, allocator_default(), 256);
+    REQUIRE_TRUE(symtab_write_binary(&symtab, allocator_default(), append_bytes, &bytes));
+    symtab_deinit(&symtab);
+
+    // Copy the file into memory aligned as a mapped file would be
+    uint64_t *data = malloc(bytes.size);
+    memcpy(data, bytes.data, bytes.size);
+    const baron_symbol_file_header_t *file = baron_symbol_file_open(data, bytes.size);
+    REQUIRE_TRUE(file);
+    REQUIRE_FALSE(baron_symbol_file_open(data, bytes.size - 1));
+    REQUIRE(file->num_symbols,==,7);
+    REQUIRE(file->num_numeric_symbols,==,4);
+
+    // Numeric symbols are sorted by value, ties in definition order, followed by string symbols sorted by name
+    const baron_symbol_record_t *records = (const baron_symbol_record_t *)((const uint8_t *)data + file->records_offset);
+    REQUIRE(make_strview(baron_symbol_file_string(file, records[0].name_offset)),==,STRVIEW("start"));
+    REQUIRE(make_strview(baron_symbol_file_string(file, records[1].name_offset)),==,STRVIEW("entry"));
+    REQUIRE(make_strview(baron_symbol_file_string(file, records[2].name_offset)),==,STRVIEW("loop"));
+    REQUIRE(make_strview(baron_symbol_file_string(file, records[3].name_offset)),==,STRVIEW("end"));
+    REQUIRE(make_strview(baron_symbol_file_string(file, records[4].name_offset)),==,STRVIEW("alpha"));
+    REQUIRE(make_strview(baron_symbol_file_string(file, records[5].name_offset)),==,STRVIEW("version"));
+    REQUIRE(make_strview(baron_symbol_file_string(file, records[6].name_offset)),==,STRVIEW("zeta"));
+
+    const baron_symbol_record_t *record = baron_symbol_file_find(file, "loop");
+    REQUIRE_TRUE(record);
+    REQUIRE(record->type,==,baron_value_numeric);
+    REQUIRE(record->number,==,0x1910);
+    record = baron_symbol_file_find(file, "version");
+    REQUIRE_TRUE(record);
+    REQUIRE(record->type,==,baron_value_string);
+    REQUIRE(make_strview(baron_symbol_file_string(file, record->string_offset)),==,STRVIEW("1.0"));
+    REQUIRE_TRUE(baron_symbol_file_find(file, "zeta") == &records[6]);
+    REQUIRE_FALSE(baron_symbol_file_find(file, "table"));
+    REQUIRE_FALSE(baron_symbol_file_find(file, "lo"));
+
+    REQUIRE_FALSE(baron_symbol_file_find_address(file, 0x18FF));
+    REQUIRE_TRUE(baron_symbol_file_find_address(file, 0x1900) == &records[0]);
+    REQUIRE_TRUE(baron_symbol_file_find_address(file, 0x190F) == &records[0]);
+    REQUIRE_TRUE(baron_symbol_file_find_address(file, 0x1910) == &records[2]);
+    REQUIRE_TRUE(baron_symbol_file_find_address(file, 0xFFFF) == &records[3]);
+
+    free(data);
+    array_deinit(&bytes);
+}
+
+DEF_TEST(symtab, binary_file_nan_and_corrupt) {
+    symtab_t symtab;
+    REQUIRE_TRUE(symtab_init(&symtab, allocator_default()));
+    REQUIRE_TRUE(symtab_set(&symtab, STRVIEW("undefined"), make_number_value(NAN)));
+    REQUIRE_TRUE(symtab_set(&symtab, STRVIEW("end"), make_number_value(0x1A00)));
+    REQUIRE_TRUE(symtab_set(&symtab, STRVIEW("unknown"), make_number_value(NAN)));
+    REQUIRE_TRUE(symtab_set(&symtab, STRVIEW("start"), make_number_value(0x1900)));
+
+    array_uint8_t bytes = make_array(uint8_t, allocator_default(), 256);
+    REQUIRE_TRUE(symtab_write_binary(&symtab, allocator_default(), append_bytes, &bytes));
+    symtab_deinit(&symtab);
+
+    uint64_t *data = malloc(bytes.size);
+    memcpy(data, bytes.data, bytes.size);
+    const baron_symbol_file_header_t *file = baron_symbol_file_open(data, bytes.size);
+    REQUIRE_TRUE(file);
+
+    // NaN values are sorted after every other number, in definition order, so address lookups never see them
+    const baron_symbol_record_t *records = (const baron_symbol_record_t *)((const uint8_t *)data + file->records_offset);
+    REQUIRE(make_strview(baron_symbol_file_string(file, records[0].name_offset)),==,STRVIEW("start"));
+    REQUIRE(make_strview(baron_symbol_file_string(file, records[1].name_offset)),==,STRVIEW("end"));
+    REQUIRE(make_strview(baron_symbol_file_string(file, records[2].name_offset)),==,STRVIEW("undefined"));
+    REQUIRE(make_strview(baron_symbol_file_string(file, records[3].name_offset)),==,STRVIEW("unknown"));
+    REQUIRE_TRUE(baron_symbol_file_find_address(file, 0x1A00) == &records[1]);
+    REQUIRE_TRUE(baron_symbol_file_find_address(file, 0xFFFF) == &records[1]);
+    REQUIRE_FALSE(baron_symbol_file_find_address(file, NAN));
+    REQUIRE_TRUE(isnan(baron_symbol_file_find(file, "unknown")->number));
+
+    // A corrupt file with no empty hash slot ends the probe once every slot has been examined
+    uint32_t *slots = (uint32_t *)((uint8_t *)data + file->hash_offset);
+    for (uint32_t i = 0; i < file->num_hash_slots; i++) {
+        slots[i] = 0;
+    }
+    REQUIRE_FALSE(baron_symbol_file_find(file, "missing"));
+    REQUIRE_TRUE(baron_symbol_file_find(file, "start") == &records[0]);
+
+    free(data);
+    array_deinit(&bytes);
+}
+
+DEF_TEST(symtab, visit_and_batch_find) {
+    baron_assembly_t *assembly = assembly_create(0);
+    REQUIRE_TRUE(assembly);
+    symtab_t *symtab = &assembly->symbols;
+    REQUIRE_TRUE(symtab_set(symtab, STRVIEW("start"), make_number_value(0x1900)));
+    REQUIRE_TRUE(symtab_set(symtab, STRVIEW("sprites.count"), make_number_value(12)));
+    REQUIRE_TRUE(symtab_set(symtab, STRVIEW("sprites.name"), make_string_value(allocator_default(), STRVIEW("ship"))));
+    REQUIRE_TRUE(symtab_set(symtab, STRVIEW("spritesheet"), make_number_value(0x3000)));
+    REQUIRE_TRUE(symtab_set(symtab, STRVIEW("sprites.table.size"), make_number_value(64)));
+
+    visited_t visited = {.max_names = 8};
+    REQUIRE(baron_assembly_visit_symbols(assembly, 0, visit_symbol, &visited),==,5);
+    REQUIRE(make_strview(visited.names[3]),==,STRVIEW("spritesheet"));
+
+    // Names are views of the table itself
+    REQUIRE_TRUE(visited.names[0] == (const char *)symtab_find(symtab, STRVIEW("start"))->name.data);
+
+    visited = (visited_t){.max_names = 8};
+    baron_symbol_filter_t filter = {.scope = "sprites"};
+    REQUIRE(baron_assembly_visit_symbols(assembly, &filter, visit_symbol, &visited),==,3);
+    REQUIRE(make_strview(visited.names[0]),==,STRVIEW("sprites.count"));
+    REQUIRE(make_strview(visited.names[1]),==,STRVIEW("sprites.name"));
+    REQUIRE(make_strview(visited.names[2]),==,STRVIEW("sprites.table.size"));
+
+    visited = (visited_t){.max_names = 8};
+    filter.types = 1U << baron_value_numeric;
+    REQUIRE(baron_assembly_visit_symbols(assembly, &filter, visit_symbol, &visited),==,2);
+
+    // Visiting stops as soon as the visitor asks
+    visited = (visited_t){.max_names = 1};
+    REQUIRE(baron_assembly_visit_symbols(assembly, 0, visit_symbol, &visited),==,1);
+
+    const char *const names[] = {"sprites.name", "missing", "start"};
+    baron_symbol_t symbols[3];
+    REQUIRE(baron_assembly_find_symbols(assembly, names, 3, symbols),==,2);
+    REQUIRE(symbols[0].type,==,baron_value_string);
+    REQUIRE(((strview_t){(const uint8_t *)symbols[0].string, (uint32_t)symbols[0].string_length}),==,STRVIEW("ship"));
+    REQUIRE(symbols[1].type,==,baron_value_none);
+    REQUIRE(symbols[2].type,==,baron_value_numeric);
+    REQUIRE(symbols[2].number,==,0x1900);
+    REQUIRE(symbols[2].name_length,==,5);
+
+    assembly_destroy(assembly);
+}
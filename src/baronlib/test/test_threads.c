@@ -0,0 +1,255 @@
+#include <stdio.h>
+#include <string.h>
+#if !defined(__STDC_NO_THREADS__)
+#include <threads.h>
+#endif
+#include "base/test.h"
+#include "base/allocator.h"
+#include "assembly.h"
+#include "lexer.h"
+
+#define NUM_THREADS 8
+#define NUM_ROUNDS 10
+
+
+static const char *const corpus[] = {
+    "start = &1900\n"
+    "count = 12\n"
+    "LDX #count : LDA table,X : STA &7C00,X : DEX : BPL loop\n",
+
+    "screen = &3000\n"
+    "width = 80 : height = 256\n"
+    "size = width * height / 8\n"
+    "ratio = 1.25E-1 : pi = 3.14159265358979\n",
+
+    "name = \"Spinning cube\"\n"
+    "x = %10110011 : y = &FFFF : z = 1E300 ; big\n"
+    "JSR &FFEE : RTS\n"
+};
+
+
+static bool append_bytes(const void *data, size_t size, void *context) {
+    return array_append((array_uint8_t *)context, ((slice_const_uint8_t){data, (uint32_t)size}));
+}
+
+
+/**
+ *  Run one source through everything an assembly produces, appending all of its output to results: the lexer and
+ *  number parsing, the symbol table and its binary export, the log, the memory map and a disk image.
+ *  The assembly is reset rather than recreated, as a context would do.
+ */
+static bool process_source(baron_assembly_t *assembly, array_token_t *tokens, const char *source, array_uint8_t *results) {
+    assembly_reset(assembly);
+    array_reset(tokens);
+    if (lex(make_strview(source), tokens).error) {
+        return false;
+    }
+
+    overlay_t *overlay = &assembly->overlays.data[0];
+    for (uint32_t i = 0; i < tokens->size; i++) {
+        const token_t *token = &tokens->data[i];
+        uint8_t byte = (token->type == token_number && token->number < 256) ? (uint8_t)token->number : 0;
+        if (token->type == token_number && !array_add(&overlay->object_code, byte)) {
+            return false;
+        }
+        if (token->type == token_identifier && i + 2 < tokens->size && token_is_symbol(&token[1], STRVIEW("="))) {
+            bool is_string = (token[2].type == token_string);
+            double number = is_string ? 0.0 : token[2].number;
+            value_t value = is_string ? make_string_value(&assembly->allocator, token[2].text) : make_number_value(number);
+            if (!symtab_set(&assembly->symbols, token->text, value) ||
+                !log_write(&assembly->log, 1, log_message_symbol_value, token->line, token->text, number)) {
+                return false;
+            }
+        }
+    }
+
+    assembly->overlays.data[0].name = STRVIEW("CODE");
+    baron_disk_file_t file;
+    assembly_save_overlay(assembly, 0, 0x1900, 0x1900);
+    if (!assembly_finish(assembly) ||
+        baron_assembly_disk_files(assembly, &file, 1) != 1) {
+        return false;
+    }
+
+    baron_disk_image_desc_t desc = {.title = "STRESS", .num_tracks = 40, .files = &file, .num_files = 1};
+    const char *log = baron_assembly_log(assembly, 1);
+    const char *memory_map = baron_assembly_memory_map(assembly);
+    return log && array_append(results, ((slice_const_uint8_t){(const uint8_t *)log, (uint32_t)strlen(log)})) &&
+           array_append(results, ((slice_const_uint8_t){(const uint8_t *)memory_map, (uint32_t)strlen(memory_map)})) &&
+           baron_assembly_symbols_write(assembly, append_bytes, results) &&
+           baron_disk_image_write(&desc, append_bytes, results) == baron_disk_image_ok;
+}
+
+
+static bool process_corpus(array_uint8_t *results) {
+    baron_assembly_t *assembly = assembly_create(0);
+    array_token_t tokens = make_array(token_t, allocator_default(), 64);
+    bool success = assembly && array_is_valid(&tokens);
+    for (uint32_t round = 0; success && round < NUM_ROUNDS; round++) {
+        for (uint32_t i = 0; success && i < sizeof corpus / sizeof corpus[0]; i++) {
+            success = process_source(assembly, &tokens, corpus[i], results);
+        }
+    }
+    array_deinit(&tokens);
+    assembly_destroy(assembly);
+    return success;
+}
+
+
+/**
+ *  Make a finished assembly with something in every kind of output, including a warning in the error log
+ */
+static baron_assembly_t *create_finished_assembly(void) {
+    baron_assembly_t *assembly = assembly_create(0);
+    if (!assembly) {
+        return 0;
+    }
+    uint32_t data = assembly_add_overlay(assembly, STRVIEW("DATA"));
+    assembly->overlays.data[0].name = STRVIEW("CODE");
+    assembly_save_overlay(assembly, 0, 0x1900, 0x1900);
+    assembly_save_overlay(assembly, data, 0x1A80, 0x1A80);
+    bool success = array_resize(&assembly->overlays.data[0].object_code, 0x200) &&
+                   array_resize(&assembly->overlays.data[data].object_code, 0x100);
+    for (uint32_t i = 0; success && i < 100; i++) {
+        char name[16];
+        snprintf(name, sizeof name, "label%u", i);
+        success = symtab_set(&assembly->symbols, make_strview(name), make_number_value(0x1900 + i)) &&
+                  log_write(&assembly->log, 1 + i % 3, log_message_symbol_value, i, make_strview(name), (double)(0x1900 + i));
+    }
+    success = success &&
+              symtab_set(&assembly->symbols, STRVIEW("title"), make_string_value(&assembly->allocator, STRVIEW("Shared"))) &&
+              assembly_finish(assembly);
+    if (!success) {
+        assembly_destroy(assembly);
+        return 0;
+    }
+    return assembly;
+}
+
+
+/**
+ *  Read everything a finished assembly offers through its const accessors, appending it all to results
+ */
+static bool read_assembly(const baron_assembly_t *assembly, array_uint8_t *results) {
+    for (uint32_t round = 0; round < NUM_ROUNDS; round++) {
+        for (int channel = 0; channel < LOG_NUM_CHANNELS; channel++) {
+            const char *text = (channel == LOG_CHANNEL_ERRORS) ? baron_assembly_errors(assembly)
+                                                                : baron_assembly_log(assembly, channel);
+            if (!text || !array_append(results, ((slice_const_uint8_t){(const uint8_t *)text, (uint32_t)strlen(text)}))) {
+                return false;
+            }
+        }
+
+        const char *memory_map = baron_assembly_memory_map(assembly);
+        const double *number = baron_assembly_symbol_numeric(assembly, "label42");
+        baron_object_code_t code = baron_assembly_object_code(assembly, "CODE");
+        baron_disk_file_t files[2];
+        if (!number || *number != 0x1900 + 42 || baron_assembly_symbol_type(assembly, "title") != baron_value_string || code.size != 0x200 ||
+            baron_assembly_disk_files(assembly, files, 2) != 2 ||
+            !array_append(results, ((slice_const_uint8_t){(const uint8_t *)memory_map, (uint32_t)strlen(memory_map)})) ||
+            !baron_assembly_symbols_write(assembly, append_bytes, results)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+#if !defined(__STDC_NO_THREADS__)
+
+typedef struct worker_t worker_t;
+
+struct worker_t {
+    array_uint8_t results;
+    bool success;
+};
+
+
+static int run_worker(void *context) {
+    worker_t *worker = context;
+    worker->success = process_corpus(&worker->results);
+    return 0;
+}
+
+
+typedef struct reader_t reader_t;
+
+struct reader_t {
+    const baron_assembly_t *assembly;
+    array_uint8_t results;
+    bool success;
+};
+
+
+static int run_reader(void *context) {
+    reader_t *reader = context;
+    reader->success = read_assembly(reader->assembly, &reader->results);
+    return 0;
+}
+
+#endif
+
+
+DEF_TEST(threads, identical_results) {
+    array_uint8_t expected = make_array(uint8_t, allocator_default(), 0x10000);
+    REQUIRE_TRUE(process_corpus(&expected));
+    REQUIRE(expected.size,>,NUM_ROUNDS * 3 * 40 * 10 * 256);
+
+#if !defined(__STDC_NO_THREADS__)
+    // The library holds no mutable global state, so every thread must produce exactly the same bytes
+    worker_t workers[NUM_THREADS];
+    thrd_t threads[NUM_THREADS];
+    for (int i = 0; i < NUM_THREADS; i++) {
+        workers[i] = (worker_t){make_array(uint8_t, allocator_default(), 0x10000), false};
+        REQUIRE(thrd_create(&threads[i], run_worker, &workers[i]),==,thrd_success);
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+        REQUIRE(thrd_join(threads[i], 0),==,thrd_success);
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+        REQUIRE_TRUE(workers[i].success);
+        REQUIRE(workers[i].results.size,==,expected.size);
+        REQUIRE(memcmp(workers[i].results.data, expected.data, expected.size),==,0);
+        array_deinit(&workers[i].results);
+    }
+#endif
+
+    array_deinit(&expected);
+}
+
+DEF_TEST(threads, shared_assembly) {
+    // The expected results are read from an identical assembly, so that the shared one's text is still unformatted
+    baron_assembly_t *reference = create_finished_assembly();
+    REQUIRE_TRUE(reference != 0);
+    REQUIRE(make_strview(baron_assembly_errors(reference)),==,
+            STRVIEW("Warning: saved overlays 'CODE' and 'DATA' overlap at &1A80-&1AFF\n"));
+    array_uint8_t expected = make_array(uint8_t, allocator_default(), 0x10000);
+    REQUIRE_TRUE(read_assembly(reference, &expected));
+    assembly_destroy(reference);
+
+    baron_assembly_t *assembly = create_finished_assembly();
+    REQUIRE_TRUE(assembly != 0);
+
+#if !defined(__STDC_NO_THREADS__)
+    // Every thread reads the one assembly at the same time, racing to format its logs, which mustn't change what any
+    // of them sees
+    reader_t readers[NUM_THREADS];
+    thrd_t threads[NUM_THREADS];
+    for (int i = 0; i < NUM_THREADS; i++) {
+        readers[i] = (reader_t){assembly, make_array(uint8_t, allocator_default(), 0x10000), false};
+        REQUIRE(thrd_create(&threads[i], run_reader, &readers[i]),==,thrd_success);
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+        REQUIRE(thrd_join(threads[i], 0),==,thrd_success);
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+        REQUIRE_TRUE(readers[i].success);
+        REQUIRE(readers[i].results.size,==,expected.size);
+        REQUIRE(memcmp(readers[i].results.data, expected.data, expected.size),==,0);
+        array_deinit(&readers[i].results);
+    }
+#endif
+
+    array_deinit(&expected);
+    assembly_destroy(assembly);
+}
@@ -0,0 +1,154 @@
+#include "base/test.h"
+#include "base/allocator.h"
+#include "base/tracker.h"
+#include "value.h"
+
+static tracker_t tracker;
+static allocator_t tracking_allocator;
+
+// Starts counting the blocks allocated through tracking_allocator afresh
+static void start_tracking(void) {
+    tracker_init(&tracker, allocator_default());
+    tracking_allocator = tracker_allocator(&tracker);
+}
+
+
+static value_t make_range(uint32_t size) {
+    value_t list = make_list_value(&tracking_allocator, size);
+    for (uint32_t i = 0; i < size; i++) {
+        list_append(&list, make_number_value(i));
+    }
+    return list;
+}
+
+DEF_TEST(value, list_slices) {
+    start_tracking();
+    value_t list = make_range(1000);
+    REQUIRE(list_size(&list),==,1000);
+    REQUIRE(list_get(&list, 999)->number,==,999.0);
+
+    // Slices share the storage of the list
+    value_t slice = list_slice(&list, 100, 50);
+    REQUIRE(list_size(&slice),==,50);
+    REQUIRE_TRUE(list_get(&slice, 0) == list_get(&list, 100));
+    value_t inner = list_slice(&slice, 40, 1000);
+    REQUIRE(list_size(&inner),==,10);
+    REQUIRE(list_get(&inner, 9)->number,==,149.0);
+    value_t empty = list_slice(&list, 2000, 10);
+    REQUIRE(list_size(&empty),==,0);
+    REQUIRE(tracker.totals.live_blocks,==,2);
+
+    // Modifying a shared list copies it, leaving the others untouched
+    REQUIRE_TRUE(list_set(&slice, 0, make_number_value(-1)));
+    REQUIRE(list_get(&slice, 0)->number,==,-1.0);
+    REQUIRE(list_get(&list, 100)->number,==,100.0);
+    REQUIRE(list_size(&slice),==,50);
+    REQUIRE(tracker.totals.live_blocks,==,4);
+
+    // A list which owns its storage is modified in place
+    const value_t *before = list_get(&slice, 1);
+    REQUIRE_TRUE(list_set(&slice, 1, make_number_value(-2)));
+    REQUIRE_TRUE(list_get(&slice, 1) == before);
+
+    value_release(&list);
+    value_release(&inner);
+    value_release(&empty);
+    value_release(&slice);
+    REQUIRE(tracker.totals.live_blocks,==,0);
+}
+
+DEF_TEST(value, list_nesting) {
+    start_tracking();
+    value_t outer = make_list_value(&tracking_allocator, 4);
+    value_t inner = make_range(3);
+    REQUIRE_TRUE(list_append(&outer, value_copy(&inner)));
+    REQUIRE_TRUE(list_append(&outer, inner));
+    REQUIRE_TRUE(list_get(&outer, 0)->list.storage == list_get(&outer, 1)->list.storage);
+
+    // Concatenating a list with itself
+    REQUIRE_TRUE(list_concat(&outer, &outer));
+    REQUIRE(list_size(&outer),==,4);
+    REQUIRE(list_get(list_get(&outer, 3), 2)->number,==,2.0);
+
+    // A slice which outlives its list keeps only its own view when modified
+    value_t tail = list_slice(&outer, 2, 2);
+    value_release(&outer);
+    REQUIRE_TRUE(list_append(&tail, make_number_value(7)));
+    REQUIRE(list_size(&tail),==,3);
+    REQUIRE(list_get(&tail, 2)->number,==,7.0);
+    REQUIRE(list_size(list_get(&tail, 0)),==,3);
+
+    value_release(&tail);
+    REQUIRE(tracker.totals.live_blocks,==,0);
+}
+
+DEF_TEST(value, small_strings) {
+    start_tracking();
+    value_t string = make_string_value(&tracking_allocator, make_strview("Hello"));
+    REQUIRE_TRUE(string.is_small);
+    REQUIRE(string_view(&string),==,make_strview("Hello"));
+
+    value_t copy = value_copy(&string);
+    REQUIRE_TRUE(string_append(&string, &tracking_allocator, make_strview(", world")));
+    REQUIRE(string_view(&string),==,make_strview("Hello, world"));
+    REQUIRE(string_view(&copy),==,make_strview("Hello"));
+    REQUIRE(tracker.totals.live_blocks,==,0);
+
+    // Appending a string to itself
+    REQUIRE_TRUE(string_append(&copy, &tracking_allocator, string_view(&copy)));
+    REQUIRE(string_view(&copy),==,make_strview("HelloHello"));
+
+    // Outgrowing the inline space moves the string to storage
+    REQUIRE_TRUE(string_append(&string, &tracking_allocator, make_strview("!!!!")));
+    REQUIRE_FALSE(string.is_small);
+    REQUIRE(string_view(&string),==,make_strview("Hello, world!!!!"));
+    REQUIRE(tracker.totals.live_blocks,==,2);
+
+    value_t sub = string_substr(&copy, 3, 4);
+    REQUIRE(string_view(&sub),==,make_strview("loHe"));
+
+    value_release(&string);
+    value_release(&copy);
+    value_release(&sub);
+    REQUIRE(tracker.totals.live_blocks,==,0);
+}
+
+DEF_TEST(value, string_appends) {
+    start_tracking();
+    value_t string = make_string_value(&tracking_allocator, make_strview("0123456789abcdefghij"));
+    REQUIRE_FALSE(string.is_small);
+    REQUIRE(tracker.totals.live_blocks,==,2);
+
+    // Repeated appends grow the same storage in place, even while earlier versions are still referenced
+    value_t versions[100];
+    for (uint32_t i = 0; i < 100; i++) {
+        versions[i] = value_copy(&string);
+        REQUIRE_TRUE(string_append(&string, &tracking_allocator, make_strview("xyz")));
+    }
+    REQUIRE(string_length(&string),==,320);
+    REQUIRE(tracker.totals.live_blocks,==,2);
+    REQUIRE(string_view(&versions[0]),==,make_strview("0123456789abcdefghij"));
+    REQUIRE(string_length(&versions[99]),==,317);
+    REQUIRE_TRUE(string_view(&versions[50]).data == string_view(&string).data);
+
+    // Appending to an earlier version can't write in place, so it gets its own storage
+    REQUIRE_TRUE(string_append(&versions[0], &tracking_allocator, make_strview("!")));
+    REQUIRE(string_view(&versions[0]),==,make_strview("0123456789abcdefghij!"));
+    REQUIRE(string_length(&versions[1]),==,23);
+    REQUIRE(tracker.totals.live_blocks,==,4);
+
+    // Substrings share storage, and a substring reaching the end can be appended to in place
+    value_t tail = string_substr(&string, 299, 100);
+    REQUIRE(string_view(&tail),==,make_strview("xyzxyzxyzxyzxyzxyzxyz"));
+    value_release(&string);
+    REQUIRE_TRUE(string_append(&tail, &tracking_allocator, string_view(&tail)));
+    REQUIRE(string_length(&tail),==,42);
+    REQUIRE(strview_right(string_view(&tail), 4),==,make_strview("zxyz"));
+    REQUIRE(tracker.totals.live_blocks,==,4);
+
+    for (uint32_t i = 0; i < 100; i++) {
+        value_release(&versions[i]);
+    }
+    value_release(&tail);
+    REQUIRE(tracker.totals.live_blocks,==,0);
+}
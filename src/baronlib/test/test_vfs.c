@@ -0,0 +1,139 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "base/test.h"
+#include "base/allocator.h"
+#include "vfs.h"
+
+typedef struct loader_t loader_t;
+
+struct loader_t {
+    uint32_t num_loads;
+    uint32_t num_releases;
+    baron_file_contents_t released;
+};
+
+static bool load_file(const char *filename, baron_file_contents_t *contents, void *context) {
+    loader_t *loader = context;
+#if SIZE_MAX > UINT32_MAX
+    // A file too large to use, whose contents are never read
+    if (strcmp(filename, "huge.bin") == 0) {
+        loader->num_loads++;
+        *contents = (baron_file_contents_t){filename, (size_t)UINT32_MAX + 1};
+        return true;
+    }
+#endif
+    // An empty file, which may have no data at all
+    if (strcmp(filename, "empty.bin") == 0) {
+        loader->num_loads++;
+        *contents = (baron_file_contents_t){0, 0};
+        return true;
+    }
+    if (strcmp(filename, "macros.6502") != 0) {
+        return false;
+    }
+    loader->num_loads++;
+    static const char text[] = "MACRO nop2 : NOP : NOP : ENDMACRO\n";
+    *contents = (baron_file_contents_t){text, sizeof text - 1};
+    return true;
+}
+
+static void release_file(const char *filename, baron_file_contents_t contents, void *context) {
+    loader_t *loader = context;
+    if (strcmp(filename, "macros.6502") == 0 || strcmp(filename, "huge.bin") == 0 ||
+        strcmp(filename, "empty.bin") == 0) {
+        loader->num_releases++;
+        loader->released = contents;
+    }
+}
+
+DEF_TEST(vfs, memory_files_and_loader) {
+    static const uint8_t sprite[] = {0x00, 0x3C, 0x7E, 0xFF};
+    const baron_memory_file_t files[] = {
+        {"main.6502", "INCLUDE \"macros.6502\"\n", 22},
+        {"sprite.bin", sprite, sizeof sprite},
+        {"empty.6502", 0, 0}
+    };
+    loader_t loader = {0};
+    baron_file_system_t file_system = {files, 3, load_file, release_file, &loader};
+
+    vfs_t vfs;
+    REQUIRE_TRUE(vfs_init(&vfs, allocator_default(), &file_system));
+
+    // Memory files are referenced, not copied
+    strview_t contents = vfs_load(&vfs, STRVIEW("sprite.bin"));
+    REQUIRE_TRUE(contents.data == sprite);
+    REQUIRE(contents.length,==,4);
+    REQUIRE(vfs_load(&vfs, STRVIEW("main.6502")),==,STRVIEW("INCLUDE \"macros.6502\"\n"));
+    REQUIRE_TRUE(strview_is_valid(vfs_load(&vfs, STRVIEW("empty.6502"))));
+
+    // Files from the loader are loaded once, however often they're asked for
+    for (int i = 0; i < 3; i++) {
+        REQUIRE(vfs_load(&vfs, STRVIEW("macros.6502")),==,STRVIEW("MACRO nop2 : NOP : NOP : ENDMACRO\n"));
+    }
+    REQUIRE(loader.num_loads,==,1);
+
+    // With a file system given, a name it doesn't know is never looked for on disk
+    REQUIRE_FALSE(strview_is_valid(vfs_load(&vfs, STRVIEW("CMakeCache.txt"))));
+
+    vfs_reset(&vfs);
+    REQUIRE(loader.num_releases,==,1);
+    REQUIRE_TRUE(strview_is_valid(vfs_load(&vfs, STRVIEW("macros.6502"))));
+    REQUIRE(loader.num_loads,==,2);
+
+    vfs_deinit(&vfs);
+    REQUIRE(loader.num_releases,==,2);
+}
+
+DEF_TEST(vfs, oversized_load) {
+#if SIZE_MAX > UINT32_MAX
+    loader_t loader = {0};
+    baron_file_system_t file_system = {0, 0, load_file, release_file, &loader};
+
+    vfs_t vfs;
+    REQUIRE_TRUE(vfs_init(&vfs, allocator_default(), &file_system));
+
+    // Contents too large to view are released at once, and the file is missing
+    REQUIRE_FALSE(strview_is_valid(vfs_load(&vfs, STRVIEW("huge.bin"))));
+    REQUIRE(loader.num_loads,==,1);
+    REQUIRE(loader.num_releases,==,1);
+    REQUIRE(vfs.files.size,==,0);
+
+    vfs_deinit(&vfs);
+    REQUIRE(loader.num_releases,==,1);
+#endif
+}
+
+DEF_TEST(vfs, empty_load) {
+    loader_t loader = {0};
+    baron_file_system_t file_system = {0, 0, load_file, release_file, &loader};
+
+    vfs_t vfs;
+    REQUIRE_TRUE(vfs_init(&vfs, allocator_default(), &file_system));
+
+    // Empty contents with no data can still be viewed, but exactly what was loaded is what's released
+    REQUIRE(vfs_load(&vfs, STRVIEW("empty.bin")),==,STRVIEW(""));
+    loader.released = (baron_file_contents_t){&loader, 1};
+    vfs_reset(&vfs);
+    REQUIRE(loader.num_releases,==,1);
+    REQUIRE_TRUE(loader.released.data == 0);
+    REQUIRE(loader.released.size,==,0);
+
+    vfs_deinit(&vfs);
+    REQUIRE(loader.num_releases,==,1);
+}
+
+DEF_TEST(vfs, disk) {
+    const char *filename = "vfs_test.tmp";
+    FILE *file = fopen(filename, "wb");
+    REQUIRE_TRUE(file != 0);
+    fputs("LDA #1\n", file);
+    fclose(file);
+
+    vfs_t vfs;
+    REQUIRE_TRUE(vfs_init(&vfs, allocator_default(), 0));
+    REQUIRE(vfs_load(&vfs, make_strview(filename)),==,STRVIEW("LDA #1\n"));
+    REQUIRE_FALSE(strview_is_valid(vfs_load(&vfs, STRVIEW("no such file.6502"))));
+    vfs_deinit(&vfs);
+    remove(filename);
+}